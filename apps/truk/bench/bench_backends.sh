@@ -0,0 +1,81 @@
+#!/bin/bash
+#
+# Compiles each program in programs/ with the TCC backend and with the system
+# compiler (--backend=cc, once at the profile's -O2 and once with -O3, LTO
+# and -march=native), checks that all builds print the same thing, and
+# reports compile time and the best of N run times for each.
+#
+#   bench_backends.sh <truk binary> [runs]
+#
+
+set -e
+
+TRUK="$1"
+RUNS="${2:-3}"
+BENCH_DIR="$(cd "$(dirname "$0")" && pwd)"
+
+if [ -z "${TRUK}" ] || [ ! -x "${TRUK}" ]; then
+    echo "usage: $0 <truk binary> [runs]" >&2
+    exit 1
+fi
+
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+now_ms() {
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+# build <name> <program> <flags...>: prints compile time in ms.
+build() {
+    local name="$1" program="$2"
+    shift 2
+    local start end
+    start=$(now_ms)
+    "${TRUK}" "${program}" -o "${WORK_DIR}/${name}" "$@" > /dev/null
+    end=$(now_ms)
+    echo $(( end - start ))
+}
+
+# best_run <name>: prints the best wall time in ms, output in <name>.out.
+best_run() {
+    local name="$1" best="" start end i
+    for (( i = 0; i < RUNS; i++ )); do
+        start=$(now_ms)
+        "${WORK_DIR}/${name}" > "${WORK_DIR}/${name}.out"
+        end=$(now_ms)
+        if [ -z "${best}" ] || (( end - start < best )); then
+            best=$(( end - start ))
+        fi
+    done
+    echo "${best}"
+}
+
+printf "%-10s %-22s %10s %10s %9s\n" "program" "backend" "build ms" "run ms" \
+    "speedup"
+
+for program in "${BENCH_DIR}"/programs/*.truk; do
+    base="$(basename "${program}" .truk)"
+    tcc_build=$(build "${base}_tcc" "${program}")
+    tcc_run=$(best_run "${base}_tcc")
+    printf "%-10s %-22s %10d %10d %9s\n" "${base}" "tcc" "${tcc_build}" \
+        "${tcc_run}" "1.00x"
+
+    for variant in "cc -O2" "cc -O3 lto native"; do
+        case "${variant}" in
+            "cc -O2") flags=(--backend=cc) ;;
+            *) flags=(--backend=cc -O3 --lto --march=native) ;;
+        esac
+        name="${base}_${variant// /_}"
+        cc_build=$(build "${name}" "${program}" "${flags[@]}")
+        cc_run=$(best_run "${name}")
+        if ! cmp -s "${WORK_DIR}/${base}_tcc.out" "${WORK_DIR}/${name}.out"; then
+            echo "${base}: ${variant} output differs from tcc" >&2
+            exit 1
+        fi
+        speedup=$(awk -v a="${tcc_run}" -v b="${cc_run}" \
+            'BEGIN { printf "%.2fx", (b > 0 ? a / b : 0) }')
+        printf "%-10s %-22s %10d %10d %9s\n" "${base}" "${variant}" \
+            "${cc_build}" "${cc_run}" "${speedup}"
+    done
+done
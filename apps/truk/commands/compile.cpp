@@ -1,4 +1,8 @@
 #include "compile.hpp"
+#include "../common/backend.hpp"
+#include "../common/cache.hpp"
+#include "../common/profile.hpp"
+#include <cstdio>
 #include <fmt/core.h>
 #include <truk/core/error_reporter.hpp>
 #include <truk/emitc/emitter.hpp>
@@ -6,10 +10,27 @@
 #include <truk/ingestion/import_resolver.hpp>
 #include <truk/ingestion/parser.hpp>
 #include <truk/tcc/tcc.hpp>
+#include <truk/validation/range_analysis.hpp>
 #include <truk/validation/typecheck.hpp>
 
 namespace truk::commands {
 
+static void add_search_paths(tcc::backend_if &compiler,
+                             const compile_options_s &opts) {
+  for (const auto &path : opts.include_paths) {
+    compiler.add_include_path(path);
+  }
+  for (const auto &path : opts.library_paths) {
+    compiler.add_library_path(path);
+  }
+  for (const auto &lib : opts.libraries) {
+    compiler.add_library(lib);
+  }
+  for (const auto &path : opts.rpaths) {
+    compiler.set_rpath(path);
+  }
+}
+
 int compile(const compile_options_s &opts) {
   core::error_reporter_c reporter;
 
@@ -26,6 +47,17 @@ int compile(const compile_options_s &opts) {
     fmt::print("Rpath: {}\n", path);
   }
 
+  std::optional<common::compile_cache_c> cache;
+  std::vector<std::string> program_argv = {opts.input_file};
+  program_argv.insert(program_argv.end(), opts.program_args.begin(),
+                      opts.program_args.end());
+  if (!opts.output_file.has_value() && opts.use_cache) {
+    cache.emplace("run", opts.input_file, common::cache_settings(opts));
+    if (auto cached = cache->lookup()) {
+      return common::run_executable(*cached, program_argv);
+    }
+  }
+
   ingestion::import_resolver_c resolver;
   for (const auto &path : opts.include_paths) {
     resolver.add_include_path(path);
@@ -83,10 +115,19 @@ int compile(const compile_options_s &opts) {
     return 1;
   }
 
+  validation::range_analysis_c range_analysis;
+  range_analysis.analyze(resolved.all_declarations);
+
   emitc::emitter_c emitter;
   auto emit_result = emitter.add_declarations(resolved.all_declarations)
                          .set_declaration_file_map(resolved.decl_to_file)
                          .set_file_to_shards_map(resolved.file_to_shards)
+                         .set_build_profile(opts.profile)
+                         .set_alloc_tracking(opts.alloc_tracking)
+                         .set_slice_map_keys(type_checker.slice_map_keys())
+                         .set_unchecked_indices(
+                             range_analysis.unchecked_indices())
+                         .set_hoisted_checks(range_analysis.hoisted_checks())
                          .set_c_imports(resolved.c_imports)
                          .finalize();
 
@@ -122,27 +163,11 @@ int compile(const compile_options_s &opts) {
       emit_result.assemble(emitc::assembly_type_e::APPLICATION);
   std::string c_output = assembly_result.source;
 
-  truk::tcc::tcc_compiler_c compiler;
-
   if (opts.output_file.has_value()) {
-    compiler.set_output_type(truk::tcc::OUTPUT_EXE);
-  }
-
-  for (const auto &path : opts.include_paths) {
-    compiler.add_include_path(path);
-  }
-  for (const auto &path : opts.library_paths) {
-    compiler.add_library_path(path);
-  }
-  for (const auto &lib : opts.libraries) {
-    compiler.add_library(lib);
-  }
-  for (const auto &path : opts.rpaths) {
-    compiler.set_rpath(path);
-  }
+    auto compiler = common::make_backend(opts.backend, opts.cc, opts.profile);
+    add_search_paths(*compiler, opts);
 
-  if (opts.output_file.has_value()) {
-    auto compile_result = compiler.compile_string(c_output, *opts.output_file);
+    auto compile_result = compiler->compile_string(c_output, *opts.output_file);
 
     if (!compile_result.success) {
       reporter.report_compilation_error(compile_result.error_message);
@@ -153,7 +178,38 @@ int compile(const compile_options_s &opts) {
     fmt::print("Successfully compiled '{}' to '{}'\n", opts.input_file,
                *opts.output_file);
     return 0;
+  } else if (cache && cache->enabled()) {
+    truk::tcc::tcc_compiler_c compiler;
+    compiler.set_options(common::compiler_options(opts.profile));
+    compiler.set_output_type(truk::tcc::OUTPUT_EXE);
+    add_search_paths(compiler, opts);
+
+    std::string scratch = cache->scratch_path();
+    auto compile_result = compiler.compile_string(c_output, scratch);
+    if (!compile_result.success) {
+      std::remove(scratch.c_str());
+      reporter.report_compilation_error(compile_result.error_message);
+      reporter.print_summary();
+      return 1;
+    }
+
+    auto sources = common::build_sources(resolved, opts.include_paths,
+                                         opts.library_paths, opts.libraries);
+    std::optional<std::string> cached;
+    if (sources) {
+      cached = cache->store(*sources, c_output, scratch);
+    }
+    int exit_code =
+        common::run_executable(cached ? *cached : scratch, program_argv);
+    if (!cached) {
+      std::remove(scratch.c_str());
+    }
+    return exit_code;
   } else {
+    truk::tcc::tcc_compiler_c compiler;
+    compiler.set_options(common::compiler_options(opts.profile));
+    add_search_paths(compiler, opts);
+
     int argc = static_cast<int>(opts.program_args.size()) + 1;
     std::vector<char *> argv_ptrs;
     argv_ptrs.reserve(argc + 1);
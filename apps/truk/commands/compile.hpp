@@ -2,6 +2,9 @@
 
 #include <optional>
 #include <string>
+#include <truk/emitc/emitter.hpp>
+#include <truk/tcc/backend.hpp>
+#include <truk/tcc/cc.hpp>
 #include <vector>
 
 namespace truk::commands {
@@ -14,6 +17,13 @@ struct compile_options_s {
   std::vector<std::string> libraries;
   std::vector<std::string> rpaths;
   std::vector<std::string> program_args;
+  emitc::build_profile_e profile{emitc::build_profile_e::RELEASE};
+  emitc::alloc_tracking_e alloc_tracking{emitc::alloc_tracking_e::OFF};
+  // Backend for output_file; running without one always uses TCC.
+  tcc::backend_e backend{tcc::backend_e::TCC};
+  tcc::cc_options_s cc;
+  // Reuse and record builds in the compile cache when running.
+  bool use_cache{true};
 };
 
 int compile(const compile_options_s &opts);
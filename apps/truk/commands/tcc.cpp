@@ -1,4 +1,5 @@
 #include "tcc.hpp"
+#include "../common/profile.hpp"
 #include <fmt/core.h>
 #include <truk/core/error_reporter.hpp>
 #include <truk/tcc/tcc.hpp>
@@ -22,6 +23,7 @@ int tcc(const tcc_options_s &opts) {
   }
 
   truk::tcc::tcc_compiler_c compiler;
+  compiler.set_options(common::compiler_options(opts.profile));
   compiler.set_output_type(truk::tcc::OUTPUT_EXE);
 
   for (const auto &path : opts.include_paths) {
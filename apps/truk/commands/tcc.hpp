@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <truk/emitc/emitter.hpp>
 #include <vector>
 
 namespace truk::commands {
@@ -12,6 +13,7 @@ struct tcc_options_s {
   std::vector<std::string> library_paths;
   std::vector<std::string> libraries;
   std::vector<std::string> rpaths;
+  emitc::build_profile_e profile{emitc::build_profile_e::RELEASE};
 };
 
 int tcc(const tcc_options_s &opts);
@@ -1,14 +1,23 @@
 #include "test.hpp"
+#include "../common/cache.hpp"
+#include "../common/profile.hpp"
+#include "../common/test_report.hpp"
 #include <algorithm>
+#include <cerrno>
+#include <cstdio>
 #include <filesystem>
 #include <fmt/core.h>
+#include <sys/wait.h>
+#include <thread>
 #include <truk/core/error_reporter.hpp>
 #include <truk/emitc/emitter.hpp>
 #include <truk/ingestion/file_utils.hpp>
 #include <truk/ingestion/import_resolver.hpp>
 #include <truk/ingestion/parser.hpp>
 #include <truk/tcc/tcc.hpp>
+#include <truk/validation/range_analysis.hpp>
 #include <truk/validation/typecheck.hpp>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
@@ -52,6 +61,20 @@ static int test_single_file(const test_options_s &opts, bool quiet = false) {
     fmt::print("Rpath: {}\n", path);
   }
 
+  std::optional<common::compile_cache_c> cache;
+  std::vector<std::string> program_argv = {opts.input_file};
+  program_argv.insert(program_argv.end(), opts.program_args.begin(),
+                      opts.program_args.end());
+  if (opts.use_cache) {
+    auto settings = common::cache_settings(opts);
+    settings.push_back(fmt::format("{}:{}:{}", opts.isolate, opts.jobs,
+                                   opts.timeout_ms));
+    cache.emplace("test", opts.input_file, settings);
+    if (auto cached = cache->lookup()) {
+      return common::run_executable(*cached, program_argv);
+    }
+  }
+
   ingestion::import_resolver_c resolver;
   for (const auto &path : opts.include_paths) {
     resolver.add_include_path(path);
@@ -109,10 +132,19 @@ static int test_single_file(const test_options_s &opts, bool quiet = false) {
     return 1;
   }
 
+  validation::range_analysis_c range_analysis;
+  range_analysis.analyze(resolved.all_declarations);
+
   emitc::emitter_c emitter;
   auto emit_result = emitter.add_declarations(resolved.all_declarations)
                          .set_declaration_file_map(resolved.decl_to_file)
                          .set_file_to_shards_map(resolved.file_to_shards)
+                         .set_build_profile(opts.profile)
+                         .set_alloc_tracking(opts.alloc_tracking)
+                         .set_slice_map_keys(type_checker.slice_map_keys())
+                         .set_unchecked_indices(
+                             range_analysis.unchecked_indices())
+                         .set_hoisted_checks(range_analysis.hoisted_checks())
                          .set_c_imports(resolved.c_imports)
                          .finalize();
 
@@ -139,9 +171,11 @@ static int test_single_file(const test_options_s &opts, bool quiet = false) {
     return -1;
   }
 
-  std::string c_source = emit_result.assemble_test_runner();
+  std::string c_source = emit_result.assemble_test_runner(
+      {opts.isolate, opts.jobs, opts.timeout_ms});
 
   truk::tcc::tcc_compiler_c compiler;
+  compiler.set_options(common::compiler_options(opts.profile));
 
   for (const auto &path : opts.include_paths) {
     compiler.add_include_path(path);
@@ -156,6 +190,31 @@ static int test_single_file(const test_options_s &opts, bool quiet = false) {
     compiler.set_rpath(path);
   }
 
+  if (cache && cache->enabled()) {
+    compiler.set_output_type(truk::tcc::OUTPUT_EXE);
+    std::string scratch = cache->scratch_path();
+    auto compile_result = compiler.compile_string(c_source, scratch);
+    if (!compile_result.success) {
+      std::remove(scratch.c_str());
+      reporter.report_compilation_error(compile_result.error_message);
+      reporter.print_summary();
+      return 1;
+    }
+
+    auto sources = common::build_sources(resolved, opts.include_paths,
+                                         opts.library_paths, opts.libraries);
+    std::optional<std::string> cached;
+    if (sources) {
+      cached = cache->store(*sources, c_source, scratch);
+    }
+    int exit_code =
+        common::run_executable(cached ? *cached : scratch, program_argv);
+    if (!cached) {
+      std::remove(scratch.c_str());
+    }
+    return exit_code;
+  }
+
   int argc = static_cast<int>(opts.program_args.size()) + 1;
   std::vector<char *> argv_ptrs;
   argv_ptrs.reserve(argc + 1);
@@ -179,6 +238,167 @@ static int test_single_file(const test_options_s &opts, bool quiet = false) {
   return run_result.exit_code;
 }
 
+// Points the runtime's __truk_test_record at record_file; the variable is
+// inherited by the runner whether it runs in this process or its own.
+static void set_record_file(const std::string &record_file) {
+  if (!record_file.empty()) {
+    ::setenv("TRUK_TEST_REPORT", record_file.c_str(), 1);
+  }
+}
+
+struct test_job_s {
+  pid_t pid{-1};
+  std::FILE *out{nullptr};
+  std::FILE *err{nullptr};
+  int result_fd{-1};
+  bool done{false};
+  int result{0};
+};
+
+static void replay(std::FILE *from, std::FILE *to) {
+  char buf[4096];
+  std::size_t n;
+  std::rewind(from);
+  while ((n = std::fread(buf, 1, sizeof(buf), from)) > 0) {
+    std::fwrite(buf, 1, n, to);
+  }
+  std::fclose(from);
+}
+
+// Forks a child that tests one file with stdout and stderr going to
+// temporary files, and reports its result through a pipe. Returns false if
+// the child could not be started.
+static bool start_job(test_job_s &job, const test_options_s &opts,
+                      const std::string &file, const std::string &record_file) {
+  int fds[2];
+  job.out = std::tmpfile();
+  job.err = std::tmpfile();
+  if (!job.out || !job.err || ::pipe(fds) != 0) {
+    return false;
+  }
+
+  std::fflush(stdout);
+  std::fflush(stderr);
+  pid_t pid = ::fork();
+  if (pid < 0) {
+    ::close(fds[0]);
+    ::close(fds[1]);
+    return false;
+  }
+
+  if (pid == 0) {
+    ::close(fds[0]);
+    ::dup2(fileno(job.out), STDOUT_FILENO);
+    ::dup2(fileno(job.err), STDERR_FILENO);
+    test_options_s file_opts = opts;
+    file_opts.input_file = file;
+    set_record_file(record_file);
+    int result = test_single_file(file_opts, true);
+    std::fflush(nullptr);
+    ssize_t written = ::write(fds[1], &result, sizeof(result));
+    ::_exit(written == sizeof(result) ? 0 : 1);
+  }
+
+  ::close(fds[1]);
+  job.pid = pid;
+  job.result_fd = fds[0];
+  return true;
+}
+
+static void finish_job(test_job_s &job, const std::string &file, int status) {
+  int result = 0;
+  if (::read(job.result_fd, &result, sizeof(result)) == sizeof(result)) {
+    job.result = result;
+  } else {
+    // Killed before reporting, e.g. by a crash inside the test runner.
+    job.result = 1;
+    std::fprintf(job.err, "Error: testing %s did not finish (%s %d)\n",
+                 file.c_str(), WIFSIGNALED(status) ? "signal" : "exit status",
+                 WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status));
+  }
+  ::close(job.result_fd);
+  job.done = true;
+}
+
+// Tests every file in its own child process, at most jobs at a time. Output
+// is printed in file order as soon as all earlier files are done, so it reads
+// the same as a serial run whatever order the children finish in. Returns
+// each file's test_single_file result.
+static std::vector<int>
+test_files_isolated(const test_options_s &opts,
+                    const std::vector<std::string> &files,
+                    const std::vector<std::string> &record_files,
+                    unsigned jobs) {
+  std::vector<test_job_s> pool(files.size());
+  std::size_t next_start = 0;
+  std::size_t next_print = 0;
+  unsigned running = 0;
+
+  while (next_print < files.size()) {
+    while (running < jobs && next_start < files.size()) {
+      test_job_s &job = pool[next_start];
+      if (start_job(job, opts, files[next_start], record_files[next_start])) {
+        running++;
+      } else {
+        if (job.out) {
+          std::fclose(job.out);
+        }
+        if (job.err) {
+          std::fclose(job.err);
+        }
+        job.out = job.err = nullptr;
+        job.done = true;
+        job.result = -2;
+      }
+      next_start++;
+    }
+
+    if (running > 0) {
+      int status = 0;
+      pid_t pid = ::waitpid(-1, &status, 0);
+      if (pid < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        break;
+      }
+      for (std::size_t i = 0; i < pool.size(); i++) {
+        if (pool[i].pid == pid && !pool[i].done) {
+          finish_job(pool[i], files[i], status);
+          running--;
+          break;
+        }
+      }
+    }
+
+    while (next_print < files.size() && pool[next_print].done) {
+      test_job_s &job = pool[next_print];
+      fmt::print("\nTesting: {}\n", files[next_print]);
+      std::fflush(stdout);
+      if (job.result == -2) {
+        // No child process; test in this one instead.
+        test_options_s file_opts = opts;
+        file_opts.input_file = files[next_print];
+        set_record_file(record_files[next_print]);
+        job.result = test_single_file(file_opts, true);
+      } else {
+        replay(job.out, stdout);
+        replay(job.err, stderr);
+      }
+      std::fflush(stdout);
+      std::fflush(stderr);
+      next_print++;
+    }
+  }
+
+  std::vector<int> results;
+  results.reserve(pool.size());
+  for (const auto &job : pool) {
+    results.push_back(job.result);
+  }
+  return results;
+}
+
 int test(const test_options_s &opts) {
   auto files = collect_truk_files(opts.input_file);
 
@@ -191,22 +411,57 @@ int test(const test_options_s &opts) {
   int total_failed = 0;
   int files_with_tests = 0;
 
-  for (const auto &file : files) {
-    if (is_multi_file) {
-      fmt::print("\nTesting: {}\n", file);
+  bool recording = !opts.junit_report.empty() || !opts.json_report.empty() ||
+                   opts.slowest > 0;
+  std::vector<std::string> record_files(files.size());
+  if (recording) {
+    for (auto &record_file : record_files) {
+      record_file = common::make_test_record_file();
+      if (record_file.empty()) {
+        fmt::print(stderr, "Error: could not create a file for test records\n");
+        return 1;
+      }
     }
+  }
 
+  std::vector<int> results;
+  if (is_multi_file) {
+    unsigned jobs = opts.jobs ? opts.jobs
+                              : std::max(1u, std::thread::hardware_concurrency());
+    // The files already keep every core busy, so each one's tests run one
+    // at a time.
     test_options_s file_opts = opts;
-    file_opts.input_file = file;
-
-    int result = test_single_file(file_opts, is_multi_file);
+    file_opts.jobs = 1;
+    results = test_files_isolated(file_opts, files, record_files, jobs);
+  } else {
+    test_options_s file_opts = opts;
+    file_opts.input_file = files.front();
+    set_record_file(record_files.front());
+    results.push_back(test_single_file(file_opts));
+  }
 
-    if (result == -1) {
+  std::vector<common::test_record_s> records;
+  for (std::size_t i = 0; i < results.size(); i++) {
+    std::vector<common::test_record_s> file_records;
+    if (recording) {
+      file_records = common::take_test_records(record_files[i], files[i]);
+    }
+    if (results[i] == -1) {
       continue;
     }
 
     files_with_tests++;
-    total_failed += result;
+    total_failed += results[i];
+    // The runner exits with its number of failed tests, so any other result
+    // means it did not finish: the file failed to build, or a test crashed
+    // and took the rest of the file with it.
+    auto recorded_failures = std::count_if(
+        file_records.begin(), file_records.end(),
+        [](const auto &record) { return !record.ok(); });
+    if (recording && results[i] != recorded_failures) {
+      file_records.push_back({files[i], "(file)", "error", 0, 0, 0, 0});
+    }
+    records.insert(records.end(), file_records.begin(), file_records.end());
   }
 
   if (files_with_tests == 0) {
@@ -220,6 +475,20 @@ int test(const test_options_s &opts) {
                total_failed);
   }
 
+  if (opts.slowest > 0) {
+    common::print_slowest_tests(records, opts.slowest);
+  }
+  if (!opts.junit_report.empty() &&
+      !common::write_junit_report(opts.junit_report, records)) {
+    fmt::print(stderr, "Error: could not write {}\n", opts.junit_report);
+    return std::max(total_failed, 1);
+  }
+  if (!opts.json_report.empty() &&
+      !common::write_json_report(opts.json_report, records)) {
+    fmt::print(stderr, "Error: could not write {}\n", opts.json_report);
+    return std::max(total_failed, 1);
+  }
+
   return total_failed;
 }
 
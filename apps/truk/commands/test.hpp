@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <truk/emitc/emitter.hpp>
 #include <vector>
 
 namespace truk::commands {
@@ -12,6 +13,21 @@ struct test_options_s {
   std::vector<std::string> libraries;
   std::vector<std::string> rpaths;
   std::vector<std::string> program_args;
+  emitc::build_profile_e profile{emitc::build_profile_e::RELEASE};
+  emitc::alloc_tracking_e alloc_tracking{emitc::alloc_tracking_e::OFF};
+  bool use_cache{true};
+  // Files tested at once, each in its own child process; 0 means one per
+  // available core. With isolate and a single file, tests run at once.
+  unsigned jobs{0};
+  // Fork every test into its own process (see emitc::test_runner_options_s).
+  bool isolate{false};
+  // Per-test limit for isolated tests; 0 means none.
+  unsigned long long timeout_ms{0};
+  // Report files to write after the run; empty writes none.
+  std::string junit_report;
+  std::string json_report;
+  // Print this many of the slowest tests after the run.
+  std::size_t slowest{0};
 };
 
 int test(const test_options_s &opts);
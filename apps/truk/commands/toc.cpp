@@ -5,6 +5,7 @@
 #include <truk/ingestion/file_utils.hpp>
 #include <truk/ingestion/import_resolver.hpp>
 #include <truk/ingestion/parser.hpp>
+#include <truk/validation/range_analysis.hpp>
 #include <truk/validation/typecheck.hpp>
 
 namespace truk::commands {
@@ -73,10 +74,19 @@ int toc(const toc_options_s &opts) {
     return 1;
   }
 
+  validation::range_analysis_c range_analysis;
+  range_analysis.analyze(resolved.all_declarations);
+
   emitc::emitter_c emitter;
   auto emit_result = emitter.add_declarations(resolved.all_declarations)
                          .set_declaration_file_map(resolved.decl_to_file)
                          .set_file_to_shards_map(resolved.file_to_shards)
+                         .set_build_profile(opts.profile)
+                         .set_alloc_tracking(opts.alloc_tracking)
+                         .set_slice_map_keys(type_checker.slice_map_keys())
+                         .set_unchecked_indices(
+                             range_analysis.unchecked_indices())
+                         .set_hoisted_checks(range_analysis.hoisted_checks())
                          .set_c_imports(resolved.c_imports)
                          .finalize();
 
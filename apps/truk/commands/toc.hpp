@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <truk/emitc/emitter.hpp>
 #include <vector>
 
 namespace truk::commands {
@@ -9,6 +10,8 @@ struct toc_options_s {
   std::string input_file;
   std::string output_file;
   std::vector<std::string> include_paths;
+  emitc::build_profile_e profile{emitc::build_profile_e::RELEASE};
+  emitc::alloc_tracking_e alloc_tracking{emitc::alloc_tracking_e::OFF};
 };
 
 int toc(const toc_options_s &opts);
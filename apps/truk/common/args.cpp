@@ -1,4 +1,6 @@
 #include "args.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <fmt/core.h>
 
@@ -37,6 +39,46 @@ void print_usage(const char *program_name) {
   fmt::print(stderr, "  -l <name>   Link library (multiple allowed)\n");
   fmt::print(stderr, "  -rpath <p>  Runtime library search path (multiple "
                      "allowed)\n");
+  fmt::print(stderr, "  --profile=<debug|release|fast>\n");
+  fmt::print(stderr, "              Runtime safety checks and C optimization "
+                     "(default: release)\n");
+  fmt::print(stderr, "  --track-allocs[=full|sampled]\n");
+  fmt::print(stderr, "              Count heap allocations per make site and "
+                     "report live bytes\n"
+                     "              at exit or on SIGUSR1 (sampled is cheap "
+                     "enough for production)\n");
+  fmt::print(stderr, "  --backend=<tcc|cc>\n");
+  fmt::print(stderr, "              C compiler for executables (default: tcc; "
+                     "run and test always\n"
+                     "              use tcc)\n");
+  fmt::print(stderr, "  --cc=<path> System compiler for --backend=cc (default: "
+                     "$CC, then cc)\n");
+  fmt::print(stderr, "  -O<level>   Optimization level for --backend=cc "
+                     "(default from --profile)\n");
+  fmt::print(stderr, "  --lto       Link-time optimization for --backend=cc\n");
+  fmt::print(stderr, "  --march=<cpu>\n");
+  fmt::print(stderr, "              Target CPU for --backend=cc, e.g. native\n");
+  fmt::print(stderr, "  -j <n>      Test files run at once, each in its own "
+                     "process, or tests of\n"
+                     "              one file with --isolate (test; default: "
+                     "number of cores)\n");
+  fmt::print(stderr, "  --isolate   Run every test in its own process, "
+                     "with its wall time (test)\n");
+  fmt::print(stderr, "  --timeout=<seconds>\n");
+  fmt::print(stderr, "              Kill and fail an isolated test that runs "
+                     "longer (test; implies\n"
+                     "              --isolate)\n");
+  fmt::print(stderr, "  --junit=<file>\n");
+  fmt::print(stderr, "              Write a JUnit XML report of every test "
+                     "(test)\n");
+  fmt::print(stderr, "  --json=<file>\n");
+  fmt::print(stderr, "              Write a JSON report of every test with "
+                     "wall and CPU time (test)\n");
+  fmt::print(stderr, "  --slowest <n>\n");
+  fmt::print(stderr, "              List the n tests with the longest wall "
+                     "time (test)\n");
+  fmt::print(stderr, "  --no-cache  Rebuild instead of reusing the compile "
+                     "cache (run/test)\n");
   fmt::print(stderr, "  --          Separator for program arguments (run/test "
                      "commands)\n");
 }
@@ -86,6 +128,101 @@ parsed_args_s parse_args(int argc, char **argv) {
     } else if (std::strcmp(argv[idx], "-rpath") == 0 && idx + 1 < argc) {
       args.rpaths.push_back(argv[idx + 1]);
       idx += 2;
+    } else if (std::strncmp(argv[idx], "--profile=", 10) == 0) {
+      auto profile = emitc::build_profile_from_name(argv[idx] + 10);
+      if (!profile) {
+        fmt::print(stderr, "Unknown profile: {}\n", argv[idx] + 10);
+        print_usage(argv[0]);
+        std::exit(1);
+      }
+      args.profile = *profile;
+      idx++;
+    } else if (std::strcmp(argv[idx], "--track-allocs") == 0) {
+      args.alloc_tracking = emitc::alloc_tracking_e::FULL;
+      idx++;
+    } else if (std::strncmp(argv[idx], "--track-allocs=", 15) == 0) {
+      auto tracking = emitc::alloc_tracking_from_name(argv[idx] + 15);
+      if (!tracking) {
+        fmt::print(stderr, "Unknown allocation tracking mode: {}\n",
+                   argv[idx] + 15);
+        print_usage(argv[0]);
+        std::exit(1);
+      }
+      args.alloc_tracking = *tracking;
+      idx++;
+    } else if (std::strncmp(argv[idx], "--backend=", 10) == 0) {
+      auto backend = tcc::backend_from_name(argv[idx] + 10);
+      if (!backend) {
+        fmt::print(stderr, "Unknown backend: {}\n", argv[idx] + 10);
+        print_usage(argv[0]);
+        std::exit(1);
+      }
+      args.backend = *backend;
+      idx++;
+    } else if (std::strncmp(argv[idx], "--cc=", 5) == 0) {
+      args.cc.compiler = argv[idx] + 5;
+      idx++;
+    } else if (std::strncmp(argv[idx], "-O", 2) == 0 && argv[idx][2] != '\0') {
+      args.cc.optimization = argv[idx] + 2;
+      idx++;
+    } else if (std::strncmp(argv[idx], "-j", 2) == 0) {
+      const char *value = argv[idx][2] != '\0' ? argv[idx] + 2
+                          : idx + 1 < argc     ? argv[++idx]
+                                               : "";
+      char *end = nullptr;
+      unsigned long jobs = std::strtoul(value, &end, 10);
+      if (*value == '\0' || *end != '\0' || jobs == 0) {
+        fmt::print(stderr, "Invalid job count: {}\n", value);
+        print_usage(argv[0]);
+        std::exit(1);
+      }
+      args.jobs = static_cast<unsigned>(jobs);
+      idx++;
+    } else if (std::strcmp(argv[idx], "--isolate") == 0) {
+      args.isolate = true;
+      idx++;
+    } else if (std::strncmp(argv[idx], "--timeout=", 10) == 0) {
+      const char *value = argv[idx] + 10;
+      char *end = nullptr;
+      double seconds = std::strtod(value, &end);
+      if (*value == '\0' || *end != '\0' || !(seconds > 0)) {
+        fmt::print(stderr, "Invalid timeout: {}\n", value);
+        print_usage(argv[0]);
+        std::exit(1);
+      }
+      args.timeout_ms =
+          std::max(1ULL, static_cast<unsigned long long>(seconds * 1000));
+      args.isolate = true;
+      idx++;
+    } else if (std::strncmp(argv[idx], "--junit=", 8) == 0) {
+      args.junit_report = argv[idx] + 8;
+      idx++;
+    } else if (std::strncmp(argv[idx], "--json=", 7) == 0) {
+      args.json_report = argv[idx] + 7;
+      idx++;
+    } else if (std::strncmp(argv[idx], "--slowest", 9) == 0 &&
+               (argv[idx][9] == '\0' || argv[idx][9] == '=')) {
+      const char *value = argv[idx][9] == '=' ? argv[idx] + 10
+                          : idx + 1 < argc    ? argv[++idx]
+                                              : "";
+      char *end = nullptr;
+      unsigned long count = std::strtoul(value, &end, 10);
+      if (*value == '\0' || *end != '\0' || count == 0) {
+        fmt::print(stderr, "Invalid test count: {}\n", value);
+        print_usage(argv[0]);
+        std::exit(1);
+      }
+      args.slowest = count;
+      idx++;
+    } else if (std::strcmp(argv[idx], "--no-cache") == 0) {
+      args.use_cache = false;
+      idx++;
+    } else if (std::strcmp(argv[idx], "--lto") == 0) {
+      args.cc.lto = true;
+      idx++;
+    } else if (std::strncmp(argv[idx], "--march=", 8) == 0) {
+      args.cc.march = argv[idx] + 8;
+      idx++;
     } else {
       fmt::print(stderr, "Unknown option: {}\n", argv[idx]);
       print_usage(argv[0]);
@@ -93,6 +230,36 @@ parsed_args_s parse_args(int argc, char **argv) {
     }
   }
 
+  bool cc_flags = !args.cc.compiler.empty() || !args.cc.optimization.empty() ||
+                  args.cc.lto || !args.cc.march.empty();
+  if (args.backend == tcc::backend_e::CC && !args.command.empty()) {
+    fmt::print(stderr, "--backend=cc only applies when compiling to an "
+                       "executable\n");
+    std::exit(1);
+  }
+  if (args.jobs && args.command != "test") {
+    fmt::print(stderr, "-j only applies to test\n");
+    std::exit(1);
+  }
+  bool reports = !args.junit_report.empty() || !args.json_report.empty() ||
+                 args.slowest > 0;
+  if (reports && args.command != "test") {
+    fmt::print(stderr, "--junit, --json and --slowest only apply to test\n");
+    std::exit(1);
+  }
+  if (args.isolate && args.command != "test") {
+    fmt::print(stderr, "--isolate and --timeout only apply to test\n");
+    std::exit(1);
+  }
+  if (!args.use_cache && args.command != "run" && args.command != "test") {
+    fmt::print(stderr, "--no-cache only applies to run and test\n");
+    std::exit(1);
+  }
+  if (cc_flags && args.backend != tcc::backend_e::CC) {
+    fmt::print(stderr, "--cc, -O, --lto and --march require --backend=cc\n");
+    std::exit(1);
+  }
+
   if (args.output_file.empty()) {
     if (args.command == "toc") {
       args.output_file = "output.c";
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <string>
+#include <truk/emitc/emitter.hpp>
+#include <truk/tcc/backend.hpp>
+#include <truk/tcc/cc.hpp>
 #include <vector>
 
 namespace truk::common {
@@ -14,6 +17,17 @@ struct parsed_args_s {
   std::vector<std::string> libraries;
   std::vector<std::string> rpaths;
   std::vector<std::string> program_args;
+  emitc::build_profile_e profile{emitc::build_profile_e::RELEASE};
+  emitc::alloc_tracking_e alloc_tracking{emitc::alloc_tracking_e::OFF};
+  tcc::backend_e backend{tcc::backend_e::TCC};
+  tcc::cc_options_s cc;
+  bool use_cache{true};
+  unsigned jobs{0};
+  bool isolate{false};
+  unsigned long long timeout_ms{0};
+  std::string junit_report;
+  std::string json_report;
+  std::size_t slowest{0};
 };
 
 parsed_args_s parse_args(int argc, char **argv);
@@ -0,0 +1,42 @@
+#include "backend.hpp"
+#include "profile.hpp"
+#include <truk/tcc/tcc.hpp>
+
+namespace truk::common {
+
+tcc::cc_options_s cc_options(emitc::build_profile_e profile,
+                             tcc::cc_options_s options) {
+  std::string level;
+  switch (profile) {
+  case emitc::build_profile_e::DEBUG:
+    level = "0";
+    options.extra_flags.insert(options.extra_flags.begin(), "-g");
+    break;
+  case emitc::build_profile_e::FAST:
+    level = "3";
+    options.extra_flags.insert(options.extra_flags.begin(), "-DNDEBUG");
+    break;
+  case emitc::build_profile_e::RELEASE:
+  default:
+    level = "2";
+    break;
+  }
+  if (options.optimization.empty()) {
+    options.optimization = level;
+  }
+  return options;
+}
+
+std::unique_ptr<tcc::backend_if> make_backend(tcc::backend_e backend,
+                                              const tcc::cc_options_s &cc,
+                                              emitc::build_profile_e profile) {
+  if (backend == tcc::backend_e::CC) {
+    return std::make_unique<tcc::cc_compiler_c>(cc_options(profile, cc));
+  }
+  auto compiler = std::make_unique<tcc::tcc_compiler_c>();
+  compiler->set_options(compiler_options(profile));
+  compiler->set_output_type(tcc::OUTPUT_EXE);
+  return compiler;
+}
+
+} // namespace truk::common
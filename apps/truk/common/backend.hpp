@@ -0,0 +1,21 @@
+#pragma once
+
+#include <memory>
+#include <truk/emitc/emitter.hpp>
+#include <truk/tcc/backend.hpp>
+#include <truk/tcc/cc.hpp>
+
+namespace truk::common {
+
+// cc backend flags for a build profile: -O0 -g for debug, -O2 for release and
+// -O3 -DNDEBUG for fast. Anything already set in options (from -O, --lto or
+// --march) is kept.
+tcc::cc_options_s cc_options(emitc::build_profile_e profile,
+                             tcc::cc_options_s options);
+
+// Executable-producing backend for `truk compile`, set up for the profile.
+std::unique_ptr<tcc::backend_if> make_backend(tcc::backend_e backend,
+                                              const tcc::cc_options_s &cc,
+                                              emitc::build_profile_e profile);
+
+} // namespace truk::common
@@ -0,0 +1,359 @@
+#include "cache.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fmt/core.h>
+#include <fstream>
+#include <set>
+#include <spawn.h>
+#include <sstream>
+#include <sys/wait.h>
+#include <truk/core/core.hpp>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace fs = std::filesystem;
+
+namespace truk::common {
+
+namespace {
+
+// Two FNV-1a lanes from different offsets, 128 bits in all. Every field is
+// preceded by its length so concatenations cannot collide.
+class hasher_c {
+public:
+  hasher_c &add(const std::string &data) {
+    std::uint64_t len = data.size();
+    mix(reinterpret_cast<const unsigned char *>(&len), sizeof(len));
+    mix(reinterpret_cast<const unsigned char *>(data.data()), data.size());
+    return *this;
+  }
+
+  std::string hex() const { return fmt::format("{:016x}{:016x}", _a, _b); }
+
+private:
+  void mix(const unsigned char *p, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+      _a = (_a ^ p[i]) * 0x100000001b3ULL;
+      _b = (_b ^ p[i]) * 0x100000001b3ULL;
+    }
+  }
+
+  std::uint64_t _a = 0xcbf29ce484222325ULL;
+  std::uint64_t _b = 0x84222325cbf29ce4ULL;
+};
+
+std::optional<std::string> read_whole(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return std::nullopt;
+  }
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+std::optional<std::string> content_hash(const std::string &path) {
+  auto data = read_whole(path);
+  if (!data) {
+    return std::nullopt;
+  }
+  return hasher_c().add(*data).hex();
+}
+
+std::string cache_root() {
+  if (const char *dir = std::getenv("TRUK_CACHE_DIR"); dir && *dir) {
+    return dir;
+  }
+  if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+    return std::string(xdg) + "/truk";
+  }
+  if (const char *home = std::getenv("HOME"); home && *home) {
+    return std::string(home) + "/.cache/truk";
+  }
+  return "";
+}
+
+// The configure-time build hash does not change with local edits, so the
+// binary's own size and modification time are part of its identity too.
+std::string compiler_identity() {
+  std::string identity = core::core_c().get_build_hash();
+  std::error_code ec;
+  fs::path self = fs::read_symlink("/proc/self/exe", ec);
+  if (!ec) {
+    auto size = fs::file_size(self, ec);
+    auto mtime = fs::last_write_time(self, ec);
+    if (!ec) {
+      identity += fmt::format(
+          ":{}:{}", size,
+          static_cast<long long>(mtime.time_since_epoch().count()));
+    }
+  }
+  return identity;
+}
+
+// Writes data next to path and renames it into place.
+bool write_atomically(const std::string &path, const std::string &data) {
+  std::string tmp = fmt::format("{}.tmp{}", path, ::getpid());
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out << data;
+    if (!out) {
+      std::remove(tmp.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+void evict(const fs::path &objects) {
+  std::error_code ec;
+  std::vector<std::pair<fs::file_time_type, fs::path>> entries;
+  for (const auto &entry : fs::directory_iterator(objects, ec)) {
+    if (entry.path().extension().empty() && entry.is_regular_file(ec)) {
+      entries.emplace_back(entry.last_write_time(ec), entry.path());
+    }
+  }
+  if (entries.size() <= compile_cache_c::max_entries) {
+    return;
+  }
+  std::sort(entries.begin(), entries.end());
+  std::size_t excess = entries.size() - compile_cache_c::max_entries;
+  for (std::size_t i = 0; i < excess; i++) {
+    fs::remove(entries[i].second, ec);
+    fs::path source = entries[i].second;
+    source += ".c";
+    fs::remove(source, ec);
+  }
+}
+
+} // namespace
+
+compile_cache_c::compile_cache_c(const std::string &kind,
+                                 const std::string &input_file,
+                                 const std::vector<std::string> &settings) {
+  std::string root = cache_root();
+  if (root.empty()) {
+    return;
+  }
+  std::error_code ec;
+  fs::create_directories(fs::path(root) / "manifests", ec);
+  fs::create_directories(fs::path(root) / "objects", ec);
+  if (ec) {
+    return;
+  }
+  _dir = root;
+
+  hasher_c key;
+  key.add(kind).add(compiler_identity());
+  key.add(fs::weakly_canonical(input_file, ec).string());
+  key.add(fs::current_path(ec).string());
+  for (const auto &setting : settings) {
+    key.add(setting);
+  }
+  _manifest_key = key.hex();
+}
+
+std::optional<std::string> compile_cache_c::lookup() {
+  if (!enabled()) {
+    return std::nullopt;
+  }
+  auto manifest = read_whole(_dir + "/manifests/" + _manifest_key);
+  if (!manifest) {
+    return std::nullopt;
+  }
+
+  std::istringstream lines(*manifest);
+  std::string object;
+  if (!std::getline(lines, object) || object.empty()) {
+    return std::nullopt;
+  }
+  std::string line;
+  while (std::getline(lines, line)) {
+    auto space = line.find(' ');
+    if (space == std::string::npos) {
+      return std::nullopt;
+    }
+    auto hash = content_hash(line.substr(space + 1));
+    if (!hash || *hash != line.substr(0, space)) {
+      return std::nullopt;
+    }
+  }
+
+  std::string path = _dir + "/objects/" + object;
+  if (::access(path.c_str(), X_OK) != 0) {
+    return std::nullopt;
+  }
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+  return path;
+}
+
+std::string compile_cache_c::scratch_path() const {
+  return fmt::format("{}/objects/build-{}-{}", _dir, _manifest_key, ::getpid());
+}
+
+std::optional<std::string>
+compile_cache_c::store(const std::vector<std::string> &sources,
+                       const std::string &c_source,
+                       const std::string &executable) {
+  if (!enabled()) {
+    return std::nullopt;
+  }
+
+  std::string listing;
+  hasher_c object_key;
+  object_key.add(_manifest_key);
+  for (const auto &source : sources) {
+    auto hash = content_hash(source);
+    if (!hash) {
+      return std::nullopt;
+    }
+    listing += *hash + " " + source + "\n";
+    object_key.add(*hash).add(source);
+  }
+
+  std::string object = object_key.hex();
+  std::string path = _dir + "/objects/" + object;
+  if (!write_atomically(path + ".c", c_source) ||
+      std::rename(executable.c_str(), path.c_str()) != 0) {
+    return std::nullopt;
+  }
+  write_atomically(_dir + "/manifests/" + _manifest_key,
+                   object + "\n" + listing);
+  evict(fs::path(_dir) / "objects");
+  return path;
+}
+
+std::optional<std::vector<std::string>>
+build_sources(const ingestion::resolved_imports_s &resolved,
+              const std::vector<std::string> &include_paths,
+              const std::vector<std::string> &library_paths,
+              const std::vector<std::string> &libraries) {
+  std::vector<std::string> sources = resolved.source_files;
+  std::set<std::string> seen;
+  std::vector<fs::path> pending;
+  std::error_code ec;
+
+  // Quoted names are looked up next to the including file first (the
+  // working directory for a cimport), then along the include paths; angle
+  // names only along the include paths. Anything else is a system header.
+  auto resolve = [&](const std::string &name, bool quoted,
+                     const fs::path &from) {
+    std::vector<fs::path> candidates;
+    if (quoted) {
+      candidates.push_back(from / name);
+    }
+    for (const auto &dir : include_paths) {
+      candidates.push_back(fs::path(dir) / name);
+    }
+    for (const auto &candidate : candidates) {
+      if (fs::is_regular_file(candidate, ec)) {
+        std::string path = fs::weakly_canonical(candidate, ec).string();
+        if (seen.insert(path).second) {
+          sources.push_back(path);
+          pending.push_back(path);
+        }
+        return;
+      }
+    }
+  };
+
+  for (const auto &c_import : resolved.c_imports) {
+    resolve(c_import.path, !c_import.is_angle_bracket, fs::path("."));
+  }
+
+  // Every #include of every tracked header is followed, whether or not a
+  // conditional would skip it, so the set can only be too large.
+  while (!pending.empty()) {
+    fs::path header = pending.back();
+    pending.pop_back();
+    std::ifstream in(header);
+    std::string line;
+    while (std::getline(in, line)) {
+      std::size_t at = line.find_first_not_of(" \t");
+      if (at == std::string::npos || line[at] != '#') {
+        continue;
+      }
+      at = line.find_first_not_of(" \t", at + 1);
+      if (at == std::string::npos || line.compare(at, 7, "include") != 0) {
+        continue;
+      }
+      at += line.compare(at, 12, "include_next") == 0 ? 12 : 7;
+      at = line.find_first_not_of(" \t", at);
+      if (at == std::string::npos) {
+        continue;
+      }
+      char open = line[at];
+      std::size_t close = line.find(open == '"' ? '"' : '>', at + 1);
+      if ((open != '"' && open != '<') || close == std::string::npos) {
+        // A computed include could name any file.
+        return std::nullopt;
+      }
+      resolve(line.substr(at + 1, close - at - 1), open == '"',
+              header.parent_path());
+    }
+  }
+
+  // The first libNAME.so or libNAME.a along the library paths, which is what
+  // the linker picks; libraries found only in system directories are not
+  // tracked.
+  for (const auto &lib : libraries) {
+    for (const auto &dir : library_paths) {
+      fs::path shared = fs::path(dir) / ("lib" + lib + ".so");
+      fs::path archive = fs::path(dir) / ("lib" + lib + ".a");
+      fs::path found = fs::is_regular_file(shared, ec)    ? shared
+                       : fs::is_regular_file(archive, ec) ? archive
+                                                          : fs::path();
+      if (!found.empty()) {
+        sources.push_back(fs::weakly_canonical(found, ec).string());
+        break;
+      }
+    }
+  }
+  return sources;
+}
+
+int run_executable(const std::string &path,
+                   const std::vector<std::string> &argv) {
+  std::vector<char *> args;
+  args.reserve(argv.size() + 1);
+  for (const auto &arg : argv) {
+    args.push_back(const_cast<char *>(arg.c_str()));
+  }
+  args.push_back(nullptr);
+
+  std::fflush(stdout);
+  std::fflush(stderr);
+
+  pid_t pid;
+  int err = ::posix_spawn(&pid, path.c_str(), nullptr, nullptr, args.data(),
+                          environ);
+  if (err != 0) {
+    fmt::print(stderr, "Error: could not run {}: {}\n", path,
+               std::strerror(err));
+    return 1;
+  }
+
+  int status = 0;
+  while (::waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      return 1;
+    }
+  }
+  if (WIFSIGNALED(status)) {
+    return 128 + WTERMSIG(status);
+  }
+  return WEXITSTATUS(status);
+}
+
+} // namespace truk::common
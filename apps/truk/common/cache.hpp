@@ -0,0 +1,82 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <truk/emitc/emitter.hpp>
+#include <truk/ingestion/import_resolver.hpp>
+#include <vector>
+
+namespace truk::common {
+
+// On-disk cache of the executables `truk run` and `truk test` build, so an
+// unchanged program skips resolution, checking, emission and TCC entirely.
+//
+// Entries live in $TRUK_CACHE_DIR, else $XDG_CACHE_HOME/truk, else
+// ~/.cache/truk. A manifest, keyed by the input path, the build settings and
+// the truk binary itself, lists the content hash of every .truk file, C
+// header and library the last build read (see build_sources); when all of
+// them still match, the executable it names is reused. System headers and
+// libraries are not tracked. Writes go through rename so concurrent runs
+// never see a partial entry, and the least recently used executables are
+// evicted past max_entries.
+class compile_cache_c {
+public:
+  static constexpr std::size_t max_entries = 512;
+
+  // kind separates run from test builds of the same file; settings is every
+  // option that changes the build (profile, paths, libraries, ...).
+  compile_cache_c(const std::string &kind, const std::string &input_file,
+                  const std::vector<std::string> &settings);
+
+  // False when there is no usable cache directory.
+  bool enabled() const { return !_dir.empty(); }
+
+  // The cached executable, if every source it was built from is unchanged.
+  std::optional<std::string> lookup();
+
+  // Where the compiler should write the executable that store() takes.
+  std::string scratch_path() const;
+
+  // Moves executable into the cache along with its C source and records the
+  // files it was built from. Returns the cached executable's path, or nullopt
+  // if the entry could not be written (the executable is then left alone).
+  std::optional<std::string> store(const std::vector<std::string> &sources,
+                                   const std::string &c_source,
+                                   const std::string &executable);
+
+private:
+  std::string _dir;
+  std::string _manifest_key;
+};
+
+// Options that key a cache entry, from run or test options.
+template <typename Options>
+std::vector<std::string> cache_settings(const Options &opts) {
+  std::vector<std::string> settings = {
+      emitc::build_profile_name(opts.profile),
+      std::to_string(static_cast<int>(opts.alloc_tracking))};
+  for (const auto *list : {&opts.include_paths, &opts.library_paths,
+                           &opts.libraries, &opts.rpaths}) {
+    settings.push_back(std::to_string(list->size()));
+    settings.insert(settings.end(), list->begin(), list->end());
+  }
+  return settings;
+}
+
+// Files a build read: every resolved .truk file, the C headers its cimports
+// pull in from the working directory or an include path (followed through
+// their own #includes), and the libraries found along the library paths.
+// nullopt when a header uses a computed #include, so the build cannot be
+// cached.
+std::optional<std::vector<std::string>>
+build_sources(const ingestion::resolved_imports_s &resolved,
+              const std::vector<std::string> &include_paths,
+              const std::vector<std::string> &library_paths,
+              const std::vector<std::string> &libraries);
+
+// Runs an executable with the given argv (argv[0] included), waits for it
+// and returns its exit status, or 128 + the signal that killed it.
+int run_executable(const std::string &path,
+                   const std::vector<std::string> &argv);
+
+} // namespace truk::common
@@ -0,0 +1,17 @@
+#include "profile.hpp"
+
+namespace truk::common {
+
+std::string compiler_options(emitc::build_profile_e profile) {
+  switch (profile) {
+  case emitc::build_profile_e::DEBUG:
+    return "-g";
+  case emitc::build_profile_e::FAST:
+    return "-O2 -DNDEBUG";
+  case emitc::build_profile_e::RELEASE:
+  default:
+    return "-O2";
+  }
+}
+
+} // namespace truk::common
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <truk/emitc/emitter.hpp>
+
+namespace truk::common {
+
+// TCC options that go with a build profile: debug info for debug, the
+// optimizer for release and fast, and NDEBUG for fast so asserts in imported
+// C code go away along with the bounds checks.
+std::string compiler_options(emitc::build_profile_e profile);
+
+} // namespace truk::common
@@ -0,0 +1,235 @@
+#include "test_report.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fmt/core.h>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace truk::common {
+
+namespace {
+
+std::string xml_escape(const std::string &text) {
+  std::string out;
+  out.reserve(text.size());
+  for (char c : text) {
+    switch (c) {
+    case '&':
+      out += "&amp;";
+      break;
+    case '<':
+      out += "&lt;";
+      break;
+    case '>':
+      out += "&gt;";
+      break;
+    case '"':
+      out += "&quot;";
+      break;
+    case '\'':
+      out += "&apos;";
+      break;
+    default:
+      out += c;
+    }
+  }
+  return out;
+}
+
+std::string json_string(const std::string &text) {
+  std::string out = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out += fmt::format("\\u{:04x}", static_cast<unsigned>(c));
+    } else {
+      out += c;
+    }
+  }
+  return out + "\"";
+}
+
+double seconds(std::uint64_t ns) { return static_cast<double>(ns) / 1e9; }
+
+double millis(std::uint64_t ns) { return static_cast<double>(ns) / 1e6; }
+
+bool is_error(const test_record_s &record) {
+  return record.status != "passed" && record.status != "failed";
+}
+
+struct totals_s {
+  std::size_t tests{0};
+  std::size_t failures{0};
+  std::size_t errors{0};
+  std::uint64_t wall_ns{0};
+  std::uint64_t cpu_ns{0};
+};
+
+totals_s totals_of(std::vector<test_record_s>::const_iterator begin,
+                   std::vector<test_record_s>::const_iterator end) {
+  totals_s totals;
+  for (auto it = begin; it != end; ++it) {
+    totals.tests++;
+    if (is_error(*it)) {
+      totals.errors++;
+    } else if (!it->ok()) {
+      totals.failures++;
+    }
+    totals.wall_ns += it->wall_ns;
+    totals.cpu_ns += it->cpu_ns;
+  }
+  return totals;
+}
+
+} // namespace
+
+std::string make_test_record_file() {
+  const char *tmpdir = std::getenv("TMPDIR");
+  std::string pattern =
+      std::string(tmpdir && *tmpdir ? tmpdir : "/tmp") + "/truk-tests-XXXXXX";
+  int fd = ::mkstemp(pattern.data());
+  if (fd < 0) {
+    return "";
+  }
+  ::close(fd);
+  return pattern;
+}
+
+std::vector<test_record_s> take_test_records(const std::string &record_file,
+                                             const std::string &file) {
+  std::vector<test_record_s> records;
+  std::ifstream in(record_file);
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string status, name, passed, failed, wall, cpu;
+    if (!std::getline(fields, status, '\t') ||
+        !std::getline(fields, name, '\t') ||
+        !std::getline(fields, passed, '\t') ||
+        !std::getline(fields, failed, '\t') ||
+        !std::getline(fields, wall, '\t') || !std::getline(fields, cpu)) {
+      continue;
+    }
+    test_record_s record;
+    record.file = file;
+    record.name = name;
+    record.status = status;
+    record.passed = std::atoi(passed.c_str());
+    record.failed = std::atoi(failed.c_str());
+    record.wall_ns = std::strtoull(wall.c_str(), nullptr, 10);
+    record.cpu_ns = std::strtoull(cpu.c_str(), nullptr, 10);
+    records.push_back(std::move(record));
+  }
+  in.close();
+  std::remove(record_file.c_str());
+  return records;
+}
+
+bool write_junit_report(const std::string &path,
+                        const std::vector<test_record_s> &records) {
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) {
+    return false;
+  }
+
+  auto all = totals_of(records.begin(), records.end());
+  out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+  out << fmt::format("<testsuites name=\"truk test\" tests=\"{}\" "
+                     "failures=\"{}\" errors=\"{}\" time=\"{:.6f}\">\n",
+                     all.tests, all.failures, all.errors, seconds(all.wall_ns));
+
+  auto begin = records.begin();
+  while (begin != records.end()) {
+    auto end = std::find_if(begin, records.end(), [&](const auto &record) {
+      return record.file != begin->file;
+    });
+    auto suite = totals_of(begin, end);
+    std::string file = xml_escape(begin->file);
+    out << fmt::format("  <testsuite name=\"{}\" tests=\"{}\" failures=\"{}\" "
+                       "errors=\"{}\" time=\"{:.6f}\">\n",
+                       file, suite.tests, suite.failures, suite.errors,
+                       seconds(suite.wall_ns));
+    for (auto it = begin; it != end; ++it) {
+      out << fmt::format("    <testcase name=\"{}\" classname=\"{}\" "
+                         "time=\"{:.6f}\"",
+                         xml_escape(it->name), file, seconds(it->wall_ns));
+      if (it->ok()) {
+        out << "/>\n";
+        continue;
+      }
+      out << ">\n";
+      if (is_error(*it)) {
+        out << fmt::format("      <error message=\"{}\" type=\"{}\"/>\n",
+                           xml_escape(it->status), xml_escape(it->status));
+      } else {
+        out << fmt::format(
+            "      <failure message=\"{} of {} assertions failed\" "
+            "type=\"assertion\"/>\n",
+            it->failed, it->failed + it->passed);
+      }
+      out << "    </testcase>\n";
+    }
+    out << "  </testsuite>\n";
+    begin = end;
+  }
+  out << "</testsuites>\n";
+  return static_cast<bool>(out);
+}
+
+bool write_json_report(const std::string &path,
+                       const std::vector<test_record_s> &records) {
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) {
+    return false;
+  }
+
+  auto all = totals_of(records.begin(), records.end());
+  out << "{\n";
+  out << fmt::format("  \"summary\": {{\"tests\": {}, \"passed\": {}, "
+                     "\"failed\": {}, \"errors\": {}, \"wall_ms\": {:.3f}, "
+                     "\"cpu_ms\": {:.3f}}},\n",
+                     all.tests, all.tests - all.failures - all.errors,
+                     all.failures, all.errors, millis(all.wall_ns),
+                     millis(all.cpu_ns));
+  out << "  \"tests\": [";
+  for (std::size_t i = 0; i < records.size(); i++) {
+    const auto &record = records[i];
+    out << (i ? ",\n" : "\n");
+    out << fmt::format("    {{\"file\": {}, \"name\": {}, \"status\": {}, "
+                       "\"assertions\": {{\"passed\": {}, \"failed\": {}}}, "
+                       "\"wall_ms\": {:.3f}, \"cpu_ms\": {:.3f}}}",
+                       json_string(record.file), json_string(record.name),
+                       json_string(record.status), record.passed,
+                       record.failed, millis(record.wall_ns),
+                       millis(record.cpu_ns));
+  }
+  out << (records.empty() ? "]\n" : "\n  ]\n");
+  out << "}\n";
+  return static_cast<bool>(out);
+}
+
+void print_slowest_tests(const std::vector<test_record_s> &records,
+                         std::size_t count) {
+  std::vector<const test_record_s *> sorted;
+  sorted.reserve(records.size());
+  for (const auto &record : records) {
+    sorted.push_back(&record);
+  }
+  std::stable_sort(sorted.begin(), sorted.end(), [](auto *a, auto *b) {
+    return a->wall_ns > b->wall_ns;
+  });
+  sorted.resize(std::min(count, sorted.size()));
+
+  fmt::print("\nSlowest {} test(s):\n", sorted.size());
+  for (const auto *record : sorted) {
+    fmt::print("  {:>10.2f} ms wall  {:>10.2f} ms cpu  {}: {}{}\n",
+               millis(record->wall_ns), millis(record->cpu_ns), record->file,
+               record->name, record->ok() ? "" : " (" + record->status + ")");
+  }
+}
+
+} // namespace truk::common
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace truk::common {
+
+// One test as the runner recorded it (see __truk_test_record in the sxs
+// runtime), tagged with the file it came from.
+struct test_record_s {
+  std::string file;
+  std::string name;
+  // passed, failed, crashed or timeout; error, under the name "(file)", for
+  // a file whose runner did not finish, e.g. because it did not compile.
+  std::string status;
+  int passed{0};
+  int failed{0};
+  std::uint64_t wall_ns{0};
+  std::uint64_t cpu_ns{0};
+
+  bool ok() const { return status == "passed"; }
+};
+
+// A temporary file for a runner to record into, or "" if none could be made.
+std::string make_test_record_file();
+
+// Reads and removes a record file, attributing its tests to file.
+std::vector<test_record_s> take_test_records(const std::string &record_file,
+                                             const std::string &file);
+
+// JUnit XML, one <testsuite> per file. Returns false if path is unwritable.
+bool write_junit_report(const std::string &path,
+                        const std::vector<test_record_s> &records);
+
+// JSON: every test with its counts and times, and the totals.
+bool write_json_report(const std::string &path,
+                       const std::vector<test_record_s> &records);
+
+// Prints the count tests with the longest wall time.
+void print_slowest_tests(const std::vector<test_record_s> &records,
+                         std::size_t count);
+
+} // namespace truk::common
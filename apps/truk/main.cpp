@@ -10,19 +10,25 @@ int main(int argc, char **argv) {
 
   if (args.command == "toc") {
     return truk::commands::toc(
-        {args.input_file, args.output_file, args.include_paths});
+        {args.input_file, args.output_file, args.include_paths, args.profile,
+         args.alloc_tracking});
   } else if (args.command == "tcc") {
     return truk::commands::tcc({args.input_file, args.output_file,
                                 args.include_paths, args.library_paths,
-                                args.libraries, args.rpaths});
+                                args.libraries, args.rpaths, args.profile});
   } else if (args.command == "run") {
     return truk::commands::run(
         {args.input_file, std::nullopt, args.include_paths, args.library_paths,
-         args.libraries, args.rpaths, args.program_args});
+         args.libraries, args.rpaths, args.program_args, args.profile,
+         args.alloc_tracking, args.backend, args.cc, args.use_cache});
   } else if (args.command == "test") {
     return truk::commands::test({args.input_file, args.include_paths,
                                  args.library_paths, args.libraries,
-                                 args.rpaths, args.program_args});
+                                 args.rpaths, args.program_args,
+                                 args.profile, args.alloc_tracking,
+                                 args.use_cache, args.jobs, args.isolate,
+                                 args.timeout_ms, args.junit_report,
+                                 args.json_report, args.slowest});
   } else {
     return truk::commands::compile({args.input_file,
                                     args.output_file,
@@ -30,6 +36,11 @@ int main(int argc, char **argv) {
                                     args.library_paths,
                                     args.libraries,
                                     args.rpaths,
-                                    {}});
+                                    {},
+                                    args.profile,
+                                    args.alloc_tracking,
+                                    args.backend,
+                                    args.cc,
+                                    args.use_cache});
   }
 }
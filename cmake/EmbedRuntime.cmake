@@ -2,12 +2,24 @@ function(get_sxs_runtime_files out_var)
     set(SXS_FILES
         "include/sxs/types.h"
         "include/sxs/runtime.h"
+        "include/sxs/alloc.h"
+        "include/sxs/bytes.h"
         "include/sxs/sxs.h"
         "include/sxs/ds/map.h"
+        "include/sxs/ds/ordered_map.h"
+        "include/sxs/ds/concurrent_map.h"
+        "include/sxs/ds/scanner.h"
         "include/sxs/test.h"
         "src/runtime.c"
+        "src/alloc.c"
+        "src/bytes.c"
         "src/ds/map.c"
+        "src/ds/ordered_map.c"
+        "src/ds/concurrent_map.c"
+        "src/ds/scanner.c"
+        "src/track.c"
         "src/test.c"
+        "src/test_runner.c"
     )
     set(${out_var} ${SXS_FILES} PARENT_SCOPE)
 endfunction()
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "embedded_runtime.hpp"
+#include <cctype>
 #include <fmt/core.h>
 #include <sstream>
 #include <string>
@@ -17,7 +18,11 @@ inline std::string strip_pragma_and_includes(const std::string &content) {
     if (line.find("#pragma once") != std::string::npos) {
       continue;
     }
-    if (line.find("#include") != std::string::npos) {
+    // Only unindented includes are dropped; the emitted prelude provides the
+    // system headers. Ones spelled "#  include" sit inside a platform
+    // conditional (e.g. SIMD intrinsics or malloc introspection) and must
+    // survive.
+    if (line.rfind("#include", 0) == 0) {
       continue;
     }
     if (line.empty() && !had_content) {
@@ -39,7 +44,8 @@ inline std::string emit_system_includes() {
   ss << "#include <stdlib.h>\n";
   ss << "#include <stdio.h>\n";
   ss << "#include <string.h>\n";
-  ss << "#include <stdarg.h>\n\n";
+  ss << "#include <stdarg.h>\n";
+  ss << "#include <pthread.h>\n\n";
   return ss.str();
 }
 
@@ -61,6 +67,66 @@ inline std::string emit_runtime_declarations() {
   return ss.str();
 }
 
+// Records the build profile in the generated C: as macros for the code
+// itself, and as a string kept in the binary so `strings` can tell how it was
+// built.
+inline std::string emit_build_profile(const std::string &profile) {
+  std::string upper = profile;
+  for (auto &c : upper) {
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  }
+  std::stringstream ss;
+  ss << "/* truk build profile: " << profile << " */\n";
+  ss << "#define TRUK_PROFILE \"" << profile << "\"\n";
+  ss << "#define TRUK_PROFILE_" << upper << " 1\n";
+  ss << "__attribute__((used)) static const char __truk_build_profile[] = "
+        "\"truk-build-profile: "
+     << profile << "\";\n\n";
+  return ss.str();
+}
+
+// Switches the runtime's allocation tracking on before runtime.h is emitted;
+// sample_bytes is the sampling period, or 0 to record every allocation.
+inline std::string emit_alloc_tracking(unsigned long long sample_bytes) {
+  std::stringstream ss;
+  ss << "#define TRUK_TRACK_ALLOCS 1\n";
+  if (sample_bytes) {
+    ss << "#define TRUK_TRACK_ALLOCS_SAMPLE " << sample_bytes << "ULL\n";
+  }
+  ss << "#include <signal.h>\n";
+  ss << "#include <unistd.h>\n\n";
+  return ss.str();
+}
+
+// The forking test runner and the POSIX headers it needs. Only isolated test
+// builds carry it, so ordinary programs keep their namespace free of fork,
+// pipe, kill and the like.
+inline std::string emit_isolated_test_runner() {
+  std::stringstream ss;
+  ss << "#include <errno.h>\n";
+  ss << "#include <poll.h>\n";
+  ss << "#include <signal.h>\n";
+  ss << "#include <sys/resource.h>\n";
+  ss << "#include <sys/wait.h>\n";
+  ss << "#include <unistd.h>\n\n";
+  if (embedded::runtime_files.count("src/test_runner.c")) {
+    ss << strip_pragma_and_includes(
+        embedded::runtime_files.at("src/test_runner.c").content);
+  }
+  return ss.str();
+}
+
+inline std::string emit_string_literal(const std::string &text) {
+  std::string out = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+    }
+    out += c;
+  }
+  return out + "\"";
+}
+
 inline std::string emit_runtime_macros() {
   std::stringstream ss;
   ss << "#define TRUK_PANIC(msg, len) __truk_runtime_sxs_panic((msg), (len))\n";
@@ -121,21 +187,92 @@ inline std::string emit_slice_typedef(const std::string &element_type,
       element_type, slice_name);
 }
 
-inline std::string emit_builtin_make(const std::string &type_str) {
-  return fmt::format("({0}*)__truk_runtime_sxs_alloc(sizeof({0}))", type_str);
+inline std::string emit_vec_typedef(const std::string &data_member,
+                                    const std::string &vec_name) {
+  return fmt::format("typedef struct {{\n  {};\n  __truk_u64 len;\n  "
+                     "__truk_u64 cap;\n}} {};\n\n",
+                     data_member, vec_name);
+}
+
+// With a site (allocation tracking on) make allocates through
+// __truk_runtime_sxs_alloc_at so the runtime can attribute the memory.
+inline std::string emit_builtin_make(const std::string &type_str,
+                                     const std::string &site = "") {
+  if (!site.empty()) {
+    return fmt::format("({0}*)__truk_runtime_sxs_alloc_at(__truk_runtime_sxs_"
+                       "current_allocator(), sizeof({0}), {1})",
+                       type_str, site);
+  }
+  return fmt::format("({0}*)__truk_runtime_sxs_alloc_object(sizeof({0}))",
+                     type_str);
 }
 
 inline std::string
 emit_builtin_make_array(const std::string &cast_type,
                         const std::string &elem_type_for_sizeof,
-                        const std::string &count_expr) {
+                        const std::string &count_expr,
+                        const std::string &site = "") {
+  if (!site.empty()) {
+    return fmt::format("{{({0})__truk_runtime_sxs_alloc_at(__truk_runtime_sxs_"
+                       "current_allocator(), sizeof({1}) * ({2}), {3}), ({2})}}",
+                       cast_type, elem_type_for_sizeof, count_expr, site);
+  }
   return fmt::format(
       "{{({0})__truk_runtime_sxs_alloc_array(sizeof({1}), ({2})), ({2})}}",
       cast_type, elem_type_for_sizeof, count_expr);
 }
 
+inline std::string emit_builtin_make_in(const std::string &type_str,
+                                        const std::string &allocator_expr,
+                                        const std::string &site = "") {
+  if (!site.empty()) {
+    return fmt::format("({0}*)__truk_runtime_sxs_alloc_at((__truk_allocator_t "
+                       "*)({1}), sizeof({0}), {2})",
+                       type_str, allocator_expr, site);
+  }
+  return fmt::format("({0}*)__truk_runtime_sxs_alloc_with((__truk_allocator_t "
+                     "*)({1}), sizeof({0}))",
+                     type_str, allocator_expr);
+}
+
+inline std::string
+emit_builtin_make_array_in(const std::string &cast_type,
+                           const std::string &elem_type_for_sizeof,
+                           const std::string &count_expr,
+                           const std::string &allocator_expr,
+                           const std::string &site = "") {
+  if (!site.empty()) {
+    return fmt::format("{{({0})__truk_runtime_sxs_alloc_at((__truk_allocator_t "
+                       "*)({3}), sizeof({1}) * ({2}), {4}), ({2})}}",
+                       cast_type, elem_type_for_sizeof, count_expr,
+                       allocator_expr, site);
+  }
+  return fmt::format("{{({0})__truk_runtime_sxs_alloc_array_with((__truk_"
+                     "allocator_t *)({3}), sizeof({1}), ({2})), ({2})}}",
+                     cast_type, elem_type_for_sizeof, count_expr,
+                     allocator_expr);
+}
+
+inline std::string emit_builtin_delete_in(const std::string &ptr_expr,
+                                          const std::string &allocator_expr) {
+  return fmt::format(
+      "__truk_runtime_sxs_free_with((__truk_allocator_t *)({1}), {0})",
+      ptr_expr, allocator_expr);
+}
+
+inline std::string
+emit_builtin_delete_array_in(const std::string &arr_expr,
+                             const std::string &allocator_expr) {
+  return fmt::format(
+      "__truk_runtime_sxs_free_with((__truk_allocator_t *)({1}), ({0}).data)",
+      arr_expr, allocator_expr);
+}
+
+// The pointee size picks the runtime's object cache class; sizeof does not
+// evaluate its operand, so ptr_expr still runs once.
 inline std::string emit_builtin_delete(const std::string &ptr_expr) {
-  return fmt::format("__truk_runtime_sxs_free({})", ptr_expr);
+  return fmt::format("__truk_runtime_sxs_free_object({0}, sizeof(*({0})))",
+                     ptr_expr);
 }
 
 inline std::string emit_builtin_delete_array(const std::string &arr_expr) {
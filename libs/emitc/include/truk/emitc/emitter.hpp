@@ -9,6 +9,7 @@
 #include <truk/emitc/variable_registry.hpp>
 
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <unordered_map>
@@ -36,6 +37,25 @@ enum class emission_phase_e {
 
 const char *emission_phase_name(emission_phase_e phase);
 
+// How much runtime safety code the emitted C carries. DEBUG bounds-checks
+// every slice access, RELEASE leaves out the checks proven unnecessary or
+// hoisted out of loops (see set_unchecked_indices and set_hoisted_checks), and
+// FAST additionally drops every check inside an `unchecked { }` block.
+enum class build_profile_e { DEBUG, RELEASE, FAST };
+
+const char *build_profile_name(build_profile_e profile);
+std::optional<build_profile_e> build_profile_from_name(const std::string &name);
+
+// Allocation tracking compiled into the program (truk --track-allocs). FULL
+// records every make by source line; SAMPLED records about one allocation per
+// alloc_track_sample_bytes and scales the counts, cheap enough to leave on.
+enum class alloc_tracking_e { OFF, FULL, SAMPLED };
+
+inline constexpr unsigned long long alloc_track_sample_bytes = 512 * 1024;
+
+std::optional<alloc_tracking_e>
+alloc_tracking_from_name(const std::string &name);
+
 struct defer_scope_s {
   enum class scope_type_e { FUNCTION, LAMBDA, BLOCK, LOOP };
 
@@ -49,6 +69,16 @@ struct defer_scope_s {
       : type(t), owner_node(owner), parent(p) {}
 };
 
+// A map key as the runtime takes it: a pointer (ref) to a key that decl, if
+// not empty, declares first. block_ref points to the same key without needing
+// a declaration, through a compound literal where one is required, so it
+// stays valid to the end of the enclosing C block.
+struct map_key_s {
+  std::string decl;
+  std::string ref;
+  std::string block_ref;
+};
+
 struct error_s {
   std::string message;
   const truk::language::nodes::base_c *node;
@@ -93,6 +123,19 @@ struct assembly_result_s {
         header_name(std::move(hdr_name)) {}
 };
 
+// How the test runner assembled by result_c::assemble_test_runner runs a
+// file's tests. By default main calls each one in turn in a single process;
+// isolated, every test is forked into its own process so a crash or a hang
+// only fails that test, and up to jobs of them run at once.
+struct test_runner_options_s {
+  bool isolate{false};
+  // Tests run at once when isolated; 0 means one per available core.
+  unsigned jobs{0};
+  // Per-test limit when isolated; a test still running is killed and fails.
+  // 0 means no limit.
+  unsigned long long timeout_ms{0};
+};
+
 struct result_c {
   std::vector<error_s> errors;
   std::vector<std::string> chunks;
@@ -102,7 +145,8 @@ struct result_c {
   std::string assemble_code() const;
   assembly_result_s assemble(assembly_type_e type,
                              const std::string &header_name = "") const;
-  std::string assemble_test_runner() const;
+  std::string
+  assemble_test_runner(const test_runner_options_s &options = {}) const;
 };
 
 class emitter_c : public truk::language::nodes::visitor_if {
@@ -114,6 +158,12 @@ class emitter_c : public truk::language::nodes::visitor_if {
   friend class panic_builtin_handler_c;
   friend class each_builtin_handler_c;
   friend class va_arg_builtin_handler_c;
+  friend class map_capacity_builtin_handler_c;
+  friend class map_get_or_insert_builtin_handler_c;
+  friend class vec_builtin_handler_c;
+  friend class bytes_builtin_handler_c;
+  friend class scan_builtin_handler_c;
+  friend class allocator_builtin_handler_c;
   friend class expression_visitor_c;
 
 public:
@@ -136,6 +186,42 @@ public:
     _file_to_shards = map;
     return *this;
   }
+  emitter_c &set_build_profile(build_profile_e profile) {
+    _build_profile = profile;
+    return *this;
+  }
+  emitter_c &set_alloc_tracking(alloc_tracking_e tracking) {
+    _alloc_tracking = tracking;
+    return *this;
+  }
+  // Map key expressions the type checker resolved to a u8 or i8 slice; they
+  // are keyed by (data, len). Without them only slice variables and subslices
+  // are recognized.
+  emitter_c &set_slice_map_keys(
+      const std::unordered_set<const truk::language::nodes::base_c *> &keys) {
+    _slice_map_keys = keys;
+    return *this;
+  }
+  // Slice index expressions proven in range; outside the debug profile these
+  // are emitted without a bounds check.
+  emitter_c &set_unchecked_indices(
+      const std::unordered_set<const truk::language::nodes::index_c *>
+          &indices) {
+    _unchecked_indices = indices;
+    return *this;
+  }
+  // Per-iteration slice checks of a for loop that are replaced by one check
+  // of the last index before the loop; ignored in the debug profile.
+  emitter_c &set_hoisted_checks(
+      const std::unordered_map<
+          const truk::language::nodes::for_c *,
+          std::vector<const truk::language::nodes::index_c *>> &checks) {
+    _hoisted_checks = checks;
+    for (const auto &[loop, indices] : checks) {
+      _hoisted_indices.insert(indices.begin(), indices.end());
+    }
+    return *this;
+  }
 
   result_c finalize();
 
@@ -196,13 +282,14 @@ private:
   std::string
   get_slice_type_name(const truk::language::nodes::type_c *element_type);
   void ensure_slice_typedef(const truk::language::nodes::type_c *element_type);
+  void ensure_unsized_typedef(const truk::language::nodes::array_type_c *arr);
   bool is_slice_type(const truk::language::nodes::type_c *type);
-  std::string
-  get_map_type_name(const truk::language::nodes::type_c *key_type,
-                    const truk::language::nodes::type_c *value_type);
-  void ensure_map_typedef(const truk::language::nodes::type_c *key_type,
-                          const truk::language::nodes::type_c *value_type);
+  bool is_vec_type(const truk::language::nodes::type_c *type);
+  std::string get_map_type_name(const truk::language::nodes::map_type_c *map);
+  void ensure_map_typedef(const truk::language::nodes::map_type_c *map);
   bool is_map_type(const truk::language::nodes::type_c *type);
+  std::string get_map_api(const truk::language::nodes::map_type_c *map);
+  std::string get_variable_map_api(const std::string &name);
   bool is_array_type(const truk::language::nodes::type_c *type);
   std::string get_array_dimensions(const truk::language::nodes::type_c *type);
   std::string get_tuple_type_name(
@@ -211,11 +298,23 @@ private:
       const std::vector<const truk::language::nodes::type_c *> &element_types);
   std::string get_map_hash_fn(const truk::language::nodes::type_c *key_type);
   std::string get_map_cmp_fn(const truk::language::nodes::type_c *key_type);
-  int get_key_size(const truk::language::nodes::type_c *key_type);
+  std::string get_key_size(const truk::language::nodes::type_c *key_type);
+  bool is_string_key_type(const truk::language::nodes::type_c *key_type);
+  // __TRUK_ALLOC_SITE for a make call when tracking, otherwise empty.
+  std::string alloc_site(const truk::language::nodes::base_c *node);
+  map_key_s emit_map_key(const std::string &map_name,
+                         const truk::language::nodes::base_c *key_node,
+                         const std::string &key_expr);
   void register_variable_type(const std::string &name,
                               const truk::language::nodes::type_c *type);
   bool is_variable_slice(const std::string &name);
+  // A slice variable or a subslice of one.
+  bool is_slice_expression(const truk::language::nodes::base_c *node);
   bool is_variable_map(const std::string &name);
+  bool is_variable_concurrent_map(const std::string &name);
+  bool is_variable_vec(const std::string &name);
+  bool needs_bounds_check(const truk::language::nodes::index_c *node) const;
+  void emit_hoisted_checks(const truk::language::nodes::for_c &node);
   bool is_variable_string_ptr(const std::string &name);
   bool is_private_identifier(const std::string &name) const;
 
@@ -226,6 +325,7 @@ private:
   std::string emit_expr_cast(const truk::language::nodes::cast_c &node);
   std::string emit_expr_call(const truk::language::nodes::call_c &node);
   std::string emit_expr_index(const truk::language::nodes::index_c &node);
+  std::string emit_expr_subslice(const truk::language::nodes::index_c &node);
   std::string
   emit_expr_member_access(const truk::language::nodes::member_access_c &node);
   std::string emit_expr_literal(const truk::language::nodes::literal_c &node);
@@ -244,6 +344,18 @@ private:
   std::unordered_map<const truk::language::nodes::base_c *, std::string>
       _decl_to_file;
   std::unordered_map<std::string, std::vector<std::string>> _file_to_shards;
+  std::unordered_set<const truk::language::nodes::base_c *> _slice_map_keys;
+  std::unordered_set<const truk::language::nodes::index_c *>
+      _unchecked_indices;
+  std::unordered_map<const truk::language::nodes::for_c *,
+                     std::vector<const truk::language::nodes::index_c *>>
+      _hoisted_checks;
+  std::unordered_set<const truk::language::nodes::index_c *> _hoisted_indices;
+  build_profile_e _build_profile{build_profile_e::RELEASE};
+  alloc_tracking_e _alloc_tracking{alloc_tracking_e::OFF};
+  std::string _current_file;
+  std::unordered_map<std::string, std::vector<std::size_t>> _line_starts;
+  int _unchecked_block_depth{0};
   result_c _result;
   std::stringstream _current_expr;
   std::stringstream _header;
@@ -260,6 +372,9 @@ private:
   bool _in_expression{false};
   bool _collecting_declarations{false};
   bool _skip_lambda_generation{false};
+  bool _uses_allocators{false};
+  bool _uses_bytes{false};
+  bool _uses_scanner{false};
   std::string _current_function_name;
   const truk::language::nodes::type_c *_current_function_return_type{nullptr};
   int _lambda_counter{0};
@@ -26,13 +26,19 @@ public:
   bool is_slice_type(const truk::language::nodes::type_c *type);
 
   std::string
-  get_map_type_name(const truk::language::nodes::type_c *key_type,
-                    const truk::language::nodes::type_c *value_type);
-  void ensure_map_typedef(const truk::language::nodes::type_c *key_type,
-                          const truk::language::nodes::type_c *value_type,
+  get_vec_type_name(const truk::language::nodes::type_c *element_type);
+  void ensure_vec_typedef(const truk::language::nodes::type_c *element_type,
+                          std::stringstream &header_stream);
+  bool is_vec_type(const truk::language::nodes::type_c *type);
+
+  std::string get_map_api(const truk::language::nodes::map_type_c *map) const;
+  std::string get_map_type_name(const truk::language::nodes::map_type_c *map);
+  void ensure_map_typedef(const truk::language::nodes::map_type_c *map,
                           std::stringstream &structs_stream);
   bool is_map_type(const truk::language::nodes::type_c *type);
   bool has_maps() const;
+  bool has_ordered_maps() const;
+  bool has_concurrent_maps() const;
 
   bool is_string_ptr_type(const truk::language::nodes::type_c *type);
 
@@ -46,6 +52,8 @@ public:
 private:
   std::unordered_set<std::string> _slice_types_emitted;
   std::unordered_set<std::string> _map_types_emitted;
+  bool _ordered_maps_emitted{false};
+  bool _concurrent_maps_emitted{false};
   std::unordered_set<std::string> _struct_names;
   std::unordered_set<std::string> _extern_struct_names;
 };
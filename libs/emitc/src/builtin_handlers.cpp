@@ -7,34 +7,87 @@ namespace truk::emitc {
 
 using namespace truk::language::nodes;
 
+static bool is_allocator_variant(const call_c &node) {
+  if (auto ident = node.callee()->as_identifier()) {
+    auto builtin = language::builtins::lookup_builtin(ident->id().name);
+    return builtin &&
+           (builtin->kind == language::builtins::builtin_kind_e::MAKE_IN ||
+            builtin->kind == language::builtins::builtin_kind_e::DELETE_IN);
+  }
+  return false;
+}
+
 class make_builtin_handler_c : public builtin_handler_if {
 public:
   void emit_call(const call_c &node, emitter_c &emitter) override {
     if (!node.arguments().empty()) {
       if (auto type_param = node.arguments()[0].get()->as_type_param()) {
-        if (node.arguments().size() == 1) {
-          if (emitter.is_map_type(type_param->type())) {
-            auto *map_type = type_param->type()->as_map_type();
-            emitter.ensure_map_typedef(map_type->key_type(),
-                                       map_type->value_type());
-
-            std::string map_name = emitter.get_map_type_name(
-                map_type->key_type(), map_type->value_type());
-            std::string hash_fn = emitter.get_map_hash_fn(map_type->key_type());
-            std::string cmp_fn = emitter.get_map_cmp_fn(map_type->key_type());
-            int key_size = emitter.get_key_size(map_type->key_type());
-
-            emitter._current_expr << "({" << map_name
-                                  << " __tmp; __truk_map_init_generic(&__tmp, "
-                                  << key_size << ", " << hash_fn << ", "
-                                  << cmp_fn << "); __tmp;})";
-            return;
+        std::size_t arg_count = node.arguments().size();
+        std::string allocator_expr;
+        if (is_allocator_variant(node)) {
+          allocator_expr =
+              emitter.emit_expression(node.arguments().back().get());
+          arg_count--;
+        }
+
+        if (arg_count <= 3 && emitter.is_map_type(type_param->type())) {
+          auto *map_type = type_param->type()->as_map_type();
+          emitter.ensure_map_typedef(map_type);
+
+          std::string map_name = emitter.get_map_type_name(map_type);
+          std::string map_api = emitter.get_map_api(map_type);
+          std::string hash_fn = emitter.get_map_hash_fn(map_type->key_type());
+          std::string cmp_fn = emitter.get_map_cmp_fn(map_type->key_type());
+          std::string key_size = emitter.get_key_size(map_type->key_type());
+
+          emitter._current_expr << "({" << map_name << " __tmp; " << map_api
+                                << "_init_generic(&__tmp, " << key_size << ", "
+                                << hash_fn << ", " << cmp_fn << "); ";
+          if (arg_count == 3) {
+            std::string incremental_expr =
+                emitter.emit_expression(node.arguments()[2].get());
+            emitter._current_expr << "__truk_map_set_incremental(&__tmp, ("
+                                  << incremental_expr << ")); ";
+          }
+          if (arg_count >= 2) {
+            std::string capacity_expr =
+                emitter.emit_expression(node.arguments()[1].get());
+            emitter._current_expr << map_api << "_reserve(&__tmp, ("
+                                  << capacity_expr << ")); ";
+          }
+          emitter._current_expr << "__tmp;})";
+          return;
+        }
+
+        if (arg_count <= 2 && emitter.is_vec_type(type_param->type())) {
+          auto *vec_type = type_param->type()->as_array_type();
+          emitter.ensure_unsized_typedef(vec_type);
+          std::string vec_name = emitter.emit_type(vec_type);
+          if (arg_count == 1) {
+            emitter._current_expr << "((" << vec_name << "){0})";
+          } else {
+            std::string capacity_expr =
+                emitter.emit_expression(node.arguments()[1].get());
+            emitter._current_expr << "({" << vec_name
+                                  << " __tmp = {0}; __truk_vec_reserve(__tmp, ("
+                                  << capacity_expr << ")); __tmp;})";
           }
+          return;
+        }
+
+        if (arg_count == 1) {
 
           std::string type_str = emitter.emit_type(type_param->type());
-          emitter._current_expr << cdef::emit_builtin_make(type_str);
+          if (allocator_expr.empty()) {
+            emitter._current_expr
+                << cdef::emit_builtin_make(type_str, emitter.alloc_site(&node));
+          } else {
+            emitter._current_expr
+                << cdef::emit_builtin_make_in(type_str, allocator_expr,
+                                              emitter.alloc_site(&node));
+          }
           return;
-        } else if (node.arguments().size() == 2) {
+        } else if (arg_count == 2) {
           std::string elem_type_for_sizeof =
               emitter.emit_type_for_sizeof(type_param->type());
           emitter.ensure_slice_typedef(type_param->type());
@@ -56,8 +109,15 @@ public:
             cast_type = elem_type_for_sizeof + "*";
           }
 
-          emitter._current_expr << cdef::emit_builtin_make_array(
-              cast_type, elem_type_for_sizeof, count_expr);
+          if (allocator_expr.empty()) {
+            emitter._current_expr << cdef::emit_builtin_make_array(
+                cast_type, elem_type_for_sizeof, count_expr,
+                emitter.alloc_site(&node));
+          } else {
+            emitter._current_expr << cdef::emit_builtin_make_array_in(
+                cast_type, elem_type_for_sizeof, count_expr, allocator_expr,
+                emitter.alloc_site(&node));
+          }
           return;
         }
       }
@@ -75,34 +135,17 @@ public:
             std::string obj_expr = emitter.emit_expression(idx->object());
             std::string idx_expr = emitter.emit_expression(idx->index());
 
-            bool key_is_slice = false;
-            auto *key_literal = idx->index()->as_literal();
-            bool key_is_string_literal =
-                key_literal && key_literal->type() == literal_type_e::STRING;
-            bool key_is_non_string_literal =
-                key_literal && !key_is_string_literal;
-
-            if (auto key_ident = idx->index()->as_identifier()) {
-              key_is_slice = emitter.is_variable_slice(key_ident->id().name);
-            }
-
-            if (key_is_slice) {
-              emitter._current_expr << "__truk_map_remove_generic(&("
-                                    << obj_expr << "), &((" << idx_expr
-                                    << ").data))";
-            } else if (key_is_string_literal) {
-              emitter._current_expr
-                  << "({ const __truk_u8* __truk_key_tmp = " << idx_expr
-                  << "; __truk_map_remove_generic(&(" << obj_expr
-                  << "), &__truk_key_tmp); })";
-            } else if (key_is_non_string_literal) {
-              emitter._current_expr << "({ typeof(" << idx_expr
-                                    << ") __truk_key_tmp = " << idx_expr
-                                    << "; __truk_map_remove_generic(&("
-                                    << obj_expr << "), &__truk_key_tmp); })";
+            auto key = emitter.emit_map_key(ident->id().name, idx->index(),
+                                            idx_expr);
+            std::string map_api =
+                emitter.get_variable_map_api(ident->id().name);
+            if (key.decl.empty()) {
+              emitter._current_expr << map_api << "_remove_generic(&("
+                                    << obj_expr << "), " << key.ref << ")";
             } else {
-              emitter._current_expr << "__truk_map_remove_generic(&("
-                                    << obj_expr << "), &(" << idx_expr << "))";
+              emitter._current_expr << "({ " << key.decl << map_api
+                                    << "_remove_generic(&(" << obj_expr
+                                    << "), " << key.ref << "); })";
             }
             return;
           }
@@ -111,8 +154,22 @@ public:
 
       std::string arg = emitter.emit_expression(node.arguments()[0].get());
 
+      if (is_allocator_variant(node) && node.arguments().size() == 2) {
+        std::string allocator_expr =
+            emitter.emit_expression(node.arguments()[1].get());
+        if (emitter.is_variable_slice(arg)) {
+          emitter._current_expr
+              << cdef::emit_builtin_delete_array_in(arg, allocator_expr);
+        } else {
+          emitter._current_expr
+              << cdef::emit_builtin_delete_in(arg, allocator_expr);
+        }
+        return;
+      }
+
       if (emitter.is_variable_map(arg)) {
-        emitter._current_expr << "__truk_map_deinit(&(" << arg << "))";
+        emitter._current_expr << emitter.get_variable_map_api(arg)
+                              << "_deinit(&(" << arg << "))";
       } else if (emitter.is_variable_slice(arg)) {
         emitter._current_expr << cdef::emit_builtin_delete_array(arg);
       } else {
@@ -163,14 +220,21 @@ class each_builtin_handler_c : public builtin_handler_if {
 public:
   void emit_call(const call_c &node, emitter_c &emitter) override {
     if (node.arguments().size() == 3) {
-      bool is_slice = false;
+      bool is_slice = emitter.is_slice_expression(node.arguments()[0].get());
       bool is_map = false;
       bool is_string_ptr = false;
+      std::string map_api = emitter.get_map_api(nullptr);
+      // Concurrent maps iterate over a copy of each shard, which has to be
+      // freed when the callback stops the loop early.
+      bool needs_iter_end = false;
 
       if (auto ident = node.arguments()[0].get()->as_identifier()) {
-        is_slice = emitter.is_variable_slice(ident->id().name);
         is_map = emitter.is_variable_map(ident->id().name);
         is_string_ptr = emitter.is_variable_string_ptr(ident->id().name);
+        if (is_map) {
+          map_api = emitter.get_variable_map_api(ident->id().name);
+          needs_iter_end = emitter.is_variable_concurrent_map(ident->id().name);
+        }
       }
 
       std::string collection_var =
@@ -186,6 +250,14 @@ public:
         emitter._indent_level++;
 
         if (is_slice) {
+          if (!node.arguments()[0].get()->as_identifier()) {
+            // A subslice is taken once, not on every loop test.
+            emitter._functions << cdef::indent(emitter._indent_level)
+                               << "__typeof__(" << collection_var
+                               << ") __truk_each_src = " << collection_var
+                               << ";\n";
+            collection_var = "__truk_each_src";
+          }
           emitter._functions << cdef::indent(emitter._indent_level)
                              << "for (__truk_u64 __truk_idx = 0; __truk_idx < ("
                              << collection_var << ").len; __truk_idx++) {\n";
@@ -217,27 +289,36 @@ public:
           std::string key_type =
               emitter.emit_type(lambda->params()[0].type.get());
 
-          emitter._functions
-              << cdef::indent(emitter._indent_level)
-              << "__truk_map_iter_t __truk_iter = __truk_map_iter();\n";
+          emitter._functions << cdef::indent(emitter._indent_level)
+                             << map_api << "_iter_t __truk_iter = " << map_api
+                             << "_iter_();\n";
           emitter._functions << cdef::indent(emitter._indent_level) << key_type
                              << "* __truk_key_ptr;\n";
+          emitter._functions << cdef::indent(emitter._indent_level)
+                             << "void* __truk_val_ptr;\n";
           emitter._functions << cdef::indent(emitter._indent_level)
                              << "while ((__truk_key_ptr = (" << key_type
-                             << "*)__truk_map_next_generic(&(" << collection_var
-                             << "), &__truk_iter)) != NULL) {\n";
+                             << "*)" << map_api << "_next_kv_generic(&("
+                             << collection_var
+                             << "), &__truk_iter, &__truk_val_ptr)) != "
+                                "NULL) {\n";
           emitter._indent_level++;
           emitter._functions << cdef::indent(emitter._indent_level) << key_type
                              << " __truk_key = *__truk_key_ptr;\n";
-          emitter._functions
-              << cdef::indent(emitter._indent_level)
-              << "__truk_bool __truk_continue = " << callback_func
-              << "(__truk_key, __truk_map_get_generic(&(" << collection_var
-              << "), __truk_key_ptr), " << context_var << ");\n";
+          emitter._functions << cdef::indent(emitter._indent_level)
+                             << "__truk_bool __truk_continue = "
+                             << callback_func
+                             << "(__truk_key, __truk_val_ptr, " << context_var
+                             << ");\n";
           emitter._functions << cdef::indent(emitter._indent_level)
                              << "if (!__truk_continue) break;\n";
           emitter._indent_level--;
           emitter._functions << cdef::indent(emitter._indent_level) << "}\n";
+          if (needs_iter_end) {
+            emitter._functions << cdef::indent(emitter._indent_level)
+                               << map_api << "_iter_end(&(" << collection_var
+                               << "), &__truk_iter);\n";
+          }
         }
 
         emitter._indent_level--;
@@ -250,6 +331,13 @@ public:
         emitter._indent_level++;
 
         if (is_slice) {
+          if (!node.arguments()[0].get()->as_identifier()) {
+            emitter._functions << cdef::indent(emitter._indent_level)
+                               << "__typeof__(" << collection_var
+                               << ") __truk_each_src = " << collection_var
+                               << ";\n";
+            collection_var = "__truk_each_src";
+          }
           emitter._functions << cdef::indent(emitter._indent_level)
                              << "for (__truk_u64 __truk_idx = 0; __truk_idx < ("
                              << collection_var << ").len; __truk_idx++) {\n";
@@ -281,30 +369,38 @@ public:
           if (auto func_call = node.arguments()[2].get()->as_call()) {
             if (auto func_ident = func_call->callee()->as_identifier()) {
               std::string key_type = "__truk_u8*";
-              emitter._functions
-                  << cdef::indent(emitter._indent_level)
-                  << "__truk_map_iter_t __truk_iter = __truk_map_iter();\n";
+              emitter._functions << cdef::indent(emitter._indent_level)
+                                 << map_api << "_iter_t __truk_iter = "
+                                 << map_api << "_iter_();\n";
               emitter._functions << cdef::indent(emitter._indent_level)
                                  << key_type << " __truk_key_ptr;\n";
+              emitter._functions << cdef::indent(emitter._indent_level)
+                                 << "void* __truk_val_ptr;\n";
               emitter._functions << cdef::indent(emitter._indent_level)
                                  << "while ((__truk_key_ptr = (" << key_type
-                                 << ")__truk_map_next_generic(&("
+                                 << ")" << map_api << "_next_kv_generic(&("
                                  << collection_var
-                                 << "), &__truk_iter)) != NULL) {\n";
+                                 << "), &__truk_iter, &__truk_val_ptr)) != "
+                                    "NULL) {\n";
               emitter._indent_level++;
               emitter._functions << cdef::indent(emitter._indent_level)
                                  << key_type
                                  << " __truk_key = *__truk_key_ptr;\n";
-              emitter._functions
-                  << cdef::indent(emitter._indent_level)
-                  << "__truk_bool __truk_continue = " << callback_func
-                  << "(__truk_key, __truk_map_get_generic(&(" << collection_var
-                  << "), __truk_key_ptr), " << context_var << ");\n";
+              emitter._functions << cdef::indent(emitter._indent_level)
+                                 << "__truk_bool __truk_continue = "
+                                 << callback_func
+                                 << "(__truk_key, __truk_val_ptr, "
+                                 << context_var << ");\n";
               emitter._functions << cdef::indent(emitter._indent_level)
                                  << "if (!__truk_continue) break;\n";
               emitter._indent_level--;
               emitter._functions << cdef::indent(emitter._indent_level)
                                  << "}\n";
+              if (needs_iter_end) {
+                emitter._functions << cdef::indent(emitter._indent_level)
+                                   << map_api << "_iter_end(&("
+                                   << collection_var << "), &__truk_iter);\n";
+              }
             }
           }
         }
@@ -349,16 +445,265 @@ public:
   }
 };
 
+class map_capacity_builtin_handler_c : public builtin_handler_if {
+public:
+  void emit_call(const call_c &node, emitter_c &emitter) override {
+    if (node.arguments().empty()) {
+      return;
+    }
+    std::string map_expr = emitter.emit_expression(node.arguments()[0].get());
+    std::string map_api = emitter.get_map_api(nullptr);
+    if (auto ident = node.arguments()[0].get()->as_identifier()) {
+      if (emitter.is_variable_vec(ident->id().name)) {
+        std::string capacity_expr =
+            emitter.emit_expression(node.arguments()[1].get());
+        emitter._current_expr << "__truk_vec_reserve(" << map_expr << ", ("
+                              << capacity_expr << "))";
+        return;
+      }
+      map_api = emitter.get_variable_map_api(ident->id().name);
+    }
+    if (node.arguments().size() == 2) {
+      std::string capacity_expr =
+          emitter.emit_expression(node.arguments()[1].get());
+      emitter._current_expr << map_api << "_reserve(&(" << map_expr << "), ("
+                            << capacity_expr << "))";
+    } else {
+      emitter._current_expr << map_api << "_shrink(&(" << map_expr << "))";
+    }
+  }
+};
+
+class map_get_or_insert_builtin_handler_c : public builtin_handler_if {
+public:
+  void emit_call(const call_c &node, emitter_c &emitter) override {
+    if (node.arguments().size() != 3) {
+      return;
+    }
+    auto ident = node.arguments()[0].get()->as_identifier();
+    if (!ident) {
+      emitter.add_error("get_or_insert requires a map variable", &node);
+      return;
+    }
+    std::string map_expr = emitter.emit_expression(ident);
+    std::string key_expr = emitter.emit_expression(node.arguments()[1].get());
+    std::string value_expr =
+        emitter.emit_expression(node.arguments()[2].get());
+    // Like reading m[k], the stored value is copied out under the shard lock.
+    auto key = emitter.emit_map_key(ident->id().name,
+                                    node.arguments()[1].get(), key_expr);
+    emitter._current_expr
+        << "__truk_concurrent_map_get_or_insert_copy_generic(&(" << map_expr
+        << "), " << key.block_ref << ", " << value_expr << ")";
+  }
+};
+
+class vec_builtin_handler_c : public builtin_handler_if {
+public:
+  void emit_call(const call_c &node, emitter_c &emitter) override {
+    auto ident = node.callee()->as_identifier();
+    if (!ident || node.arguments().empty()) {
+      return;
+    }
+    std::string vec_expr = emitter.emit_expression(node.arguments()[0].get());
+    const std::string &name = ident->id().name;
+    if (name == "push" && node.arguments().size() == 2) {
+      std::string value_expr =
+          emitter.emit_expression(node.arguments()[1].get());
+      emitter._current_expr << "__truk_vec_push(" << vec_expr << ", ("
+                            << value_expr << "))";
+    } else if (name == "pop") {
+      emitter._current_expr << "__truk_vec_pop(" << vec_expr << ")";
+    } else if (name == "cap") {
+      emitter._current_expr << "(" << vec_expr << ").cap";
+    }
+  }
+};
+
+// Slices are bound to temporaries so each is evaluated once and passed as
+// data and length; string literals pass their bytes without the terminator.
+class bytes_builtin_handler_c : public builtin_handler_if {
+public:
+  void emit_call(const call_c &node, emitter_c &emitter) override {
+    auto ident = node.callee()->as_identifier();
+    if (!ident) {
+      return;
+    }
+    auto builtin = language::builtins::lookup_builtin(ident->id().name);
+    if (!builtin) {
+      return;
+    }
+    const auto kind = builtin->kind;
+    const bool takes_byte =
+        kind == language::builtins::builtin_kind_e::BYTES_FIND ||
+        kind == language::builtins::builtin_kind_e::BYTES_COUNT ||
+        kind == language::builtins::builtin_kind_e::BYTES_FILL;
+
+    emitter._uses_bytes = true;
+    std::string decls;
+    std::string args;
+    for (std::size_t i = 0; i < node.arguments().size(); ++i) {
+      const base_c *arg = node.arguments()[i].get();
+      std::string expr = emitter.emit_expression(arg);
+      if (i > 0) {
+        args += ", ";
+      }
+      if (i == 1 && takes_byte) {
+        args += "(__truk_u8)(" + expr + ")";
+        continue;
+      }
+      auto literal = arg->as_literal();
+      if (literal && literal->type() == literal_type_e::STRING) {
+        args += "(const __truk_u8 *)" + expr + ", (sizeof(" + expr + ") - 1)";
+        continue;
+      }
+      std::string tmp = "__truk_b" + std::to_string(i);
+      decls += "__typeof__(" + expr + ") " + tmp + " = " + expr + "; ";
+      args += "(__truk_u8 *)" + tmp + ".data, " + tmp + ".len";
+    }
+
+    emitter._current_expr << "({ " << decls << "__truk_" << builtin->name
+                          << "(" << args << "); })";
+  }
+};
+
+// scan_group and scan_token bind the scanned slice like the bytes_*
+// builtins; the optional fifth argument is the escape byte (-1 when absent)
+// or the stop-symbol slice (NULL, 0 when absent).
+class scan_builtin_handler_c : public builtin_handler_if {
+public:
+  void emit_call(const call_c &node, emitter_c &emitter) override {
+    auto ident = node.callee()->as_identifier();
+    if (!ident) {
+      return;
+    }
+    auto builtin = language::builtins::lookup_builtin(ident->id().name);
+    if (!builtin) {
+      return;
+    }
+    const bool is_group =
+        builtin->kind == language::builtins::builtin_kind_e::SCAN_GROUP;
+
+    emitter._uses_scanner = true;
+    std::vector<std::string> exprs;
+    for (const auto &arg : node.arguments()) {
+      exprs.push_back(emitter.emit_expression(arg.get()));
+    }
+
+    std::string decls;
+    auto slice_args = [&](std::size_t i) -> std::string {
+      auto literal = node.arguments()[i]->as_literal();
+      if (literal && literal->type() == literal_type_e::STRING) {
+        return "(const __truk_u8 *)" + exprs[i] + ", (sizeof(" + exprs[i] +
+               ") - 1)";
+      }
+      std::string tmp = "__truk_b" + std::to_string(i);
+      decls += "__typeof__(" + exprs[i] + ") " + tmp + " = " + exprs[i] + "; ";
+      return "(const __truk_u8 *)" + tmp + ".data, " + tmp + ".len";
+    };
+
+    std::string args = slice_args(0) + ", (__truk_u64)(" + exprs[1] + "), ";
+    if (is_group) {
+      args += "(__truk_u8)(" + exprs[2] + "), (__truk_u8)(" + exprs[3] + "), ";
+      args += exprs.size() > 4 ? "(__truk_i32)(__truk_u8)(" + exprs[4] + ")"
+                               : "-1";
+    } else {
+      args += exprs.size() > 4 ? slice_args(4) : "NULL, 0";
+      args += ", (__truk_u64 *)(" + exprs[2] + "), (__truk_u64 *)(" +
+              exprs[3] + ")";
+    }
+
+    emitter._current_expr << "({ " << decls << "__truk_" << builtin->name
+                          << "(" << args << "); })";
+  }
+};
+
+class allocator_builtin_handler_c : public builtin_handler_if {
+public:
+  void emit_call(const call_c &node, emitter_c &emitter) override {
+    auto ident = node.callee()->as_identifier();
+    if (!ident) {
+      return;
+    }
+    auto builtin = language::builtins::lookup_builtin(ident->id().name);
+    if (!builtin) {
+      return;
+    }
+
+    std::vector<std::string> args;
+    for (const auto &arg : node.arguments()) {
+      args.push_back(emitter.emit_expression(arg.get()));
+    }
+
+    switch (builtin->kind) {
+    case language::builtins::builtin_kind_e::ALLOCATOR_ARENA:
+      emitter._uses_allocators = true;
+      emitter._current_expr << "__truk_alloc_arena_new(" << args[0] << ")";
+      return;
+    case language::builtins::builtin_kind_e::ALLOCATOR_POOL:
+      emitter._uses_allocators = true;
+      emitter._current_expr << "__truk_alloc_pool_new(" << args[0] << ", "
+                            << args[1] << ")";
+      return;
+    case language::builtins::builtin_kind_e::ALLOCATOR_SLAB:
+      emitter._uses_allocators = true;
+      emitter._current_expr << "__truk_alloc_slab_new()";
+      return;
+    case language::builtins::builtin_kind_e::ALLOCATOR_RESET:
+      emitter._current_expr
+          << "__truk_runtime_sxs_allocator_reset((__truk_allocator_t *)("
+          << args[0] << "))";
+      return;
+    case language::builtins::builtin_kind_e::ALLOCATOR_DESTROY:
+      emitter._current_expr
+          << "__truk_runtime_sxs_allocator_destroy((__truk_allocator_t *)("
+          << args[0] << "))";
+      return;
+    case language::builtins::builtin_kind_e::ALLOCATOR_USE:
+      emitter._current_expr
+          << "(__truk_void *)__truk_runtime_sxs_set_thread_allocator(("
+             "__truk_allocator_t *)("
+          << args[0] << "))";
+      return;
+    default:
+      break;
+    }
+  }
+};
+
 void register_builtin_handlers(builtin_registry_c &registry) {
   registry.register_handler("make", std::make_unique<make_builtin_handler_c>());
+  registry.register_handler("make_in",
+                            std::make_unique<make_builtin_handler_c>());
   registry.register_handler("delete",
                             std::make_unique<delete_builtin_handler_c>());
+  registry.register_handler("delete_in",
+                            std::make_unique<delete_builtin_handler_c>());
   registry.register_handler("len", std::make_unique<len_builtin_handler_c>());
   registry.register_handler("sizeof",
                             std::make_unique<sizeof_builtin_handler_c>());
   registry.register_handler("panic",
                             std::make_unique<panic_builtin_handler_c>());
   registry.register_handler("each", std::make_unique<each_builtin_handler_c>());
+  registry.register_handler("reserve",
+                            std::make_unique<map_capacity_builtin_handler_c>());
+  registry.register_handler("shrink",
+                            std::make_unique<map_capacity_builtin_handler_c>());
+  registry.register_handler(
+      "get_or_insert", std::make_unique<map_get_or_insert_builtin_handler_c>());
+  registry.register_handler("push", std::make_unique<vec_builtin_handler_c>());
+  registry.register_handler("pop", std::make_unique<vec_builtin_handler_c>());
+  registry.register_handler("cap", std::make_unique<vec_builtin_handler_c>());
+  for (const auto &builtin : language::builtins::get_builtins()) {
+    if (language::builtins::is_bytes_builtin(builtin.kind)) {
+      registry.register_handler(builtin.name,
+                                std::make_unique<bytes_builtin_handler_c>());
+    }
+  }
+  registry.register_handler("scan_group",
+                            std::make_unique<scan_builtin_handler_c>());
+  registry.register_handler("scan_token",
+                            std::make_unique<scan_builtin_handler_c>());
   registry.register_handler("__TRUK_VA_ARG_I32",
                             std::make_unique<va_arg_builtin_handler_c>());
   registry.register_handler("__TRUK_VA_ARG_I64",
@@ -367,6 +712,18 @@ void register_builtin_handlers(builtin_registry_c &registry) {
                             std::make_unique<va_arg_builtin_handler_c>());
   registry.register_handler("__TRUK_VA_ARG_PTR",
                             std::make_unique<va_arg_builtin_handler_c>());
+  registry.register_handler("allocator_arena",
+                            std::make_unique<allocator_builtin_handler_c>());
+  registry.register_handler("allocator_pool",
+                            std::make_unique<allocator_builtin_handler_c>());
+  registry.register_handler("allocator_slab",
+                            std::make_unique<allocator_builtin_handler_c>());
+  registry.register_handler("allocator_reset",
+                            std::make_unique<allocator_builtin_handler_c>());
+  registry.register_handler("allocator_destroy",
+                            std::make_unique<allocator_builtin_handler_c>());
+  registry.register_handler("allocator_use",
+                            std::make_unique<allocator_builtin_handler_c>());
 }
 
 } // namespace truk::emitc
@@ -1,9 +1,11 @@
+#include <algorithm>
 #include <language/builtins.hpp>
 #include <language/keywords.hpp>
 #include <set>
 #include <truk/emitc/builtin_handler.hpp>
 #include <truk/emitc/cdef.hpp>
 #include <truk/emitc/emitter.hpp>
+#include <truk/ingestion/file_utils.hpp>
 
 namespace truk::emitc {
 
@@ -29,6 +31,46 @@ const char *emission_phase_name(emission_phase_e phase) {
   }
 }
 
+const char *build_profile_name(build_profile_e profile) {
+  switch (profile) {
+  case build_profile_e::DEBUG:
+    return "debug";
+  case build_profile_e::RELEASE:
+    return "release";
+  case build_profile_e::FAST:
+    return "fast";
+  default:
+    return "unknown";
+  }
+}
+
+std::optional<build_profile_e> build_profile_from_name(const std::string &name) {
+  if (name == "debug") {
+    return build_profile_e::DEBUG;
+  }
+  if (name == "release") {
+    return build_profile_e::RELEASE;
+  }
+  if (name == "fast") {
+    return build_profile_e::FAST;
+  }
+  return std::nullopt;
+}
+
+std::optional<alloc_tracking_e>
+alloc_tracking_from_name(const std::string &name) {
+  if (name == "off") {
+    return alloc_tracking_e::OFF;
+  }
+  if (name == "full") {
+    return alloc_tracking_e::FULL;
+  }
+  if (name == "sampled") {
+    return alloc_tracking_e::SAMPLED;
+  }
+  return std::nullopt;
+}
+
 emitter_c::emitter_c() : _collecting_declarations(false) {
   register_builtin_handlers(_builtin_registry);
 }
@@ -66,6 +108,8 @@ result_c emitter_c::finalize() {
 
     _current_phase = emission_phase_e::FUNCTION_DEFINITION;
     for (const auto *decl : _declarations) {
+      auto file_it = _decl_to_file.find(decl);
+      _current_file = file_it != _decl_to_file.end() ? file_it->second : "";
       emit(decl);
     }
 
@@ -109,6 +153,27 @@ void emitter_c::emit_forward_declarations() {
         continue;
       }
 
+      // Slice and vec typedefs are otherwise only emitted along with the
+      // function body, which comes after these prototypes. Those of
+      // primitives do not depend on any struct, so they can go ahead of
+      // everything.
+      auto ensure_primitive_slice = [this](const type_c *type) {
+        auto arr = type->as_array_type();
+        if (arr && !arr->size().has_value() &&
+            arr->element_type()->as_primitive_type()) {
+          if (arr->growable()) {
+            _type_registry.ensure_vec_typedef(arr->element_type(), _structs);
+          } else {
+            _type_registry.ensure_slice_typedef(arr->element_type(), _structs,
+                                                _structs);
+          }
+        }
+      };
+      for (const auto &param : fn->params()) {
+        ensure_primitive_slice(param.type.get());
+      }
+      ensure_primitive_slice(fn->return_type());
+
       bool is_private = is_private_identifier(fn->name().name);
       bool is_library = _result.metadata.is_library();
 
@@ -225,13 +290,20 @@ void emitter_c::emit(const base_c *root) {
 void emitter_c::internal_finalize() {
   std::stringstream final_header;
 
+  final_header << cdef::emit_build_profile(build_profile_name(_build_profile));
+  if (_alloc_tracking != alloc_tracking_e::OFF) {
+    final_header << cdef::emit_alloc_tracking(
+        _alloc_tracking == alloc_tracking_e::SAMPLED ? alloc_track_sample_bytes
+                                                     : 0);
+  }
   final_header << cdef::emit_system_includes();
   final_header << cdef::emit_runtime_types();
   final_header << cdef::emit_runtime_declarations();
   final_header << cdef::emit_runtime_macros();
 
   std::set<std::string> system_includes = {"stdbool.h", "stdint.h", "stdlib.h",
-                                           "stdio.h",   "string.h", "stdarg.h"};
+                                           "stdio.h",   "string.h", "stdarg.h",
+                                           "pthread.h"};
 
   bool has_user_imports = false;
   for (const auto &import : _c_imports) {
@@ -250,6 +322,44 @@ void emitter_c::internal_finalize() {
   }
 
   final_header << cdef::emit_runtime_implementation();
+  if (_alloc_tracking != alloc_tracking_e::OFF &&
+      embedded::runtime_files.count("src/track.c")) {
+    final_header << cdef::strip_pragma_and_includes(
+        embedded::runtime_files.at("src/track.c").content);
+  }
+
+  if (_uses_allocators) {
+    if (embedded::runtime_files.count("include/sxs/alloc.h")) {
+      final_header << cdef::strip_pragma_and_includes(
+          embedded::runtime_files.at("include/sxs/alloc.h").content);
+    }
+    if (embedded::runtime_files.count("src/alloc.c")) {
+      final_header << cdef::strip_pragma_and_includes(
+          embedded::runtime_files.at("src/alloc.c").content);
+    }
+  }
+
+  if (_uses_bytes || _uses_scanner) {
+    if (embedded::runtime_files.count("include/sxs/bytes.h")) {
+      final_header << cdef::strip_pragma_and_includes(
+          embedded::runtime_files.at("include/sxs/bytes.h").content);
+    }
+    if (embedded::runtime_files.count("src/bytes.c")) {
+      final_header << cdef::strip_pragma_and_includes(
+          embedded::runtime_files.at("src/bytes.c").content);
+    }
+  }
+
+  if (_uses_scanner) {
+    if (embedded::runtime_files.count("include/sxs/ds/scanner.h")) {
+      final_header << cdef::strip_pragma_and_includes(
+          embedded::runtime_files.at("include/sxs/ds/scanner.h").content);
+    }
+    if (embedded::runtime_files.count("src/ds/scanner.c")) {
+      final_header << cdef::strip_pragma_and_includes(
+          embedded::runtime_files.at("src/ds/scanner.c").content);
+    }
+  }
 
   if (_type_registry.has_maps()) {
     if (embedded::runtime_files.count("include/sxs/ds/map.h")) {
@@ -262,7 +372,31 @@ void emitter_c::internal_finalize() {
     }
   }
 
+  if (_type_registry.has_ordered_maps()) {
+    if (embedded::runtime_files.count("include/sxs/ds/ordered_map.h")) {
+      final_header << cdef::strip_pragma_and_includes(
+          embedded::runtime_files.at("include/sxs/ds/ordered_map.h").content);
+    }
+    if (embedded::runtime_files.count("src/ds/ordered_map.c")) {
+      final_header << cdef::strip_pragma_and_includes(
+          embedded::runtime_files.at("src/ds/ordered_map.c").content);
+    }
+  }
+
+  if (_type_registry.has_concurrent_maps()) {
+    if (embedded::runtime_files.count("include/sxs/ds/concurrent_map.h")) {
+      final_header << cdef::strip_pragma_and_includes(
+          embedded::runtime_files.at("include/sxs/ds/concurrent_map.h")
+              .content);
+    }
+    if (embedded::runtime_files.count("src/ds/concurrent_map.c")) {
+      final_header << cdef::strip_pragma_and_includes(
+          embedded::runtime_files.at("src/ds/concurrent_map.c").content);
+    }
+  }
+
   if (_result.metadata.has_tests()) {
+    final_header << "#include <time.h>\n\n";
     if (embedded::runtime_files.count("include/sxs/test.h")) {
       final_header << cdef::strip_pragma_and_includes(
           embedded::runtime_files.at("include/sxs/test.h").content);
@@ -315,6 +449,40 @@ void emitter_c::internal_finalize() {
   }
 }
 
+std::string emitter_c::alloc_site(const base_c *node) {
+  if (_alloc_tracking == alloc_tracking_e::OFF) {
+    return "";
+  }
+  std::size_t line = 0;
+  if (!_current_file.empty() && node) {
+    auto it = _line_starts.find(_current_file);
+    if (it == _line_starts.end()) {
+      std::vector<std::size_t> starts{0};
+      try {
+        std::string source = ingestion::read_file(_current_file);
+        for (std::size_t i = 0; i < source.size(); ++i) {
+          if (source[i] == '\n') {
+            starts.push_back(i + 1);
+          }
+        }
+      } catch (const std::exception &) {
+        starts.clear();
+      }
+      it = _line_starts.emplace(_current_file, std::move(starts)).first;
+    }
+    if (!it->second.empty()) {
+      line = static_cast<std::size_t>(
+          std::upper_bound(it->second.begin(), it->second.end(),
+                           node->source_index()) -
+          it->second.begin());
+    }
+  }
+  return "__TRUK_ALLOC_SITE(" +
+         cdef::emit_string_literal(_current_file.empty() ? "<unknown>"
+                                                         : _current_file) +
+         ", " + std::to_string(line) + ")";
+}
+
 std::string emitter_c::emit_type(const type_c *type) {
   return _type_registry.get_c_type(type);
 }
@@ -336,18 +504,30 @@ void emitter_c::ensure_slice_typedef(const type_c *element_type) {
   _type_registry.ensure_slice_typedef(element_type, _header, _structs);
 }
 
+// The typedef for a slice or vec type, whichever arr is.
+void emitter_c::ensure_unsized_typedef(const array_type_c *arr) {
+  if (arr->growable()) {
+    _type_registry.ensure_vec_typedef(arr->element_type(), _header);
+  } else {
+    _type_registry.ensure_slice_typedef(arr->element_type(), _header,
+                                        _structs);
+  }
+}
+
 bool emitter_c::is_slice_type(const type_c *type) {
   return _type_registry.is_slice_type(type);
 }
 
-std::string emitter_c::get_map_type_name(const type_c *key_type,
-                                         const type_c *value_type) {
-  return _type_registry.get_map_type_name(key_type, value_type);
+bool emitter_c::is_vec_type(const type_c *type) {
+  return _type_registry.is_vec_type(type);
 }
 
-void emitter_c::ensure_map_typedef(const type_c *key_type,
-                                   const type_c *value_type) {
-  _type_registry.ensure_map_typedef(key_type, value_type, _structs);
+std::string emitter_c::get_map_type_name(const map_type_c *map) {
+  return _type_registry.get_map_type_name(map);
+}
+
+void emitter_c::ensure_map_typedef(const map_type_c *map) {
+  _type_registry.ensure_map_typedef(map, _structs);
 }
 
 std::string emitter_c::get_tuple_type_name(
@@ -380,7 +560,7 @@ void emitter_c::ensure_tuple_typedef(
 
   for (const auto *elem_type : element_types) {
     if (auto map = elem_type->as_map_type()) {
-      ensure_map_typedef(map->key_type(), map->value_type());
+      ensure_map_typedef(map);
     }
   }
 
@@ -443,6 +623,15 @@ bool emitter_c::is_map_type(const type_c *type) {
   return _type_registry.is_map_type(type);
 }
 
+std::string emitter_c::get_map_api(const map_type_c *map) {
+  return map ? _type_registry.get_map_api(map) : "__truk_map";
+}
+
+std::string emitter_c::get_variable_map_api(const std::string &name) {
+  const type_c *type = _variable_registry.get_type(name);
+  return get_map_api(type ? type->as_map_type() : nullptr);
+}
+
 bool emitter_c::is_array_type(const type_c *type) {
   if (auto arr = type->as_array_type()) {
     return arr->size().has_value();
@@ -464,52 +653,8 @@ std::string emitter_c::get_array_dimensions(const type_c *type) {
   return dims;
 }
 
-std::string emitter_c::get_map_hash_fn(const type_c *key_type) {
-  if (auto *ptr = key_type->as_pointer_type()) {
-    return "__truk_map_hash_str";
-  }
-  if (auto *prim = key_type->as_primitive_type()) {
-    switch (prim->keyword()) {
-    case keywords_e::I8:
-      return "__truk_map_hash_i8";
-    case keywords_e::I16:
-      return "__truk_map_hash_i16";
-    case keywords_e::I32:
-      return "__truk_map_hash_i32";
-    case keywords_e::I64:
-      return "__truk_map_hash_i64";
-    case keywords_e::U8:
-      return "__truk_map_hash_u8";
-    case keywords_e::U16:
-      return "__truk_map_hash_u16";
-    case keywords_e::U32:
-      return "__truk_map_hash_u32";
-    case keywords_e::U64:
-      return "__truk_map_hash_u64";
-    case keywords_e::F32:
-      return "__truk_map_hash_f32";
-    case keywords_e::F64:
-      return "__truk_map_hash_f64";
-    case keywords_e::BOOL:
-      return "__truk_map_hash_bool";
-    default:
-      break;
-    }
-  }
-  return "__truk_map_hash_str";
-}
-
-std::string emitter_c::get_map_cmp_fn(const type_c *key_type) {
-  if (auto *ptr = key_type->as_pointer_type()) {
-    return "__truk_map_cmp_str";
-  }
-  return "__truk_map_cmp_mem";
-}
-
-int emitter_c::get_key_size(const type_c *key_type) {
-  if (auto *ptr = key_type->as_pointer_type()) {
-    return sizeof(void *);
-  }
+// Width in bytes of a primitive map key, or 0 for string keys.
+static int get_primitive_key_width(const type_c *key_type) {
   if (auto *prim = key_type->as_primitive_type()) {
     switch (prim->keyword()) {
     case keywords_e::I8:
@@ -531,7 +676,76 @@ int emitter_c::get_key_size(const type_c *key_type) {
       break;
     }
   }
-  return sizeof(void *);
+  return 0;
+}
+
+std::string emitter_c::get_map_hash_fn(const type_c *key_type) {
+  int width = get_primitive_key_width(key_type);
+  if (width == 0) {
+    return "__truk_map_hash_strkey";
+  }
+  return "__truk_map_mixhash_" + std::to_string(width * 8);
+}
+
+std::string emitter_c::get_map_cmp_fn(const type_c *key_type) {
+  if (is_string_key_type(key_type)) {
+    return "__truk_map_cmp_strkey";
+  }
+  return "__truk_map_cmp_mem";
+}
+
+std::string emitter_c::get_key_size(const type_c *key_type) {
+  if (is_string_key_type(key_type)) {
+    return "sizeof(__truk_map_strkey_t)";
+  }
+  return std::to_string(get_primitive_key_width(key_type));
+}
+
+bool emitter_c::is_string_key_type(const type_c *key_type) {
+  return get_primitive_key_width(key_type) == 0;
+}
+
+map_key_s emitter_c::emit_map_key(const std::string &map_name,
+                                  const base_c *key_node,
+                                  const std::string &key_expr) {
+  auto key_ident = key_node->as_identifier();
+  auto key_index = key_node->as_index();
+  bool key_is_slice =
+      _slice_map_keys.count(key_node) ||
+      (key_ident && is_variable_slice(key_ident->id().name)) ||
+      (key_index && key_index->is_range());
+  auto *key_literal = key_node->as_literal();
+  bool key_is_string_literal =
+      key_literal && key_literal->type() == literal_type_e::STRING;
+
+  const type_c *map_type = _variable_registry.get_type(map_name);
+  if (map_type && map_type->as_map_type() &&
+      is_string_key_type(map_type->as_map_type()->key_type())) {
+    // String keys are (pointer, length); the length comes from the slice or
+    // the literal when it is known, and from one strlen otherwise.
+    std::string init;
+    if (key_is_slice && key_ident) {
+      init = "{(" + key_expr + ").data, (" + key_expr + ").len}";
+    } else if (key_is_slice) {
+      // Subslices, fields and call results are evaluated once.
+      init = "({ typeof(" + key_expr + ") __truk_key_src = " + key_expr +
+             "; (__truk_map_strkey_t){__truk_key_src.data, "
+             "__truk_key_src.len}; })";
+    } else if (key_is_string_literal) {
+      init = "{" + key_expr + ", sizeof(" + key_expr + ") - 1}";
+    } else {
+      init = "__truk_map_strkey_cstr(" + key_expr + ")";
+    }
+    return {"__truk_map_strkey_t __truk_key_tmp = " + init + "; ",
+            "&__truk_key_tmp", "((__truk_map_strkey_t[1]){" + init + "})"};
+  }
+
+  if (key_literal) {
+    return {"typeof(" + key_expr + ") __truk_key_tmp = " + key_expr + "; ",
+            "&__truk_key_tmp",
+            "((typeof(" + key_expr + ")[1]){" + key_expr + "})"};
+  }
+  return {"", "&(" + key_expr + ")", "&(" + key_expr + ")"};
 }
 
 void emitter_c::register_variable_type(const std::string &name,
@@ -543,10 +757,78 @@ bool emitter_c::is_variable_slice(const std::string &name) {
   return _variable_registry.is_slice(name);
 }
 
+bool emitter_c::is_slice_expression(const base_c *node) {
+  if (auto ident = node->as_identifier()) {
+    return is_variable_slice(ident->id().name);
+  }
+  auto index = node->as_index();
+  return index && index->is_range();
+}
+
 bool emitter_c::is_variable_map(const std::string &name) {
   return _variable_registry.is_map(name);
 }
 
+bool emitter_c::is_variable_concurrent_map(const std::string &name) {
+  const type_c *type = _variable_registry.get_type(name);
+  const map_type_c *map = type ? type->as_map_type() : nullptr;
+  return map && map->concurrent();
+}
+
+bool emitter_c::is_variable_vec(const std::string &name) {
+  const type_c *type = _variable_registry.get_type(name);
+  return type && _type_registry.is_vec_type(type);
+}
+
+bool emitter_c::needs_bounds_check(const index_c *node) const {
+  switch (_build_profile) {
+  case build_profile_e::DEBUG:
+    return true;
+  case build_profile_e::FAST:
+    if (_unchecked_block_depth > 0) {
+      return false;
+    }
+    break;
+  default:
+    break;
+  }
+  return !_unchecked_indices.count(node) && !_hoisted_indices.count(node);
+}
+
+void emitter_c::emit_hoisted_checks(const for_c &node) {
+  auto it = _hoisted_checks.find(&node);
+  if (_build_profile == build_profile_e::DEBUG ||
+      it == _hoisted_checks.end()) {
+    return;
+  }
+
+  std::string first = emit_expression(node.init()->as_var()->initializer());
+  std::string bound = emit_expression(node.condition()->as_binary_op()->right());
+  std::vector<std::string> slices;
+  for (const auto *idx : it->second) {
+    auto ident = idx->object()->as_identifier();
+    if (!ident || !is_variable_slice(ident->id().name)) {
+      continue;
+    }
+    std::string obj = emit_expression(ident);
+    if (std::find(slices.begin(), slices.end(), obj) == slices.end()) {
+      slices.push_back(obj);
+    }
+  }
+  if (slices.empty()) {
+    return;
+  }
+
+  _functions << cdef::indent(_indent_level) << "if (" << first << " < ("
+             << bound << ")) {\n";
+  for (const auto &obj : slices) {
+    _functions << cdef::indent(_indent_level + 1)
+               << "__truk_runtime_sxs_bounds_check((" << bound << ") - 1, ("
+               << obj << ").len);\n";
+  }
+  _functions << cdef::indent(_indent_level) << "}\n";
+}
+
 bool emitter_c::is_variable_string_ptr(const std::string &name) {
   return _variable_registry.is_string_ptr(name);
 }
@@ -570,7 +852,7 @@ void emitter_c::visit(const array_type_c &node) {
 void emitter_c::visit(const function_type_c &node) {}
 
 void emitter_c::visit(const map_type_c &node) {
-  _current_expr << get_map_type_name(node.key_type(), node.value_type());
+  _current_expr << get_map_type_name(&node);
 }
 
 void emitter_c::visit(const tuple_type_c &node) {
@@ -697,7 +979,7 @@ void emitter_c::visit(const fn_c &node) {
           _functions << "[" << arr->size().value() << "]";
           current_type = arr->element_type();
         } else {
-          ensure_slice_typedef(arr->element_type());
+          ensure_unsized_typedef(arr);
           break;
         }
       }
@@ -883,7 +1165,7 @@ void emitter_c::visit(const lambda_c &node) {
         _functions << "[" << arr->size().value() << "]";
         current_type = arr->element_type();
       } else {
-        ensure_slice_typedef(arr->element_type());
+        ensure_unsized_typedef(arr);
         break;
       }
     }
@@ -981,7 +1263,7 @@ void emitter_c::visit(const struct_c &node) {
         _structs << "[" << arr->size().value() << "]";
         current_type = arr->element_type();
       } else {
-        ensure_slice_typedef(arr->element_type());
+        ensure_unsized_typedef(arr);
         break;
       }
     }
@@ -1050,7 +1332,7 @@ void emitter_c::visit(const var_c &node) {
   register_variable_type(node.name().name, node.type());
 
   if (auto map = node.type()->as_map_type()) {
-    ensure_map_typedef(map->key_type(), map->value_type());
+    ensure_map_typedef(map);
   }
 
   bool is_private = is_private_identifier(node.name().name);
@@ -1063,7 +1345,7 @@ void emitter_c::visit(const var_c &node) {
       array_dims.push_back(arr->size().value());
       base_type = arr->element_type();
     } else {
-      ensure_slice_typedef(arr->element_type());
+      ensure_unsized_typedef(arr);
       break;
     }
   }
@@ -1165,7 +1447,7 @@ void emitter_c::visit(const let_c &node) {
     register_variable_type(var_name, var_type);
 
     if (auto map = var_type->as_map_type()) {
-      ensure_map_typedef(map->key_type(), map->value_type());
+      ensure_map_typedef(map);
     }
 
     bool is_private = is_private_identifier(var_name);
@@ -1224,7 +1506,7 @@ void emitter_c::visit(const let_c &node) {
         _functions << "[" << arr->size().value() << "]";
         current_type = arr->element_type();
       } else {
-        ensure_slice_typedef(arr->element_type());
+        ensure_unsized_typedef(arr);
         break;
       }
     }
@@ -1386,6 +1668,7 @@ void emitter_c::visit(const while_c &node) {
 }
 
 void emitter_c::visit(const for_c &node) {
+  emit_hoisted_checks(node);
   _functions << cdef::indent(_indent_level) << "for (";
 
   if (node.init()) {
@@ -1623,17 +1906,10 @@ void emitter_c::visit(const assignment_c &node) {
   bool was_in_expr = _in_expression;
 
   if (auto idx = node.target()->as_index()) {
-    bool is_slice = false;
+    bool is_slice = is_slice_expression(idx->object());
     bool is_map = false;
     if (auto ident = idx->object()->as_identifier()) {
-      is_slice = is_variable_slice(ident->id().name);
       is_map = is_variable_map(ident->id().name);
-    } else if (auto inner_idx = idx->object()->as_index()) {
-      is_slice = false;
-      is_map = false;
-    } else {
-      is_slice = false;
-      is_map = false;
     }
 
     if (is_map && !was_in_expr) {
@@ -1641,43 +1917,22 @@ void emitter_c::visit(const assignment_c &node) {
       std::string idx_expr = emit_expression(idx->index());
       std::string value = emit_expression(node.value());
 
-      bool key_is_slice = false;
-      if (auto key_ident = idx->index()->as_identifier()) {
-        key_is_slice = is_variable_slice(key_ident->id().name);
-      }
-
-      auto *key_literal = idx->index()->as_literal();
-      bool key_is_string_literal =
-          key_literal && key_literal->type() == literal_type_e::STRING;
-      bool key_is_non_string_literal = key_literal && !key_is_string_literal;
+      const std::string &map_name = idx->object()->as_identifier()->id().name;
+      auto key = emit_map_key(map_name, idx->index(), idx_expr);
 
       _functions << cdef::indent(_indent_level);
-      _functions << "{ ";
-      if (key_is_string_literal && !key_is_slice) {
-        _functions << "const __truk_u8* __truk_key_tmp = " << idx_expr << "; ";
-        _functions << "(" << obj_expr << ").tmp = " << value << "; ";
-        _functions << "__truk_map_set_(&(" << obj_expr
-                   << ").base, &__truk_key_tmp, &(" << obj_expr
-                   << ").tmp, sizeof((" << obj_expr << ").tmp)); }\n";
-      } else if (key_is_non_string_literal && !key_is_slice) {
-        _functions << "typeof(" << idx_expr << ") __truk_key_tmp = " << idx_expr
-                   << "; ";
-        _functions << "(" << obj_expr << ").tmp = " << value << "; ";
-        _functions << "__truk_map_set_(&(" << obj_expr
-                   << ").base, &__truk_key_tmp, &(" << obj_expr
-                   << ").tmp, sizeof((" << obj_expr << ").tmp)); }\n";
-      } else {
-        _functions << "(" << obj_expr << ").tmp = " << value << "; ";
-        if (key_is_slice) {
-          _functions << "__truk_map_set_(&(" << obj_expr << ").base, &(("
-                     << idx_expr << ").data), &(" << obj_expr
-                     << ").tmp, sizeof((" << obj_expr << ").tmp)); }\n";
-        } else {
-          _functions << "__truk_map_set_(&(" << obj_expr << ").base, &("
-                     << idx_expr << "), &(" << obj_expr << ").tmp, sizeof(("
-                     << obj_expr << ").tmp)); }\n";
-        }
+      if (is_variable_concurrent_map(map_name)) {
+        // The map's tmp field is shared between threads, so stage the value
+        // in a local instead.
+        _functions << "{ " << key.decl << "__truk_concurrent_map_set_generic(&("
+                   << obj_expr << "), " << key.ref << ", " << value << "); }\n";
+        return;
       }
+      _functions << "{ " << key.decl;
+      _functions << "(" << obj_expr << ").tmp = " << value << "; ";
+      _functions << get_variable_map_api(map_name) << "_set_(&(" << obj_expr
+                 << ").base, " << key.ref << ", &(" << obj_expr
+                 << ").tmp, sizeof((" << obj_expr << ").tmp)); }\n";
       return;
     }
 
@@ -1686,12 +1941,24 @@ void emitter_c::visit(const assignment_c &node) {
       std::string idx_expr = emit_expression(idx->index());
       std::string value = emit_expression(node.value());
 
-      _functions << cdef::indent(_indent_level);
-      _functions << "__truk_runtime_sxs_bounds_check(" << idx_expr << ", ("
-                 << obj_expr << ").len);\n";
+      // A subslice is computed once into a temporary, not per use.
+      bool is_subslice = !idx->object()->as_identifier();
+      if (is_subslice) {
+        _functions << cdef::indent(_indent_level) << "{ __typeof__(" << obj_expr
+                   << ") __truk_e = " << obj_expr << ";\n";
+        obj_expr = "__truk_e";
+      }
+      if (needs_bounds_check(idx)) {
+        _functions << cdef::indent(_indent_level);
+        _functions << "__truk_runtime_sxs_bounds_check(" << idx_expr << ", ("
+                   << obj_expr << ").len);\n";
+      }
       _functions << cdef::indent(_indent_level);
       _functions << "(" << obj_expr << ").data[" << idx_expr << "] = " << value
                  << ";\n";
+      if (is_subslice) {
+        _functions << cdef::indent(_indent_level) << "}\n";
+      }
       return;
     }
   }
@@ -1710,6 +1977,9 @@ void emitter_c::visit(const assignment_c &node) {
 void emitter_c::visit(const block_c &node) {
   _functions << "{\n";
   _indent_level++;
+  if (node.is_unchecked()) {
+    _unchecked_block_depth++;
+  }
 
   push_defer_scope(defer_scope_s::scope_type_e::BLOCK, &node);
 
@@ -1720,6 +1990,9 @@ void emitter_c::visit(const block_c &node) {
   emit_scope_defers(_current_defer_scope);
   pop_defer_scope();
 
+  if (node.is_unchecked()) {
+    _unchecked_block_depth--;
+  }
   _indent_level--;
   _functions << cdef::indent(_indent_level) << "}";
 }
@@ -1917,54 +2190,49 @@ std::string emitter_c::emit_expr_struct_literal(const struct_literal_c &node) {
 }
 
 std::string emitter_c::emit_expr_index(const index_c &node) {
+  if (node.is_range()) {
+    return emit_expr_subslice(node);
+  }
+
   std::string obj_expr = emit_expression(node.object());
   std::string idx_expr = emit_expression(node.index());
 
-  bool is_slice = false;
+  bool is_slice = is_slice_expression(node.object());
   bool is_map = false;
   if (auto ident = node.object()->as_identifier()) {
-    is_slice = is_variable_slice(ident->id().name);
     is_map = is_variable_map(ident->id().name);
-  } else if (auto inner_idx = node.object()->as_index()) {
-    if (auto inner_ident = inner_idx->object()->as_identifier()) {
-      if (is_variable_slice(inner_ident->id().name)) {
-        is_slice = false;
-      } else {
-        is_slice = false;
-      }
-    } else {
-      is_slice = false;
-    }
-  } else {
-    is_slice = false;
   }
 
   if (is_map) {
-    bool key_is_slice = false;
-    auto *key_literal = node.index()->as_literal();
-    bool key_is_string_literal =
-        key_literal && key_literal->type() == literal_type_e::STRING;
-    bool key_is_non_string_literal = key_literal && !key_is_string_literal;
-
-    if (auto key_ident = node.index()->as_identifier()) {
-      key_is_slice = is_variable_slice(key_ident->id().name);
-    }
-
-    if (key_is_slice) {
-      return "__truk_map_get_generic(&(" + obj_expr + "), &((" + idx_expr +
-             ").data))";
-    } else if (key_is_string_literal) {
-      return "({ const __truk_u8* __truk_key_tmp = " + idx_expr +
-             "; __truk_map_get_generic(&(" + obj_expr +
-             "), &__truk_key_tmp); })";
-    } else if (key_is_non_string_literal) {
-      return "({ typeof(" + idx_expr + ") __truk_key_tmp = " + idx_expr +
-             "; __truk_map_get_generic(&(" + obj_expr +
-             "), &__truk_key_tmp); })";
-    } else {
-      return "__truk_map_get_generic(&(" + obj_expr + "), &(" + idx_expr + "))";
-    }
+    const std::string &map_name = node.object()->as_identifier()->id().name;
+    auto key = emit_map_key(map_name, node.index(), idx_expr);
+    if (is_variable_concurrent_map(map_name)) {
+      // Reading through a pointer into the map would race with other
+      // threads' writes, so the value is copied out under the shard lock.
+      return "__truk_concurrent_map_get_copy_generic(&(" + obj_expr + "), " +
+             key.block_ref + ")";
+    }
+    std::string get =
+        get_variable_map_api(map_name) + "_get_generic(&(" + obj_expr + "), ";
+    if (key.decl.empty()) {
+      return get + key.ref + ")";
+    }
+    return "({ " + key.decl + get + key.ref + "); })";
   } else if (is_slice) {
+    if (!node.object()->as_identifier()) {
+      // A subslice is evaluated once; the element stays an lvalue through its
+      // address.
+      std::string check =
+          needs_bounds_check(&node)
+              ? "__truk_runtime_sxs_bounds_check(" + idx_expr +
+                    ", __truk_e.len); "
+              : "";
+      return "(*({ __typeof__(" + obj_expr + ") __truk_e = " + obj_expr +
+             "; " + check + "&__truk_e.data[" + idx_expr + "]; }))";
+    }
+    if (!needs_bounds_check(&node)) {
+      return "(" + obj_expr + ").data[" + idx_expr + "]";
+    }
     return "({ __truk_runtime_sxs_bounds_check(" + idx_expr + ", (" + obj_expr +
            ").len); (" + obj_expr + ").data[" + idx_expr + "]; })";
   } else {
@@ -1972,6 +2240,52 @@ std::string emitter_c::emit_expr_index(const index_c &node) {
   }
 }
 
+// s[lo..hi] is a slice struct pointing into the object's storage at lo with
+// length hi - lo. Slices and vecs are copied into a temporary so the object is
+// evaluated once; a fixed-size array contributes its declared size.
+std::string emitter_c::emit_expr_subslice(const index_c &node) {
+  const base_c *root = node.object();
+  while (auto inner = root->as_index()) {
+    root = inner->object();
+  }
+  auto ident = root->as_identifier();
+  const type_c *type =
+      ident ? _variable_registry.get_type(ident->id().name) : nullptr;
+  auto arr = type ? type->as_array_type() : nullptr;
+  if (!arr) {
+    add_error("Subslice requires a slice, vec or array variable", &node);
+    return "";
+  }
+
+  ensure_slice_typedef(arr->element_type());
+  std::string slice_name = get_slice_type_name(arr->element_type());
+  std::string obj_expr = emit_expression(node.object());
+  std::string lo_expr = emit_expression(node.index());
+
+  std::string result = "({ ";
+  std::string base;
+  std::string len;
+  if (node.object() == root && arr->size().has_value()) {
+    base = "(" + obj_expr + ")";
+    len = "(__truk_u64)" + std::to_string(*arr->size());
+  } else {
+    result += "__typeof__(" + obj_expr + ") __truk_s = " + obj_expr + "; ";
+    base = "__truk_s.data";
+    len = "__truk_s.len";
+  }
+  std::string hi_expr = node.end() ? emit_expression(node.end()) : len;
+
+  result += "__truk_u64 __truk_lo = " + lo_expr + "; ";
+  result += "__truk_u64 __truk_hi = " + hi_expr + "; ";
+  if (needs_bounds_check(&node)) {
+    result += "__truk_runtime_sxs_range_check(__truk_lo, __truk_hi, " + len +
+              "); ";
+  }
+  result += "(" + slice_name + "){" + base + " + __truk_lo, __truk_hi - " +
+            "__truk_lo}; })";
+  return result;
+}
+
 std::string emitter_c::emit_expr_call(const call_c &node) {
   if (auto ident = node.callee()->as_identifier()) {
     if (auto *handler = _builtin_registry.get_handler(ident->id().name)) {
@@ -2250,7 +2564,8 @@ assembly_result_s result_c::assemble(assembly_type_e type,
                            header_content, header_name);
 }
 
-std::string result_c::assemble_test_runner() const {
+std::string
+result_c::assemble_test_runner(const test_runner_options_s &options) const {
   std::string output;
 
   if (metadata.test_functions.empty()) {
@@ -2264,6 +2579,30 @@ std::string result_c::assemble_test_runner() const {
     output += chunk;
   }
 
+  if (options.isolate) {
+    output += "\n" + cdef::emit_isolated_test_runner();
+    output += "\nint main(int argc, char** argv) {\n";
+    output += "    static const __truk_test_case_s tests[] = {\n";
+    for (const auto &test_name : metadata.test_functions) {
+      output += "        {\"" + test_name + "\", " + test_name + "},\n";
+    }
+    output += "    };\n";
+    output += "    __truk_test_runner_s runner = {0};\n";
+    if (metadata.has_test_setup) {
+      output += "    runner.setup = test_setup;\n";
+    }
+    if (metadata.has_test_teardown) {
+      output += "    runner.teardown = test_teardown;\n";
+    }
+    output += fmt::format("    runner.jobs = {};\n", options.jobs);
+    output += fmt::format("    runner.timeout_ms = {}ULL;\n", options.timeout_ms);
+    output += "    return __truk_test_run_isolated(tests, "
+              "(__truk_i32)(sizeof(tests) / sizeof(tests[0])), &runner, argc, "
+              "argv);\n";
+    output += "}\n";
+    return output;
+  }
+
   output += "\nint main(int argc, char** argv) {\n";
   output += "    int total_tests = 0;\n";
   output += "    int total_failed = 0;\n\n";
@@ -2276,6 +2615,7 @@ std::string result_c::assemble_test_runner() const {
     output += "        ctx.argv = argv;\n";
     output +=
         "        printf(\"Running %s...\\n\", ctx.current_test_name);\n\n";
+    output += "        __truk_test_begin(&ctx);\n";
 
     if (metadata.has_test_setup) {
       output += "        test_setup(&ctx);\n";
@@ -2287,6 +2627,7 @@ std::string result_c::assemble_test_runner() const {
       output += "        test_teardown(&ctx);\n";
     }
 
+    output += "        __truk_test_end(&ctx);\n";
     output += "        total_tests++;\n";
     output += "        if (ctx.has_failed) {\n";
     output += "            printf(\"  FAILED (%d/%d assertions)\\n\", "
@@ -2296,6 +2637,8 @@ std::string result_c::assemble_test_runner() const {
     output +=
         "            printf(\"  PASSED (%d assertions)\\n\", ctx.passed);\n";
     output += "        }\n";
+    output += "        __truk_test_record(&ctx, ctx.has_failed ? \"failed\" : "
+              "\"passed\");\n";
     output += "    }\n\n";
   }
 
@@ -58,13 +58,15 @@ std::string type_registry_c::get_c_type(const type_c *type) {
   if (auto arr = type->as_array_type()) {
     if (arr->size().has_value()) {
       return get_c_type(arr->element_type());
+    } else if (arr->growable()) {
+      return get_vec_type_name(arr->element_type());
     } else {
       return get_slice_type_name(arr->element_type());
     }
   }
 
   if (auto map = type->as_map_type()) {
-    return get_map_type_name(map->key_type(), map->value_type());
+    return get_map_type_name(map);
   }
 
   if (auto tuple = type->as_tuple_type()) {
@@ -142,6 +144,8 @@ std::string type_registry_c::get_c_type_for_sizeof(const type_c *type) {
     if (arr->size().has_value()) {
       std::string base = get_c_type_for_sizeof(arr->element_type());
       return base + "[" + std::to_string(arr->size().value()) + "]";
+    } else if (arr->growable()) {
+      return get_vec_type_name(arr->element_type());
     } else {
       return get_slice_type_name(arr->element_type());
     }
@@ -222,6 +226,28 @@ void type_registry_c::ensure_slice_typedef(const type_c *element_type,
   }
 }
 
+std::string type_registry_c::get_vec_type_name(const type_c *element_type) {
+  std::string name = get_slice_type_name(element_type);
+  return "truk_vec_" + name.substr(std::string("truk_slice_").size());
+}
+
+// A vec starts with the same data and len members as the slice of its
+// element type, followed by the allocated capacity.
+void type_registry_c::ensure_vec_typedef(const type_c *element_type,
+                                         std::stringstream &header_stream) {
+  std::string vec_name = get_vec_type_name(element_type);
+  if (_slice_types_emitted.insert(vec_name).second) {
+    std::string data_member;
+    auto arr = element_type->as_array_type();
+    if (arr && arr->size().has_value()) {
+      data_member = get_array_pointer_type(element_type, "data");
+    } else {
+      data_member = get_c_type_for_sizeof(element_type) + "* data";
+    }
+    header_stream << cdef::emit_vec_typedef(data_member, vec_name);
+  }
+}
+
 bool type_registry_c::is_slice_type(const type_c *type) {
   if (auto arr = type->as_array_type()) {
     return !arr->size().has_value();
@@ -229,10 +255,27 @@ bool type_registry_c::is_slice_type(const type_c *type) {
   return false;
 }
 
-std::string type_registry_c::get_map_type_name(const type_c *key_type,
-                                               const type_c *value_type) {
-  std::string key_str = get_c_type_for_sizeof(key_type);
-  std::string value_str = get_c_type_for_sizeof(value_type);
+bool type_registry_c::is_vec_type(const type_c *type) {
+  auto arr = type->as_array_type();
+  return arr && arr->growable();
+}
+
+// Prefix of the runtime macros for a map's flavor: __truk_map for the flat
+// map, __truk_ordered_map and __truk_concurrent_map for maps declared
+// map[K, V, ordered] and map[K, V, concurrent].
+std::string type_registry_c::get_map_api(const map_type_c *map) const {
+  if (map->ordered()) {
+    return "__truk_ordered_map";
+  }
+  if (map->concurrent()) {
+    return "__truk_concurrent_map";
+  }
+  return "__truk_map";
+}
+
+std::string type_registry_c::get_map_type_name(const map_type_c *map) {
+  std::string key_str = get_c_type_for_sizeof(map->key_type());
+  std::string value_str = get_c_type_for_sizeof(map->value_type());
   std::string sanitized_key = key_str;
   std::string sanitized_value = value_str;
 
@@ -248,19 +291,24 @@ std::string type_registry_c::get_map_type_name(const type_c *key_type,
     if (c == '[' || c == ']' || c == ' ' || c == '(' || c == ')')
       c = '_';
   }
-  return "__truk_map_" + sanitized_key + "_" + sanitized_value;
+  return get_map_api(map) + "_" + sanitized_key + "_" + sanitized_value;
 }
 
-void type_registry_c::ensure_map_typedef(const type_c *key_type,
-                                         const type_c *value_type,
+void type_registry_c::ensure_map_typedef(const map_type_c *map,
                                          std::stringstream &structs_stream) {
-  std::string map_name = get_map_type_name(key_type, value_type);
+  std::string map_name = get_map_type_name(map);
 
   if (_map_types_emitted.find(map_name) == _map_types_emitted.end()) {
     _map_types_emitted.insert(map_name);
-    std::string value_str = get_c_type_for_sizeof(value_type);
-    structs_stream << "typedef __truk_map_t(" << value_str << ") " << map_name
-                   << ";\n\n";
+    if (map->ordered()) {
+      _ordered_maps_emitted = true;
+    }
+    if (map->concurrent()) {
+      _concurrent_maps_emitted = true;
+    }
+    std::string value_str = get_c_type_for_sizeof(map->value_type());
+    structs_stream << "typedef " << get_map_api(map) << "_t(" << value_str
+                   << ") " << map_name << ";\n\n";
   }
 }
 
@@ -270,6 +318,14 @@ bool type_registry_c::is_map_type(const type_c *type) {
 
 bool type_registry_c::has_maps() const { return !_map_types_emitted.empty(); }
 
+bool type_registry_c::has_ordered_maps() const {
+  return _ordered_maps_emitted;
+}
+
+bool type_registry_c::has_concurrent_maps() const {
+  return _concurrent_maps_emitted;
+}
+
 bool type_registry_c::is_string_ptr_type(const type_c *type) {
   if (auto ptr = type->as_pointer_type()) {
     if (auto pointee = ptr->pointee_type()) {
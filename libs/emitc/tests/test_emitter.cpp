@@ -1,6 +1,7 @@
 #include <cstring>
 #include <truk/emitc/emitter.hpp>
 #include <truk/ingestion/parser.hpp>
+#include <truk/validation/typecheck.hpp>
 
 #include <CppUTest/CommandLineTestRunner.h>
 #include <CppUTest/TestHarness.h>
@@ -98,6 +99,140 @@ TEST(EmitterBasicTests, EmitCompleteProgram) {
   CHECK_TRUE(result.chunks.size() >= 3);
 }
 
+TEST(EmitterBasicTests, AllocTrackingTagsMakeSites) {
+  const char *source = R"(
+    fn main() : i32 {
+      var p: *i32 = make(@i32);
+      delete(p);
+      return 0;
+    }
+  )";
+  truk::ingestion::parser_c parser(source, std::strlen(source));
+  auto parsed = parser.parse();
+  CHECK_TRUE(parsed.success);
+  auto result = emitter->add_declarations(parsed.declarations)
+                    .set_alloc_tracking(truk::emitc::alloc_tracking_e::SAMPLED)
+                    .finalize();
+  CHECK_FALSE(result.has_errors());
+  std::string code;
+  for (const auto &chunk : result.chunks) {
+    code += chunk;
+  }
+  CHECK_TRUE(code.find("#define TRUK_TRACK_ALLOCS_SAMPLE") != std::string::npos);
+  CHECK_TRUE(code.find("__truk_runtime_sxs_alloc_at(") != std::string::npos);
+  CHECK_TRUE(code.find("__TRUK_ALLOC_SITE(\"<unknown>\", 0)") !=
+             std::string::npos);
+}
+
+TEST(EmitterBasicTests, ConcurrentMapReadsCopyOut) {
+  const char *source = R"(
+    fn main() : i32 {
+      var m: map[i32, i32, concurrent] = make(@map[i32, i32, concurrent]);
+      var k: i32 = 3;
+      var a: *i32 = m[k];
+      var b: *i32 = get_or_insert(m, k, 4);
+      delete(m);
+      return 0;
+    }
+  )";
+  auto result = parse_and_emit(source);
+  CHECK_FALSE(result.has_errors());
+  std::string code;
+  for (const auto &chunk : result.chunks) {
+    code += chunk;
+  }
+  CHECK_TRUE(code.find("__truk_concurrent_map_get_copy_generic(&(m), &(k))") !=
+             std::string::npos);
+  CHECK_TRUE(code.find("__truk_concurrent_map_get_or_insert_copy_generic(&(m), "
+                       "&(k), 4)") != std::string::npos);
+  CHECK_TRUE(code.find("__truk_concurrent_map_get_generic(&(m)") ==
+             std::string::npos);
+}
+
+TEST(EmitterBasicTests, SliceTypedMapKeysUseDataAndLength) {
+  const char *source = R"(
+    struct Entry {
+      name: []u8,
+      id: i32
+    }
+
+    fn pick(buf: []u8) : []u8 {
+      return buf[0..1];
+    }
+
+    fn main() : i32 {
+      var m: map[*u8, i32] = make(@map[*u8, i32]);
+      var buf: []u8 = make(@u8, 2 as u64);
+      var e: Entry = Entry{name: buf, id: 1};
+      m[buf[0..2]] = 1;
+      m[e.name] = 2;
+      var p: *i32 = m[pick(buf)];
+      return 0;
+    }
+  )";
+  truk::ingestion::parser_c parser(source, std::strlen(source));
+  auto parsed = parser.parse();
+  CHECK_TRUE(parsed.success);
+  truk::validation::type_checker_c checker;
+  for (const auto &decl : parsed.declarations) {
+    checker.check(decl.get());
+  }
+  CHECK_FALSE(checker.has_errors());
+  CHECK_EQUAL(3, checker.slice_map_keys().size());
+
+  auto result = emitter->add_declarations(parsed.declarations)
+                    .set_slice_map_keys(checker.slice_map_keys())
+                    .finalize();
+  CHECK_FALSE(result.has_errors());
+  std::string code;
+  for (const auto &chunk : result.chunks) {
+    code += chunk;
+  }
+  CHECK_TRUE(code.find("__truk_map_strkey_cstr(e.name)") ==
+             std::string::npos);
+  CHECK_TRUE(code.find("__truk_map_strkey_cstr(pick(") == std::string::npos);
+  CHECK_TRUE(code.find("__truk_map_strkey_cstr(({") == std::string::npos);
+  std::size_t keyed = 0;
+  for (auto at = code.find("__truk_key_src.len"); at != std::string::npos;
+       at = code.find("__truk_key_src.len", at + 1)) {
+    keyed++;
+  }
+  CHECK_EQUAL(3, keyed);
+}
+
+TEST(EmitterBasicTests, IsolatedTestRunnerForksPerTest) {
+  const char *source = R"(
+    extern struct __truk_test_context_s;
+
+    fn test_setup(t: *__truk_test_context_s) : void {}
+
+    fn test_one(t: *__truk_test_context_s) : void {}
+
+    fn test_two(t: *__truk_test_context_s) : void {}
+  )";
+  auto result = parse_and_emit(source);
+  CHECK_FALSE(result.has_errors());
+
+  std::string serial = result.assemble_test_runner();
+  CHECK_TRUE(serial.find("__truk_test_run_isolated(tests") ==
+             std::string::npos);
+  CHECK_TRUE(serial.find("__truk_test_begin(&ctx);\n"
+                         "        test_setup(&ctx);") != std::string::npos);
+  CHECK_TRUE(serial.find("__truk_test_record(&ctx,") != std::string::npos);
+  CHECK_TRUE(serial.find("#include <sys/wait.h>") == std::string::npos);
+
+  std::string isolated = result.assemble_test_runner({true, 4, 2500});
+  CHECK_TRUE(isolated.find("#include <sys/wait.h>") != std::string::npos);
+  CHECK_TRUE(isolated.find("{\"test_one\", test_one},\n"
+                           "        {\"test_two\", test_two},") !=
+             std::string::npos);
+  CHECK_TRUE(isolated.find("runner.setup = test_setup;") != std::string::npos);
+  CHECK_TRUE(isolated.find("runner.teardown") == std::string::npos);
+  CHECK_TRUE(isolated.find("runner.jobs = 4;") != std::string::npos);
+  CHECK_TRUE(isolated.find("runner.timeout_ms = 2500ULL;") !=
+             std::string::npos);
+}
+
 int main(int argc, char **argv) {
   return CommandLineTestRunner::RunAllTests(argc, argv);
 }
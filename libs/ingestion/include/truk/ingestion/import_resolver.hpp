@@ -32,6 +32,8 @@ struct resolved_imports_s {
   std::unordered_map<const truk::language::nodes::base_c *, std::string>
       decl_to_file;
   std::unordered_map<std::string, std::vector<std::string>> file_to_shards;
+  // Canonical path of every .truk file read, in the order they finished.
+  std::vector<std::string> source_files;
   bool success;
 };
 
@@ -116,6 +118,7 @@ private:
 
   std::vector<std::string> _include_paths;
   std::unordered_set<std::string> _processed_files;
+  std::vector<std::string> _source_files;
   std::vector<std::string> _import_stack;
   std::vector<truk::language::nodes::base_ptr> _all_declarations;
   std::unordered_map<std::string, const truk::language::nodes::base_c *>
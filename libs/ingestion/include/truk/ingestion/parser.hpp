@@ -84,7 +84,7 @@ private:
   language::nodes::type_ptr parse_tuple_type();
 
   language::nodes::base_ptr parse_statement();
-  language::nodes::base_ptr parse_block();
+  language::nodes::base_ptr parse_block(bool is_unchecked = false);
   language::nodes::base_ptr parse_if_stmt();
   language::nodes::base_ptr parse_while_stmt();
   language::nodes::base_ptr parse_for_stmt();
@@ -93,6 +93,7 @@ private:
   language::nodes::base_ptr parse_break_stmt();
   language::nodes::base_ptr parse_continue_stmt();
   language::nodes::base_ptr parse_defer_stmt();
+  language::nodes::base_ptr parse_unchecked_block();
   language::nodes::base_ptr parse_expression_stmt();
 
   language::nodes::base_ptr parse_expression();
@@ -68,6 +68,7 @@ enum class token_type_e {
   DOT,
   ARROW,
   FAT_ARROW,
+  DOT_DOT,
   DOT_DOT_DOT,
   AT,
   END_OF_FILE,
@@ -242,6 +242,9 @@ void dependency_visitor_c::visit(const index_c &node) {
   if (node.index()) {
     node.index()->accept(*this);
   }
+  if (node.end()) {
+    node.end()->accept(*this);
+  }
 }
 
 void dependency_visitor_c::visit(const member_access_c &node) {
@@ -352,6 +355,7 @@ import_resolver_c::resolve_import_path(const std::string &import_path,
 
 resolved_imports_s import_resolver_c::resolve(const std::string &entry_file) {
   _processed_files.clear();
+  _source_files.clear();
   _import_stack.clear();
   _all_declarations.clear();
   _symbol_to_decl.clear();
@@ -374,6 +378,7 @@ resolved_imports_s import_resolver_c::resolve(const std::string &entry_file) {
   result.c_imports = std::move(_c_imports);
   result.decl_to_file = _decl_to_file;
   result.file_to_shards = _file_to_shards;
+  result.source_files = std::move(_source_files);
 
   return result;
 }
@@ -426,6 +431,7 @@ void import_resolver_c::process_file(const std::string &file_path) {
 
   _import_stack.pop_back();
   _processed_files.insert(canonical);
+  _source_files.push_back(canonical);
 }
 
 void import_resolver_c::extract_imports_and_declarations(
@@ -555,9 +555,37 @@ language::nodes::type_ptr parser_c::parse_type_internal() {
           throw parse_error("Expected value type in map", peek().line,
                             peek().column);
         }
+        auto map_flavor = language::nodes::map_flavor_e::FLAT;
+        if (match(token_type_e::COMMA)) {
+          const auto &flavor = consume(token_type_e::IDENTIFIER,
+                                       "Expected map flavor after ','");
+          if (flavor.lexeme == "ordered") {
+            map_flavor = language::nodes::map_flavor_e::ORDERED;
+          } else if (flavor.lexeme == "concurrent") {
+            map_flavor = language::nodes::map_flavor_e::CONCURRENT;
+          } else {
+            throw parse_error("Unknown map flavor '" + flavor.lexeme +
+                                  "' (expected 'ordered' or 'concurrent')",
+                              flavor.line, flavor.column);
+          }
+        }
         consume(token_type_e::RIGHT_BRACKET, "Expected ']' after value type");
         return std::make_unique<language::nodes::map_type_c>(
-            map_token.source_index, std::move(key_type), std::move(value_type));
+            map_token.source_index, std::move(key_type), std::move(value_type),
+            map_flavor);
+      }
+      case language::keywords_e::VEC: {
+        const auto &vec_token = advance();
+        consume(token_type_e::LEFT_BRACKET, "Expected '[' after 'vec'");
+        auto element_type = parse_type_internal();
+        if (!element_type) {
+          throw parse_error("Expected element type in vec", peek().line,
+                            peek().column);
+        }
+        consume(token_type_e::RIGHT_BRACKET, "Expected ']' after element type");
+        return std::make_unique<language::nodes::array_type_c>(
+            vec_token.source_index, std::move(element_type), std::nullopt,
+            true);
       }
       default:
         break;
@@ -727,13 +755,16 @@ language::nodes::base_ptr parser_c::parse_statement() {
   if (check_keyword(language::keywords_e::DEFER)) {
     return parse_defer_stmt();
   }
+  if (check_keyword(language::keywords_e::UNCHECKED)) {
+    return parse_unchecked_block();
+  }
   if (check(token_type_e::LEFT_BRACE)) {
     return parse_block();
   }
   return parse_expression_stmt();
 }
 
-language::nodes::base_ptr parser_c::parse_block() {
+language::nodes::base_ptr parser_c::parse_block(bool is_unchecked) {
   const auto &brace_token = consume(token_type_e::LEFT_BRACE, "Expected '{'");
 
   std::vector<language::nodes::base_ptr> statements;
@@ -743,8 +774,8 @@ language::nodes::base_ptr parser_c::parse_block() {
 
   consume(token_type_e::RIGHT_BRACE, "Expected '}' after block");
 
-  return std::make_unique<language::nodes::block_c>(brace_token.source_index,
-                                                    std::move(statements));
+  return std::make_unique<language::nodes::block_c>(
+      brace_token.source_index, std::move(statements), is_unchecked);
 }
 
 language::nodes::base_ptr parser_c::parse_if_stmt() {
@@ -955,6 +986,12 @@ language::nodes::base_ptr parser_c::parse_defer_stmt() {
                                                     std::move(deferred_code));
 }
 
+language::nodes::base_ptr parser_c::parse_unchecked_block() {
+  consume_keyword(language::keywords_e::UNCHECKED,
+                  "Expected 'unchecked' keyword");
+  return parse_block(true);
+}
+
 language::nodes::base_ptr parser_c::parse_expression_stmt() {
   auto expr = parse_expression();
   consume(token_type_e::SEMICOLON, "Expected ';' after expression");
@@ -978,7 +1015,7 @@ clone_expr_for_compound_assignment(const language::nodes::base_c *expr) {
         lit->source_index(), lit->type(), lit->value());
   }
 
-  if (auto *index = expr->as_index()) {
+  if (auto *index = expr->as_index(); index && !index->is_range()) {
     auto cloned_object = clone_expr_for_compound_assignment(index->object());
     auto cloned_index = clone_expr_for_compound_assignment(index->index());
     if (!cloned_object || !cloned_index) {
@@ -1337,10 +1374,28 @@ language::nodes::base_ptr parser_c::parse_postfix() {
           paren_token.source_index, std::move(expr), std::move(arguments));
     } else if (match(token_type_e::LEFT_BRACKET)) {
       const auto &bracket_token = previous();
-      auto index = parse_expression();
-      consume(token_type_e::RIGHT_BRACKET, "Expected ']' after index");
-      expr = std::make_unique<language::nodes::index_c>(
-          bracket_token.source_index, std::move(expr), std::move(index));
+      language::nodes::base_ptr index;
+      if (check(token_type_e::DOT_DOT)) {
+        index = std::make_unique<language::nodes::literal_c>(
+            peek().source_index, language::nodes::literal_type_e::INTEGER,
+            "0");
+      } else {
+        index = parse_expression();
+      }
+      if (match(token_type_e::DOT_DOT)) {
+        language::nodes::base_ptr end;
+        if (!check(token_type_e::RIGHT_BRACKET)) {
+          end = parse_expression();
+        }
+        consume(token_type_e::RIGHT_BRACKET, "Expected ']' after range");
+        expr = std::make_unique<language::nodes::index_c>(
+            bracket_token.source_index, std::move(expr), std::move(index),
+            true, std::move(end));
+      } else {
+        consume(token_type_e::RIGHT_BRACKET, "Expected ']' after index");
+        expr = std::make_unique<language::nodes::index_c>(
+            bracket_token.source_index, std::move(expr), std::move(index));
+      }
     } else if (match(token_type_e::DOT)) {
       const auto &dot_token = previous();
       const auto &field_token =
@@ -494,6 +494,11 @@ std::optional<token_s> tokenizer_c::next_token() {
       return make_token(token_type_e::DOT_DOT_DOT, start_pos, start_line,
                         start_column);
     }
+    if (current_char() == '.') {
+      advance();
+      return make_token(token_type_e::DOT_DOT, start_pos, start_line,
+                        start_column);
+    }
     return make_token(token_type_e::DOT, start_pos, start_line, start_column);
 
   case '@':
@@ -1061,6 +1061,50 @@ TEST(ParserTypeSystem, ErrorArraySizeWithBoolean) {
   validate_parse_failure(source, "Array size must be an integer literal");
 }
 
+TEST(ParserTypeSystem, OrderedMapType) {
+  const char *source = R"(
+    fn plain(m: map[i32, i64]) {}
+    fn ordered(m: map[*u8, i64, ordered]) {}
+  )";
+  parse_result_wrapper_s wrapper(source);
+
+  CHECK_TRUE(wrapper.result.success);
+  auto *plain = wrapper.result.declarations[0].get()->as_fn();
+  auto *ordered = wrapper.result.declarations[1].get()->as_fn();
+  CHECK_FALSE(plain->params()[0].type->as_map_type()->ordered());
+  CHECK_TRUE(ordered->params()[0].type->as_map_type()->ordered());
+}
+
+TEST(ParserTypeSystem, ConcurrentMapType) {
+  const char *source = "fn shared(m: map[u64, i32, concurrent]) {}";
+  parse_result_wrapper_s wrapper(source);
+
+  CHECK_TRUE(wrapper.result.success);
+  auto *map = wrapper.result.declarations[0]
+                  .get()
+                  ->as_fn()
+                  ->params()[0]
+                  .type->as_map_type();
+  CHECK_TRUE(map->concurrent());
+  CHECK_FALSE(map->ordered());
+}
+
+TEST(ParserTypeSystem, VecType) {
+  const char *source = "fn test(v: vec[i32], s: []i32) {}";
+  parse_result_wrapper_s wrapper(source);
+
+  CHECK_TRUE(wrapper.result.success);
+  auto &params = wrapper.result.declarations[0].get()->as_fn()->params();
+  CHECK_TRUE(params[0].type->as_array_type()->growable());
+  CHECK_FALSE(params[0].type->as_array_type()->size().has_value());
+  CHECK_FALSE(params[1].type->as_array_type()->growable());
+}
+
+TEST(ParserTypeSystem, ErrorUnknownMapFlavor) {
+  const char *source = "fn test(m: map[i32, i32, sorted]) {}";
+  validate_parse_failure(source, "Unknown map flavor 'sorted'");
+}
+
 TEST_GROUP(ParserControlFlow){void setup() override{} void teardown()
                                   override{}};
 
@@ -1304,6 +1348,29 @@ TEST(ParserControlFlow, ReturnWithExpression) {
              return_stmt->expressions()[0].get() != nullptr);
 }
 
+TEST(ParserControlFlow, UncheckedBlock) {
+  const char *source = "fn test() { unchecked { s[i] = 0; } { s[i] = 1; } }";
+  parse_result_wrapper_s wrapper(source);
+
+  CHECK_TRUE(wrapper.result.success);
+
+  auto *fn = wrapper.result.declarations[0].get()->as_fn();
+  auto *body = fn->body()->as_block();
+  auto *unchecked = body->statements()[0].get()->as_block();
+  auto *plain = body->statements()[1].get()->as_block();
+
+  CHECK_TRUE(unchecked != nullptr);
+  CHECK_TRUE(unchecked->is_unchecked());
+  CHECK_EQUAL(1, unchecked->statements().size());
+  CHECK_TRUE(plain != nullptr);
+  CHECK_FALSE(plain->is_unchecked());
+}
+
+TEST(ParserControlFlow, ErrorUncheckedWithoutBlock) {
+  const char *source = "fn test() { unchecked s[i] = 0; }";
+  validate_parse_failure(source, "Expected '{'");
+}
+
 TEST(ParserControlFlow, ErrorMissingIfCondition) {
   const char *source = "fn test() { if { return 1; } }";
   validate_parse_failure(source, "Expected expression");
@@ -2089,6 +2156,28 @@ TEST(ParserPostfixOperations, MultiDimensionalArrayIndexing) {
   CHECK_TRUE(inner_index != nullptr);
 }
 
+TEST(ParserPostfixOperations, SubsliceRange) {
+  const char *source = "fn test() { a[1..n]; a[..4]; a[2..]; a[i]; }";
+  parse_result_wrapper_s wrapper(source);
+
+  CHECK_TRUE(wrapper.result.success);
+
+  auto *fn = wrapper.result.declarations[0].get()->as_fn();
+  auto *body = fn->body()->as_block();
+  auto *full = body->statements()[0].get()->as_index();
+  auto *head = body->statements()[1].get()->as_index();
+  auto *tail = body->statements()[2].get()->as_index();
+  auto *plain = body->statements()[3].get()->as_index();
+
+  CHECK_TRUE(full->is_range());
+  CHECK_TRUE(full->end()->as_identifier() != nullptr);
+  CHECK_TRUE(head->is_range());
+  STRCMP_EQUAL("0", head->index()->as_literal()->value().c_str());
+  CHECK_TRUE(tail->is_range());
+  CHECK_TRUE(tail->end() == nullptr);
+  CHECK_FALSE(plain->is_range());
+}
+
 TEST(ParserPostfixOperations, MemberAccess) {
   const char *source = "fn test() { return obj.field; }";
   parse_result_wrapper_s wrapper(source);
@@ -10,11 +10,34 @@ namespace truk::language::builtins {
 
 enum class builtin_kind_e {
   MAKE,
+  MAKE_IN,
   DELETE,
+  DELETE_IN,
   LEN,
   SIZEOF,
   PANIC,
   EACH,
+  MAP_RESERVE,
+  MAP_SHRINK,
+  MAP_GET_OR_INSERT,
+  VEC_PUSH,
+  VEC_POP,
+  VEC_CAP,
+  BYTES_FIND,
+  BYTES_FIND_ANY,
+  BYTES_COUNT,
+  BYTES_COMPARE,
+  BYTES_FILL,
+  BYTES_COPY,
+  BYTES_UTF8_VALID,
+  SCAN_GROUP,
+  SCAN_TOKEN,
+  ALLOCATOR_ARENA,
+  ALLOCATOR_POOL,
+  ALLOCATOR_SLAB,
+  ALLOCATOR_RESET,
+  ALLOCATOR_DESTROY,
+  ALLOCATOR_USE,
   VA_ARG_I32,
   VA_ARG_I64,
   VA_ARG_F64,
@@ -35,4 +58,6 @@ const builtin_signature_s *lookup_builtin(const std::string &name);
 
 nodes::type_ptr clone_type(const nodes::type_c *type);
 
+bool is_bytes_builtin(builtin_kind_e kind);
+
 } // namespace truk::language::builtins
@@ -22,6 +22,7 @@ enum class keywords_e {
   BREAK,
   CONTINUE,
   DEFER,
+  UNCHECKED,
   AS,
   TRUE,
   FALSE,
@@ -44,7 +45,8 @@ enum class keywords_e {
   F64,
   BOOL,
   VOID,
-  MAP
+  MAP,
+  VEC
 };
 
 class keywords_c {
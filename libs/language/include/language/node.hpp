@@ -274,16 +274,23 @@ private:
   type_ptr _pointee_type;
 };
 
+// [N]T is a fixed array, []T a slice and vec[T] a growable slice. A vec is
+// laid out like a slice with a trailing capacity, so everything that reads a
+// slice (indexing, len, each) works on it unchanged.
 class array_type_c : public type_c {
 public:
   array_type_c() = delete;
   array_type_c(std::size_t source_index, type_ptr element_type,
-               std::optional<std::size_t> size = std::nullopt)
-      : type_c(keywords_e::UNKNOWN_KEYWORD, source_index),
-        _element_type(std::move(element_type)), _size(size) {}
+               std::optional<std::size_t> size = std::nullopt,
+               bool growable = false)
+      : type_c(growable ? keywords_e::VEC : keywords_e::UNKNOWN_KEYWORD,
+               source_index),
+        _element_type(std::move(element_type)), _size(size),
+        _growable(growable) {}
 
   const type_c *element_type() const { return _element_type.get(); }
   std::optional<std::size_t> size() const { return _size; }
+  bool growable() const { return _growable; }
 
   void accept(visitor_if &visitor) const override;
   node_kind_e kind() const override { return node_kind_e::ARRAY_TYPE; }
@@ -293,6 +300,7 @@ public:
 private:
   type_ptr _element_type;
   std::optional<std::size_t> _size;
+  bool _growable;
 };
 
 class function_type_c : public type_c {
@@ -319,15 +327,21 @@ private:
   bool _has_variadic{false};
 };
 
+enum class map_flavor_e { FLAT, ORDERED, CONCURRENT };
+
 class map_type_c : public type_c {
 public:
   map_type_c() = delete;
-  map_type_c(std::size_t source_index, type_ptr key_type, type_ptr value_type)
+  map_type_c(std::size_t source_index, type_ptr key_type, type_ptr value_type,
+             map_flavor_e flavor = map_flavor_e::FLAT)
       : type_c(keywords_e::MAP, source_index), _key_type(std::move(key_type)),
-        _value_type(std::move(value_type)) {}
+        _value_type(std::move(value_type)), _flavor(flavor) {}
 
   const type_c *key_type() const { return _key_type.get(); }
   const type_c *value_type() const { return _value_type.get(); }
+  map_flavor_e flavor() const { return _flavor; }
+  bool ordered() const { return _flavor == map_flavor_e::ORDERED; }
+  bool concurrent() const { return _flavor == map_flavor_e::CONCURRENT; }
 
   void accept(visitor_if &visitor) const override;
   node_kind_e kind() const override { return node_kind_e::MAP_TYPE; }
@@ -337,6 +351,7 @@ public:
 private:
   type_ptr _key_type;
   type_ptr _value_type;
+  map_flavor_e _flavor{map_flavor_e::FLAT};
 };
 
 class tuple_type_c : public type_c {
@@ -782,15 +797,22 @@ private:
   std::vector<base_ptr> _arguments;
 };
 
+// `object[index]`, or the subslice `object[index..end]` when is_range() is
+// set. A range always has a start (the parser supplies 0 for `[..end]`);
+// end() is null when the range runs to the length of the object.
 class index_c : public base_c {
 public:
   index_c() = delete;
-  index_c(std::size_t source_index, base_ptr object, base_ptr index)
+  index_c(std::size_t source_index, base_ptr object, base_ptr index,
+          bool is_range = false, base_ptr end = nullptr)
       : base_c(keywords_e::UNKNOWN_KEYWORD, source_index),
-        _object(std::move(object)), _index(std::move(index)) {}
+        _object(std::move(object)), _index(std::move(index)),
+        _is_range(is_range), _end(std::move(end)) {}
 
   const base_c *object() const { return _object.get(); }
   const base_c *index() const { return _index.get(); }
+  bool is_range() const { return _is_range; }
+  const base_c *end() const { return _end.get(); }
 
   void accept(visitor_if &visitor) const override;
   node_kind_e kind() const override { return node_kind_e::INDEX; }
@@ -799,6 +821,8 @@ public:
 private:
   base_ptr _object;
   base_ptr _index;
+  bool _is_range;
+  base_ptr _end;
 };
 
 class member_access_c : public base_c {
@@ -896,11 +920,13 @@ private:
 class block_c : public base_c {
 public:
   block_c() = delete;
-  block_c(std::size_t source_index, std::vector<base_ptr> statements)
+  block_c(std::size_t source_index, std::vector<base_ptr> statements,
+          bool is_unchecked = false)
       : base_c(keywords_e::UNKNOWN_KEYWORD, source_index),
-        _statements(std::move(statements)) {}
+        _statements(std::move(statements)), _is_unchecked(is_unchecked) {}
 
   const std::vector<base_ptr> &statements() const { return _statements; }
+  bool is_unchecked() const { return _is_unchecked; }
 
   void accept(visitor_if &visitor) const override;
   node_kind_e kind() const override { return node_kind_e::BLOCK; }
@@ -908,6 +934,7 @@ public:
 
 private:
   std::vector<base_ptr> _statements;
+  bool _is_unchecked{false};
 };
 
 class array_literal_c : public base_c {
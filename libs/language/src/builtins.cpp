@@ -28,7 +28,8 @@ nodes::type_ptr clone_type(const nodes::type_c *type) {
   if (auto *array = type->as_array_type()) {
     auto element = clone_type(array->element_type());
     return std::make_unique<array_type_c>(array->source_index(),
-                                          std::move(element), array->size());
+                                          std::move(element), array->size(),
+                                          array->growable());
   }
 
   if (auto *function = type->as_function_type()) {
@@ -68,6 +69,21 @@ static type_ptr build_delete_signature(const type_c *type_param) {
                                            std::move(return_type));
 }
 
+static type_ptr build_delete_in_signature(const type_c *type_param) {
+  std::vector<type_ptr> params;
+
+  for (int i = 0; i < 2; i++) {
+    auto void_type = std::make_unique<primitive_type_c>(keywords_e::VOID, 0);
+    params.push_back(
+        std::make_unique<pointer_type_c>(0, std::move(void_type)));
+  }
+
+  auto return_type = std::make_unique<primitive_type_c>(keywords_e::VOID, 0);
+
+  return std::make_unique<function_type_c>(0, std::move(params),
+                                           std::move(return_type));
+}
+
 static type_ptr build_len_signature(const type_c *type_param) {
   std::vector<type_ptr> params;
 
@@ -134,6 +150,108 @@ static type_ptr build_va_arg_ptr_signature(const type_c *type_param) {
                                            std::move(return_type));
 }
 
+static type_ptr build_map_capacity_signature(const type_c *type_param) {
+  // reserve and shrink take any map, reserve also a vec; validated in
+  // typecheck.cpp
+  std::vector<type_ptr> params;
+  params.push_back(std::make_unique<map_type_c>(
+      0, std::make_unique<primitive_type_c>(keywords_e::VOID, 0),
+      std::make_unique<primitive_type_c>(keywords_e::VOID, 0)));
+  auto return_type = std::make_unique<primitive_type_c>(keywords_e::VOID, 0);
+  return std::make_unique<function_type_c>(0, std::move(params),
+                                           std::move(return_type));
+}
+
+static type_ptr build_map_get_or_insert_signature(const type_c *type_param) {
+  // get_or_insert takes a concurrent map, a key and a value and returns a
+  // pointer to the value's type; validated in typecheck.cpp
+  std::vector<type_ptr> params;
+  params.push_back(std::make_unique<map_type_c>(
+      0, std::make_unique<primitive_type_c>(keywords_e::VOID, 0),
+      std::make_unique<primitive_type_c>(keywords_e::VOID, 0),
+      map_flavor_e::CONCURRENT));
+  auto void_type = std::make_unique<primitive_type_c>(keywords_e::VOID, 0);
+  auto return_type = std::make_unique<pointer_type_c>(0, std::move(void_type));
+  return std::make_unique<function_type_c>(0, std::move(params),
+                                           std::move(return_type));
+}
+
+static type_ptr build_vec_signature(const type_c *type_param) {
+  // push, pop and cap take any vec; validated in typecheck.cpp
+  std::vector<type_ptr> params;
+  params.push_back(std::make_unique<array_type_c>(
+      0, std::make_unique<primitive_type_c>(keywords_e::VOID, 0), std::nullopt,
+      true));
+  auto return_type = std::make_unique<primitive_type_c>(keywords_e::VOID, 0);
+  return std::make_unique<function_type_c>(0, std::move(params),
+                                           std::move(return_type));
+}
+
+static type_ptr build_bytes_signature(const type_c *type_param) {
+  // bytes_* take byte slices ([]u8 or []i8) or string literals and a byte;
+  // validated in typecheck.cpp
+  std::vector<type_ptr> params;
+  params.push_back(std::make_unique<array_type_c>(
+      0, std::make_unique<primitive_type_c>(keywords_e::U8, 0), std::nullopt));
+  auto return_type = std::make_unique<primitive_type_c>(keywords_e::U64, 0);
+  return std::make_unique<function_type_c>(0, std::move(params),
+                                           std::move(return_type));
+}
+
+static type_ptr build_scan_signature(const type_c *type_param) {
+  // scan_group and scan_token take a byte slice, a position and either
+  // delimiters or *u64 token bounds, with an optional fifth argument;
+  // validated in typecheck.cpp
+  std::vector<type_ptr> params;
+  params.push_back(std::make_unique<array_type_c>(
+      0, std::make_unique<primitive_type_c>(keywords_e::U8, 0), std::nullopt));
+  params.push_back(std::make_unique<primitive_type_c>(keywords_e::U64, 0));
+  auto return_type = std::make_unique<primitive_type_c>(keywords_e::U64, 0);
+  return std::make_unique<function_type_c>(0, std::move(params),
+                                           std::move(return_type));
+}
+
+static type_ptr make_allocator_handle_type() {
+  auto void_type = std::make_unique<primitive_type_c>(keywords_e::VOID, 0);
+  return std::make_unique<pointer_type_c>(0, std::move(void_type));
+}
+
+static type_ptr build_allocator_arena_signature(const type_c *type_param) {
+  std::vector<type_ptr> params;
+  params.push_back(std::make_unique<primitive_type_c>(keywords_e::U64, 0));
+  return std::make_unique<function_type_c>(0, std::move(params),
+                                           make_allocator_handle_type());
+}
+
+static type_ptr build_allocator_pool_signature(const type_c *type_param) {
+  std::vector<type_ptr> params;
+  params.push_back(std::make_unique<primitive_type_c>(keywords_e::U64, 0));
+  params.push_back(std::make_unique<primitive_type_c>(keywords_e::U64, 0));
+  return std::make_unique<function_type_c>(0, std::move(params),
+                                           make_allocator_handle_type());
+}
+
+static type_ptr build_allocator_slab_signature(const type_c *type_param) {
+  std::vector<type_ptr> params;
+  return std::make_unique<function_type_c>(0, std::move(params),
+                                           make_allocator_handle_type());
+}
+
+static type_ptr build_allocator_release_signature(const type_c *type_param) {
+  std::vector<type_ptr> params;
+  params.push_back(make_allocator_handle_type());
+  auto return_type = std::make_unique<primitive_type_c>(keywords_e::VOID, 0);
+  return std::make_unique<function_type_c>(0, std::move(params),
+                                           std::move(return_type));
+}
+
+static type_ptr build_allocator_use_signature(const type_c *type_param) {
+  std::vector<type_ptr> params;
+  params.push_back(make_allocator_handle_type());
+  return std::make_unique<function_type_c>(0, std::move(params),
+                                           make_allocator_handle_type());
+}
+
 static type_ptr build_each_signature(const type_c *type_param) {
   // each takes: map, context pointer, callback
   // callback takes: key, value, context pointer
@@ -175,12 +293,24 @@ static type_ptr build_each_signature(const type_c *type_param) {
 
 static std::vector<builtin_signature_s> builtin_registry = {
     {"make", builtin_kind_e::MAKE, true, false, {}, build_make_signature},
+    {"make_in",
+     builtin_kind_e::MAKE_IN,
+     true,
+     false,
+     {},
+     build_make_signature},
     {"delete",
      builtin_kind_e::DELETE,
      false,
      false,
      {"ptr"},
      build_delete_signature},
+    {"delete_in",
+     builtin_kind_e::DELETE_IN,
+     false,
+     false,
+     {"ptr", "allocator"},
+     build_delete_in_signature},
     {"len", builtin_kind_e::LEN, false, false, {"arr"}, build_len_signature},
     {"sizeof", builtin_kind_e::SIZEOF, true, false, {}, build_sizeof_signature},
     {"panic",
@@ -195,6 +325,122 @@ static std::vector<builtin_signature_s> builtin_registry = {
      false,
      {"map", "context", "callback"},
      build_each_signature},
+    {"reserve",
+     builtin_kind_e::MAP_RESERVE,
+     false,
+     false,
+     {"map", "capacity"},
+     build_map_capacity_signature},
+    {"shrink",
+     builtin_kind_e::MAP_SHRINK,
+     false,
+     false,
+     {"map"},
+     build_map_capacity_signature},
+    {"get_or_insert",
+     builtin_kind_e::MAP_GET_OR_INSERT,
+     false,
+     false,
+     {"map", "key", "value"},
+     build_map_get_or_insert_signature},
+    {"push",
+     builtin_kind_e::VEC_PUSH,
+     false,
+     false,
+     {"vec", "value"},
+     build_vec_signature},
+    {"pop", builtin_kind_e::VEC_POP, false, false, {"vec"}, build_vec_signature},
+    {"cap", builtin_kind_e::VEC_CAP, false, false, {"vec"}, build_vec_signature},
+    {"bytes_find",
+     builtin_kind_e::BYTES_FIND,
+     false,
+     false,
+     {"data", "byte"},
+     build_bytes_signature},
+    {"bytes_find_any",
+     builtin_kind_e::BYTES_FIND_ANY,
+     false,
+     false,
+     {"data", "set"},
+     build_bytes_signature},
+    {"bytes_count",
+     builtin_kind_e::BYTES_COUNT,
+     false,
+     false,
+     {"data", "byte"},
+     build_bytes_signature},
+    {"bytes_compare",
+     builtin_kind_e::BYTES_COMPARE,
+     false,
+     false,
+     {"a", "b"},
+     build_bytes_signature},
+    {"bytes_fill",
+     builtin_kind_e::BYTES_FILL,
+     false,
+     false,
+     {"data", "byte"},
+     build_bytes_signature},
+    {"bytes_copy",
+     builtin_kind_e::BYTES_COPY,
+     false,
+     false,
+     {"dst", "src"},
+     build_bytes_signature},
+    {"bytes_utf8_valid",
+     builtin_kind_e::BYTES_UTF8_VALID,
+     false,
+     false,
+     {"data"},
+     build_bytes_signature},
+    {"scan_group",
+     builtin_kind_e::SCAN_GROUP,
+     false,
+     false,
+     {"data", "at", "open", "close", "escape"},
+     build_scan_signature},
+    {"scan_token",
+     builtin_kind_e::SCAN_TOKEN,
+     false,
+     false,
+     {"data", "at", "start", "end", "stops"},
+     build_scan_signature},
+    {"allocator_arena",
+     builtin_kind_e::ALLOCATOR_ARENA,
+     false,
+     false,
+     {"block_size"},
+     build_allocator_arena_signature},
+    {"allocator_pool",
+     builtin_kind_e::ALLOCATOR_POOL,
+     false,
+     false,
+     {"elem_size", "count"},
+     build_allocator_pool_signature},
+    {"allocator_slab",
+     builtin_kind_e::ALLOCATOR_SLAB,
+     false,
+     false,
+     {},
+     build_allocator_slab_signature},
+    {"allocator_reset",
+     builtin_kind_e::ALLOCATOR_RESET,
+     false,
+     false,
+     {"allocator"},
+     build_allocator_release_signature},
+    {"allocator_destroy",
+     builtin_kind_e::ALLOCATOR_DESTROY,
+     false,
+     false,
+     {"allocator"},
+     build_allocator_release_signature},
+    {"allocator_use",
+     builtin_kind_e::ALLOCATOR_USE,
+     false,
+     false,
+     {"allocator"},
+     build_allocator_use_signature},
     {"__TRUK_VA_ARG_I32",
      builtin_kind_e::VA_ARG_I32,
      false,
@@ -220,6 +466,21 @@ static std::vector<builtin_signature_s> builtin_registry = {
      {},
      build_va_arg_ptr_signature}};
 
+bool is_bytes_builtin(builtin_kind_e kind) {
+  switch (kind) {
+  case builtin_kind_e::BYTES_FIND:
+  case builtin_kind_e::BYTES_FIND_ANY:
+  case builtin_kind_e::BYTES_COUNT:
+  case builtin_kind_e::BYTES_COMPARE:
+  case builtin_kind_e::BYTES_FILL:
+  case builtin_kind_e::BYTES_COPY:
+  case builtin_kind_e::BYTES_UTF8_VALID:
+    return true;
+  default:
+    return false;
+  }
+}
+
 const std::vector<builtin_signature_s> &get_builtins() {
   return builtin_registry;
 }
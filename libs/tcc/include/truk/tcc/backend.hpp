@@ -0,0 +1,42 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+namespace truk::tcc {
+
+struct compile_result_s {
+  bool success;
+  std::string error_message;
+};
+
+struct run_result_s {
+  bool success;
+  int exit_code;
+  std::string error_message;
+};
+
+// Which C compiler turns emitted C into an executable. TCC is built in and
+// compiles quickly with little optimization; CC runs the system compiler
+// (see cc_compiler_c) for shipped binaries.
+enum class backend_e { TCC, CC };
+
+const char *backend_name(backend_e backend);
+std::optional<backend_e> backend_from_name(const std::string &name);
+
+// Common surface of the C backends: search paths and libraries, then one
+// translation unit of C source compiled and linked into output_file.
+class backend_if {
+public:
+  virtual ~backend_if() = default;
+
+  virtual void add_include_path(const std::string &path) = 0;
+  virtual void add_library_path(const std::string &path) = 0;
+  virtual void add_library(const std::string &lib) = 0;
+  virtual void set_rpath(const std::string &path) = 0;
+
+  virtual compile_result_s compile_string(const std::string &c_source,
+                                          const std::string &output_file) = 0;
+};
+
+} // namespace truk::tcc
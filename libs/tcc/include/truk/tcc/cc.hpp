@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <truk/tcc/backend.hpp>
+#include <vector>
+
+namespace truk::tcc {
+
+struct cc_options_s {
+  // Compiler to run; empty means $CC, then "cc".
+  std::string compiler;
+  // Level for -O ("0" to "3", "s", "z"); empty leaves it to the compiler.
+  std::string optimization;
+  bool lto{false};
+  // Target for -march, e.g. "native"; empty leaves it to the compiler.
+  std::string march;
+  // Passed through verbatim, after the flags above.
+  std::vector<std::string> extra_flags;
+};
+
+// Runs the system C compiler on emitted C. The source is written to a
+// temporary file and compiled and linked in one invocation; the compiler's
+// own diagnostics go straight to stderr.
+class cc_compiler_c : public backend_if {
+public:
+  explicit cc_compiler_c(cc_options_s options = {});
+
+  void add_include_path(const std::string &path) override;
+  void add_library_path(const std::string &path) override;
+  void add_library(const std::string &lib) override;
+  void set_rpath(const std::string &path) override;
+
+  compile_result_s compile_string(const std::string &c_source,
+                                  const std::string &output_file) override;
+
+  // Full command line compile_string runs for a source file, for logging.
+  std::vector<std::string> command(const std::string &input_file,
+                                   const std::string &output_file) const;
+
+private:
+  cc_options_s m_options;
+  std::vector<std::string> m_include_paths;
+  std::vector<std::string> m_library_paths;
+  std::vector<std::string> m_libraries;
+  std::vector<std::string> m_rpaths;
+};
+
+} // namespace truk::tcc
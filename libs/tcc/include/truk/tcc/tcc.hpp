@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <truk/tcc/backend.hpp>
 #include <vector>
 
 namespace truk::tcc {
@@ -13,36 +14,26 @@ enum output_type_e {
   OUTPUT_PREPROCESS = 5
 };
 
-struct compile_result_s {
-  bool success;
-  std::string error_message;
-};
-
-struct run_result_s {
-  bool success;
-  int exit_code;
-  std::string error_message;
-};
-
-class tcc_compiler_c {
+class tcc_compiler_c : public backend_if {
 public:
   tcc_compiler_c();
-  ~tcc_compiler_c();
+  ~tcc_compiler_c() override;
 
   tcc_compiler_c(const tcc_compiler_c &) = delete;
   tcc_compiler_c &operator=(const tcc_compiler_c &) = delete;
 
-  void add_include_path(const std::string &path);
-  void add_library_path(const std::string &path);
-  void add_library(const std::string &lib);
-  void set_rpath(const std::string &path);
+  void add_include_path(const std::string &path) override;
+  void add_library_path(const std::string &path) override;
+  void add_library(const std::string &lib) override;
+  void set_rpath(const std::string &path) override;
   void set_output_type(int type);
+  void set_options(const std::string &options);
 
   compile_result_s compile_file(const std::string &input_file,
                                 const std::string &output_file);
 
   compile_result_s compile_string(const std::string &c_source,
-                                  const std::string &output_file);
+                                  const std::string &output_file) override;
 
   run_result_s compile_and_run(const std::string &c_source, int argc,
                                char **argv);
@@ -0,0 +1,26 @@
+#include "truk/tcc/backend.hpp"
+
+namespace truk::tcc {
+
+const char *backend_name(backend_e backend) {
+  switch (backend) {
+  case backend_e::TCC:
+    return "tcc";
+  case backend_e::CC:
+    return "cc";
+  default:
+    return "unknown";
+  }
+}
+
+std::optional<backend_e> backend_from_name(const std::string &name) {
+  if (name == "tcc") {
+    return backend_e::TCC;
+  }
+  if (name == "cc") {
+    return backend_e::CC;
+  }
+  return std::nullopt;
+}
+
+} // namespace truk::tcc
@@ -0,0 +1,161 @@
+#include "truk/tcc/cc.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace truk::tcc {
+
+namespace {
+
+std::string default_compiler() {
+  const char *cc = std::getenv("CC");
+  return cc && *cc ? cc : "cc";
+}
+
+// Removes the temporary source however compile_string returns.
+struct temp_file_s {
+  std::string path;
+  ~temp_file_s() {
+    if (!path.empty()) {
+      ::unlink(path.c_str());
+    }
+  }
+};
+
+} // namespace
+
+cc_compiler_c::cc_compiler_c(cc_options_s options)
+    : m_options(std::move(options)) {
+  if (m_options.compiler.empty()) {
+    m_options.compiler = default_compiler();
+  }
+}
+
+void cc_compiler_c::add_include_path(const std::string &path) {
+  m_include_paths.push_back(path);
+}
+
+void cc_compiler_c::add_library_path(const std::string &path) {
+  m_library_paths.push_back(path);
+}
+
+void cc_compiler_c::add_library(const std::string &lib) {
+  m_libraries.push_back(lib);
+}
+
+void cc_compiler_c::set_rpath(const std::string &path) {
+  m_rpaths.push_back(path);
+}
+
+std::vector<std::string>
+cc_compiler_c::command(const std::string &input_file,
+                       const std::string &output_file) const {
+  std::vector<std::string> argv = {m_options.compiler, "-w", "-std=gnu11"};
+  if (!m_options.optimization.empty()) {
+    argv.push_back("-O" + m_options.optimization);
+  }
+  if (m_options.lto) {
+    argv.push_back("-flto");
+  }
+  if (!m_options.march.empty()) {
+    argv.push_back("-march=" + m_options.march);
+  }
+  argv.insert(argv.end(), m_options.extra_flags.begin(),
+              m_options.extra_flags.end());
+  for (const auto &path : m_include_paths) {
+    argv.push_back("-I" + path);
+  }
+  argv.push_back("-x");
+  argv.push_back("c");
+  argv.push_back(input_file);
+  argv.push_back("-x");
+  argv.push_back("none");
+  argv.push_back("-o");
+  argv.push_back(output_file);
+  for (const auto &path : m_library_paths) {
+    argv.push_back("-L" + path);
+  }
+  for (const auto &lib : m_libraries) {
+    argv.push_back("-l" + lib);
+  }
+  for (const auto &path : m_rpaths) {
+    argv.push_back("-Wl,-rpath," + path);
+  }
+  argv.push_back("-lpthread");
+  argv.push_back("-lm");
+  return argv;
+}
+
+compile_result_s cc_compiler_c::compile_string(const std::string &c_source,
+                                               const std::string &output_file) {
+  compile_result_s result;
+  result.success = false;
+
+  const char *tmpdir = std::getenv("TMPDIR");
+  std::string pattern =
+      std::string(tmpdir && *tmpdir ? tmpdir : "/tmp") + "/truk-XXXXXX.c";
+  int fd = ::mkstemps(pattern.data(), 2);
+  if (fd < 0) {
+    result.error_message =
+        "Failed to create temporary C file: " + std::string(strerror(errno));
+    return result;
+  }
+  ::close(fd);
+  temp_file_s source{pattern};
+
+  {
+    std::ofstream out(source.path, std::ios::binary | std::ios::trunc);
+    out << c_source;
+    if (!out) {
+      result.error_message = "Failed to write temporary C file: " + source.path;
+      return result;
+    }
+  }
+
+  auto args = command(source.path, output_file);
+  std::vector<char *> argv;
+  argv.reserve(args.size() + 1);
+  for (auto &arg : args) {
+    argv.push_back(arg.data());
+  }
+  argv.push_back(nullptr);
+
+  pid_t pid;
+  int err = ::posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(),
+                           environ);
+  if (err != 0) {
+    result.error_message = "Failed to run C compiler '" + m_options.compiler +
+                           "': " + std::string(strerror(err));
+    return result;
+  }
+
+  int status = 0;
+  while (::waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      result.error_message = "Failed to wait for C compiler '" +
+                             m_options.compiler +
+                             "': " + std::string(strerror(errno));
+      return result;
+    }
+  }
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    result.error_message =
+        "C compiler '" + m_options.compiler + "' failed" +
+        (WIFEXITED(status)
+             ? " with exit status " + std::to_string(WEXITSTATUS(status))
+             : " (killed by signal " + std::to_string(WTERMSIG(status)) + ")");
+    return result;
+  }
+
+  result.success = true;
+  return result;
+}
+
+} // namespace truk::tcc
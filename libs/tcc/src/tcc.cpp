@@ -3,6 +3,16 @@
 
 namespace truk::tcc {
 
+namespace {
+
+// The emitted runtime uses pthreads (the object cache's thread-exit key and
+// concurrent maps), which older C libraries keep out of libc.
+void add_runtime_libraries(TCCState *state) {
+  tcc_add_library(state, "pthread");
+}
+
+} // namespace
+
 tcc_compiler_c::tcc_compiler_c() {
   m_state = tcc_new();
   tcc_set_options(static_cast<TCCState *>(m_state), "-w");
@@ -35,6 +45,10 @@ void tcc_compiler_c::set_output_type(int type) {
   tcc_set_output_type(static_cast<TCCState *>(m_state), type);
 }
 
+void tcc_compiler_c::set_options(const std::string &options) {
+  tcc_set_options(static_cast<TCCState *>(m_state), options.c_str());
+}
+
 compile_result_s tcc_compiler_c::compile_file(const std::string &input_file,
                                               const std::string &output_file) {
   compile_result_s result;
@@ -68,6 +82,7 @@ tcc_compiler_c::compile_string(const std::string &c_source,
     result.error_message = "Failed to compile C source";
     return result;
   }
+  add_runtime_libraries(state);
 
   if (tcc_output_file(state, output_file.c_str()) < 0) {
     result.error_message = "Failed to write output file: " + output_file;
@@ -92,6 +107,7 @@ run_result_s tcc_compiler_c::compile_and_run(const std::string &c_source,
     result.error_message = "Failed to compile C source";
     return result;
   }
+  add_runtime_libraries(state);
 
   result.exit_code = tcc_run(state, argc, argv);
   result.success = true;
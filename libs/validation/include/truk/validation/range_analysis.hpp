@@ -0,0 +1,124 @@
+#pragma once
+
+#include <language/node.hpp>
+#include <language/visitor.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace truk::validation {
+
+// Finds slice index expressions that can never be out of range so the emitter
+// can leave out their bounds check. Runs after type checking, over the same
+// declarations the emitter is given.
+//
+// Only locals and parameters that are declared once in their function, never
+// have their address taken and are not referenced from a nested lambda are
+// tracked. For those, s[i] is proven when a dominating condition established
+// i < len(s), and s[k] for an integer literal k when one established
+// len(s) > k. Conditions come from for and while headers, if branches, the
+// right operand of && and ||, and early exits such as
+// `if i >= len(s) { return; }`. A fact is dropped as soon as either variable
+// may have been reassigned, or resized by push, pop or reserve.
+//
+// Accesses that cannot be proven this way may still be hoisted: in a loop
+// `for var i: T = a; i < hi; i += 1` whose body always reaches s[i], cannot
+// leave early and calls nothing, checking hi - 1 against len(s) once before
+// the loop covers every iteration. hoisted_checks() lists those accesses per
+// loop; the emitter emits the pre-check and drops their per-iteration checks.
+class range_analysis_c : public language::nodes::visitor_if {
+public:
+  range_analysis_c() = default;
+
+  void analyze(
+      const std::vector<std::unique_ptr<language::nodes::base_c>> &decls);
+
+  bool is_unchecked(const language::nodes::index_c *node) const {
+    return _unchecked.count(node) > 0;
+  }
+  const std::unordered_set<const language::nodes::index_c *> &
+  unchecked_indices() const {
+    return _unchecked;
+  }
+  const std::unordered_map<const language::nodes::for_c *,
+                           std::vector<const language::nodes::index_c *>> &
+  hoisted_checks() const {
+    return _hoisted;
+  }
+
+  void visit(const language::nodes::primitive_type_c &node) override;
+  void visit(const language::nodes::named_type_c &node) override;
+  void visit(const language::nodes::pointer_type_c &node) override;
+  void visit(const language::nodes::array_type_c &node) override;
+  void visit(const language::nodes::function_type_c &node) override;
+  void visit(const language::nodes::map_type_c &node) override;
+  void visit(const language::nodes::tuple_type_c &node) override;
+  void visit(const language::nodes::fn_c &node) override;
+  void visit(const language::nodes::lambda_c &node) override;
+  void visit(const language::nodes::struct_c &node) override;
+  void visit(const language::nodes::enum_c &node) override;
+  void visit(const language::nodes::var_c &node) override;
+  void visit(const language::nodes::const_c &node) override;
+  void visit(const language::nodes::let_c &node) override;
+  void visit(const language::nodes::if_c &node) override;
+  void visit(const language::nodes::while_c &node) override;
+  void visit(const language::nodes::for_c &node) override;
+  void visit(const language::nodes::return_c &node) override;
+  void visit(const language::nodes::break_c &node) override;
+  void visit(const language::nodes::continue_c &node) override;
+  void visit(const language::nodes::defer_c &node) override;
+  void visit(const language::nodes::match_c &node) override;
+  void visit(const language::nodes::binary_op_c &node) override;
+  void visit(const language::nodes::unary_op_c &node) override;
+  void visit(const language::nodes::cast_c &node) override;
+  void visit(const language::nodes::call_c &node) override;
+  void visit(const language::nodes::index_c &node) override;
+  void visit(const language::nodes::member_access_c &node) override;
+  void visit(const language::nodes::literal_c &node) override;
+  void visit(const language::nodes::identifier_c &node) override;
+  void visit(const language::nodes::assignment_c &node) override;
+  void visit(const language::nodes::block_c &node) override;
+  void visit(const language::nodes::array_literal_c &node) override;
+  void visit(const language::nodes::struct_literal_c &node) override;
+  void visit(const language::nodes::type_param_c &node) override;
+  void visit(const language::nodes::import_c &node) override;
+  void visit(const language::nodes::cimport_c &node) override;
+  void visit(const language::nodes::shard_c &node) override;
+  void visit(const language::nodes::enum_value_access_c &node) override;
+
+private:
+  struct facts_s {
+    std::set<std::pair<std::string, std::string>> below_len;
+    std::unordered_map<std::string, std::uint64_t> min_len;
+
+    void kill(const std::string &name);
+    void add_min_len(const std::string &slice, std::uint64_t len);
+    void merge(const facts_s &other);
+  };
+
+  std::unordered_set<std::string> _globals;
+  std::unordered_set<std::string> _tracked;
+  facts_s _facts;
+  std::unordered_set<const language::nodes::index_c *> _unchecked;
+  std::unordered_map<const language::nodes::for_c *,
+                     std::vector<const language::nodes::index_c *>>
+      _hoisted;
+
+  void walk(const language::nodes::base_c *node);
+  void enter_function(const std::vector<language::nodes::parameter_s> &params,
+                      const language::nodes::base_c *body);
+  void kill_assigned(const language::nodes::base_c *node);
+  void hoist_checks(const language::nodes::for_c &node);
+  void add_condition(const language::nodes::base_c *cond, bool truth,
+                     facts_s &out) const;
+  const std::string *tracked_name(const language::nodes::base_c *node) const;
+  const std::string *len_operand(const language::nodes::base_c *node) const;
+};
+
+} // namespace truk::validation
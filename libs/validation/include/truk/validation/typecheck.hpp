@@ -47,6 +47,8 @@ struct type_entry_s : public truk::core::memory_c<2048>::storeable_if {
   std::string name;
   std::size_t pointer_depth{0};
   std::optional<std::size_t> array_size;
+  // vec[T]: an unsized array that also carries a capacity.
+  bool is_growable{false};
 
   std::vector<std::string> struct_field_names;
   std::unordered_map<std::string, std::unique_ptr<type_entry_s>> struct_fields;
@@ -72,7 +74,7 @@ struct type_entry_s : public truk::core::memory_c<2048>::storeable_if {
 
   type_entry_s(const type_entry_s &other)
       : kind(other.kind), name(other.name), pointer_depth(other.pointer_depth),
-        array_size(other.array_size),
+        array_size(other.array_size), is_growable(other.is_growable),
         struct_field_names(other.struct_field_names),
         enum_values(other.enum_values), is_variadic(other.is_variadic),
         is_builtin(other.is_builtin), builtin_kind(other.builtin_kind) {
@@ -224,6 +226,13 @@ public:
   const std::vector<type_error_s> &errors() const { return _detailed_errors; }
   bool has_errors() const { return !_detailed_errors.empty(); }
 
+  // Map keys whose type is a u8 or i8 slice, whatever the expression: the
+  // emitter keys those by (data, len) rather than by a C string.
+  const std::unordered_set<const truk::language::nodes::base_c *> &
+  slice_map_keys() const {
+    return _slice_map_keys;
+  }
+
   void visit(const truk::language::nodes::primitive_type_c &node) override;
   void visit(const truk::language::nodes::named_type_c &node) override;
   void visit(const truk::language::nodes::pointer_type_c &node) override;
@@ -270,6 +279,7 @@ private:
   std::unique_ptr<type_entry_s> _current_expression_type;
   std::unique_ptr<type_entry_s> _current_function_return_type;
   bool _in_loop{false};
+  std::unordered_set<const truk::language::nodes::base_c *> _slice_map_keys;
 
   std::unordered_map<const truk::language::nodes::base_c *, std::string>
       _decl_to_file;
@@ -326,9 +336,17 @@ private:
   bool is_compatible_for_assignment(const type_entry_s *target,
                                     const type_entry_s *source);
   bool is_type_identifier(const truk::language::nodes::identifier_c *id_node);
+  bool is_addressable(const truk::language::nodes::base_c *node) const;
 
   void validate_builtin_call(const truk::language::nodes::call_c &node,
                              const type_entry_s &func_type);
+  bool check_map_key(const type_entry_s *map_type,
+                     const truk::language::nodes::base_c *key_node,
+                     std::unique_ptr<type_entry_s> key_type,
+                     std::size_t source_index);
+  bool validate_map_value_type(const type_entry_s *map_type,
+                               std::size_t source_index);
+  void check_subslice(const truk::language::nodes::index_c &node);
 
   bool check_no_control_flow(const truk::language::nodes::base_c *node);
   bool check_no_break_or_continue(const truk::language::nodes::base_c *node);
@@ -163,6 +163,10 @@ void control_flow_checker_c::visit(const index_c &node) {
     return;
 
   check_node(node.index());
+  if (_has_control_flow || !node.end())
+    return;
+
+  check_node(node.end());
 }
 
 void control_flow_checker_c::visit(const member_access_c &node) {
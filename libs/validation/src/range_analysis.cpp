@@ -0,0 +1,800 @@
+#include <truk/validation/range_analysis.hpp>
+
+#include <charconv>
+#include <functional>
+
+namespace truk::validation {
+
+using namespace truk::language::nodes;
+
+namespace {
+
+std::vector<const base_c *> children_of(const base_c *node) {
+  std::vector<const base_c *> out;
+  auto add = [&out](const base_c *child) {
+    if (child) {
+      out.push_back(child);
+    }
+  };
+
+  if (auto fn = node->as_fn()) {
+    add(fn->body());
+  } else if (auto lambda = node->as_lambda()) {
+    add(lambda->body());
+  } else if (auto var = node->as_var()) {
+    add(var->initializer());
+  } else if (auto c = node->as_const()) {
+    add(c->value());
+  } else if (auto let = node->as_let()) {
+    add(let->initializer());
+  } else if (auto if_node = node->as_if()) {
+    add(if_node->condition());
+    add(if_node->then_block());
+    add(if_node->else_block());
+  } else if (auto while_node = node->as_while()) {
+    add(while_node->condition());
+    add(while_node->body());
+  } else if (auto for_node = node->as_for()) {
+    add(for_node->init());
+    add(for_node->condition());
+    add(for_node->post());
+    add(for_node->body());
+  } else if (auto ret = node->as_return()) {
+    for (const auto &expr : ret->expressions()) {
+      add(expr.get());
+    }
+  } else if (auto defer = node->as_defer()) {
+    add(defer->deferred_code());
+  } else if (auto match = node->as_match()) {
+    add(match->scrutinee());
+    for (const auto &arm : match->cases()) {
+      add(arm.pattern.get());
+      add(arm.body.get());
+    }
+  } else if (auto binary = node->as_binary_op()) {
+    add(binary->left());
+    add(binary->right());
+  } else if (auto unary = node->as_unary_op()) {
+    add(unary->operand());
+  } else if (auto cast = node->as_cast()) {
+    add(cast->expression());
+  } else if (auto call = node->as_call()) {
+    add(call->callee());
+    for (const auto &arg : call->arguments()) {
+      add(arg.get());
+    }
+  } else if (auto index = node->as_index()) {
+    add(index->object());
+    add(index->index());
+    add(index->end());
+  } else if (auto member = node->as_member_access()) {
+    add(member->object());
+  } else if (auto assign = node->as_assignment()) {
+    add(assign->target());
+    add(assign->value());
+  } else if (auto block = node->as_block()) {
+    for (const auto &stmt : block->statements()) {
+      add(stmt.get());
+    }
+  } else if (auto array = node->as_array_literal()) {
+    for (const auto &elem : array->elements()) {
+      add(elem.get());
+    }
+  } else if (auto literal = node->as_struct_literal()) {
+    for (const auto &field : literal->field_initializers()) {
+      add(field.value.get());
+    }
+  }
+  return out;
+}
+
+void for_each_node(const base_c *node,
+                   const std::function<void(const base_c *)> &fn) {
+  if (!node) {
+    return;
+  }
+  fn(node);
+  for (const auto *child : children_of(node)) {
+    for_each_node(child, fn);
+  }
+}
+
+// The variable whose own value an assignment to, or the address of, this
+// expression can change. Writing through s[i] changes an element, not s.
+const std::string *root_name(const base_c *node) {
+  if (auto ident = node->as_identifier()) {
+    return &ident->id().name;
+  }
+  if (auto member = node->as_member_access()) {
+    return root_name(member->object());
+  }
+  return nullptr;
+}
+
+// The variable a node changes in place: the target of an assignment, or the
+// vec that push, pop or reserve resizes.
+const std::string *written_name(const base_c *node) {
+  if (auto assign = node->as_assignment()) {
+    return root_name(assign->target());
+  }
+  if (auto call = node->as_call(); call && !call->arguments().empty()) {
+    auto callee = call->callee()->as_identifier();
+    if (callee && (callee->id().name == "push" || callee->id().name == "pop" ||
+                   callee->id().name == "reserve")) {
+      return root_name(call->arguments()[0].get());
+    }
+  }
+  return nullptr;
+}
+
+// Integer literals, also under casts as long as the value fits every integer
+// type unchanged.
+bool int_literal(const base_c *node, std::uint64_t &value) {
+  if (auto cast = node->as_cast()) {
+    return int_literal(cast->expression(), value) && value <= 127;
+  }
+  auto literal = node->as_literal();
+  if (!literal || literal->type() != literal_type_e::INTEGER) {
+    return false;
+  }
+  const std::string &text = literal->value();
+  auto [end, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  return ec == std::errc() && end == text.data() + text.size();
+}
+
+bool always_exits(const base_c *node) {
+  if (!node) {
+    return false;
+  }
+  if (node->as_return() || node->as_break() || node->as_continue()) {
+    return true;
+  }
+  if (auto block = node->as_block()) {
+    return !block->statements().empty() &&
+           always_exits(block->statements().back().get());
+  }
+  if (auto if_node = node->as_if()) {
+    return always_exits(if_node->then_block()) &&
+           always_exits(if_node->else_block());
+  }
+  if (auto call = node->as_call()) {
+    auto callee = call->callee()->as_identifier();
+    return callee && callee->id().name == "panic";
+  }
+  return false;
+}
+
+bool is_identifier(const base_c *node, const std::string &name) {
+  auto ident = node->as_identifier();
+  return ident && ident->id().name == name;
+}
+
+bool assigns(const base_c *node, const std::string &name) {
+  bool found = false;
+  for_each_node(node, [&](const base_c *n) {
+    auto target = written_name(n);
+    found = found || (target && *target == name);
+  });
+  return found;
+}
+
+bool declares(const base_c *node, const std::string &name) {
+  bool found = false;
+  for_each_node(node, [&](const base_c *n) {
+    auto declared = n->symbol_name();
+    found = found || (declared && *declared == name &&
+                      (n->as_var() || n->as_const() || n->as_let()));
+  });
+  return found;
+}
+
+// Index expressions evaluated on every pass through node: conditional parts
+// (branches, loop bodies, match arms, the right side of && and ||) and code
+// that runs elsewhere (lambdas, defers) are skipped.
+void collect_unconditional(const base_c *node,
+                           std::vector<const index_c *> &out) {
+  if (!node || node->as_lambda() || node->as_defer()) {
+    return;
+  }
+  if (auto if_node = node->as_if()) {
+    collect_unconditional(if_node->condition(), out);
+    return;
+  }
+  if (auto while_node = node->as_while()) {
+    collect_unconditional(while_node->condition(), out);
+    return;
+  }
+  if (auto for_node = node->as_for()) {
+    collect_unconditional(for_node->init(), out);
+    collect_unconditional(for_node->condition(), out);
+    return;
+  }
+  if (auto match = node->as_match()) {
+    collect_unconditional(match->scrutinee(), out);
+    return;
+  }
+  if (auto binary = node->as_binary_op();
+      binary && (binary->op() == binary_op_e::AND ||
+                 binary->op() == binary_op_e::OR)) {
+    collect_unconditional(binary->left(), out);
+    return;
+  }
+  if (auto index = node->as_index()) {
+    out.push_back(index);
+  }
+  for (const auto *child : children_of(node)) {
+    collect_unconditional(child, out);
+  }
+}
+
+} // namespace
+
+void range_analysis_c::facts_s::kill(const std::string &name) {
+  for (auto it = below_len.begin(); it != below_len.end();) {
+    if (it->first == name || it->second == name) {
+      it = below_len.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  min_len.erase(name);
+}
+
+void range_analysis_c::facts_s::add_min_len(const std::string &slice,
+                                            std::uint64_t len) {
+  auto &current = min_len[slice];
+  if (len > current) {
+    current = len;
+  }
+}
+
+void range_analysis_c::facts_s::merge(const facts_s &other) {
+  below_len.insert(other.below_len.begin(), other.below_len.end());
+  for (const auto &[slice, len] : other.min_len) {
+    add_min_len(slice, len);
+  }
+}
+
+void range_analysis_c::analyze(const std::vector<base_ptr> &decls) {
+  for (const auto &decl : decls) {
+    if (auto name = decl->symbol_name();
+        name && (decl->as_var() || decl->as_const() || decl->as_let())) {
+      _globals.insert(*name);
+    }
+  }
+  for (const auto &decl : decls) {
+    walk(decl.get());
+  }
+}
+
+void range_analysis_c::walk(const base_c *node) {
+  if (node) {
+    node->accept(*this);
+  }
+}
+
+void range_analysis_c::enter_function(const std::vector<parameter_s> &params,
+                                      const base_c *body) {
+  std::unordered_map<std::string, int> declared;
+  std::unordered_set<std::string> excluded;
+  for (const auto &param : params) {
+    declared[param.name.name]++;
+  }
+
+  // Anything a nested lambda mentions may be captured and changed behind our
+  // back, and anything whose address is taken may be written through it.
+  std::function<void(const base_c *, bool)> collect =
+      [&](const base_c *node, bool in_lambda) {
+        if (auto lambda = node->as_lambda()) {
+          for (const auto &param : lambda->params()) {
+            declared[param.name.name]++;
+          }
+          in_lambda = true;
+        } else if (auto var = node->as_var()) {
+          declared[var->name().name]++;
+        } else if (auto c = node->as_const()) {
+          declared[c->name().name]++;
+        } else if (auto let = node->as_let()) {
+          for (const auto &name : let->names()) {
+            declared[name.name]++;
+          }
+        } else if (auto ident = node->as_identifier()) {
+          if (in_lambda) {
+            excluded.insert(ident->id().name);
+          }
+        } else if (auto unary = node->as_unary_op()) {
+          if (unary->op() == unary_op_e::ADDRESS_OF) {
+            if (auto name = root_name(unary->operand())) {
+              excluded.insert(*name);
+            }
+          }
+        }
+        for (const auto *child : children_of(node)) {
+          collect(child, in_lambda);
+        }
+      };
+  if (body) {
+    collect(body, false);
+  }
+
+  auto saved_tracked = std::move(_tracked);
+  auto saved_facts = std::move(_facts);
+  _tracked.clear();
+  _facts = facts_s{};
+  for (const auto &[name, count] : declared) {
+    if (count == 1 && !excluded.count(name) && !_globals.count(name)) {
+      _tracked.insert(name);
+    }
+  }
+
+  walk(body);
+
+  _tracked = std::move(saved_tracked);
+  _facts = std::move(saved_facts);
+}
+
+void range_analysis_c::kill_assigned(const base_c *node) {
+  for_each_node(node, [this](const base_c *n) {
+    if (auto name = written_name(n)) {
+      _facts.kill(*name);
+    } else if (auto var = n->as_var()) {
+      _facts.kill(var->name().name);
+    } else if (auto let = n->as_let()) {
+      for (const auto &name : let->names()) {
+        _facts.kill(name.name);
+      }
+    }
+  });
+}
+
+const std::string *
+range_analysis_c::tracked_name(const base_c *node) const {
+  auto ident = node->as_identifier();
+  if (!ident || !_tracked.count(ident->id().name)) {
+    return nullptr;
+  }
+  return &ident->id().name;
+}
+
+const std::string *range_analysis_c::len_operand(const base_c *node) const {
+  auto call = node->as_call();
+  if (!call || call->arguments().size() != 1) {
+    return nullptr;
+  }
+  auto callee = call->callee()->as_identifier();
+  if (!callee || callee->id().name != "len") {
+    return nullptr;
+  }
+  return tracked_name(call->arguments()[0].get());
+}
+
+// Slice lengths are u64 in C, so `i < len(s)` compares i converted to u64,
+// exactly as the runtime bounds check does; a negative i never passes it.
+void range_analysis_c::add_condition(const base_c *cond, bool truth,
+                                     facts_s &out) const {
+  if (auto unary = cond->as_unary_op()) {
+    if (unary->op() == unary_op_e::NOT) {
+      add_condition(unary->operand(), !truth, out);
+    }
+    return;
+  }
+
+  auto binary = cond->as_binary_op();
+  if (!binary) {
+    return;
+  }
+
+  binary_op_e op = binary->op();
+  if ((op == binary_op_e::AND && truth) || (op == binary_op_e::OR && !truth)) {
+    add_condition(binary->left(), truth, out);
+    add_condition(binary->right(), truth, out);
+    return;
+  }
+
+  if (!truth) {
+    switch (op) {
+    case binary_op_e::LT:
+      op = binary_op_e::GE;
+      break;
+    case binary_op_e::LE:
+      op = binary_op_e::GT;
+      break;
+    case binary_op_e::GT:
+      op = binary_op_e::LE;
+      break;
+    case binary_op_e::GE:
+      op = binary_op_e::LT;
+      break;
+    case binary_op_e::EQ:
+      op = binary_op_e::NE;
+      break;
+    case binary_op_e::NE:
+      op = binary_op_e::EQ;
+      break;
+    default:
+      return;
+    }
+  }
+
+  const base_c *lhs = binary->left();
+  const base_c *rhs = binary->right();
+  if (op == binary_op_e::GT || op == binary_op_e::GE) {
+    std::swap(lhs, rhs);
+    op = op == binary_op_e::GT ? binary_op_e::LT : binary_op_e::LE;
+  }
+
+  std::uint64_t k = 0;
+  switch (op) {
+  case binary_op_e::LT:
+    if (auto slice = len_operand(rhs)) {
+      if (auto index = tracked_name(lhs)) {
+        out.below_len.emplace(*index, *slice);
+      } else if (int_literal(lhs, k) && k != UINT64_MAX) {
+        out.add_min_len(*slice, k + 1);
+      }
+    }
+    break;
+  case binary_op_e::LE:
+    if (auto slice = len_operand(rhs); slice && int_literal(lhs, k)) {
+      out.add_min_len(*slice, k);
+    }
+    break;
+  case binary_op_e::EQ:
+  case binary_op_e::NE: {
+    const std::string *slice = len_operand(lhs);
+    const base_c *other = rhs;
+    if (!slice) {
+      slice = len_operand(rhs);
+      other = lhs;
+    }
+    if (!slice || !int_literal(other, k)) {
+      break;
+    }
+    if (op == binary_op_e::EQ) {
+      out.add_min_len(*slice, k);
+    } else if (k == 0) {
+      out.add_min_len(*slice, 1);
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void range_analysis_c::visit(const primitive_type_c &) {}
+
+void range_analysis_c::visit(const named_type_c &) {}
+
+void range_analysis_c::visit(const pointer_type_c &) {}
+
+void range_analysis_c::visit(const array_type_c &) {}
+
+void range_analysis_c::visit(const function_type_c &) {}
+
+void range_analysis_c::visit(const map_type_c &) {}
+
+void range_analysis_c::visit(const tuple_type_c &) {}
+
+void range_analysis_c::visit(const fn_c &node) {
+  enter_function(node.params(), node.body());
+}
+
+void range_analysis_c::visit(const lambda_c &node) {
+  enter_function(node.params(), node.body());
+}
+
+void range_analysis_c::visit(const struct_c &) {}
+
+void range_analysis_c::visit(const enum_c &) {}
+
+void range_analysis_c::visit(const var_c &node) {
+  walk(node.initializer());
+  _facts.kill(node.name().name);
+}
+
+void range_analysis_c::visit(const const_c &node) { walk(node.value()); }
+
+void range_analysis_c::visit(const let_c &node) {
+  walk(node.initializer());
+  for (const auto &name : node.names()) {
+    _facts.kill(name.name);
+  }
+}
+
+void range_analysis_c::visit(const if_c &node) {
+  walk(node.condition());
+  facts_s before = _facts;
+  facts_s when_true;
+  facts_s when_false;
+  add_condition(node.condition(), true, when_true);
+  add_condition(node.condition(), false, when_false);
+
+  _facts = before;
+  _facts.merge(when_true);
+  walk(node.then_block());
+
+  _facts = before;
+  _facts.merge(when_false);
+  walk(node.else_block());
+
+  // Past the if, a branch that always leaves means the other one was taken.
+  _facts = before;
+  if (always_exits(node.then_block())) {
+    _facts.merge(when_false);
+  } else {
+    kill_assigned(node.then_block());
+  }
+  if (always_exits(node.else_block())) {
+    _facts.merge(when_true);
+  } else {
+    kill_assigned(node.else_block());
+  }
+}
+
+void range_analysis_c::visit(const while_c &node) {
+  kill_assigned(node.condition());
+  kill_assigned(node.body());
+  facts_s entry = _facts;
+
+  walk(node.condition());
+  add_condition(node.condition(), true, _facts);
+  walk(node.body());
+
+  _facts = std::move(entry);
+}
+
+void range_analysis_c::visit(const for_c &node) {
+  walk(node.init());
+
+  kill_assigned(node.condition());
+  kill_assigned(node.post());
+  kill_assigned(node.body());
+  facts_s entry = _facts;
+
+  walk(node.condition());
+  if (node.condition()) {
+    add_condition(node.condition(), true, _facts);
+  }
+  walk(node.body());
+
+  _facts = entry;
+  walk(node.post());
+
+  _facts = std::move(entry);
+  hoist_checks(node);
+}
+
+// Loops of the shape `for var i: T = a; i < hi; i += 1` take every value from
+// a to hi - 1 when they run at all, so if the body reaches s[i] on every
+// iteration, `a < hi` implies the loop checks s[hi - 1] at some point and
+// checking that once up front is equivalent, apart from when the panic
+// happens. The body must not leave early or call anything, so nothing
+// observable can happen in between, and i, hi and s must stay put.
+void range_analysis_c::hoist_checks(const for_c &node) {
+  auto init = node.init() ? node.init()->as_var() : nullptr;
+  if (!init || !init->initializer() || !init->type() ||
+      !init->type()->as_primitive_type() ||
+      !_tracked.count(init->name().name)) {
+    return;
+  }
+  const std::string &index = init->name().name;
+
+  // Narrow counters can wrap before reaching hi.
+  switch (init->type()->keyword()) {
+  case language::keywords_e::I32:
+  case language::keywords_e::I64:
+  case language::keywords_e::U32:
+  case language::keywords_e::U64:
+    break;
+  default:
+    return;
+  }
+  std::uint64_t k = 0;
+  if (!int_literal(init->initializer(), k)) {
+    return;
+  }
+
+  auto cond = node.condition() ? node.condition()->as_binary_op() : nullptr;
+  if (!cond || cond->op() != binary_op_e::LT ||
+      !is_identifier(cond->left(), index)) {
+    return;
+  }
+  const std::string *bound = tracked_name(cond->right());
+  if (!bound) {
+    bound = len_operand(cond->right());
+  }
+  if (!bound && !int_literal(cond->right(), k)) {
+    return;
+  }
+
+  auto post = node.post() ? node.post()->as_assignment() : nullptr;
+  auto step = post ? post->value()->as_binary_op() : nullptr;
+  if (!step || !is_identifier(post->target(), index) ||
+      step->op() != binary_op_e::ADD) {
+    return;
+  }
+  const base_c *other = is_identifier(step->left(), index)    ? step->right()
+                        : is_identifier(step->right(), index) ? step->left()
+                                                              : nullptr;
+  if (!other || !int_literal(other, k) || k != 1) {
+    return;
+  }
+
+  bool simple = true;
+  for_each_node(node.body(), [&](const base_c *n) {
+    if (n->as_break() || n->as_continue() || n->as_return() ||
+        n->as_lambda()) {
+      simple = false;
+    } else if (auto call = n->as_call()) {
+      auto callee = call->callee()->as_identifier();
+      simple = simple && callee && callee->id().name == "len";
+    }
+  });
+  if (!simple || assigns(node.body(), index) ||
+      (bound && assigns(node.body(), *bound))) {
+    return;
+  }
+
+  std::vector<const index_c *> hoisted;
+  std::vector<const index_c *> candidates;
+  collect_unconditional(node.body(), candidates);
+  for (const auto *access : candidates) {
+    auto slice = tracked_name(access->object());
+    if (slice && !access->is_range() &&
+        is_identifier(access->index(), index) &&
+        !_unchecked.count(access) && !assigns(node.body(), *slice) &&
+        !declares(node.body(), *slice)) {
+      hoisted.push_back(access);
+    }
+  }
+  if (!hoisted.empty()) {
+    _hoisted[&node] = std::move(hoisted);
+  }
+}
+
+void range_analysis_c::visit(const return_c &node) {
+  for (const auto &expr : node.expressions()) {
+    walk(expr.get());
+  }
+}
+
+void range_analysis_c::visit(const break_c &) {}
+
+void range_analysis_c::visit(const continue_c &) {}
+
+// Deferred code runs at scope exit, after whatever follows it, so nothing
+// known here still holds there.
+void range_analysis_c::visit(const defer_c &node) {
+  facts_s saved = std::move(_facts);
+  _facts = facts_s{};
+  walk(node.deferred_code());
+  _facts = std::move(saved);
+}
+
+void range_analysis_c::visit(const match_c &node) {
+  walk(node.scrutinee());
+  facts_s before = _facts;
+  for (const auto &arm : node.cases()) {
+    _facts = before;
+    walk(arm.pattern.get());
+    walk(arm.body.get());
+  }
+  _facts = std::move(before);
+  for (const auto &arm : node.cases()) {
+    kill_assigned(arm.body.get());
+  }
+}
+
+void range_analysis_c::visit(const binary_op_c &node) {
+  walk(node.left());
+  if (node.op() != binary_op_e::AND && node.op() != binary_op_e::OR) {
+    walk(node.right());
+    return;
+  }
+
+  // The right operand only runs once the left one has decided nothing.
+  facts_s saved = _facts;
+  add_condition(node.left(), node.op() == binary_op_e::AND, _facts);
+  walk(node.right());
+  _facts = std::move(saved);
+}
+
+void range_analysis_c::visit(const unary_op_c &node) { walk(node.operand()); }
+
+void range_analysis_c::visit(const cast_c &node) { walk(node.expression()); }
+
+void range_analysis_c::visit(const call_c &node) {
+  walk(node.callee());
+  for (const auto &arg : node.arguments()) {
+    walk(arg.get());
+  }
+  if (auto name = written_name(&node)) {
+    _facts.kill(*name);
+  }
+}
+
+void range_analysis_c::visit(const index_c &node) {
+  walk(node.object());
+  walk(node.index());
+  walk(node.end());
+
+  auto slice = tracked_name(node.object());
+  if (!slice || node.is_range()) {
+    return;
+  }
+
+  if (auto index = tracked_name(node.index())) {
+    if (_facts.below_len.count({*index, *slice})) {
+      _unchecked.insert(&node);
+    }
+    return;
+  }
+
+  std::uint64_t k = 0;
+  if (!int_literal(node.index(), k)) {
+    return;
+  }
+  std::uint64_t known = 0;
+  if (auto it = _facts.min_len.find(*slice); it != _facts.min_len.end()) {
+    known = it->second;
+  }
+  if (known == 0) {
+    for (const auto &[index, s] : _facts.below_len) {
+      if (s == *slice) {
+        known = 1;
+        break;
+      }
+    }
+  }
+  if (k < known) {
+    _unchecked.insert(&node);
+  }
+}
+
+void range_analysis_c::visit(const member_access_c &node) {
+  walk(node.object());
+}
+
+void range_analysis_c::visit(const literal_c &) {}
+
+void range_analysis_c::visit(const identifier_c &) {}
+
+void range_analysis_c::visit(const assignment_c &node) {
+  walk(node.value());
+  walk(node.target());
+  if (auto name = root_name(node.target())) {
+    _facts.kill(*name);
+  }
+}
+
+void range_analysis_c::visit(const block_c &node) {
+  for (const auto &stmt : node.statements()) {
+    walk(stmt.get());
+  }
+}
+
+void range_analysis_c::visit(const array_literal_c &node) {
+  for (const auto &elem : node.elements()) {
+    walk(elem.get());
+  }
+}
+
+void range_analysis_c::visit(const struct_literal_c &node) {
+  for (const auto &field : node.field_initializers()) {
+    walk(field.value.get());
+  }
+}
+
+void range_analysis_c::visit(const type_param_c &) {}
+
+void range_analysis_c::visit(const import_c &) {}
+
+void range_analysis_c::visit(const cimport_c &) {}
+
+void range_analysis_c::visit(const shard_c &) {}
+
+void range_analysis_c::visit(const enum_value_access_c &) {}
+
+} // namespace truk::validation
@@ -8,6 +8,40 @@ namespace truk::validation {
 using namespace truk::language;
 using namespace truk::language::nodes;
 
+// Map flavors are told apart by the name of their type entry, so that
+// types_equal keeps map[K, V] and map[K, V, ordered] distinct.
+static const char *map_entry_name(map_flavor_e flavor) {
+  switch (flavor) {
+  case map_flavor_e::ORDERED:
+    return "ordered_map";
+  case map_flavor_e::CONCURRENT:
+    return "concurrent_map";
+  default:
+    return "map";
+  }
+}
+
+static map_flavor_e map_flavor_from_entry_name(const std::string &name) {
+  if (name == "ordered_map") {
+    return map_flavor_e::ORDERED;
+  }
+  if (name == "concurrent_map") {
+    return map_flavor_e::CONCURRENT;
+  }
+  return map_flavor_e::FLAT;
+}
+
+static std::string map_type_suffix(map_flavor_e flavor) {
+  switch (flavor) {
+  case map_flavor_e::ORDERED:
+    return ", ordered]";
+  case map_flavor_e::CONCURRENT:
+    return ", concurrent]";
+  default:
+    return "]";
+  }
+}
+
 type_checker_c::type_checker_c() {
   register_builtin_types();
   register_builtin_functions();
@@ -149,10 +183,20 @@ type_checker_c::resolve_type(const type_c *type_node) {
       return nullptr;
     }
 
+    if (array->growable() && element->kind == type_kind_e::ARRAY &&
+        element->array_size.has_value()) {
+      report_error("Vecs of fixed-size arrays are not supported: vec[" +
+                       get_type_name_from_entry(element.get()) +
+                       "]. Consider wrapping the array in a struct",
+                   array->source_index());
+      return nullptr;
+    }
+
     auto resolved =
         std::make_unique<type_entry_s>(type_kind_e::ARRAY, element->name);
     resolved->element_type = std::move(element);
     resolved->array_size = array->size();
+    resolved->is_growable = array->growable();
     return resolved;
   }
 
@@ -194,7 +238,8 @@ type_checker_c::resolve_type(const type_c *type_node) {
       return nullptr;
     }
 
-    auto resolved = std::make_unique<type_entry_s>(type_kind_e::MAP, "map");
+    auto resolved = std::make_unique<type_entry_s>(
+        type_kind_e::MAP, map_entry_name(map->flavor()));
     resolved->map_key_type = std::make_unique<type_entry_s>(*key_type);
     resolved->map_value_type = std::make_unique<type_entry_s>(*value_type);
     return resolved;
@@ -235,6 +280,9 @@ std::string type_checker_c::get_type_name_for_error(const type_c *type_node) {
   }
 
   if (auto *array = type_node->as_array_type()) {
+    if (array->growable()) {
+      return "vec[" + get_type_name_for_error(array->element_type()) + "]";
+    }
     std::string size_str =
         array->size().has_value() ? std::to_string(array->size().value()) : "";
     return "[" + size_str + "]" +
@@ -247,7 +295,8 @@ std::string type_checker_c::get_type_name_for_error(const type_c *type_node) {
 
   if (auto *map = type_node->as_map_type()) {
     return "map[" + get_type_name_for_error(map->key_type()) + ", " +
-           get_type_name_for_error(map->value_type()) + "]";
+           get_type_name_for_error(map->value_type()) +
+           map_type_suffix(map->flavor());
   }
 
   if (auto *tuple = type_node->as_tuple_type()) {
@@ -281,6 +330,13 @@ std::string type_checker_c::get_type_name_from_entry(const type_entry_s *type) {
   }
 
   if (type->kind == type_kind_e::ARRAY) {
+    if (type->is_growable) {
+      return "vec[" +
+             (type->element_type
+                  ? get_type_name_from_entry(type->element_type.get())
+                  : base_name) +
+             "]";
+    }
     std::string size_str = type->array_size.has_value()
                                ? std::to_string(type->array_size.value())
                                : "";
@@ -290,7 +346,8 @@ std::string type_checker_c::get_type_name_from_entry(const type_entry_s *type) {
   if (type->kind == type_kind_e::MAP) {
     if (type->map_key_type && type->map_value_type) {
       return "map[" + get_type_name_from_entry(type->map_key_type.get()) +
-             ", " + get_type_name_from_entry(type->map_value_type.get()) + "]";
+             ", " + get_type_name_from_entry(type->map_value_type.get()) +
+             map_type_suffix(map_flavor_from_entry_name(type->name));
     }
     return "map[<unknown>, <unknown>]";
   }
@@ -349,7 +406,7 @@ bool type_checker_c::types_equal(const type_entry_s *a, const type_entry_s *b) {
     return false;
   }
 
-  if (a->array_size != b->array_size) {
+  if (a->array_size != b->array_size || a->is_growable != b->is_growable) {
     return false;
   }
 
@@ -553,6 +610,19 @@ type_checker_c::resolve_untyped_literal(const type_entry_s *literal_type,
              : std::make_unique<type_entry_s>(type_kind_e::PRIMITIVE, "f64");
 }
 
+// Expressions that name storage: push and pop update the vec in place, so
+// they need one rather than a temporary.
+bool type_checker_c::is_addressable(const base_c *node) const {
+  if (auto index = node->as_index()) {
+    return !index->is_range();
+  }
+  if (node->as_identifier() || node->as_member_access()) {
+    return true;
+  }
+  auto unary = node->as_unary_op();
+  return unary && unary->op() == unary_op_e::DEREF;
+}
+
 bool type_checker_c::is_type_identifier(const identifier_c *id_node) {
   if (!id_node) {
     return false;
@@ -560,6 +630,76 @@ bool type_checker_c::is_type_identifier(const identifier_c *id_node) {
   return lookup_type(id_node->id().name) != nullptr;
 }
 
+// Checks a key against a map's key type. A u8 or i8 slice stands in for a
+// string key; such keys are recorded for the emitter.
+bool type_checker_c::check_map_key(const type_entry_s *map_type,
+                                   const base_c *key_node,
+                                   std::unique_ptr<type_entry_s> key_type,
+                                   std::size_t source_index) {
+  if (key_type->kind == type_kind_e::ARRAY &&
+      !key_type->array_size.has_value() && key_type->element_type &&
+      (key_type->element_type->name == "i8" ||
+       key_type->element_type->name == "u8")) {
+    _slice_map_keys.insert(key_node);
+    auto string_ptr_type =
+        std::make_unique<type_entry_s>(type_kind_e::POINTER, "u8");
+    string_ptr_type->pointer_depth = 1;
+    key_type = std::move(string_ptr_type);
+  }
+
+  key_type =
+      resolve_untyped_literal(key_type.get(), map_type->map_key_type.get());
+
+  bool key_types_compatible =
+      types_equal(key_type.get(), map_type->map_key_type.get());
+
+  if (!key_types_compatible && key_type->kind == type_kind_e::POINTER &&
+      map_type->map_key_type->kind == type_kind_e::POINTER &&
+      key_type->pointer_depth == 1 &&
+      map_type->map_key_type->pointer_depth == 1 &&
+      ((key_type->name == "i8" && map_type->map_key_type->name == "u8") ||
+       (key_type->name == "u8" && map_type->map_key_type->name == "i8"))) {
+    key_types_compatible = true;
+  }
+
+  if (!key_types_compatible) {
+    report_error("Map key type mismatch: expected " +
+                     get_type_name_from_entry(map_type->map_key_type.get()) +
+                     " but got " + get_type_name_from_entry(key_type.get()),
+                 source_index);
+    return false;
+  }
+  return true;
+}
+
+bool type_checker_c::validate_map_value_type(const type_entry_s *map_type,
+                                             std::size_t source_index) {
+  if (!map_type->map_value_type) {
+    return true;
+  }
+  auto value_type = map_type->map_value_type.get();
+  if (value_type->kind == type_kind_e::ARRAY &&
+      value_type->array_size.has_value()) {
+    report_error("Maps with fixed-size array values are not supported: " +
+                     get_type_name_from_entry(value_type) +
+                     ". Consider wrapping the array in a struct",
+                 source_index);
+    return false;
+  }
+  if (value_type->kind == type_kind_e::POINTER && value_type->pointee_type) {
+    auto pointee = value_type->pointee_type.get();
+    if (pointee->kind == type_kind_e::ARRAY &&
+        pointee->array_size.has_value()) {
+      report_error("Maps with pointer-to-array values are not supported: " +
+                       get_type_name_from_entry(value_type) +
+                       ". Consider wrapping the array in a struct",
+                   source_index);
+      return false;
+    }
+  }
+  return true;
+}
+
 void type_checker_c::validate_builtin_call(const call_c &node,
                                            const type_entry_s &func_type) {
   if (!func_type.builtin_kind.has_value()) {
@@ -574,9 +714,14 @@ void type_checker_c::validate_builtin_call(const call_c &node,
     return;
   }
 
-  if (func_type.builtin_kind == language::builtins::builtin_kind_e::MAKE) {
+  if (func_type.builtin_kind == language::builtins::builtin_kind_e::MAKE ||
+      func_type.builtin_kind == language::builtins::builtin_kind_e::MAKE_IN) {
+    const bool with_allocator =
+        func_type.builtin_kind == language::builtins::builtin_kind_e::MAKE_IN;
+    const std::string quoted_name = "'" + builtin->name + "'";
+
     if (node.arguments().empty()) {
-      report_error("Builtin 'make' requires a type parameter",
+      report_error("Builtin " + quoted_name + " requires a type parameter",
                    node.source_index());
       return;
     }
@@ -584,15 +729,31 @@ void type_checker_c::validate_builtin_call(const call_c &node,
     const auto *first_arg_type_param =
         node.arguments()[0].get()->as_type_param();
     if (!first_arg_type_param) {
-      report_error(
-          "Builtin 'make' requires a type parameter (use @type syntax)",
-          node.source_index());
+      report_error("Builtin " + quoted_name +
+                       " requires a type parameter (use @type syntax)",
+                   node.source_index());
       return;
     }
 
     const type_c *type_param = first_arg_type_param->type();
     std::size_t actual_arg_count = node.arguments().size() - 1;
 
+    if (with_allocator) {
+      if (actual_arg_count == 0) {
+        report_error("Builtin 'make_in' requires an allocator argument",
+                     node.source_index());
+        return;
+      }
+      node.arguments().back()->accept(*this);
+      auto allocator_type = std::move(_current_expression_type);
+      if (!allocator_type || allocator_type->kind != type_kind_e::POINTER) {
+        report_error("Builtin 'make_in' allocator must be a pointer",
+                     node.source_index());
+        return;
+      }
+      actual_arg_count--;
+    }
+
     if (actual_arg_count == 0) {
       auto resolved = resolve_type(type_param);
       if (!resolved) {
@@ -600,31 +761,27 @@ void type_checker_c::validate_builtin_call(const call_c &node,
         return;
       }
 
+      if (resolved->kind == type_kind_e::MAP && with_allocator) {
+        report_error("Builtin 'make_in' does not support maps; a map "
+                     "allocates from the current allocator",
+                     node.source_index());
+        return;
+      }
+
+      if (resolved->is_growable) {
+        if (with_allocator) {
+          report_error("Builtin 'make_in' does not support vecs; a vec "
+                       "allocates from the current allocator",
+                       node.source_index());
+          return;
+        }
+        _current_expression_type = std::move(resolved);
+        return;
+      }
+
       if (resolved->kind == type_kind_e::MAP) {
-        if (resolved->map_value_type) {
-          auto value_type = resolved->map_value_type.get();
-          if (value_type->kind == type_kind_e::ARRAY &&
-              value_type->array_size.has_value()) {
-            report_error(
-                "Maps with fixed-size array values are not supported: " +
-                    get_type_name_from_entry(value_type) +
-                    ". Consider wrapping the array in a struct",
-                node.source_index());
-            return;
-          }
-          if (value_type->kind == type_kind_e::POINTER &&
-              value_type->pointee_type) {
-            auto pointee = value_type->pointee_type.get();
-            if (pointee->kind == type_kind_e::ARRAY &&
-                pointee->array_size.has_value()) {
-              report_error(
-                  "Maps with pointer-to-array values are not supported: " +
-                      get_type_name_from_entry(value_type) +
-                      ". Consider wrapping the array in a struct",
-                  node.source_index());
-              return;
-            }
-          }
+        if (!validate_map_value_type(resolved.get(), node.source_index())) {
+          return;
         }
         _current_expression_type = std::move(resolved);
         return;
@@ -639,37 +796,158 @@ void type_checker_c::validate_builtin_call(const call_c &node,
     } else if (actual_arg_count == 1) {
       node.arguments()[1]->accept(*this);
       auto count_type = std::move(_current_expression_type);
-      if (!count_type || count_type->name != "u64") {
-        report_error("Builtin 'make' array count must be u64",
-                     node.source_index());
-        return;
-      }
       auto element = resolve_type(type_param);
       if (!element) {
         report_error("Failed to resolve element type for make",
                      node.source_index());
         return;
       }
+
+      if (element->kind == type_kind_e::MAP) {
+        if (with_allocator) {
+          report_error("Builtin 'make_in' does not support maps; a map "
+                       "allocates from the current allocator",
+                       node.source_index());
+          return;
+        }
+        if (!count_type || count_type->name != "u64") {
+          report_error("Builtin 'make' map capacity must be u64",
+                       node.source_index());
+          return;
+        }
+        if (!validate_map_value_type(element.get(), node.source_index())) {
+          return;
+        }
+        _current_expression_type = std::move(element);
+        return;
+      }
+
+      if (element->is_growable) {
+        if (with_allocator) {
+          report_error("Builtin 'make_in' does not support vecs; a vec "
+                       "allocates from the current allocator",
+                       node.source_index());
+          return;
+        }
+        if (!count_type || count_type->name != "u64") {
+          report_error("Builtin 'make' vec capacity must be u64",
+                       node.source_index());
+          return;
+        }
+        _current_expression_type = std::move(element);
+        return;
+      }
+
+      if (!count_type || count_type->name != "u64") {
+        report_error("Builtin 'make' array count must be u64",
+                     node.source_index());
+        return;
+      }
       auto return_type =
           std::make_unique<type_entry_s>(type_kind_e::ARRAY, element->name);
       return_type->element_type = std::move(element);
       return_type->array_size = std::nullopt;
       _current_expression_type = std::move(return_type);
       return;
+    } else if (actual_arg_count == 2 && !with_allocator) {
+      auto element = resolve_type(type_param);
+      if (!element || element->kind != type_kind_e::MAP) {
+        report_error("Builtin 'make' only takes a third argument for maps "
+                     "(incremental resize flag)",
+                     node.source_index());
+        return;
+      }
+      node.arguments()[1]->accept(*this);
+      auto count_type = std::move(_current_expression_type);
+      if (!count_type || count_type->name != "u64") {
+        report_error("Builtin 'make' map capacity must be u64",
+                     node.source_index());
+        return;
+      }
+      node.arguments()[2]->accept(*this);
+      auto flag_type = std::move(_current_expression_type);
+      if (!flag_type || flag_type->name != "bool") {
+        report_error("Builtin 'make' map incremental flag must be bool",
+                     node.source_index());
+        return;
+      }
+      if (element->name != "map") {
+        report_error("Builtin 'make' incremental resizing is not available "
+                     "for " +
+                         element->name.substr(0, element->name.find('_')) +
+                         " maps",
+                     node.source_index());
+        return;
+      }
+      if (!validate_map_value_type(element.get(), node.source_index())) {
+        return;
+      }
+      _current_expression_type = std::move(element);
+      return;
+    } else if (with_allocator) {
+      report_error("Builtin 'make_in' expects 2 or 3 arguments (type "
+                   "parameter + optional count + allocator)",
+                   node.source_index());
+      return;
     } else {
-      report_error("Builtin 'make' expects 1 or 2 arguments (type parameter + "
-                   "optional count)",
+      report_error("Builtin 'make' expects 1 to 3 arguments (type parameter + "
+                   "optional count + optional map incremental flag)",
                    node.source_index());
       return;
     }
   }
 
+  if (func_type.builtin_kind == language::builtins::builtin_kind_e::DELETE_IN) {
+    if (node.arguments().size() != 2) {
+      report_error("Builtin 'delete_in' expects 2 arguments (value and "
+                   "allocator)",
+                   node.source_index());
+      return;
+    }
+
+    if (auto index = node.arguments()[0]->as_index();
+        index && index->is_range()) {
+      report_error("Cannot delete a subslice; delete the slice it was taken "
+                   "from",
+                   node.source_index());
+      return;
+    }
+
+    node.arguments()[0]->accept(*this);
+    auto arg_type = std::move(_current_expression_type);
+    if (!arg_type || (arg_type->kind != type_kind_e::POINTER &&
+                      arg_type->kind != type_kind_e::ARRAY)) {
+      report_error("Builtin 'delete_in' requires pointer or array type",
+                   node.source_index());
+      return;
+    }
+
+    node.arguments()[1]->accept(*this);
+    auto allocator_type = std::move(_current_expression_type);
+    if (!allocator_type || allocator_type->kind != type_kind_e::POINTER) {
+      report_error("Builtin 'delete_in' allocator must be a pointer",
+                   node.source_index());
+      return;
+    }
+
+    _current_expression_type.reset();
+    return;
+  }
+
   if (func_type.builtin_kind == language::builtins::builtin_kind_e::DELETE) {
     if (node.arguments().size() != 1) {
       report_error("Builtin 'delete' expects 1 argument", node.source_index());
       return;
     }
 
+    if (auto index = node.arguments()[0]->as_index();
+        index && index->is_range()) {
+      report_error("Cannot delete a subslice; delete the slice it was taken "
+                   "from",
+                   node.source_index());
+      return;
+    }
+
     node.arguments()[0]->accept(*this);
     auto arg_type = std::move(_current_expression_type);
 
@@ -691,6 +969,294 @@ void type_checker_c::validate_builtin_call(const call_c &node,
     return;
   }
 
+  if (func_type.builtin_kind ==
+          language::builtins::builtin_kind_e::MAP_RESERVE ||
+      func_type.builtin_kind ==
+          language::builtins::builtin_kind_e::MAP_SHRINK) {
+    const bool is_reserve =
+        func_type.builtin_kind ==
+        language::builtins::builtin_kind_e::MAP_RESERVE;
+    const std::size_t expected = is_reserve ? 2 : 1;
+    if (node.arguments().size() != expected) {
+      report_error(is_reserve ? "Builtin 'reserve' expects 2 arguments (map "
+                                "and capacity)"
+                              : "Builtin 'shrink' expects 1 argument",
+                   node.source_index());
+      return;
+    }
+
+    node.arguments()[0]->accept(*this);
+    auto map_type = std::move(_current_expression_type);
+    const bool is_vec = map_type && map_type->is_growable;
+    if (is_reserve && is_vec) {
+      if (!node.arguments()[0]->as_identifier()) {
+        report_error("Builtin 'reserve' requires a vec variable",
+                     node.source_index());
+        return;
+      }
+    } else if (!map_type || map_type->kind != type_kind_e::MAP) {
+      report_error(is_reserve ? "Builtin 'reserve' requires a map or vec"
+                              : "Builtin 'shrink' requires a map",
+                   node.source_index());
+      return;
+    }
+
+    if (is_reserve) {
+      node.arguments()[1]->accept(*this);
+      auto count_type = std::move(_current_expression_type);
+      if (!count_type || count_type->name != "u64") {
+        report_error("Builtin 'reserve' capacity must be u64",
+                     node.source_index());
+        return;
+      }
+    }
+
+    _current_expression_type =
+        std::make_unique<type_entry_s>(type_kind_e::PRIMITIVE, "void");
+    return;
+  }
+
+  if (func_type.builtin_kind == language::builtins::builtin_kind_e::VEC_PUSH ||
+      func_type.builtin_kind == language::builtins::builtin_kind_e::VEC_POP ||
+      func_type.builtin_kind == language::builtins::builtin_kind_e::VEC_CAP) {
+    const bool is_push =
+        func_type.builtin_kind == language::builtins::builtin_kind_e::VEC_PUSH;
+    const bool is_cap =
+        func_type.builtin_kind == language::builtins::builtin_kind_e::VEC_CAP;
+    const std::size_t expected = is_push ? 2 : 1;
+    if (node.arguments().size() != expected) {
+      report_error(is_push ? "Builtin 'push' expects 2 arguments (vec and "
+                             "value)"
+                           : "Builtin '" + builtin->name +
+                                 "' expects 1 argument",
+                   node.source_index());
+      return;
+    }
+
+    node.arguments()[0]->accept(*this);
+    auto vec_type = std::move(_current_expression_type);
+    if (!vec_type || !vec_type->is_growable || !vec_type->element_type) {
+      report_error("Builtin '" + builtin->name + "' requires a vec",
+                   node.source_index());
+      return;
+    }
+    if (!is_cap && !is_addressable(node.arguments()[0].get())) {
+      report_error("Builtin '" + builtin->name +
+                       "' requires a vec variable, field or element",
+                   node.source_index());
+      return;
+    }
+
+    if (is_push) {
+      node.arguments()[1]->accept(*this);
+      auto value_type = resolve_untyped_literal(
+          _current_expression_type.get(), vec_type->element_type.get());
+      if (!value_type || !is_compatible_for_assignment(
+                             vec_type->element_type.get(), value_type.get())) {
+        report_error("Builtin 'push' value must match the vec element type " +
+                         get_type_name_from_entry(vec_type->element_type.get()),
+                     node.source_index());
+        return;
+      }
+      _current_expression_type =
+          std::make_unique<type_entry_s>(type_kind_e::PRIMITIVE, "void");
+    } else if (is_cap) {
+      _current_expression_type =
+          std::make_unique<type_entry_s>(type_kind_e::PRIMITIVE, "u64");
+    } else {
+      _current_expression_type =
+          std::make_unique<type_entry_s>(*vec_type->element_type);
+    }
+    return;
+  }
+
+  if (language::builtins::is_bytes_builtin(*func_type.builtin_kind)) {
+    using language::builtins::builtin_kind_e;
+    const auto kind = *func_type.builtin_kind;
+    const bool takes_byte = kind == builtin_kind_e::BYTES_FIND ||
+                            kind == builtin_kind_e::BYTES_COUNT ||
+                            kind == builtin_kind_e::BYTES_FILL;
+    const bool writes_first =
+        kind == builtin_kind_e::BYTES_FILL || kind == builtin_kind_e::BYTES_COPY;
+    const std::size_t expected =
+        kind == builtin_kind_e::BYTES_UTF8_VALID ? 1 : 2;
+    if (node.arguments().size() != expected) {
+      report_error("Builtin '" + builtin->name + "' expects " +
+                       std::to_string(expected) + " argument(s)",
+                   node.source_index());
+      return;
+    }
+
+    for (std::size_t i = 0; i < expected; ++i) {
+      const base_c *arg = node.arguments()[i].get();
+      arg->accept(*this);
+      auto arg_type = std::move(_current_expression_type);
+      if (i == 1 && takes_byte) {
+        if (!arg_type || (arg_type->kind != type_kind_e::UNTYPED_INTEGER &&
+                          arg_type->name != "u8" && arg_type->name != "i8") ||
+            arg_type->pointer_depth != 0) {
+          report_error("Builtin '" + builtin->name + "' byte must be u8 or i8",
+                       node.source_index());
+          return;
+        }
+        continue;
+      }
+      auto literal = arg->as_literal();
+      if (literal && literal->type() == literal_type_e::STRING &&
+          !(i == 0 && writes_first)) {
+        continue;
+      }
+      if (!arg_type || arg_type->kind != type_kind_e::ARRAY ||
+          arg_type->array_size.has_value() || !arg_type->element_type ||
+          (arg_type->element_type->name != "u8" &&
+           arg_type->element_type->name != "i8")) {
+        report_error("Builtin '" + builtin->name +
+                         "' requires a []u8 or []i8 slice",
+                     node.source_index());
+        return;
+      }
+    }
+
+    std::string result = "u64";
+    if (kind == builtin_kind_e::BYTES_COMPARE) {
+      result = "i32";
+    } else if (kind == builtin_kind_e::BYTES_FILL) {
+      result = "void";
+    } else if (kind == builtin_kind_e::BYTES_UTF8_VALID) {
+      result = "bool";
+    }
+    _current_expression_type =
+        std::make_unique<type_entry_s>(type_kind_e::PRIMITIVE, result);
+    return;
+  }
+
+  if (func_type.builtin_kind ==
+          language::builtins::builtin_kind_e::SCAN_GROUP ||
+      func_type.builtin_kind ==
+          language::builtins::builtin_kind_e::SCAN_TOKEN) {
+    const bool is_group = *func_type.builtin_kind ==
+                          language::builtins::builtin_kind_e::SCAN_GROUP;
+    const auto argc = node.arguments().size();
+    if (argc != 4 && argc != 5) {
+      report_error("Builtin '" + builtin->name + "' expects 4 or 5 arguments",
+                   node.source_index());
+      return;
+    }
+
+    for (std::size_t i = 0; i < argc; ++i) {
+      const base_c *arg = node.arguments()[i].get();
+      arg->accept(*this);
+      auto arg_type = std::move(_current_expression_type);
+      if (i == 1) {
+        if (!arg_type || (arg_type->kind != type_kind_e::UNTYPED_INTEGER &&
+                          !is_integer_type(arg_type.get()))) {
+          report_error("Builtin '" + builtin->name +
+                           "' position must be an integer",
+                       node.source_index());
+          return;
+        }
+        continue;
+      }
+      if (i > 1 && is_group) {
+        if (!arg_type || (arg_type->kind != type_kind_e::UNTYPED_INTEGER &&
+                          arg_type->name != "u8" && arg_type->name != "i8") ||
+            arg_type->pointer_depth != 0) {
+          report_error("Builtin '" + builtin->name +
+                           "' delimiters must be u8 or i8",
+                       node.source_index());
+          return;
+        }
+        continue;
+      }
+      if (i == 2 || i == 3) {
+        if (!arg_type || arg_type->kind != type_kind_e::POINTER ||
+            arg_type->pointer_depth != 1 || arg_type->name != "u64") {
+          report_error("Builtin '" + builtin->name +
+                           "' token bounds must be *u64",
+                       node.source_index());
+          return;
+        }
+        continue;
+      }
+      auto literal = arg->as_literal();
+      if (literal && literal->type() == literal_type_e::STRING) {
+        continue;
+      }
+      if (!arg_type || arg_type->kind != type_kind_e::ARRAY ||
+          arg_type->array_size.has_value() || !arg_type->element_type ||
+          (arg_type->element_type->name != "u8" &&
+           arg_type->element_type->name != "i8")) {
+        report_error("Builtin '" + builtin->name +
+                         "' requires a []u8 or []i8 slice",
+                     node.source_index());
+        return;
+      }
+    }
+
+    _current_expression_type = std::make_unique<type_entry_s>(
+        type_kind_e::PRIMITIVE, is_group ? "u64" : "i32");
+    return;
+  }
+
+  if (func_type.builtin_kind ==
+      language::builtins::builtin_kind_e::MAP_GET_OR_INSERT) {
+    if (node.arguments().size() != 3) {
+      report_error("Builtin 'get_or_insert' expects 3 arguments (map, key and "
+                   "value)",
+                   node.source_index());
+      return;
+    }
+
+    node.arguments()[0]->accept(*this);
+    auto map_type = std::move(_current_expression_type);
+    if (!map_type || map_type->kind != type_kind_e::MAP ||
+        map_flavor_from_entry_name(map_type->name) !=
+            map_flavor_e::CONCURRENT) {
+      report_error("Builtin 'get_or_insert' requires a concurrent map",
+                   node.source_index());
+      return;
+    }
+    if (!map_type->map_key_type || !map_type->map_value_type) {
+      report_error("Map has no key or value type", node.source_index());
+      return;
+    }
+
+    node.arguments()[1]->accept(*this);
+    auto key_type = std::move(_current_expression_type);
+    if (!key_type) {
+      report_error("Map key has invalid type", node.source_index());
+      return;
+    }
+    if (!check_map_key(map_type.get(), node.arguments()[1].get(),
+                       std::move(key_type), node.source_index())) {
+      return;
+    }
+
+    node.arguments()[2]->accept(*this);
+    auto value_type = std::move(_current_expression_type);
+    if (!value_type) {
+      report_error("Map value has invalid type", node.source_index());
+      return;
+    }
+    value_type = resolve_untyped_literal(value_type.get(),
+                                         map_type->map_value_type.get());
+    if (!is_compatible_for_assignment(map_type->map_value_type.get(),
+                                      value_type.get())) {
+      report_error("Builtin 'get_or_insert' value type mismatch",
+                   node.source_index());
+      return;
+    }
+
+    auto stored_type =
+        std::make_unique<type_entry_s>(*map_type->map_value_type);
+    auto ptr_type =
+        std::make_unique<type_entry_s>(type_kind_e::POINTER, stored_type->name);
+    ptr_type->pointer_depth = stored_type->pointer_depth + 1;
+    ptr_type->pointee_type = std::move(stored_type);
+    _current_expression_type = std::move(ptr_type);
+    return;
+  }
+
   if (func_type.builtin_kind == language::builtins::builtin_kind_e::EACH) {
     if (node.arguments().size() != 3) {
       report_error("Builtin 'each' expects 3 arguments (collection, context, "
@@ -1117,7 +1683,8 @@ void type_checker_c::visit(const map_type_c &node) {
     }
   }
 
-  auto map_type = std::make_unique<type_entry_s>(type_kind_e::MAP, "map");
+  auto map_type = std::make_unique<type_entry_s>(
+      type_kind_e::MAP, map_entry_name(node.flavor()));
   map_type->map_key_type = std::move(key_type);
   map_type->map_value_type = std::move(value_type);
   _current_expression_type = std::move(map_type);
@@ -1860,6 +2427,10 @@ void type_checker_c::visit(const unary_op_c &node) {
     break;
 
   case unary_op_e::ADDRESS_OF: {
+    if (auto index = node.operand()->as_index(); index && index->is_range()) {
+      report_error("Cannot take address of a subslice", node.source_index());
+      return;
+    }
     if (_current_expression_type->kind == type_kind_e::FUNCTION) {
       report_error(
           "Cannot take address of function/lambda (functions are already "
@@ -2008,6 +2579,11 @@ void type_checker_c::visit(const call_c &node) {
 }
 
 void type_checker_c::visit(const index_c &node) {
+  if (node.is_range()) {
+    check_subslice(node);
+    return;
+  }
+
   node.object()->accept(*this);
   auto object_type = std::move(_current_expression_type);
 
@@ -2030,39 +2606,8 @@ void type_checker_c::visit(const index_c &node) {
       return;
     }
 
-    if (index_type->kind == type_kind_e::ARRAY &&
-        !index_type->array_size.has_value() && index_type->element_type &&
-        (index_type->element_type->name == "i8" ||
-         index_type->element_type->name == "u8")) {
-      auto string_ptr_type =
-          std::make_unique<type_entry_s>(type_kind_e::POINTER, "u8");
-      string_ptr_type->pointer_depth = 1;
-      index_type = std::move(string_ptr_type);
-    }
-
-    index_type = resolve_untyped_literal(index_type.get(),
-                                         object_type->map_key_type.get());
-
-    bool key_types_compatible =
-        types_equal(index_type.get(), object_type->map_key_type.get());
-
-    if (!key_types_compatible && index_type->kind == type_kind_e::POINTER &&
-        object_type->map_key_type->kind == type_kind_e::POINTER &&
-        index_type->pointer_depth == 1 &&
-        object_type->map_key_type->pointer_depth == 1 &&
-        ((index_type->name == "i8" &&
-          object_type->map_key_type->name == "u8") ||
-         (index_type->name == "u8" &&
-          object_type->map_key_type->name == "i8"))) {
-      key_types_compatible = true;
-    }
-
-    if (!key_types_compatible) {
-      report_error(
-          "Map key type mismatch: expected " +
-              get_type_name_from_entry(object_type->map_key_type.get()) +
-              " but got " + get_type_name_from_entry(index_type.get()),
-          node.source_index());
+    if (!check_map_key(object_type.get(), node.index(), std::move(index_type),
+                       node.source_index())) {
       return;
     }
 
@@ -2114,6 +2659,57 @@ void type_checker_c::visit(const index_c &node) {
   }
 }
 
+// `object[start..end]` is a []T over the elements of a slice, vec or
+// fixed-size array without copying them. The emitter takes the element type
+// from the variable, so the object must name one or be another subslice.
+void type_checker_c::check_subslice(const index_c &node) {
+  node.object()->accept(*this);
+  auto object_type = std::move(_current_expression_type);
+
+  if (!object_type) {
+    report_error("Index operation on invalid type", node.source_index());
+    return;
+  }
+
+  if (object_type->kind != type_kind_e::ARRAY ||
+      !object_type->element_type) {
+    report_error("Subslice requires a slice, vec or array",
+                 node.source_index());
+    return;
+  }
+
+  const base_c *root = node.object();
+  while (root->as_index() && root->as_index()->is_range()) {
+    root = root->as_index()->object();
+  }
+  if (!root->as_identifier()) {
+    report_error("Subslice requires a slice, vec or array variable",
+                 node.source_index());
+    return;
+  }
+
+  for (const base_c *bound : {node.index(), node.end()}) {
+    if (!bound) {
+      continue;
+    }
+    bound->accept(*this);
+    auto bound_type = std::move(_current_expression_type);
+    if (!bound_type || (bound_type->kind != type_kind_e::UNTYPED_INTEGER &&
+                        !is_integer_type(bound_type.get()))) {
+      report_error("Subslice bounds must be integer type",
+                   bound->source_index());
+      return;
+    }
+  }
+
+  auto element = std::make_unique<type_entry_s>(*object_type->element_type);
+  auto slice_type =
+      std::make_unique<type_entry_s>(type_kind_e::ARRAY, element->name);
+  slice_type->element_type = std::move(element);
+  slice_type->array_size = std::nullopt;
+  _current_expression_type = std::move(slice_type);
+}
+
 void type_checker_c::visit(const member_access_c &node) {
   if (auto *id_node = node.object()->as_identifier()) {
     auto *type_entry = lookup_type(id_node->id().name);
@@ -2233,6 +2829,11 @@ void type_checker_c::visit(const assignment_c &node) {
   const type_entry_s *map_value_type = nullptr;
 
   if (auto *index = node.target()->as_index()) {
+    if (index->is_range()) {
+      report_error("Cannot assign to a subslice", node.source_index());
+      return;
+    }
+
     index->object()->accept(*this);
     auto object_type = std::move(_current_expression_type);
 
@@ -2253,39 +2854,8 @@ void type_checker_c::visit(const assignment_c &node) {
         return;
       }
 
-      if (index_type->kind == type_kind_e::ARRAY &&
-          !index_type->array_size.has_value() && index_type->element_type &&
-          (index_type->element_type->name == "i8" ||
-           index_type->element_type->name == "u8")) {
-        auto string_ptr_type =
-            std::make_unique<type_entry_s>(type_kind_e::POINTER, "u8");
-        string_ptr_type->pointer_depth = 1;
-        index_type = std::move(string_ptr_type);
-      }
-
-      index_type = resolve_untyped_literal(index_type.get(),
-                                           object_type->map_key_type.get());
-
-      bool key_types_compatible =
-          types_equal(index_type.get(), object_type->map_key_type.get());
-
-      if (!key_types_compatible && index_type->kind == type_kind_e::POINTER &&
-          object_type->map_key_type->kind == type_kind_e::POINTER &&
-          index_type->pointer_depth == 1 &&
-          object_type->map_key_type->pointer_depth == 1 &&
-          ((index_type->name == "i8" &&
-            object_type->map_key_type->name == "u8") ||
-           (index_type->name == "u8" &&
-            object_type->map_key_type->name == "i8"))) {
-        key_types_compatible = true;
-      }
-
-      if (!key_types_compatible) {
-        report_error(
-            "Map key type mismatch: expected " +
-                get_type_name_from_entry(object_type->map_key_type.get()) +
-                " but got " + get_type_name_from_entry(index_type.get()),
-            node.source_index());
+      if (!check_map_key(object_type.get(), index->index(),
+                         std::move(index_type), node.source_index())) {
         return;
       }
 
@@ -2886,6 +3456,9 @@ void symbol_collector_c::visit(const index_c &node) {
   if (node.index()) {
     node.index()->accept(*this);
   }
+  if (node.end()) {
+    node.end()->accept(*this);
+  }
 }
 
 void symbol_collector_c::visit(const member_access_c &node) {
@@ -3147,6 +3720,9 @@ void lambda_capture_validator_c::visit(const index_c &node) {
   if (node.index()) {
     node.index()->accept(*this);
   }
+  if (node.end()) {
+    node.end()->accept(*this);
+  }
 }
 
 void lambda_capture_validator_c::visit(const member_access_c &node) {
@@ -3325,7 +3901,7 @@ type_checker_c::create_type_node_from_entry(const type_entry_s *entry) {
     if (!element)
       return nullptr;
     return std::make_unique<language::nodes::array_type_c>(
-        0, std::move(element), entry->array_size);
+        0, std::move(element), entry->array_size, entry->is_growable);
   }
   case type_kind_e::FUNCTION: {
     std::vector<language::nodes::type_ptr> param_types;
@@ -3347,8 +3923,9 @@ type_checker_c::create_type_node_from_entry(const type_entry_s *entry) {
     auto value_type = create_type_node_from_entry(entry->map_value_type.get());
     if (!key_type || !value_type)
       return nullptr;
-    return std::make_unique<language::nodes::map_type_c>(0, std::move(key_type),
-                                                         std::move(value_type));
+    return std::make_unique<language::nodes::map_type_c>(
+        0, std::move(key_type), std::move(value_type),
+        map_flavor_from_entry_name(entry->name));
   }
   case type_kind_e::TUPLE: {
     std::vector<language::nodes::type_ptr> element_types;
@@ -296,6 +296,367 @@ TEST(BuiltinTests, MakeWithAllPrimitiveTypes) {
   CHECK_TRUE(errors.empty());
 }
 
+TEST(BuiltinTests, MakeInWithAllocator) {
+  std::string code = R"(
+    fn test() : void {
+      var arena: *void = allocator_arena(4096 as u64);
+      var ptr: *i32 = make_in(@i32, arena);
+      var arr: []i32 = make_in(@i32, 8 as u64, arena);
+      delete_in(ptr, arena);
+      delete_in(arr, arena);
+      allocator_reset(arena);
+      allocator_destroy(arena);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_TRUE(errors.empty());
+}
+
+TEST(BuiltinTests, AllocatorConstructorsReturnHandles) {
+  std::string code = R"(
+    fn test() : void {
+      var pool: *void = allocator_pool(16 as u64, 64 as u64);
+      var slab: *void = allocator_slab();
+      var previous: *void = allocator_use(slab);
+      allocator_use(previous);
+      allocator_destroy(pool);
+      allocator_destroy(slab);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_TRUE(errors.empty());
+}
+
+TEST(BuiltinTests, MakeInRequiresPointerAllocator) {
+  std::string code = R"(
+    fn test() : void {
+      var ptr: *i32 = make_in(@i32, 5 as u64);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("allocator must be a pointer") !=
+             std::string::npos);
+}
+
+TEST(BuiltinTests, MakeInRejectsMaps) {
+  std::string code = R"(
+    fn test() : void {
+      var a: *void = allocator_slab();
+      var m: map[i32, i32] = make_in(@map[i32, i32], a);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("does not support maps") != std::string::npos);
+}
+
+TEST(BuiltinTests, MakeMapWithCapacity) {
+  std::string code = R"(
+    fn test() : void {
+      var m: map[i32, i32] = make(@map[i32, i32], 1000 as u64);
+      reserve(m, 5000 as u64);
+      shrink(m);
+      delete(m);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_TRUE(errors.empty());
+}
+
+TEST(BuiltinTests, MakeMapCapacityMustBeU64) {
+  std::string code = R"(
+    fn test() : void {
+      var m: map[i32, i32] = make(@map[i32, i32], 1000);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("map capacity must be u64") != std::string::npos);
+}
+
+TEST(BuiltinTests, MakeIncrementalMap) {
+  std::string code = R"(
+    fn test() : void {
+      var m: map[i32, i32] = make(@map[i32, i32], 0 as u64, true);
+      delete(m);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_TRUE(errors.empty());
+}
+
+TEST(BuiltinTests, MakeIncrementalFlagMustBeBool) {
+  std::string code = R"(
+    fn test() : void {
+      var m: map[i32, i32] = make(@map[i32, i32], 0 as u64, 1);
+      var arr: []i32 = make(@i32, 4 as u64, true);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_EQUAL(2, errors.size());
+  CHECK_TRUE(errors[0].find("incremental flag must be bool") !=
+             std::string::npos);
+  CHECK_TRUE(errors[1].find("only takes a third argument for maps") !=
+             std::string::npos);
+}
+
+TEST(BuiltinTests, OrderedMapRejectsIncrementalFlag) {
+  std::string code = R"(
+    fn test() : void {
+      var m: map[i32, i32, ordered] =
+          make(@map[i32, i32, ordered], 0 as u64, true);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("not available for ordered maps") !=
+             std::string::npos);
+}
+
+TEST(BuiltinTests, ConcurrentMapRejectsIncrementalFlag) {
+  std::string code = R"(
+    fn test() : void {
+      var m: map[u64, i32, concurrent] =
+          make(@map[u64, i32, concurrent], 1024 as u64, true);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("not available for concurrent maps") !=
+             std::string::npos);
+}
+
+TEST(BuiltinTests, GetOrInsertReturnsValuePointer) {
+  std::string code = R"(
+    fn test() : i32 {
+      var m: map[u64, i32, concurrent] = make(@map[u64, i32, concurrent]);
+      var v: *i32 = get_or_insert(m, 7 as u64, 1);
+      return *v;
+    }
+  )";
+
+  CHECK_TRUE(typecheck_code(code).empty());
+}
+
+TEST(BuiltinTests, GetOrInsertRequiresConcurrentMap) {
+  std::string code = R"(
+    fn test() : void {
+      var m: map[u64, i32] = make(@map[u64, i32]);
+      var v: *i32 = get_or_insert(m, 7 as u64, 1);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("requires a concurrent map") != std::string::npos);
+}
+
+TEST(BuiltinTests, GetOrInsertChecksKeyType) {
+  std::string code = R"(
+    fn test() : void {
+      var m: map[u64, i32, concurrent] = make(@map[u64, i32, concurrent]);
+      var v: *i32 = get_or_insert(m, "seven", 1);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("Map key type mismatch") != std::string::npos);
+}
+
+TEST(BuiltinTests, ReserveRequiresMap) {
+  std::string code = R"(
+    fn test() : void {
+      var arr: []i32 = make(@i32, 4 as u64);
+      reserve(arr, 8 as u64);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("requires a map") != std::string::npos);
+}
+
+TEST(BuiltinTests, VecBuiltins) {
+  std::string code = R"(
+    fn test() : i32 {
+      var v: vec[i32] = make(@vec[i32], 16 as u64);
+      push(v, 1);
+      push(v, 2);
+      reserve(v, 64 as u64);
+      var c: u64 = cap(v);
+      var n: u64 = len(v);
+      var last: i32 = pop(v);
+      var first: i32 = v[0];
+      delete(v);
+      return last + first;
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_TRUE(errors.empty());
+}
+
+TEST(BuiltinTests, PushValueMustMatchElementType) {
+  std::string code = R"(
+    fn test() : void {
+      var v: vec[i32] = make(@vec[i32]);
+      push(v, true);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("must match the vec element type") !=
+             std::string::npos);
+}
+
+TEST(BuiltinTests, PopRequiresVec) {
+  std::string code = R"(
+    fn test() : void {
+      var arr: []i32 = make(@i32, 4 as u64);
+      var x: i32 = pop(arr);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("'pop' requires a vec") != std::string::npos);
+}
+
+TEST(BuiltinTests, MakeInRejectsVec) {
+  std::string code = R"(
+    fn test(a: *void) : void {
+      var v: vec[i32] = make_in(@vec[i32], a);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("does not support vecs") != std::string::npos);
+}
+
+TEST(BuiltinTests, VecIsNotASlice) {
+  std::string code = R"(
+    fn test() : void {
+      var v: vec[i32] = make(@vec[i32]);
+      var s: []i32 = v;
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+}
+
+TEST(BuiltinTests, BytesBuiltins) {
+  std::string code = R"(
+    fn test(line: []u8, raw: []i8) : u64 {
+      var head: []u8 = line[..bytes_find_any(line, ",;")];
+      var lines: u64 = bytes_count(raw, '\n') + bytes_find(line, 10);
+      var order: i32 = bytes_compare(head, "GET");
+      bytes_fill(line, 0);
+      var copied: u64 = bytes_copy(line, "abc");
+      var ok: bool = bytes_utf8_valid(line);
+      return lines + copied;
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_TRUE(errors.empty());
+}
+
+TEST(BuiltinTests, BytesRequiresByteSlice) {
+  std::string code = R"(
+    fn test(words: []i32) : u64 {
+      return bytes_count(words, 1);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("requires a []u8 or []i8 slice") !=
+             std::string::npos);
+}
+
+TEST(BuiltinTests, BytesByteMustBeByte) {
+  std::string code = R"(
+    fn test(line: []u8) : u64 {
+      var b: i32 = 10;
+      return bytes_find(line, b);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("byte must be u8 or i8") != std::string::npos);
+}
+
+TEST(BuiltinTests, BytesFillRejectsStringLiteral) {
+  std::string code = R"(
+    fn test() : void {
+      bytes_fill("abc", 0);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+}
+
+TEST(BuiltinTests, ScanBuiltins) {
+  std::string code = R"(
+    fn test(text: []u8, at: u64) : i32 {
+      var close: u64 = scan_group(text, at, '(', ')', '\\');
+      var quote: u64 = scan_group("\"a\"", 0, '"', '"');
+      var start: u64 = 0;
+      var end: u64 = 0;
+      var kind: i32 = scan_token(text, close + 1, &start, &end, ")(");
+      return kind + scan_token(text[end..], 0, &start, &end);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_TRUE(errors.empty());
+}
+
+TEST(BuiltinTests, ScanGroupDelimitersMustBeBytes) {
+  std::string code = R"(
+    fn test(text: []u8) : u64 {
+      var open: i32 = 40;
+      return scan_group(text, 0, open, ')');
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("delimiters must be u8 or i8") !=
+             std::string::npos);
+}
+
+TEST(BuiltinTests, ScanTokenBoundsMustBeU64Pointers) {
+  std::string code = R"(
+    fn test(text: []u8) : i32 {
+      var start: u64 = 0;
+      var end: i64 = 0;
+      return scan_token(text, 0, &start, &end);
+    }
+  )";
+
+  auto errors = typecheck_code(code);
+  CHECK_FALSE(errors.empty());
+  CHECK_TRUE(errors[0].find("token bounds must be *u64") != std::string::npos);
+}
+
 int main(int argc, char **argv) {
   return CommandLineTestRunner::RunAllTests(argc, argv);
 }
@@ -0,0 +1,298 @@
+#include <cstring>
+#include <truk/ingestion/parser.hpp>
+#include <truk/validation/range_analysis.hpp>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace truk::validation;
+using namespace truk::ingestion;
+
+static std::size_t count_unchecked(const std::string &code) {
+  parser_c parser(code.c_str(), code.size());
+  auto result = parser.parse();
+  CHECK_TRUE(result.success);
+
+  range_analysis_c analysis;
+  analysis.analyze(result.declarations);
+  return analysis.unchecked_indices().size();
+}
+
+static std::size_t count_hoisted(const std::string &code) {
+  parser_c parser(code.c_str(), code.size());
+  auto result = parser.parse();
+  CHECK_TRUE(result.success);
+
+  range_analysis_c analysis;
+  analysis.analyze(result.declarations);
+  std::size_t count = 0;
+  for (const auto &[loop, indices] : analysis.hoisted_checks()) {
+    count += indices.size();
+  }
+  return count;
+}
+
+TEST_GROUP(RangeAnalysisTests){};
+
+TEST(RangeAnalysisTests, ForLoopInductionVariable) {
+  std::string code = R"(
+    fn sum(s: []i32) : i32 {
+      var total: i32 = 0;
+      for var i: u64 = 0; i < len(s); i += 1 {
+        total += s[i];
+      }
+      return total;
+    }
+  )";
+  CHECK_EQUAL(1, count_unchecked(code));
+}
+
+TEST(RangeAnalysisTests, LoopStoreIsUnchecked) {
+  std::string code = R"(
+    fn clear(s: []i32) : void {
+      for var i: u64 = 0; i < len(s); i = i + 1 {
+        s[i] = 0;
+      }
+    }
+  )";
+  CHECK_EQUAL(1, count_unchecked(code));
+}
+
+TEST(RangeAnalysisTests, UnguardedIndexKeepsCheck) {
+  std::string code = R"(
+    fn get(s: []i32, i: u64) : i32 {
+      return s[i];
+    }
+  )";
+  CHECK_EQUAL(0, count_unchecked(code));
+}
+
+TEST(RangeAnalysisTests, LessOrEqualIsNotEnough) {
+  std::string code = R"(
+    fn sum(s: []i32) : i32 {
+      var total: i32 = 0;
+      for var i: u64 = 0; i <= len(s); i = i + 1 {
+        total = total + s[i];
+      }
+      return total;
+    }
+  )";
+  CHECK_EQUAL(0, count_unchecked(code));
+}
+
+TEST(RangeAnalysisTests, ReassignmentInBodyDropsFact) {
+  std::string code = R"(
+    fn walk(s: []i32, t: []i32) : i32 {
+      var total: i32 = 0;
+      for var i: u64 = 0; i < len(s); i = i + 1 {
+        s = t;
+        total = total + s[i];
+      }
+      for var j: u64 = 0; j < len(t); j = j + 1 {
+        j = j + 1;
+        total = total + t[j];
+      }
+      return total;
+    }
+  )";
+  CHECK_EQUAL(0, count_unchecked(code));
+}
+
+TEST(RangeAnalysisTests, EarlyExitGuard) {
+  std::string code = R"(
+    fn get(s: []i32, i: u64) : i32 {
+      if i >= len(s) {
+        return -1;
+      }
+      return s[i];
+    }
+  )";
+  CHECK_EQUAL(1, count_unchecked(code));
+}
+
+TEST(RangeAnalysisTests, GuardOnlyCoversItsBranch) {
+  std::string code = R"(
+    fn get(s: []i32, i: u64) : i32 {
+      var r: i32 = 0;
+      if i < len(s) {
+        r = s[i];
+      } else {
+        r = s[i];
+      }
+      return r + s[i];
+    }
+  )";
+  CHECK_EQUAL(1, count_unchecked(code));
+}
+
+TEST(RangeAnalysisTests, LiteralIndexUnderLengthGuard) {
+  std::string code = R"(
+    fn first_three(s: []i32) : i32 {
+      if len(s) >= 3 {
+        return s[0] + s[2] + s[3];
+      }
+      return 0;
+    }
+  )";
+  CHECK_EQUAL(2, count_unchecked(code));
+}
+
+TEST(RangeAnalysisTests, ShortCircuitAnd) {
+  std::string code = R"(
+    fn positive_at(s: []i32, i: u64) : bool {
+      return i < len(s) && s[i] > 0;
+    }
+  )";
+  CHECK_EQUAL(1, count_unchecked(code));
+}
+
+TEST(RangeAnalysisTests, AddressTakenIsNotTracked) {
+  std::string code = R"(
+    fn bump(p: *u64) : void {
+      *p = *p + 1;
+    }
+
+    fn sum(s: []i32) : i32 {
+      var total: i32 = 0;
+      for var i: u64 = 0; i < len(s); i = i + 1 {
+        bump(&i);
+        total = total + s[i];
+      }
+      return total;
+    }
+  )";
+  CHECK_EQUAL(0, count_unchecked(code));
+}
+
+TEST(RangeAnalysisTests, GlobalsAreNotTracked) {
+  std::string code = R"(
+    var i: u64 = 0;
+
+    fn get(s: []i32) : i32 {
+      if i < len(s) {
+        return s[i];
+      }
+      return 0;
+    }
+  )";
+  CHECK_EQUAL(0, count_unchecked(code));
+}
+
+TEST(RangeAnalysisTests, HoistsCheckAgainstLoopBound) {
+  std::string code = R"(
+    fn sum(s: []i32, n: u64) : i32 {
+      var total: i32 = 0;
+      for var i: u64 = 0; i < n; i += 1 {
+        total += s[i];
+      }
+      return total;
+    }
+  )";
+  CHECK_EQUAL(0, count_unchecked(code));
+  CHECK_EQUAL(1, count_hoisted(code));
+}
+
+TEST(RangeAnalysisTests, HoistsEveryUnconditionalAccess) {
+  std::string code = R"(
+    fn add(a: []i32, b: []i32, out: []i32) : void {
+      for var i: u64 = 0; i < len(out); i += 1 {
+        out[i] = a[i] + b[i];
+      }
+    }
+  )";
+  CHECK_EQUAL(1, count_unchecked(code));
+  CHECK_EQUAL(2, count_hoisted(code));
+}
+
+TEST(RangeAnalysisTests, EarlyExitPreventsHoisting) {
+  std::string code = R"(
+    fn find(s: []i32, n: u64) : i32 {
+      var at: i32 = -1;
+      for var i: u64 = 0; i < n; i += 1 {
+        if s[i] == 0 {
+          break;
+        }
+        at = s[i];
+      }
+      return at;
+    }
+  )";
+  CHECK_EQUAL(0, count_hoisted(code));
+}
+
+TEST(RangeAnalysisTests, CallPreventsHoisting) {
+  std::string code = R"(
+    fn log(v: i32) : void {}
+
+    fn dump(s: []i32, n: u64) : void {
+      for var i: u64 = 0; i < n; i += 1 {
+        log(s[i]);
+      }
+    }
+  )";
+  CHECK_EQUAL(0, count_hoisted(code));
+}
+
+TEST(RangeAnalysisTests, ConditionalAccessIsNotHoisted) {
+  std::string code = R"(
+    fn sum_even(s: []i32, n: u64) : i32 {
+      var total: i32 = 0;
+      for var i: u64 = 0; i < n; i += 1 {
+        if total > 100 {
+          total = total + s[i];
+        }
+      }
+      return total;
+    }
+  )";
+  CHECK_EQUAL(0, count_hoisted(code));
+}
+
+TEST(RangeAnalysisTests, OnlyUnitStepIsHoisted) {
+  std::string code = R"(
+    fn sum(s: []i32, n: u64) : i32 {
+      var total: i32 = 0;
+      for var i: u64 = 0; i < n; i += 2 {
+        total += s[i];
+      }
+      for var j: u8 = 0; j < 200; j += 1 {
+        total += s[j];
+      }
+      return total;
+    }
+  )";
+  CHECK_EQUAL(0, count_hoisted(code));
+}
+
+TEST(RangeAnalysisTests, VecPopInLoopKeepsCheck) {
+  std::string code = R"(
+    fn drain(v: vec[i32]) : i32 {
+      var total: i32 = 0;
+      for var i: u64 = 0; i < len(v); i += 1 {
+        total += v[i];
+        var x: i32 = pop(v);
+        total += v[i];
+      }
+      return total;
+    }
+  )";
+  CHECK_EQUAL(1, count_unchecked(code));
+}
+
+TEST(RangeAnalysisTests, SubsliceIsNotHoisted) {
+  std::string code = R"(
+    fn views(s: []i32, n: u64) : u64 {
+      var total: u64 = 0;
+      for var i: u64 = 0; i < n; i += 1 {
+        total += len(s[i..]);
+      }
+      return total;
+    }
+  )";
+  CHECK_EQUAL(0, count_hoisted(code));
+  CHECK_EQUAL(0, count_unchecked(code));
+}
+
+int main(int argc, char **argv) {
+  return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -509,6 +509,40 @@ TEST(TypeCheckComplexTests, ArrayIndexing) {
   CHECK_FALSE(checker->has_errors());
 }
 
+TEST(TypeCheckComplexTests, Subslice) {
+  const char *source = R"(
+    fn test(s: []u8): u64 {
+      var arr: [5]i32 = [1, 2, 3, 4, 5];
+      var start: u64 = 1;
+      var head: []u8 = s[..start];
+      var rest: []u8 = s[start..][1..];
+      var mid: []i32 = arr[1..4];
+      return len(head) + len(rest) + len(mid);
+    }
+  )";
+  parse_and_check(source);
+  CHECK_FALSE(checker->has_errors());
+}
+
+TEST(TypeCheckComplexTests, SubsliceInSlicePositions) {
+  const char *source = R"(
+    fn sum(s: []i32): i32 {
+      return s[0];
+    }
+
+    fn test(s: []i32): i32 {
+      s[1..3][0] = 4;
+      var n: u64 = len(s[1..]);
+      each(s[..2], &n, fn(elem: *i32, ctx: *u64): bool {
+        return true;
+      });
+      return s[1..3][1] + sum(s[2..]);
+    }
+  )";
+  parse_and_check(source);
+  CHECK_FALSE(checker->has_errors());
+}
+
 TEST(TypeCheckComplexTests, StructMemberAccess) {
   const char *source = R"(
     struct Point {
@@ -1074,6 +1108,46 @@ TEST(TypeCheckErrorTests, IndexNonArray) {
   CHECK_TRUE(checker->has_errors());
 }
 
+TEST(TypeCheckErrorTests, SubsliceNonArray) {
+  const char *source = R"(
+    fn test(p: *i32): void {
+      var s: []i32 = p[0..4];
+    }
+  )";
+  parse_and_check(source);
+  CHECK_TRUE(checker->has_errors());
+}
+
+TEST(TypeCheckErrorTests, SubsliceBoundNotInteger) {
+  const char *source = R"(
+    fn test(s: []i32): void {
+      var t: []i32 = s[0..true];
+    }
+  )";
+  parse_and_check(source);
+  CHECK_TRUE(checker->has_errors());
+}
+
+TEST(TypeCheckErrorTests, AssignToSubslice) {
+  const char *source = R"(
+    fn test(s: []i32, t: []i32): void {
+      s[0..2] = t;
+    }
+  )";
+  parse_and_check(source);
+  CHECK_TRUE(checker->has_errors());
+}
+
+TEST(TypeCheckErrorTests, DeleteSubslice) {
+  const char *source = R"(
+    fn test(s: []i32): void {
+      delete(s[0..2]);
+    }
+  )";
+  parse_and_check(source);
+  CHECK_TRUE(checker->has_errors());
+}
+
 TEST(TypeCheckErrorTests, MemberAccessOnNonStruct) {
   const char *source = R"(
     fn test(): i32 {
@@ -1416,6 +1490,44 @@ TEST(TypeCheckMapTests, MapNestedValueTypes) {
   CHECK_FALSE(checker->has_errors());
 }
 
+TEST(TypeCheckMapTests, OrderedMapIsDistinctType) {
+  const char *source = R"(
+    fn test(): void {
+      var m: map[*u8, i32, ordered] = make(@map[*u8, i32, ordered]);
+      m["key"] = 1;
+      var value: *i32 = m["key"];
+      delete(m["key"]);
+      delete(m);
+    }
+
+    fn mismatch(): void {
+      var m: map[*u8, i32] = make(@map[*u8, i32, ordered]);
+    }
+  )";
+  parse_and_check(source);
+  CHECK_TRUE(checker->has_errors());
+  CHECK_EQUAL(1, checker->errors().size());
+}
+
+TEST(TypeCheckMapTests, ConcurrentMapIsDistinctType) {
+  const char *source = R"(
+    fn test(): void {
+      var m: map[i64, f64, concurrent] = make(@map[i64, f64, concurrent]);
+      m[3 as i64] = 1.5;
+      var value: *f64 = m[3 as i64];
+      reserve(m, 64 as u64);
+      delete(m);
+    }
+
+    fn mismatch(): void {
+      var m: map[i64, f64, ordered] = make(@map[i64, f64, concurrent]);
+    }
+  )";
+  parse_and_check(source);
+  CHECK_TRUE(checker->has_errors());
+  CHECK_EQUAL(1, checker->errors().size());
+}
+
 int main(int argc, char **argv) {
   return CommandLineTestRunner::RunAllTests(argc, argv);
 }
@@ -0,0 +1,160 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sxs/runtime.h>
+#include <time.h>
+
+/*
+ * Cost of slice bounds checks at the check site: the runtime's hinted compare
+ * that calls the cold __truk_runtime_sxs_bounds_fail, against the previous
+ * check that had fprintf and exit inlined at every site. Each kernel sums
+ * elements picked through an index array so no check can be proven away.
+ *
+ *   ns      nanoseconds per loop iteration, best of five runs
+ *
+ * followed by the machine code size of each variant's kernels, read from the
+ * linker section they are placed in.
+ *
+ *   bench_sxs_bounds_check [log2 count]
+ */
+
+typedef struct {
+  const __truk_i32 *data;
+  __truk_u64 len;
+} slice_t;
+
+static inline __truk_void legacy_bounds_check(__truk_u64 idx, __truk_u64 len) {
+  if (idx >= len) {
+    fprintf(stderr, "panic: index out of bounds: %llu >= %llu\n",
+            (unsigned long long)idx, (unsigned long long)len);
+    exit(1);
+  }
+}
+
+/* GNU ld defines __start_ and __stop_ symbols around these sections. */
+#define LEGACY_SECTION __attribute__((noinline, section("truk_bench_legacy")))
+#define COLD_SECTION __attribute__((noinline, section("truk_bench_cold")))
+extern const char __start_truk_bench_legacy[], __stop_truk_bench_legacy[];
+extern const char __start_truk_bench_cold[], __stop_truk_bench_cold[];
+
+#define GATHER_KERNEL(name, check)                                             \
+  static long long name(slice_t a, const __truk_u64 *idx, __truk_u64 n) {      \
+    long long total = 0;                                                       \
+    __truk_u64 i;                                                              \
+    for (i = 0; i < n; i++) {                                                  \
+      check(idx[i], a.len);                                                    \
+      total += a.data[idx[i]];                                                 \
+    }                                                                          \
+    return total;                                                              \
+  }
+
+#define STENCIL_KERNEL(name, check)                                            \
+  static long long name(slice_t a, slice_t b, slice_t c, slice_t d,            \
+                        const __truk_u64 *idx, __truk_u64 n) {                 \
+    long long total = 0;                                                       \
+    __truk_u64 i;                                                              \
+    for (i = 0; i < n; i++) {                                                  \
+      __truk_u64 k = idx[i];                                                   \
+      check(k, a.len);                                                         \
+      check(k, b.len);                                                         \
+      check(k, c.len);                                                         \
+      check(k, d.len);                                                         \
+      total += a.data[k] * b.data[k] + c.data[k] * d.data[k];                  \
+    }                                                                          \
+    return total;                                                              \
+  }
+
+LEGACY_SECTION GATHER_KERNEL(gather_legacy, legacy_bounds_check)
+LEGACY_SECTION STENCIL_KERNEL(stencil_legacy, legacy_bounds_check)
+COLD_SECTION GATHER_KERNEL(gather_cold, __truk_runtime_sxs_bounds_check)
+COLD_SECTION STENCIL_KERNEL(stencil_cold, __truk_runtime_sxs_bounds_check)
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned long long splitmix64(unsigned long long *state) {
+  unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static volatile long long sink;
+
+static double time_gather(long long (*fn)(slice_t, const __truk_u64 *,
+                                          __truk_u64),
+                          slice_t a, const __truk_u64 *idx, __truk_u64 n) {
+  double best = 1e30, t;
+  int r;
+  for (r = 0; r < 5; r++) {
+    t = now();
+    sink += fn(a, idx, n);
+    t = now() - t;
+    best = t < best ? t : best;
+  }
+  return best * 1e9 / (double)n;
+}
+
+static double time_stencil(long long (*fn)(slice_t, slice_t, slice_t, slice_t,
+                                           const __truk_u64 *, __truk_u64),
+                           slice_t a, const __truk_u64 *idx, __truk_u64 n) {
+  double best = 1e30, t;
+  int r;
+  for (r = 0; r < 5; r++) {
+    t = now();
+    sink += fn(a, a, a, a, idx, n);
+    t = now() - t;
+    best = t < best ? t : best;
+  }
+  return best * 1e9 / (double)n;
+}
+
+int main(int argc, char **argv) {
+  int bits = argc > 1 ? atoi(argv[1]) : 22;
+  unsigned long long state = 7;
+  __truk_u64 n, i;
+  __truk_i32 *data;
+  __truk_u64 *idx;
+  slice_t a;
+
+  if (bits < 4 || bits > 26) {
+    fprintf(stderr, "usage: %s [log2 count, 4..26]\n", argv[0]);
+    return 1;
+  }
+  n = (__truk_u64)1 << bits;
+
+  /* A cache-resident table so the loop, not memory, is what is measured. */
+  a.len = 4096;
+  data = malloc(sizeof(*data) * a.len);
+  idx = malloc(sizeof(*idx) * n);
+  for (i = 0; i < a.len; i++) {
+    data[i] = (__truk_i32)i;
+  }
+  for (i = 0; i < n; i++) {
+    idx[i] = splitmix64(&state) % a.len;
+  }
+  a.data = data;
+
+  printf("%llu iterations over a %llu-element slice\n", (unsigned long long)n,
+         (unsigned long long)a.len);
+  printf("%-10s %-14s %8s\n", "check", "kernel", "ns");
+  printf("%-10s %-14s %8.3f\n", "inline", "gather",
+         time_gather(gather_legacy, a, idx, n));
+  printf("%-10s %-14s %8.3f\n", "cold", "gather",
+         time_gather(gather_cold, a, idx, n));
+  printf("%-10s %-14s %8.3f\n", "inline", "stencil x4",
+         time_stencil(stencil_legacy, a, idx, n));
+  printf("%-10s %-14s %8.3f\n", "cold", "stencil x4",
+         time_stencil(stencil_cold, a, idx, n));
+  printf("code bytes for both kernels: inline %ld, cold %ld\n",
+         (long)(__stop_truk_bench_legacy - __start_truk_bench_legacy),
+         (long)(__stop_truk_bench_cold - __start_truk_bench_cold));
+
+  free(data);
+  free(idx);
+  return 0;
+}
@@ -0,0 +1,168 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sxs/bytes.h>
+#include <time.h>
+
+/*
+ * Throughput of the bytes_* kernels against the byte-at-a-time loops a truk
+ * program would otherwise write, over a synthetic log: lines of 40 to 160
+ * printable bytes with an occasional two-byte UTF-8 character.
+ *
+ *   GB/s    input bytes per nanosecond, best of five runs
+ *
+ *   bench_sxs_bytes [log2 size]
+ */
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned long long splitmix64(unsigned long long *state) {
+  unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static const __truk_u8 delims[] = {',', ';', '\n'};
+
+/* The loops below are kept out of line so the compiler cannot fold them into
+ * the timing harness, and mirror what a truk loop over s[i] compiles to. */
+__attribute__((noinline)) static __truk_u64
+naive_count(const __truk_u8 *data, __truk_u64 len, __truk_u8 byte) {
+  __truk_u64 count = 0, i;
+  for (i = 0; i < len; i++) {
+    if (data[i] == byte) {
+      count++;
+    }
+  }
+  return count;
+}
+
+__attribute__((noinline)) static __truk_u64
+naive_fields(const __truk_u8 *data, __truk_u64 len) {
+  __truk_u64 fields = 0, i, k;
+  for (i = 0; i < len; i++) {
+    for (k = 0; k < sizeof(delims); k++) {
+      if (data[i] == delims[k]) {
+        fields++;
+        break;
+      }
+    }
+  }
+  return fields;
+}
+
+__attribute__((noinline)) static __truk_u64
+naive_utf8(const __truk_u8 *data, __truk_u64 len) {
+  __truk_u64 i = 0;
+  while (i < len) {
+    __truk_u8 c = data[i];
+    __truk_u64 n = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+    __truk_u64 k;
+    if (i + n > len) {
+      return 0;
+    }
+    for (k = 1; k < n; k++) {
+      if ((data[i + k] & 0xC0) != 0x80) {
+        return 0;
+      }
+    }
+    i += n;
+  }
+  return 1;
+}
+
+static __truk_u64 kernel_count(const __truk_u8 *data, __truk_u64 len) {
+  return __truk_bytes_count(data, len, '\n');
+}
+
+static __truk_u64 kernel_fields(const __truk_u8 *data, __truk_u64 len) {
+  __truk_u64 fields = 0, i = 0;
+  for (;;) {
+    i += __truk_bytes_find_any(data + i, len - i, delims, sizeof(delims));
+    if (i == len) {
+      return fields;
+    }
+    fields++;
+    i++;
+  }
+}
+
+static __truk_u64 kernel_utf8(const __truk_u8 *data, __truk_u64 len) {
+  return __truk_bytes_utf8_valid(data, len);
+}
+
+static __truk_u64 naive_count_lines(const __truk_u8 *data, __truk_u64 len) {
+  return naive_count(data, len, '\n');
+}
+
+static volatile __truk_u64 sink;
+
+static double gbps(__truk_u64 (*fn)(const __truk_u8 *, __truk_u64),
+                   const __truk_u8 *data, __truk_u64 len) {
+  double best = 1e30, t;
+  int r;
+  for (r = 0; r < 5; r++) {
+    t = now();
+    sink += fn(data, len);
+    t = now() - t;
+    best = t < best ? t : best;
+  }
+  return (double)len / best / 1e9;
+}
+
+int main(int argc, char **argv) {
+  int bits = argc > 1 ? atoi(argv[1]) : 24;
+  unsigned long long state = 11;
+  __truk_u64 len, i = 0;
+  __truk_u8 *data;
+
+  if (bits < 10 || bits > 30) {
+    fprintf(stderr, "usage: %s [log2 size, 10..30]\n", argv[0]);
+    return 1;
+  }
+  len = (__truk_u64)1 << bits;
+  data = malloc(len);
+
+  while (i < len) {
+    __truk_u64 line = 40 + splitmix64(&state) % 120, k;
+    for (k = 0; k < line && i < len - 2; k++) {
+      unsigned long long r = splitmix64(&state) % 64;
+      if (r == 0) {
+        data[i++] = 0xC3;
+        data[i++] = 0xA9;
+      } else {
+        data[i++] = r < 4 ? ',' : r < 6 ? ';' : (__truk_u8)('a' + r % 26);
+      }
+    }
+    data[i++] = '\n';
+  }
+  while (i < len) {
+    data[i++] = ' ';
+  }
+
+  if (naive_count_lines(data, len) != kernel_count(data, len) ||
+      naive_fields(data, len) != kernel_fields(data, len) ||
+      naive_utf8(data, len) != kernel_utf8(data, len)) {
+    fprintf(stderr, "kernel and loop results differ\n");
+    return 1;
+  }
+
+  printf("%llu bytes of log text\n", (unsigned long long)len);
+  printf("%-22s %10s %10s\n", "operation", "loop GB/s", "kernel GB/s");
+  printf("%-22s %10.2f %10.2f\n", "count '\\n'",
+         gbps(naive_count_lines, data, len), gbps(kernel_count, data, len));
+  printf("%-22s %10.2f %10.2f\n", "split on , ; \\n",
+         gbps(naive_fields, data, len), gbps(kernel_fields, data, len));
+  printf("%-22s %10.2f %10.2f\n", "utf8 validate", gbps(naive_utf8, data, len),
+         gbps(kernel_utf8, data, len));
+
+  free(data);
+  return 0;
+}
@@ -0,0 +1,165 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sxs/ds/concurrent_map.h>
+#include <sxs/ds/map.h>
+#include <sxs/runtime.h>
+#include <time.h>
+
+/*
+ * Scaling of the concurrent map (concurrent_map.h) against a flat map behind
+ * one global mutex, which is what a threaded program had to do before. Both
+ * start with count keys; every thread then runs the same share of a mixed
+ * workload (mostly hits, some updates, inserts and erases) over that key
+ * range, and the total throughput is reported for 1, 2, 4, ... threads.
+ *
+ *   bench_sxs_concurrent_map [count] [max threads]
+ */
+
+typedef __truk_map_t(long long) flat_map_t;
+typedef __truk_concurrent_map_t(long long) concurrent_map_t;
+
+typedef struct {
+  flat_map_t flat;
+  pthread_mutex_t lock;
+  concurrent_map_t concurrent;
+  const long long *keys;
+  int nkeys;
+} shared_t;
+
+typedef struct {
+  shared_t *shared;
+  int ops;
+  unsigned long long seed;
+  long long sum;
+} worker_t;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned long long splitmix64(unsigned long long *state) {
+  unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/* 80% lookups, 15% updates or inserts and 5% erases. The key range is twice
+ * the preloaded size so some lookups miss and some sets insert. */
+#define WORKLOAD(lock, unlock, get, set, remove)                               \
+  do {                                                                         \
+    int i;                                                                     \
+    for (i = 0; i < w->ops; i++) {                                             \
+      unsigned long long r = splitmix64(&w->seed);                             \
+      long long key = s->keys[(r >> 8) % (unsigned long long)s->nkeys];        \
+      unsigned op = (unsigned)(r & 0xff) % 20;                                 \
+      lock;                                                                    \
+      if (op < 16) {                                                           \
+        long long *v = get;                                                    \
+        w->sum += v ? *v : 0;                                                  \
+      } else if (op < 19) {                                                    \
+        set;                                                                   \
+      } else {                                                                 \
+        remove;                                                                \
+      }                                                                        \
+      unlock;                                                                  \
+    }                                                                          \
+  } while (0)
+
+static void *run_global_lock(void *arg) {
+  worker_t *w = arg;
+  shared_t *s = w->shared;
+  WORKLOAD(pthread_mutex_lock(&s->lock), pthread_mutex_unlock(&s->lock),
+           __truk_map_get_generic(&s->flat, &key),
+           __truk_map_set_generic(&s->flat, &key, key),
+           __truk_map_remove_generic(&s->flat, &key));
+  return NULL;
+}
+
+static void *run_sharded(void *arg) {
+  worker_t *w = arg;
+  shared_t *s = w->shared;
+  WORKLOAD((void)0, (void)0,
+           __truk_concurrent_map_get_generic(&s->concurrent, &key),
+           __truk_concurrent_map_set_generic(&s->concurrent, &key, key),
+           __truk_concurrent_map_remove_generic(&s->concurrent, &key));
+  return NULL;
+}
+
+static double run(shared_t *shared, void *(*fn)(void *), int nthreads,
+                  int total_ops) {
+  pthread_t threads[64];
+  worker_t workers[64];
+  double t;
+  int i;
+  for (i = 0; i < nthreads; i++) {
+    workers[i].shared = shared;
+    workers[i].ops = total_ops / nthreads;
+    workers[i].seed = 1000u + (unsigned)i;
+    workers[i].sum = 0;
+  }
+  t = now();
+  for (i = 0; i < nthreads; i++) {
+    pthread_create(&threads[i], NULL, fn, &workers[i]);
+  }
+  for (i = 0; i < nthreads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  return now() - t;
+}
+
+int main(int argc, char **argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 1000000;
+  int max_threads = argc > 2 ? atoi(argv[2]) : 8;
+  int total_ops = 4000000;
+  unsigned long long state = 42;
+  long long *keys;
+  shared_t shared;
+  int i, t;
+
+  if (n <= 0 || max_threads <= 0 || max_threads > 64) {
+    fprintf(stderr, "usage: %s [count] [max threads, 1-64]\n", argv[0]);
+    return 1;
+  }
+
+  keys = malloc(sizeof(*keys) * 2 * (size_t)n);
+  for (i = 0; i < 2 * n; i++) {
+    keys[i] = (long long)splitmix64(&state);
+  }
+  shared.keys = keys;
+  shared.nkeys = 2 * n;
+  pthread_mutex_init(&shared.lock, NULL);
+
+  printf("%d keys, %d mixed ops, Mops/s\n", n, total_ops);
+  printf("%-8s %12s %12s %9s\n", "threads", "global-lock", "sharded",
+         "speedup");
+  for (t = 1; t <= max_threads; t <<= 1) {
+    double global, sharded;
+    __truk_map_init_generic(&shared.flat, sizeof(long long),
+                            __truk_map_mixhash_64, __truk_map_cmp_mem);
+    __truk_concurrent_map_init_generic(&shared.concurrent, sizeof(long long),
+                                       __truk_map_mixhash_64,
+                                       __truk_map_cmp_mem);
+    for (i = 0; i < n; i++) {
+      __truk_map_set_generic(&shared.flat, &keys[i], keys[i]);
+      __truk_concurrent_map_set_generic(&shared.concurrent, &keys[i],
+                                        keys[i]);
+    }
+    global = run(&shared, run_global_lock, t, total_ops);
+    sharded = run(&shared, run_sharded, t, total_ops);
+    printf("%-8d %12.2f %12.2f %8.2fx\n", t, total_ops / global / 1e6,
+           total_ops / sharded / 1e6, global / sharded);
+    __truk_map_deinit(&shared.flat);
+    __truk_concurrent_map_deinit(&shared.concurrent);
+  }
+
+  pthread_mutex_destroy(&shared.lock);
+  free(keys);
+  return 0;
+}
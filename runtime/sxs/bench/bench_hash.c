@@ -0,0 +1,149 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sxs/ds/map.h>
+#include <time.h>
+
+/*
+ * Collision distribution of the map hash functions over realistic key sets.
+ * For each key set and hash it reports:
+ *
+ *   chi2    chi-squared of the low-bit bucket loads divided by its expected
+ *           value; ~1.0 is uniform, large values mean crowded buckets
+ *   max     largest bucket load, with the mean load at 1 key per bucket
+ *   empty   fraction of buckets left empty (uniform: ~0.368)
+ *   ns      nanoseconds per hash call
+ *
+ *   bench_sxs_hash [log2 count]
+ */
+
+typedef struct {
+  const char *name;
+  const void *keys;
+  int ksize;
+  __truk_map_hash_fn identity;
+  __truk_map_hash_fn mix;
+} key_set_t;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned long long splitmix64(unsigned long long *state) {
+  unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static void measure(const char *set_name, const char *hash_name,
+                    const key_set_t *set, __truk_map_hash_fn fn, int n,
+                    unsigned *counts) {
+  unsigned mask = (unsigned)n - 1;
+  unsigned max = 0, empty = 0;
+  double chi2 = 0.0, t;
+  volatile unsigned sink = 0;
+  int i;
+
+  memset(counts, 0, sizeof(*counts) * n);
+  t = now();
+  for (i = 0; i < n; i++) {
+    unsigned h = fn((const char *)set->keys + (size_t)i * set->ksize,
+                    set->ksize);
+    sink ^= h;
+    counts[h & mask]++;
+  }
+  t = now() - t;
+  (void)sink;
+
+  for (i = 0; i < n; i++) {
+    double d = (double)counts[i] - 1.0;
+    chi2 += d * d;
+    max = counts[i] > max ? counts[i] : max;
+    empty += counts[i] == 0;
+  }
+  printf("%-14s %-10s %10.2f %8u %8.3f %8.1f\n", set_name, hash_name,
+         chi2 / (double)(n - 1), max, (double)empty / n, t * 1e9 / n);
+}
+
+int main(int argc, char **argv) {
+  int bits = argc > 1 ? atoi(argv[1]) : 20;
+  int n, i, s;
+  unsigned long long state = 7;
+  long long *seq, *aligned, *rnd;
+  int *small;
+  double *floats;
+  char **words, **paths;
+  unsigned *counts;
+  key_set_t sets[7];
+
+  if (bits < 4 || bits > 26) {
+    fprintf(stderr, "usage: %s [log2 count, 4..26]\n", argv[0]);
+    return 1;
+  }
+  n = 1 << bits;
+
+  seq = malloc(sizeof(*seq) * n);
+  aligned = malloc(sizeof(*aligned) * n);
+  rnd = malloc(sizeof(*rnd) * n);
+  small = malloc(sizeof(*small) * n);
+  floats = malloc(sizeof(*floats) * n);
+  words = malloc(sizeof(*words) * n);
+  paths = malloc(sizeof(*paths) * n);
+  counts = malloc(sizeof(*counts) * n);
+  for (i = 0; i < n; i++) {
+    seq[i] = i;
+    /* Heap-like addresses: 16-byte aligned, clustered in 4 KiB pages. */
+    aligned[i] = 0x7f0000000000LL + (long long)(i / 256) * 4096 +
+                 (long long)(i % 256) * 16;
+    rnd[i] = (long long)splitmix64(&state);
+    small[i] = i * 8;
+    floats[i] = (double)i * 0.25;
+    words[i] = malloc(24);
+    snprintf(words[i], 24, "user%d", i);
+    paths[i] = malloc(64);
+    snprintf(paths[i], 64, "/usr/share/truk/pkg%03d/src/module_%d.truk",
+             i % 997, i);
+  }
+
+  sets[0] = (key_set_t){"i64-seq", seq, sizeof(long long),
+                        __truk_map_hash_i64, __truk_map_mixhash_64};
+  sets[1] = (key_set_t){"i64-pointer", aligned, sizeof(long long),
+                        __truk_map_hash_i64, __truk_map_mixhash_64};
+  sets[2] = (key_set_t){"i64-random", rnd, sizeof(long long),
+                        __truk_map_hash_i64, __truk_map_mixhash_64};
+  sets[3] = (key_set_t){"i32-stride8", small, sizeof(int),
+                        __truk_map_hash_i32, __truk_map_mixhash_32};
+  sets[4] = (key_set_t){"f64-quarters", floats, sizeof(double),
+                        __truk_map_hash_f64, __truk_map_mixhash_64};
+  sets[5] = (key_set_t){"str-ids", words, sizeof(char *),
+                        __truk_map_hash_str, __truk_map_mixhash_str};
+  sets[6] = (key_set_t){"str-paths", paths, sizeof(char *),
+                        __truk_map_hash_str, __truk_map_mixhash_str};
+
+  printf("%d keys into %d buckets by low bits\n", n, n);
+  printf("%-14s %-10s %10s %8s %8s %8s\n", "keys", "hash", "chi2", "max",
+         "empty", "ns");
+  for (s = 0; s < 7; s++) {
+    measure(sets[s].name, "identity", &sets[s], sets[s].identity, n, counts);
+    measure(sets[s].name, "mix", &sets[s], sets[s].mix, n, counts);
+  }
+
+  for (i = 0; i < n; i++) {
+    free(words[i]);
+    free(paths[i]);
+  }
+  free(seq);
+  free(aligned);
+  free(rnd);
+  free(small);
+  free(floats);
+  free(words);
+  free(paths);
+  free(counts);
+  return 0;
+}
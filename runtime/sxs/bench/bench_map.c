@@ -0,0 +1,332 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sxs/ds/chained_map.h>
+#include <sxs/ds/map.h>
+#include <sxs/ds/ordered_map.h>
+#include <sxs/runtime.h>
+#include <time.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+/*
+ * Compares the flat map (map.h), the chained map (chained_map.h) and the
+ * insertion-ordered map (ordered_map.h) on the operations emitted code
+ * performs: insert, lookup (hit and miss), iteration and erase, then reports
+ * the heap footprint of each engine and the worst single insert with and
+ * without incremental resizing.
+ *
+ *   bench_sxs_map [count]
+ */
+
+typedef __truk_map_t(long long) flat_map_t;
+typedef __truk_chained_map_t(long long) chained_map_t;
+typedef __truk_ordered_map_t(long long) ordered_map_t;
+
+typedef struct {
+  const char *name;
+  const void *keys;
+  const void *missing;
+  const int *order;
+  int ksize;
+  __truk_map_hash_fn hash_fn;
+  __truk_map_cmp_fn cmp_fn;
+} key_set_t;
+
+typedef struct {
+  double insert, hit, miss, iterate, erase;
+} result_t;
+
+static volatile long long sink;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned long long splitmix64(unsigned long long *state) {
+  unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+#define KEY_AT(set, i)                                                         \
+  ((const char *)(set)->keys + (size_t)(i) * (size_t)(set)->ksize)
+#define KEY_SHUFFLED(set, i) KEY_AT(set, (set)->order[i])
+#define MISSING_AT(set, i)                                                     \
+  ((const char *)(set)->missing + (size_t)(i) * (size_t)(set)->ksize)
+
+/* Lookups and erases walk the keys in shuffled order so the chained map does
+ * not get to follow its nodes through memory in allocation order.
+ * One instantiation per engine so neither pays for an indirect call. */
+#define DEFINE_RUN(engine, map_type, prefix)                                   \
+  static result_t run_##engine(const key_set_t *set, int n) {                  \
+    result_t r;                                                                \
+    map_type map;                                                              \
+    prefix##_iter_t iter;                                                      \
+    long long sum = 0;                                                         \
+    double t;                                                                  \
+    int i;                                                                     \
+    prefix##_init_generic(&map, set->ksize, set->hash_fn, set->cmp_fn);        \
+    t = now();                                                                 \
+    for (i = 0; i < n; i++) {                                                  \
+      prefix##_set_generic(&map, KEY_AT(set, i), (long long)i);                \
+    }                                                                          \
+    r.insert = now() - t;                                                      \
+    t = now();                                                                 \
+    for (i = 0; i < n; i++) {                                                  \
+      sum += *(long long *)prefix##_get_(&map.base, KEY_SHUFFLED(set, i));     \
+    }                                                                          \
+    r.hit = now() - t;                                                         \
+    t = now();                                                                 \
+    for (i = 0; i < n; i++) {                                                  \
+      sum += prefix##_get_(&map.base, MISSING_AT(set, i)) != NULL;             \
+    }                                                                          \
+    r.miss = now() - t;                                                        \
+    t = now();                                                                 \
+    iter = prefix##_iter(&map);                                                \
+    while (prefix##_next_generic(&map, &iter)) {                               \
+      sum++;                                                                   \
+    }                                                                          \
+    r.iterate = now() - t;                                                     \
+    t = now();                                                                 \
+    for (i = 0; i < n; i++) {                                                  \
+      prefix##_remove_generic(&map, KEY_SHUFFLED(set, i));                     \
+    }                                                                          \
+    r.erase = now() - t;                                                       \
+    prefix##_deinit(&map);                                                     \
+    sink = sum;                                                                \
+    return r;                                                                  \
+  }
+
+DEFINE_RUN(flat, flat_map_t, __truk_map)
+DEFINE_RUN(chained, chained_map_t, __truk_chained_map)
+DEFINE_RUN(ordered, ordered_map_t, __truk_ordered_map)
+
+/* Times every insert on its own, so the table doubling shows up as the
+ * maximum rather than being averaged away. */
+static void run_latency(const key_set_t *set, int n, int incremental,
+                        double *mean, double *worst) {
+  flat_map_t map;
+  double total = 0, max = 0;
+  int i;
+  __truk_map_init_generic(&map, set->ksize, set->hash_fn, set->cmp_fn);
+  __truk_map_set_incremental(&map, incremental);
+  for (i = 0; i < n; i++) {
+    double t = now();
+    __truk_map_set_generic(&map, KEY_AT(set, i), (long long)i);
+    t = now() - t;
+    total += t;
+    if (t > max) {
+      max = t;
+    }
+  }
+  __truk_map_deinit(&map);
+  *mean = total / n * 1e9;
+  *worst = max * 1e9;
+}
+
+/* Footprint is measured by routing the maps through a counting allocator.
+ * On glibc each block is charged its usable size plus the chunk header, which
+ * is what the process actually pays; elsewhere the requested size. */
+typedef struct {
+  __truk_allocator_t base;
+  long long live, peak, calls;
+} counting_allocator_t;
+
+static long long block_cost(void *ptr, __truk_u64 size) {
+#ifdef __GLIBC__
+  (void)size;
+  return (long long)malloc_usable_size(ptr) + (long long)sizeof(size_t);
+#else
+  (void)ptr;
+  return (long long)size;
+#endif
+}
+
+static void *counting_alloc(__truk_allocator_t *self, __truk_u64 size) {
+  counting_allocator_t *c = (counting_allocator_t *)self;
+  void *ptr = malloc(size);
+  c->live += block_cost(ptr, size);
+  c->calls++;
+  if (c->live > c->peak) {
+    c->peak = c->live;
+  }
+  return ptr;
+}
+
+static void counting_free(__truk_allocator_t *self, void *ptr) {
+  counting_allocator_t *c = (counting_allocator_t *)self;
+  c->live -= block_cost(ptr, 0);
+  free(ptr);
+}
+
+typedef struct {
+  double loaded, churned;
+  long long calls, churn_calls;
+} footprint_t;
+
+/* Load n keys, then remove half and insert as many new keys; the second
+ * figure shows whether removed entries are recycled. */
+#define DEFINE_FOOTPRINT(engine, map_type, prefix)                             \
+  static footprint_t footprint_##engine(const key_set_t *set, int n) {         \
+    counting_allocator_t counter = {                                           \
+        {counting_alloc, counting_free, NULL, NULL}, 0, 0, 0};                 \
+    footprint_t f;                                                             \
+    map_type map;                                                              \
+    long long calls;                                                           \
+    int i;                                                                     \
+    prefix##_init_generic(&map, set->ksize, set->hash_fn, set->cmp_fn);        \
+    __truk_runtime_sxs_set_thread_allocator(&counter.base);                    \
+    for (i = 0; i < n; i++) {                                                  \
+      prefix##_set_generic(&map, KEY_AT(set, i), (long long)i);                \
+    }                                                                          \
+    f.loaded = (double)counter.live / (double)n;                               \
+    f.calls = counter.calls;                                                   \
+    calls = counter.calls;                                                     \
+    for (i = 0; i < n / 2; i++) {                                              \
+      prefix##_remove_generic(&map, KEY_SHUFFLED(set, i));                     \
+    }                                                                          \
+    for (i = 0; i < n / 2; i++) {                                              \
+      prefix##_set_generic(&map, MISSING_AT(set, i), (long long)i);            \
+    }                                                                          \
+    f.churned = (double)counter.live / (double)n;                              \
+    f.churn_calls = counter.calls - calls;                                     \
+    prefix##_deinit(&map);                                                     \
+    __truk_runtime_sxs_set_thread_allocator(NULL);                             \
+    return f;                                                                  \
+  }
+
+DEFINE_FOOTPRINT(flat, flat_map_t, __truk_map)
+DEFINE_FOOTPRINT(chained, chained_map_t, __truk_chained_map)
+DEFINE_FOOTPRINT(ordered, ordered_map_t, __truk_ordered_map)
+
+static void report_footprint(const char *engine, const key_set_t *set,
+                             footprint_t f) {
+  printf("%-10s %-12s %12.1f %12lld %12.1f %12lld\n", engine, set->name,
+         f.loaded, f.calls, f.churned, f.churn_calls);
+}
+
+static void report(const char *engine, const key_set_t *set, result_t r,
+                   int n) {
+  double scale = 1e9 / (double)n;
+  printf("%-10s %-12s %9.1f %9.1f %9.1f %9.1f %9.1f\n", engine, set->name,
+         r.insert * scale, r.hit * scale, r.miss * scale, r.iterate * scale,
+         r.erase * scale);
+}
+
+int main(int argc, char **argv) {
+  int n = argc > 1 ? atoi(argv[1]) : 1000000;
+  unsigned long long state = 42;
+  long long *seq, *seq_missing, *rnd, *rnd_missing;
+  char **strs, **strs_missing;
+  __truk_map_strkey_t *strkeys, *strkeys_missing;
+  int *order;
+  key_set_t sets[4];
+  int i, s;
+
+  if (n <= 0) {
+    fprintf(stderr, "usage: %s [count]\n", argv[0]);
+    return 1;
+  }
+
+  seq = malloc(sizeof(*seq) * n);
+  seq_missing = malloc(sizeof(*seq_missing) * n);
+  rnd = malloc(sizeof(*rnd) * n);
+  rnd_missing = malloc(sizeof(*rnd_missing) * n);
+  strs = malloc(sizeof(*strs) * n);
+  strs_missing = malloc(sizeof(*strs_missing) * n);
+  strkeys = malloc(sizeof(*strkeys) * n);
+  strkeys_missing = malloc(sizeof(*strkeys_missing) * n);
+  order = malloc(sizeof(*order) * n);
+  for (i = 0; i < n; i++) {
+    seq[i] = i;
+    seq_missing[i] = (long long)n + i;
+    /* Force the low bit so missing keys (low bit clear) never collide. */
+    rnd[i] = (long long)(splitmix64(&state) | 1);
+    rnd_missing[i] = (long long)(splitmix64(&state) & ~1ULL);
+    strs[i] = malloc(32);
+    strs_missing[i] = malloc(32);
+    snprintf(strs[i], 32, "user:%d", i);
+    snprintf(strs_missing[i], 32, "none:%d", i);
+    strkeys[i] = __truk_map_strkey_cstr(strs[i]);
+    strkeys_missing[i] = __truk_map_strkey_cstr(strs_missing[i]);
+    order[i] = i;
+  }
+  for (i = n - 1; i > 0; i--) {
+    int j = (int)(splitmix64(&state) % (unsigned long long)(i + 1));
+    int tmp = order[i];
+    order[i] = order[j];
+    order[j] = tmp;
+  }
+
+  sets[0] = (key_set_t){"i64-seq",           seq,
+                        seq_missing,         order,
+                        sizeof(long long),   __truk_map_mixhash_64,
+                        __truk_map_cmp_mem};
+  sets[1] = (key_set_t){"i64-random",        rnd,
+                        rnd_missing,         order,
+                        sizeof(long long),   __truk_map_mixhash_64,
+                        __truk_map_cmp_mem};
+  sets[2] = (key_set_t){"str",          strs,
+                        strs_missing,   order,
+                        sizeof(char *), __truk_map_mixhash_str,
+                        __truk_map_cmp_str};
+  sets[3] = (key_set_t){"strkey",
+                        strkeys,
+                        strkeys_missing,
+                        order,
+                        sizeof(__truk_map_strkey_t),
+                        __truk_map_hash_strkey,
+                        __truk_map_cmp_strkey};
+
+  printf("%d keys, ns/op\n", n);
+  printf("%-10s %-12s %9s %9s %9s %9s %9s\n", "engine", "keys", "insert",
+         "hit", "miss", "iterate", "erase");
+  for (s = 0; s < 4; s++) {
+    report("flat", &sets[s], run_flat(&sets[s], n), n);
+    report("chained", &sets[s], run_chained(&sets[s], n), n);
+    report("ordered", &sets[s], run_ordered(&sets[s], n), n);
+  }
+
+  printf("\nheap footprint, bytes/entry (8-byte values) and allocations\n");
+  printf("%-10s %-12s %12s %12s %12s %12s\n", "engine", "keys", "loaded",
+         "allocs", "churned", "churn allocs");
+  for (s = 0; s < 4; s++) {
+    report_footprint("flat", &sets[s], footprint_flat(&sets[s], n));
+    report_footprint("chained", &sets[s], footprint_chained(&sets[s], n));
+    report_footprint("ordered", &sets[s], footprint_ordered(&sets[s], n));
+  }
+
+  printf("\ninsert latency, ns (flat map)\n");
+  printf("%-12s %-12s %12s %12s\n", "resize", "keys", "mean", "max");
+  for (s = 0; s < 4; s++) {
+    double mean, worst;
+    run_latency(&sets[s], n, 0, &mean, &worst);
+    printf("%-12s %-12s %12.1f %12.0f\n", "rehash", sets[s].name, mean,
+           worst);
+    run_latency(&sets[s], n, 1, &mean, &worst);
+    printf("%-12s %-12s %12.1f %12.0f\n", "incremental", sets[s].name, mean,
+           worst);
+  }
+
+  for (i = 0; i < n; i++) {
+    free(strs[i]);
+    free(strs_missing[i]);
+  }
+  free(strs);
+  free(strkeys);
+  free(strkeys_missing);
+  free(strs_missing);
+  free(order);
+  free(seq);
+  free(seq_missing);
+  free(rnd);
+  free(rnd_missing);
+  return 0;
+}
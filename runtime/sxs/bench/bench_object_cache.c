@@ -0,0 +1,120 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sxs/runtime.h>
+#include <time.h>
+
+/*
+ * make/delete of single small objects, through the runtime's per-thread
+ * object cache and through plain malloc/free. Every thread keeps a window of
+ * live objects of 16 to 256 bytes and replaces one at random per operation,
+ * all threads running at once.
+ *
+ *   ns/op    one allocation plus one free, wall time per thread's operation
+ *   Mops/s   allocation/free pairs per second across all threads
+ *
+ *   bench_sxs_object_cache [operations per thread]
+ */
+
+#define WINDOW 512
+#define MAX_THREADS 8
+#define RUNS 5
+
+typedef struct {
+  unsigned long long ops;
+  unsigned long long seed;
+  int cached;
+} worker_t;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned long long splitmix64(unsigned long long *state) {
+  unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static void *churn(void *arg) {
+  worker_t *w = (worker_t *)arg;
+  void *window[WINDOW];
+  __truk_u64 sizes[WINDOW];
+  unsigned long long state = w->seed, i;
+  int j;
+
+  for (j = 0; j < WINDOW; j++) {
+    sizes[j] = 16;
+    window[j] = w->cached ? __truk_runtime_sxs_alloc_object(16) : malloc(16);
+  }
+  for (i = 0; i < w->ops; i++) {
+    unsigned long long r = splitmix64(&state);
+    unsigned long long slot = r % WINDOW;
+    __truk_u64 size = 16 + (r >> 32) % 241;
+    if (w->cached) {
+      __truk_runtime_sxs_free_object(window[slot], sizes[slot]);
+      window[slot] = __truk_runtime_sxs_alloc_object(size);
+    } else {
+      free(window[slot]);
+      window[slot] = malloc(size);
+    }
+    sizes[slot] = size;
+  }
+  for (j = 0; j < WINDOW; j++) {
+    if (w->cached) {
+      __truk_runtime_sxs_free_object(window[j], sizes[j]);
+    } else {
+      free(window[j]);
+    }
+  }
+  return NULL;
+}
+
+static double run(int threads, int cached, unsigned long long ops) {
+  pthread_t ids[MAX_THREADS];
+  worker_t workers[MAX_THREADS];
+  double best = 1e30, t;
+  int r, i;
+  for (r = 0; r < RUNS; r++) {
+    t = now();
+    for (i = 0; i < threads; i++) {
+      workers[i].ops = ops;
+      workers[i].seed = (unsigned long long)(i + 1) * 7919;
+      workers[i].cached = cached;
+      pthread_create(&ids[i], NULL, churn, &workers[i]);
+    }
+    for (i = 0; i < threads; i++) {
+      pthread_join(ids[i], NULL);
+    }
+    t = now() - t;
+    best = t < best ? t : best;
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+  unsigned long long ops = argc > 1 ? strtoull(argv[1], NULL, 10) : 2000000;
+  int threads;
+
+  if (!ops) {
+    fprintf(stderr, "usage: %s [operations per thread]\n", argv[0]);
+    return 1;
+  }
+
+  printf("%-8s %-8s %10s %10s\n", "threads", "path", "ns/op", "Mops/s");
+  for (threads = 1; threads <= MAX_THREADS; threads *= 2) {
+    double total = (double)ops * threads;
+    double plain = run(threads, 0, ops);
+    double cached = run(threads, 1, ops);
+    printf("%-8d %-8s %10.1f %10.1f\n", threads, "malloc", plain / total * 1e9,
+           total / plain / 1e6);
+    printf("%-8d %-8s %10.1f %10.1f\n", threads, "cache", cached / total * 1e9,
+           total / cached / 1e6);
+  }
+  return 0;
+}
@@ -0,0 +1,260 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sxs/ds/scanner.h>
+#include <time.h>
+
+/*
+ * Throughput of the group and static-type scanners against byte-at-a-time
+ * loops, plus a stress pass over worst-case input.
+ *
+ *   config     s-expression config text: nested groups of symbols, integers,
+ *              reals and quoted strings with escapes
+ *   dense      every byte is a delimiter, one group nested as deep as the
+ *              input allows (worst case for the block scan, which then
+ *              visits every byte)
+ *   stream     the config text fed through the streaming scanners in 4 KiB
+ *              chunks, as a socket reader would
+ *
+ *   GB/s       input bytes per nanosecond, best of five runs
+ *
+ *   bench_sxs_scanner [log2 size]
+ */
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned long long splitmix64(unsigned long long *state) {
+  unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static const __truk_u8 stops[] = {'(', ')', '"'};
+
+/* Kept out of line so the compiler cannot fold them into the harness. */
+__attribute__((noinline)) static __truk_u64
+naive_group(const __truk_u8 *data, __truk_u64 len) {
+  __truk_u64 depth = 1, i;
+  for (i = 1; i < len; i++) {
+    if (data[i] == '\\') {
+      i++;
+    } else if (data[i] == ')') {
+      if (--depth == 0) {
+        return i;
+      }
+    } else if (data[i] == '(') {
+      depth++;
+    }
+  }
+  return len;
+}
+
+static int naive_is_stop(__truk_u8 c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '(' ||
+         c == ')' || c == '"';
+}
+
+static int naive_is_digit(__truk_u8 c) { return c >= '0' && c <= '9'; }
+
+/* The static-type machine written as the obvious loop over s[i], returning
+ * the sum of the token types (1 integer, 2 real, 3 symbol). The input holds
+ * no malformed numbers, so the error states are left out. */
+__attribute__((noinline)) static __truk_u64
+naive_tokens(const __truk_u8 *data, __truk_u64 len) {
+  __truk_u64 types = 0, i = 0;
+  while (i < len) {
+    __truk_u64 j, type;
+    if (naive_is_stop(data[i])) {
+      i++;
+      continue;
+    }
+    j = i + (data[i] == '+' || data[i] == '-');
+    type = j < len && naive_is_digit(data[j]) ? 1 : 3;
+    while (j < len && !naive_is_stop(data[j])) {
+      if (type == 1 && data[j] == '.') {
+        type = 2;
+      }
+      j++;
+    }
+    types += type;
+    i = j;
+  }
+  return types;
+}
+
+static __truk_u64 kernel_group(const __truk_u8 *data, __truk_u64 len) {
+  return __truk_scan_group(data, len, 0, '(', ')', '\\');
+}
+
+static __truk_u64 kernel_tokens(const __truk_u8 *data, __truk_u64 len) {
+  __truk_scanner_t scanner = {data, len, 0};
+  __truk_u64 tokens = 0;
+  while (scanner.position < len) {
+    __truk_scanner_static_t token =
+        __truk_scanner_read_static(&scanner, stops, sizeof(stops));
+    if (token.success) {
+      tokens += token.type;
+    } else if (token.type == __TRUK_SCANNER_NONE) {
+      scanner.position = token.error_position + 1;
+    } else {
+      scanner.position = token.error_position;
+      __truk_scanner_read_static(&scanner, stops, sizeof(stops));
+    }
+  }
+  return tokens;
+}
+
+static __truk_u64 stream_group(const __truk_u8 *data, __truk_u64 len) {
+  __truk_scanner_group_stream_t stream;
+  __truk_u64 at = 0, used;
+  __truk_scanner_group_begin(&stream, '(', ')', '\\', false);
+  while (at < len) {
+    __truk_u64 n = len - at < 4096 ? len - at : 4096;
+    if (__truk_scanner_group_feed(&stream, data + at, n, &used) !=
+        __TRUK_SCANNER_MORE) {
+      return stream.end;
+    }
+    at += used;
+  }
+  return len;
+}
+
+static __truk_u64 stream_tokens(const __truk_u8 *data, __truk_u64 len) {
+  __truk_scanner_static_stream_t stream;
+  __truk_u64 tokens = 0, at = 0;
+  __truk_scanner_static_begin(&stream, stops, sizeof(stops));
+  while (at < len) {
+    __truk_u64 end = len - at < 4096 ? len : at + 4096;
+    while (at < end) {
+      __truk_u64 used;
+      __truk_scanner_status_e status =
+          __truk_scanner_static_feed(&stream, data + at, end - at, &used);
+      at += used;
+      if (status == __TRUK_SCANNER_DONE) {
+        tokens += stream.type;
+      } else if (status == __TRUK_SCANNER_FAIL) {
+        at++;
+      }
+    }
+  }
+  if (__truk_scanner_static_finish(&stream) == __TRUK_SCANNER_DONE) {
+    tokens += stream.type;
+  }
+  return tokens;
+}
+
+static volatile __truk_u64 sink;
+
+static double gbps(__truk_u64 (*fn)(const __truk_u8 *, __truk_u64),
+                   const __truk_u8 *data, __truk_u64 len) {
+  double best = 1e30, t;
+  int r;
+  for (r = 0; r < 5; r++) {
+    t = now();
+    sink += fn(data, len);
+    t = now() - t;
+    best = t < best ? t : best;
+  }
+  return (double)len / best / 1e9;
+}
+
+static __truk_u64 append(__truk_u8 *data, __truk_u64 i, const char *text) {
+  __truk_u64 n = strlen(text);
+  memcpy(data + i, text, n);
+  return i + n;
+}
+
+/* One top-level group of config entries, closed at the very end. */
+static void fill_config(__truk_u8 *data, __truk_u64 len) {
+  static const char *keys[] = {"listen", "workers", "timeout", "upstream",
+                               "log-level", "ratio"};
+  unsigned long long state = 7;
+  char text[256];
+  __truk_u64 i = 0;
+  data[i++] = '(';
+  while (i + 256 < len) {
+    unsigned long long r = splitmix64(&state);
+    const char *key = keys[r % 6];
+    switch (r % 4) {
+    case 0:
+      snprintf(text, sizeof(text), "\n  (%s %llu)", key, r % 100000);
+      break;
+    case 1:
+      snprintf(text, sizeof(text), "\n  (%s %llu.%llu)", key, r % 1000,
+               (r >> 20) % 1000);
+      break;
+    case 2:
+      snprintf(text, sizeof(text),
+               "\n  (%s \"a quoted value with \\\"escapes\\\" and more "
+               "text in it\")",
+               key);
+      break;
+    default:
+      snprintf(text, sizeof(text),
+               "\n  (%s (host backend-%llu.internal.example) (port %llu))",
+               key, r % 64, 8000 + r % 100);
+      break;
+    }
+    i = append(data, i, text);
+  }
+  while (i < len - 1) {
+    data[i++] = ' ';
+  }
+  data[i] = ')';
+}
+
+static void report(const char *name,
+                   __truk_u64 (*loop)(const __truk_u8 *, __truk_u64),
+                   __truk_u64 (*kernel)(const __truk_u8 *, __truk_u64),
+                   const __truk_u8 *data, __truk_u64 len) {
+  printf("%-24s %10.2f %10.2f\n", name, gbps(loop, data, len),
+         gbps(kernel, data, len));
+}
+
+int main(int argc, char **argv) {
+  int bits = argc > 1 ? atoi(argv[1]) : 24;
+  __truk_u64 len, i;
+  __truk_u8 *data;
+
+  if (bits < 12 || bits > 30) {
+    fprintf(stderr, "usage: %s [log2 size, 12..30]\n", argv[0]);
+    return 1;
+  }
+  len = (__truk_u64)1 << bits;
+  data = malloc(len);
+
+  fill_config(data, len);
+  if (naive_group(data, len) != kernel_group(data, len) ||
+      kernel_group(data, len) != stream_group(data, len) ||
+      naive_tokens(data, len) != kernel_tokens(data, len) ||
+      kernel_tokens(data, len) != stream_tokens(data, len)) {
+    fprintf(stderr, "scanner and loop results differ\n");
+    return 1;
+  }
+
+  printf("%llu bytes of config text\n", (unsigned long long)len);
+  printf("%-24s %10s %10s\n", "operation", "loop GB/s", "scan GB/s");
+  report("config group", naive_group, kernel_group, data, len);
+  report("config tokens", naive_tokens, kernel_tokens, data, len);
+  report("stream group", naive_group, stream_group, data, len);
+  report("stream tokens", naive_tokens, stream_tokens, data, len);
+
+  for (i = 0; i < len; i++) {
+    data[i] = i < len / 2 ? '(' : ')';
+  }
+  if (naive_group(data, len) != kernel_group(data, len)) {
+    fprintf(stderr, "scanner and loop results differ\n");
+    return 1;
+  }
+  report("dense group", naive_group, kernel_group, data, len);
+
+  free(data);
+  return 0;
+}
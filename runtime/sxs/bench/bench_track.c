@@ -0,0 +1,116 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sxs/runtime.h>
+#include <time.h>
+
+/*
+ * Cost of allocation tracking on a make/delete churn: a window of live
+ * objects of 16 to 512 bytes, each replaced at random, run once through
+ * malloc/free (what untracked make and delete compile to) and once through
+ * the tracked entry points. Built twice, as bench_sxs_track (every
+ * allocation recorded) and bench_sxs_track_sampled (the production mode).
+ *
+ *   ns/op   one allocation plus one free, best of five runs
+ *
+ *   bench_sxs_track [operations]
+ */
+
+#define WINDOW 4096
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned long long splitmix64(unsigned long long *state) {
+  unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static void *window[WINDOW];
+static __truk_alloc_site_t sites[8] = {
+    {"bench.truk", 1, 0, 0, 0, 0, 0, NULL},
+    {"bench.truk", 2, 0, 0, 0, 0, 0, NULL},
+    {"bench.truk", 3, 0, 0, 0, 0, 0, NULL},
+    {"bench.truk", 4, 0, 0, 0, 0, 0, NULL},
+    {"bench.truk", 5, 0, 0, 0, 0, 0, NULL},
+    {"bench.truk", 6, 0, 0, 0, 0, 0, NULL},
+    {"bench.truk", 7, 0, 0, 0, 0, 0, NULL},
+    {"bench.truk", 8, 0, 0, 0, 0, 0, NULL}};
+
+__attribute__((noinline)) static void churn_plain(unsigned long long ops) {
+  unsigned long long state = 3, i;
+  for (i = 0; i < ops; i++) {
+    unsigned long long r = splitmix64(&state);
+    unsigned long long slot = r % WINDOW;
+    free(window[slot]);
+    window[slot] = malloc(16 + (r >> 32) % 497);
+  }
+}
+
+__attribute__((noinline)) static void churn_tracked(unsigned long long ops) {
+  unsigned long long state = 3, i;
+  for (i = 0; i < ops; i++) {
+    unsigned long long r = splitmix64(&state);
+    unsigned long long slot = r % WINDOW;
+    __truk_runtime_sxs_free_with(NULL, window[slot]);
+    window[slot] = __truk_runtime_sxs_alloc_at(NULL, 16 + (r >> 32) % 497,
+                                               &sites[(r >> 20) % 8]);
+  }
+}
+
+static void drain(int tracked) {
+  int i;
+  for (i = 0; i < WINDOW; i++) {
+    if (tracked) {
+      __truk_runtime_sxs_free_with(NULL, window[i]);
+    } else {
+      free(window[i]);
+    }
+    window[i] = NULL;
+  }
+}
+
+static double ns_per_op(void (*fn)(unsigned long long), int tracked,
+                        unsigned long long ops) {
+  double best = 1e30, t;
+  int r;
+  for (r = 0; r < 5; r++) {
+    t = now();
+    fn(ops);
+    t = now() - t;
+    drain(tracked);
+    best = t < best ? t : best;
+  }
+  return best / (double)ops * 1e9;
+}
+
+int main(int argc, char **argv) {
+  unsigned long long ops = argc > 1 ? strtoull(argv[1], NULL, 10) : 2000000;
+  double plain, tracked;
+
+  if (!ops) {
+    fprintf(stderr, "usage: %s [operations]\n", argv[0]);
+    return 1;
+  }
+
+  plain = ns_per_op(churn_plain, 0, ops);
+  tracked = ns_per_op(churn_tracked, 1, ops);
+
+#if defined(TRUK_TRACK_ALLOCS_SAMPLE)
+  printf("sampled tracking, period %llu bytes\n",
+         (unsigned long long)TRUK_TRACK_ALLOCS_SAMPLE);
+#else
+  printf("full tracking\n");
+#endif
+  printf("%-22s %10s\n", "make/delete", "ns/op");
+  printf("%-22s %10.1f\n", "untracked", plain);
+  printf("%-22s %10.1f\n", "tracked", tracked);
+  printf("%-22s %9.0f%%\n", "overhead", (tracked / plain - 1.0) * 100.0);
+  return 0;
+}
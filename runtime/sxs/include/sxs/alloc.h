@@ -0,0 +1,31 @@
+#pragma once
+
+#include "runtime.h"
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Built-in allocator backends. Each constructor returns a heap-allocated
+ * allocator that is released with __truk_runtime_sxs_allocator_destroy,
+ * which also releases every block it handed out.
+ *
+ * arena: bump allocation out of blocks of at least block_size bytes. free is
+ *        a no-op; reset makes all memory available again at once.
+ * pool:  fixed-size elements, count per chunk, recycled through a free list.
+ *        Requests larger than elem_size panic.
+ * slab:  size classes from 16 to 2048 bytes carved out of 64 KiB slabs, with
+ *        larger requests passed through to malloc.
+ *
+ * Every returned pointer is 16-byte aligned.
+ */
+__truk_allocator_t *__truk_alloc_arena_new(__truk_u64 block_size);
+__truk_allocator_t *__truk_alloc_pool_new(__truk_u64 elem_size,
+                                          __truk_u64 count);
+__truk_allocator_t *__truk_alloc_slab_new(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Byte-slice kernels behind the bytes_* builtins. Every slice is passed as a
+ * data pointer and a length. Searches return the index of the first match,
+ * or len when there is none, so the result can be used directly as a
+ * subslice bound.
+ *
+ * On x86-64 GCC and Clang builds count, find_any and the ASCII scan inside
+ * utf8_valid use SSE2, or AVX2 when the CPU reports it; the choice is made on
+ * every call from the CPU model libgcc fills in at startup. Other targets,
+ * including TCC, use scalar loops. find, compare, fill and copy go to memchr,
+ * memcmp, memset and memmove, which the C library already vectorizes.
+ */
+__truk_u64 __truk_bytes_find(const __truk_u8 *data, __truk_u64 len,
+                             __truk_u8 byte);
+__truk_u64 __truk_bytes_find_any(const __truk_u8 *data, __truk_u64 len,
+                                 const __truk_u8 *set, __truk_u64 set_len);
+__truk_u64 __truk_bytes_count(const __truk_u8 *data, __truk_u64 len,
+                              __truk_u8 byte);
+
+/* Lexicographic, with a shorter prefix ordered first: -1, 0 or 1. */
+__truk_i32 __truk_bytes_compare(const __truk_u8 *a, __truk_u64 a_len,
+                                const __truk_u8 *b, __truk_u64 b_len);
+
+__truk_void __truk_bytes_fill(__truk_u8 *data, __truk_u64 len, __truk_u8 byte);
+
+/* Copies min(dst_len, src_len) bytes, which may overlap, and returns that
+ * count. */
+__truk_u64 __truk_bytes_copy(__truk_u8 *dst, __truk_u64 dst_len,
+                             const __truk_u8 *src, __truk_u64 src_len);
+
+/* Well-formed UTF-8: no overlong forms, surrogates or code points past
+ * U+10FFFF. */
+__truk_bool __truk_bytes_utf8_valid(const __truk_u8 *data, __truk_u64 len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2014 rxi
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ * - Modified for TRUK by bosley 2025
+ */
+
+#ifndef __TRUK_CHAINED_MAP_H
+#define __TRUK_CHAINED_MAP_H
+
+#include <string.h>
+#include <sxs/ds/map.h>
+
+/*
+ * Separately chained map with one node per entry. Value pointers stay valid
+ * until their entry is removed, which the flat map in map.h does not
+ * promise. Uses the hash and compare functions declared in map.h.
+ *
+ * Nodes come from a per-map slab: chunks of growing size, with removed
+ * nodes recycled through a free list and every chunk released at deinit.
+ */
+
+struct __truk_chained_map_node_t;
+typedef struct __truk_chained_map_node_t __truk_chained_map_node_t;
+
+typedef struct {
+  void *chunks;
+  void *free_nodes;
+  unsigned char *bump, *end;
+  unsigned node_size, chunk_nodes;
+} __truk_chained_map_slab_t;
+
+typedef struct {
+  __truk_chained_map_node_t **buckets;
+  unsigned nbuckets, nnodes;
+  int ksize;
+  __truk_map_hash_fn hash_fn;
+  __truk_map_cmp_fn cmp_fn;
+  struct __truk_allocator_s *allocator;
+  __truk_chained_map_slab_t slab;
+} __truk_chained_map_base_t;
+
+typedef struct {
+  unsigned bucketidx;
+  __truk_chained_map_node_t *node;
+} __truk_chained_map_iter_t;
+
+#define __truk_chained_map_t(T)                                                \
+  struct {                                                                     \
+    __truk_chained_map_base_t base;                                            \
+    T *ref;                                                                    \
+    T tmp;                                                                     \
+  }
+
+#define __truk_chained_map_init_generic(m, keysize, hashfn, cmpfn)             \
+  do {                                                                         \
+    memset(m, 0, sizeof(*(m)));                                                \
+    (m)->base.ksize = (keysize);                                               \
+    (m)->base.hash_fn = (hashfn);                                              \
+    (m)->base.cmp_fn = (cmpfn);                                                \
+  } while (0)
+
+#define __truk_chained_map_deinit(m) __truk_chained_map_deinit_(&(m)->base)
+
+#define __truk_chained_map_get_generic(m, key)                                 \
+  ((m)->ref = __truk_chained_map_get_(&(m)->base, key))
+
+#define __truk_chained_map_set_generic(m, key, value)                          \
+  ((m)->tmp = (value),                                                         \
+   __truk_chained_map_set_(&(m)->base, key, &(m)->tmp, sizeof((m)->tmp)))
+
+#define __truk_chained_map_remove_generic(m, key)                              \
+  __truk_chained_map_remove_(&(m)->base, key)
+
+#define __truk_chained_map_iter(m) __truk_chained_map_iter_()
+
+#define __truk_chained_map_next_generic(m, iter)                               \
+  __truk_chained_map_next_(&(m)->base, iter)
+
+void __truk_chained_map_deinit_(__truk_chained_map_base_t *m);
+void *__truk_chained_map_get_(__truk_chained_map_base_t *m, const void *key);
+int __truk_chained_map_set_(__truk_chained_map_base_t *m, const void *key,
+                            void *value, int vsize);
+void __truk_chained_map_remove_(__truk_chained_map_base_t *m, const void *key);
+__truk_chained_map_iter_t __truk_chained_map_iter_(void);
+void *__truk_chained_map_next_(__truk_chained_map_base_t *m,
+                               __truk_chained_map_iter_t *iter);
+
+#endif
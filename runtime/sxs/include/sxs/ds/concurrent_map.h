@@ -0,0 +1,185 @@
+#ifndef __TRUK_CONCURRENT_MAP_H
+#define __TRUK_CONCURRENT_MAP_H
+
+#include <pthread.h>
+#include <string.h>
+#include <sxs/ds/map.h>
+
+/*
+ * Lock-striped map for tables shared between threads. Keys are spread over a
+ * fixed number of shards by the high bits of their hash; each shard is a flat
+ * map guarded by its own mutex, so threads working on different shards never
+ * wait for each other.
+ *
+ * Values live in per-entry nodes outside the shard tables, so a shard resize
+ * never moves them and the pointer returned by get stays valid while other
+ * threads insert. Removed nodes go on their shard's free list and are reused
+ * by later inserts rather than freed: a stale pointer still refers to value
+ * memory, but it may hold a newer entry's value. Reads and writes through
+ * returned pointers are not synchronized, so they can tear against a
+ * concurrent set; get_copy and get_or_insert_copy copy the value out under
+ * the shard lock instead, and set, get_or_insert or compute_if_absent make
+ * an update atomic with its lookup.
+ *
+ * Everything is allocated from the allocator that is current at init, which
+ * must be safe to call from several threads (the default allocator is).
+ * init and deinit must not race with any other call on the same map.
+ */
+
+#define __TRUK_CONCURRENT_MAP_SHARDS 32u
+
+struct __truk_allocator_s;
+
+typedef struct {
+  unsigned char *shards;
+  void *shard_mem;
+  unsigned nshards, shard_shift;
+  int ksize, vsize, nodesize;
+  __truk_map_hash_fn hash_fn;
+  __truk_map_cmp_fn cmp_fn;
+  struct __truk_allocator_s *allocator;
+} __truk_concurrent_map_base_t;
+
+/* Iteration copies one shard's keys and values at a time, under its lock,
+ * and hands out pointers into the copy, so no lock is held between calls to
+ * next and the caller may use the map meanwhile. Writes through the returned
+ * value pointers do not reach the map. The copy is allocated from the map's
+ * allocator; if that fails the scan ends early. Call iter_end when leaving a
+ * scan early to free it. */
+typedef struct {
+  unsigned shard;
+  unsigned char *buf;
+  unsigned long long cap, count, pos;
+} __truk_concurrent_map_iter_t;
+
+/* Fills a newly inserted value, which starts zeroed. Returning nonzero
+ * abandons the insert. */
+typedef int (*__truk_concurrent_map_init_fn)(const void *key, void *value,
+                                             void *ctx);
+
+#define __truk_concurrent_map_t(T)                                             \
+  struct {                                                                     \
+    __truk_concurrent_map_base_t base;                                         \
+    T *ref;                                                                    \
+    T tmp;                                                                     \
+  }
+
+#define __truk_concurrent_map_init_generic(m, keysize, hashfn, cmpfn)          \
+  do {                                                                         \
+    memset(m, 0, sizeof(*(m)));                                                \
+    __truk_concurrent_map_init_(&(m)->base, (keysize),                         \
+                                (int)sizeof((m)->tmp), (hashfn), (cmpfn));     \
+  } while (0)
+
+#define __truk_concurrent_map_deinit(m)                                        \
+  __truk_concurrent_map_deinit_(&(m)->base)
+
+/* Unlike the other maps, these leave the shared ref and tmp fields alone so
+ * that several threads can use one map at once. */
+#define __truk_concurrent_map_get_generic(m, key)                              \
+  ((__typeof__((m)->ref))__truk_concurrent_map_get_(&(m)->base, key))
+
+#define __truk_concurrent_map_set_generic(m, key, value)                       \
+  __extension__({                                                              \
+    __typeof__((m)->tmp) __truk_cm_val = (value);                              \
+    __truk_concurrent_map_set_(&(m)->base, key, &__truk_cm_val,                \
+                               sizeof(__truk_cm_val));                         \
+  })
+
+/* Copy-out forms. The copy is a compound literal, so it lives until the end
+ * of the block the macro is expanded in; the result is NULL if the key is
+ * absent (or, for get_or_insert_copy, if the insert failed). */
+#define __truk_concurrent_map_get_copy_generic(m, key)                         \
+  ((__typeof__((m)->ref))__truk_concurrent_map_get_copy_(                      \
+      &(m)->base, key, (__typeof__((m)->tmp)[1]){0}))
+
+#define __truk_concurrent_map_get_or_insert_copy_generic(m, key, value)        \
+  ((__typeof__((m)->ref))__truk_concurrent_map_get_or_insert_copy_(            \
+      &(m)->base, key, (__typeof__((m)->tmp)[1]){(value)},                     \
+      (__typeof__((m)->tmp)[1]){0}))
+
+#define __truk_concurrent_map_get_or_insert_generic(m, key, value)             \
+  __extension__({                                                              \
+    __typeof__((m)->tmp) __truk_cm_val = (value);                              \
+    (__typeof__((m)->ref))__truk_concurrent_map_get_or_insert_(                \
+        &(m)->base, key, &__truk_cm_val);                                      \
+  })
+
+#define __truk_concurrent_map_compute_if_absent(m, key, fn, ctx)               \
+  ((__typeof__((m)->ref))__truk_concurrent_map_compute_if_absent_(             \
+      &(m)->base, key, fn, ctx))
+
+#define __truk_concurrent_map_remove_generic(m, key)                           \
+  __truk_concurrent_map_remove_(&(m)->base, key)
+
+#define __truk_concurrent_map_reserve(m, count)                                \
+  __truk_concurrent_map_reserve_(&(m)->base, count)
+
+#define __truk_concurrent_map_shrink(m)                                        \
+  __truk_concurrent_map_shrink_(&(m)->base)
+
+#define __truk_concurrent_map_count(m) __truk_concurrent_map_count_(&(m)->base)
+
+#define __truk_concurrent_map_iter(m) __truk_concurrent_map_iter_()
+
+#define __truk_concurrent_map_next_generic(m, iter)                            \
+  __truk_concurrent_map_next_(&(m)->base, iter)
+
+#define __truk_concurrent_map_next_kv_generic(m, iter, value)                  \
+  __truk_concurrent_map_next_kv_(&(m)->base, iter, value)
+
+#define __truk_concurrent_map_iter_end(m, iter)                                \
+  __truk_concurrent_map_iter_end_(&(m)->base, iter)
+
+/* Allocates the shards and their initial tables; returns -1 if that fails,
+ * leaving a map that every other call treats as empty. */
+int __truk_concurrent_map_init_(__truk_concurrent_map_base_t *m, int ksize,
+                                int vsize, __truk_map_hash_fn hash_fn,
+                                __truk_map_cmp_fn cmp_fn);
+void __truk_concurrent_map_deinit_(__truk_concurrent_map_base_t *m);
+void *__truk_concurrent_map_get_(__truk_concurrent_map_base_t *m,
+                                 const void *key);
+/* Copies the value under key into out while holding the shard lock.
+ * Returns out, or NULL if the key is absent. */
+void *__truk_concurrent_map_get_copy_(__truk_concurrent_map_base_t *m,
+                                      const void *key, void *out);
+int __truk_concurrent_map_set_(__truk_concurrent_map_base_t *m,
+                               const void *key, void *value, int vsize);
+void __truk_concurrent_map_remove_(__truk_concurrent_map_base_t *m,
+                                   const void *key);
+
+/* Both return the value stored under key, inserting one first if the key is
+ * absent, all under the shard lock. get_or_insert copies in value;
+ * compute_if_absent zeroes the new value and lets fn fill it. NULL means the
+ * allocation failed or fn declined. */
+void *__truk_concurrent_map_get_or_insert_(__truk_concurrent_map_base_t *m,
+                                           const void *key, const void *value);
+void *__truk_concurrent_map_compute_if_absent_(
+    __truk_concurrent_map_base_t *m, const void *key,
+    __truk_concurrent_map_init_fn fn, void *ctx);
+/* get_or_insert that copies the stored value into out before the shard lock
+ * is released. Returns out, or NULL if the insert failed. */
+void *__truk_concurrent_map_get_or_insert_copy_(
+    __truk_concurrent_map_base_t *m, const void *key, const void *value,
+    void *out);
+
+/* reserve spreads count evenly over the shards, with some slack for uneven
+ * hashing; shrink shrinks every shard. Same return values as the flat map.
+ * count takes each shard's lock in turn, so it is only a snapshot while
+ * other threads are writing. */
+int __truk_concurrent_map_reserve_(__truk_concurrent_map_base_t *m,
+                                   unsigned long long count);
+int __truk_concurrent_map_shrink_(__truk_concurrent_map_base_t *m);
+unsigned long long
+__truk_concurrent_map_count_(__truk_concurrent_map_base_t *m);
+
+__truk_concurrent_map_iter_t __truk_concurrent_map_iter_(void);
+void *__truk_concurrent_map_next_(__truk_concurrent_map_base_t *m,
+                                  __truk_concurrent_map_iter_t *iter);
+void *__truk_concurrent_map_next_kv_(__truk_concurrent_map_base_t *m,
+                                     __truk_concurrent_map_iter_t *iter,
+                                     void **value);
+void __truk_concurrent_map_iter_end_(__truk_concurrent_map_base_t *m,
+                                     __truk_concurrent_map_iter_t *iter);
+
+#endif
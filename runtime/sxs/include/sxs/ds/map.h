@@ -4,6 +4,7 @@
  * This library is free software; you can redistribute it and/or modify it
  * under the terms of the MIT license. See LICENSE for details.
  * - Modified for TRUK by bosley 2025
+ * - Rewritten as a flat open-addressing table
  */
 
 #ifndef __TRUK_MAP_H
@@ -11,25 +12,46 @@
 
 #include <string.h>
 
-#define __TRUK_MAP_VERSION "0.2.0"
+#define __TRUK_MAP_VERSION "0.3.0"
 
-struct __truk_map_node_t;
-typedef struct __truk_map_node_t __truk_map_node_t;
+/*
+ * Flat open-addressing map in the SwissTable layout. Keys and values live
+ * inline in one slot array; a parallel array of control bytes holds 7 bits
+ * of each occupied slot's hash so a probe can test a whole group of slots
+ * with a few instructions before comparing any keys.
+ *
+ * Pointers returned by get and next stay valid until the next insertion of
+ * a new key or until the map is deinitialized. Maps with incremental resizing
+ * also move entries on removal, which invalidates pointers the same way.
+ *
+ * The table is allocated from the runtime's current allocator at the first
+ * insertion, and that allocator is kept for every later resize and free.
+ */
+
+struct __truk_allocator_s;
 
 typedef unsigned (*__truk_map_hash_fn)(const void *key, int ksize);
 typedef int (*__truk_map_cmp_fn)(const void *a, const void *b, int ksize);
 
 typedef struct {
-  __truk_map_node_t **buckets;
+  void *buckets;
+  signed char *ctrl;
   unsigned nbuckets, nnodes;
-  int ksize;
+  unsigned growth_left;
+  int ksize, vsize;
+  int voffset, slotsize;
   __truk_map_hash_fn hash_fn;
   __truk_map_cmp_fn cmp_fn;
+  struct __truk_allocator_s *allocator;
+  void *old_buckets;
+  signed char *old_ctrl;
+  unsigned old_nbuckets, old_nnodes;
+  unsigned migrate_pos;
+  int incremental;
 } __truk_map_base_t;
 
 typedef struct {
   unsigned bucketidx;
-  __truk_map_node_t *node;
 } __truk_map_iter_t;
 
 #define __truk_map_t(T)                                                        \
@@ -43,10 +65,16 @@ typedef struct {
   do {                                                                         \
     memset(m, 0, sizeof(*(m)));                                                \
     (m)->base.ksize = (keysize);                                               \
+    (m)->base.vsize = (int)sizeof((m)->tmp);                                   \
     (m)->base.hash_fn = (hashfn);                                              \
     (m)->base.cmp_fn = (cmpfn);                                                \
   } while (0)
 
+/* Opt in to incremental resizing: growth spreads the rehash over the
+ * following inserts and removes instead of doing it in one call. Set it
+ * right after init. */
+#define __truk_map_set_incremental(m, on) ((m)->base.incremental = (on))
+
 #define __truk_map_deinit(m) __truk_map_deinit_(&(m)->base)
 
 #define __truk_map_get_generic(m, key)                                         \
@@ -58,18 +86,39 @@ typedef struct {
 
 #define __truk_map_remove_generic(m, key) __truk_map_remove_(&(m)->base, key)
 
+#define __truk_map_reserve(m, count) __truk_map_reserve_(&(m)->base, count)
+
+#define __truk_map_shrink(m) __truk_map_shrink_(&(m)->base)
+
 #define __truk_map_iter(m) __truk_map_iter_()
 
 #define __truk_map_next_generic(m, iter) __truk_map_next_(&(m)->base, iter)
 
+#define __truk_map_next_kv_generic(m, iter, value)                             \
+  __truk_map_next_kv_(&(m)->base, iter, value)
+
 void __truk_map_deinit_(__truk_map_base_t *m);
 void *__truk_map_get_(__truk_map_base_t *m, const void *key);
 int __truk_map_set_(__truk_map_base_t *m, const void *key, void *value,
                     int vsize);
 void __truk_map_remove_(__truk_map_base_t *m, const void *key);
+
+/*
+ * reserve sizes the table so that count entries fit without another resize.
+ * shrink rehashes into the smallest table that holds the current entries,
+ * dropping tombstones, and frees the table when the map is empty. Both
+ * return 0 on success and -1 if the allocation fails.
+ */
+int __truk_map_reserve_(__truk_map_base_t *m, unsigned long long count);
+int __truk_map_shrink_(__truk_map_base_t *m);
 __truk_map_iter_t __truk_map_iter_(void);
 void *__truk_map_next_(__truk_map_base_t *m, __truk_map_iter_t *iter);
 
+/* Returns the next key like next and stores its value pointer in *value, so
+ * a full scan needs no lookup per entry. Both are NULL at the end. */
+void *__truk_map_next_kv_(__truk_map_base_t *m, __truk_map_iter_t *iter,
+                          void **value);
+
 unsigned __truk_map_hash_str(const void *key, int ksize);
 unsigned __truk_map_hash_i8(const void *key, int ksize);
 unsigned __truk_map_hash_i16(const void *key, int ksize);
@@ -86,6 +135,50 @@ unsigned __truk_map_hash_bool(const void *key, int ksize);
 int __truk_map_cmp_str(const void *a, const void *b, int ksize);
 int __truk_map_cmp_mem(const void *a, const void *b, int ksize);
 
+/*
+ * Seeded mixing hashes (wyhash-style folded multiply). The integer variants
+ * hash the key's bits by width, so signed, unsigned and float keys of the
+ * same size share one function. The identity-style __truk_map_hash_* family
+ * above is kept for existing callers.
+ *
+ * The seed is fixed unless TRUK_MAP_SEED is set when the first map entry is
+ * inserted: "random" picks a per-process seed, anything else is parsed as a
+ * number. __truk_map_seed_init is idempotent, safe to call from any thread,
+ * and is called by the maps.
+ */
+extern unsigned long long __truk_map_seed;
+
+void __truk_map_seed_init(void);
+unsigned long long __truk_map_hash_bytes(const void *data, unsigned long len,
+                                         unsigned long long seed);
+
+unsigned __truk_map_mixhash_8(const void *key, int ksize);
+unsigned __truk_map_mixhash_16(const void *key, int ksize);
+unsigned __truk_map_mixhash_32(const void *key, int ksize);
+unsigned __truk_map_mixhash_64(const void *key, int ksize);
+unsigned __truk_map_mixhash_str(const void *key, int ksize);
+
+/*
+ * Length-aware string keys. The key is stored as (pointer, length), so
+ * hashing and comparison never scan for a terminator and mismatched lengths
+ * are rejected before any bytes are compared. As with *u8 keys, the bytes
+ * are not copied and must outlive the entry.
+ */
+typedef struct {
+  const void *data;
+  unsigned long long len;
+} __truk_map_strkey_t;
+
+static inline __truk_map_strkey_t __truk_map_strkey_cstr(const void *str) {
+  __truk_map_strkey_t key;
+  key.data = str;
+  key.len = str ? strlen((const char *)str) : 0;
+  return key;
+}
+
+unsigned __truk_map_hash_strkey(const void *key, int ksize);
+int __truk_map_cmp_strkey(const void *a, const void *b, int ksize);
+
 typedef __truk_map_t(void *) __truk_map_void_t;
 typedef __truk_map_t(char *) __truk_map_str_t;
 typedef __truk_map_t(int) __truk_map_int_t;
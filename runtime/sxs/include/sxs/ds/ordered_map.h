@@ -0,0 +1,98 @@
+#ifndef __TRUK_ORDERED_MAP_H
+#define __TRUK_ORDERED_MAP_H
+
+#include <string.h>
+#include <sxs/ds/map.h>
+
+/*
+ * Insertion-ordered map in the compact dict layout. Entries (hash, key and
+ * value) are appended to one dense array; a separate sparse index of 32-bit
+ * entry numbers is probed to find them. Iteration is a linear scan of the
+ * dense array, so it touches only live data and always yields keys in the
+ * order they were first inserted. Uses the hash and compare functions
+ * declared in map.h.
+ *
+ * Removing a key leaves a hole in the dense array that iteration skips;
+ * holes are squeezed out the next time the array is rebuilt. Pointers
+ * returned by get and next stay valid until the next insertion of a new key
+ * or until the map is deinitialized.
+ */
+
+struct __truk_allocator_s;
+
+typedef struct {
+  unsigned char *entries;
+  unsigned *index;
+  unsigned nslots, nnodes;
+  unsigned nused, capacity;
+  int ksize, vsize;
+  int voffset, entsize;
+  __truk_map_hash_fn hash_fn;
+  __truk_map_cmp_fn cmp_fn;
+  struct __truk_allocator_s *allocator;
+} __truk_ordered_map_base_t;
+
+typedef struct {
+  unsigned entryidx;
+} __truk_ordered_map_iter_t;
+
+#define __truk_ordered_map_t(T)                                                \
+  struct {                                                                     \
+    __truk_ordered_map_base_t base;                                            \
+    T *ref;                                                                    \
+    T tmp;                                                                     \
+  }
+
+#define __truk_ordered_map_init_generic(m, keysize, hashfn, cmpfn)             \
+  do {                                                                         \
+    memset(m, 0, sizeof(*(m)));                                                \
+    (m)->base.ksize = (keysize);                                               \
+    (m)->base.vsize = (int)sizeof((m)->tmp);                                   \
+    (m)->base.hash_fn = (hashfn);                                              \
+    (m)->base.cmp_fn = (cmpfn);                                                \
+  } while (0)
+
+#define __truk_ordered_map_deinit(m) __truk_ordered_map_deinit_(&(m)->base)
+
+#define __truk_ordered_map_get_generic(m, key)                                 \
+  ((m)->ref = __truk_ordered_map_get_(&(m)->base, key))
+
+#define __truk_ordered_map_set_generic(m, key, value)                          \
+  ((m)->tmp = (value),                                                         \
+   __truk_ordered_map_set_(&(m)->base, key, &(m)->tmp, sizeof((m)->tmp)))
+
+#define __truk_ordered_map_remove_generic(m, key)                              \
+  __truk_ordered_map_remove_(&(m)->base, key)
+
+#define __truk_ordered_map_reserve(m, count)                                   \
+  __truk_ordered_map_reserve_(&(m)->base, count)
+
+#define __truk_ordered_map_shrink(m) __truk_ordered_map_shrink_(&(m)->base)
+
+#define __truk_ordered_map_iter(m) __truk_ordered_map_iter_()
+
+#define __truk_ordered_map_next_generic(m, iter)                               \
+  __truk_ordered_map_next_(&(m)->base, iter)
+
+#define __truk_ordered_map_next_kv_generic(m, iter, value)                     \
+  __truk_ordered_map_next_kv_(&(m)->base, iter, value)
+
+void __truk_ordered_map_deinit_(__truk_ordered_map_base_t *m);
+void *__truk_ordered_map_get_(__truk_ordered_map_base_t *m, const void *key);
+int __truk_ordered_map_set_(__truk_ordered_map_base_t *m, const void *key,
+                            void *value, int vsize);
+void __truk_ordered_map_remove_(__truk_ordered_map_base_t *m, const void *key);
+
+/* Same contracts as __truk_map_reserve_ and __truk_map_shrink_. shrink also
+ * squeezes out holes left by removed keys. */
+int __truk_ordered_map_reserve_(__truk_ordered_map_base_t *m,
+                                unsigned long long count);
+int __truk_ordered_map_shrink_(__truk_ordered_map_base_t *m);
+__truk_ordered_map_iter_t __truk_ordered_map_iter_(void);
+void *__truk_ordered_map_next_(__truk_ordered_map_base_t *m,
+                               __truk_ordered_map_iter_t *iter);
+void *__truk_ordered_map_next_kv_(__truk_ordered_map_base_t *m,
+                                  __truk_ordered_map_iter_t *iter,
+                                  void **value);
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef __TRUK_SCANNER_H
+#define __TRUK_SCANNER_H
+
+#include <sxs/types.h>
+
+/*
+ * Allocation-free byte scanners from docs/group-scanner.md and
+ * docs/static-type-machine.md. Results are indices into the caller's buffer;
+ * nothing is copied.
+ *
+ * Each scanner is a resumable state machine fed one chunk at a time, so input
+ * read from a socket or file in pieces can be scanned without buffering it
+ * whole. The buffer functions (__truk_scanner_find_group and
+ * __truk_scanner_read_static) run the same machines over a single chunk.
+ *
+ * Whitespace is space, tab, newline and carriage return.
+ */
+
+#define __TRUK_SCANNER_NO_ESCAPE (-1)
+
+typedef enum {
+  __TRUK_SCANNER_MORE, /* chunk used up; feed the next one */
+  __TRUK_SCANNER_DONE, /* group closed or token complete */
+  __TRUK_SCANNER_FAIL, /* malformed input, see the stream's error offset */
+  __TRUK_SCANNER_END   /* input ended before a token started */
+} __truk_scanner_status_e;
+
+typedef enum {
+  __TRUK_SCANNER_NONE = 0,
+  __TRUK_SCANNER_INTEGER = 1,
+  __TRUK_SCANNER_REAL = 2,
+  __TRUK_SCANNER_SYMBOL = 3
+} __truk_scanner_type_e;
+
+/* Streaming group scan. Offsets are counted from the first byte fed.
+ * escape is a byte or __TRUK_SCANNER_NO_ESCAPE; an escape byte makes the
+ * byte after it ordinary, so "\\)" still closes. It must differ from both
+ * delimiters. When open and close are the same byte the group ends at the
+ * first unescaped close; otherwise nesting is counted. */
+typedef struct {
+  __truk_u8 open, close;
+  __truk_i32 escape;
+  __truk_bool consume_leading_ws;
+  __truk_bool escaped;
+  __truk_u64 depth;
+  __truk_u64 offset;
+  __truk_u64 start, end;
+} __truk_scanner_group_stream_t;
+
+void __truk_scanner_group_begin(__truk_scanner_group_stream_t *stream,
+                                __truk_u8 open, __truk_u8 close,
+                                __truk_i32 escape,
+                                __truk_bool consume_leading_ws);
+
+/* Scans chunk[0, len). *used is set to the bytes consumed: through the
+ * closing delimiter on DONE, len on MORE, and up to the offending byte on
+ * FAIL (a byte other than open where the group must start). On DONE,
+ * start and end hold the offsets of the two delimiters. */
+__truk_scanner_status_e
+__truk_scanner_group_feed(__truk_scanner_group_stream_t *stream,
+                          const __truk_u8 *chunk, __truk_u64 len,
+                          __truk_u64 *used);
+
+/* Streaming static-type scan: INTEGER [+-]?[0-9]+, REAL [+-]?[0-9]+.[0-9]+,
+ * otherwise SYMBOL up to whitespace or a stop symbol. Stop symbols end a
+ * token without being consumed and must not include digits, '.', '+' or
+ * '-'. The stop array is referenced, not copied, and must outlive the
+ * stream.
+ *
+ * After DONE the stream is ready for the next token, so one stream can
+ * tokenize a whole input. */
+typedef struct {
+  __truk_u64 terminator_bits[4];
+  const __truk_u8 *stops;
+  __truk_u64 stop_count;
+  __truk_i32 state;
+  __truk_scanner_type_e type;
+  __truk_u64 offset;
+  __truk_u64 start, length;
+  __truk_u64 error;
+} __truk_scanner_static_stream_t;
+
+void __truk_scanner_static_begin(__truk_scanner_static_stream_t *stream,
+                                 const __truk_u8 *stops,
+                                 __truk_u64 stop_count);
+
+/* Scans chunk[0, len). On DONE the token is [start, start + length) with
+ * type set, and *used stops at its terminator, which is not consumed. On
+ * FAIL, error is the offset of the byte that broke a number, or of a stop
+ * symbol where a token should start, and *used stops there. MORE consumes
+ * the whole chunk; a token may span any number of chunks. */
+__truk_scanner_status_e
+__truk_scanner_static_feed(__truk_scanner_static_stream_t *stream,
+                           const __truk_u8 *chunk, __truk_u64 len,
+                           __truk_u64 *used);
+
+/* Ends the input: completes a pending token (DONE), rejects a number cut
+ * short after its '.' (FAIL), or reports END when no token had started. */
+__truk_scanner_status_e
+__truk_scanner_static_finish(__truk_scanner_static_stream_t *stream);
+
+/* Buffer scanners with the interfaces described in the docs. On failure the
+ * scanner's position is left unchanged. */
+typedef struct {
+  const __truk_u8 *buffer;
+  __truk_u64 count;
+  __truk_u64 position;
+} __truk_scanner_t;
+
+typedef struct {
+  __truk_bool success;
+  __truk_u64 index_of_start_symbol;
+  __truk_u64 index_of_closing_symbol;
+} __truk_scanner_group_t;
+
+typedef struct {
+  __truk_bool success;
+  __truk_scanner_type_e type;
+  const __truk_u8 *data;
+  __truk_u64 byte_length;
+  __truk_u64 start_position;
+  __truk_u64 error_position;
+} __truk_scanner_static_t;
+
+/* The group must open at position, or after leading whitespace when
+ * consume_leading_ws is set. On success position moves to the closing
+ * delimiter. */
+__truk_scanner_group_t
+__truk_scanner_find_group(__truk_scanner_t *scanner, __truk_u8 open,
+                          __truk_u8 close, __truk_i32 escape,
+                          __truk_bool consume_leading_ws);
+
+/* Skips leading whitespace and reads one token. On success position moves
+ * to the byte that ended it. */
+__truk_scanner_static_t
+__truk_scanner_read_static(__truk_scanner_t *scanner,
+                           const __truk_u8 *stops, __truk_u64 stop_count);
+
+/* Entry points for the scan_group and scan_token builtins. scan_group
+ * returns the index of the closing delimiter of the group opening at
+ * data[at], or len. scan_token returns the token type, 0 when no token
+ * starts before the end or a stop symbol, or -1 for a malformed number, and
+ * sets [*start, *end) to the token (or to the bad byte). */
+__truk_u64 __truk_scan_group(const __truk_u8 *data, __truk_u64 len,
+                             __truk_u64 at, __truk_u8 open, __truk_u8 close,
+                             __truk_i32 escape);
+__truk_i32 __truk_scan_token(const __truk_u8 *data, __truk_u64 len,
+                             __truk_u64 at, const __truk_u8 *stops,
+                             __truk_u64 stop_count, __truk_u64 *start,
+                             __truk_u64 *end);
+
+#endif
@@ -8,38 +8,384 @@
 extern "C" {
 #endif
 
-__truk_void __truk_runtime_sxs_panic(const char *msg, __truk_u64 len);
+/*
+ * Runtime checks are a compare and a call that is never expected to happen.
+ * The failure paths live out of line in cold, non-inlined functions so every
+ * check site stays a couple of instructions and the formatting code is not
+ * copied into hot loops. GCC and Clang also treat any branch that ends in a
+ * call to a cold function as unlikely, which covers user `panic` calls.
+ */
+#if defined(__GNUC__) && !defined(__TINYC__)
+#define __TRUK_LIKELY(x) __builtin_expect(!!(x), 1)
+#define __TRUK_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define __TRUK_COLD __attribute__((cold, noinline, noreturn))
+#else
+#define __TRUK_LIKELY(x) (x)
+#define __TRUK_UNLIKELY(x) (x)
+#define __TRUK_COLD
+#endif
+
+__TRUK_COLD __truk_void __truk_runtime_sxs_panic(const char *msg,
+                                                 __truk_u64 len);
+__TRUK_COLD __truk_void __truk_runtime_sxs_bounds_fail(__truk_u64 idx,
+                                                       __truk_u64 len);
+__TRUK_COLD __truk_void __truk_runtime_sxs_range_fail(__truk_u64 lo,
+                                                      __truk_u64 hi,
+                                                      __truk_u64 len);
 
 static inline __truk_void __truk_runtime_sxs_bounds_check(__truk_u64 idx,
                                                           __truk_u64 len) {
-  if (idx >= len) {
-    fprintf(stderr, "panic: index out of bounds: %llu >= %llu\n",
-            (unsigned long long)idx, (unsigned long long)len);
-    exit(1);
+  if (__TRUK_UNLIKELY(idx >= len)) {
+    __truk_runtime_sxs_bounds_fail(idx, len);
+  }
+}
+
+/* Subslice s[lo..hi] needs lo <= hi <= len. */
+static inline __truk_void __truk_runtime_sxs_range_check(__truk_u64 lo,
+                                                         __truk_u64 hi,
+                                                         __truk_u64 len) {
+  if (__TRUK_UNLIKELY(lo > hi || hi > len)) {
+    __truk_runtime_sxs_range_fail(lo, hi, len);
+  }
+}
+
+/*
+ * Allocators. An allocator is a vtable whose first member sits at the start
+ * of the backend's own state, so a backend is passed around as a plain
+ * __truk_allocator_t pointer. make and delete go through the calling thread's
+ * allocator when one is set, then the program's, then malloc and free.
+ * Memory must be released through the allocator that produced it.
+ */
+typedef struct __truk_allocator_s __truk_allocator_t;
+
+struct __truk_allocator_s {
+  __truk_void *(*alloc)(__truk_allocator_t *self, __truk_u64 size);
+  __truk_void (*free)(__truk_allocator_t *self, __truk_void *ptr);
+  __truk_void (*reset)(__truk_allocator_t *self);
+  __truk_void (*destroy)(__truk_allocator_t *self);
+};
+
+#if defined(__TINYC__)
+/* No thread-local storage under TCC; the thread slot is per program. */
+#define __TRUK_THREAD_LOCAL
+#else
+#define __TRUK_THREAD_LOCAL __thread
+#endif
+
+extern __truk_allocator_t *__truk_runtime_sxs_program_allocator;
+extern __TRUK_THREAD_LOCAL __truk_allocator_t
+    *__truk_runtime_sxs_thread_allocator;
+
+__truk_allocator_t *
+__truk_runtime_sxs_set_program_allocator(__truk_allocator_t *allocator);
+__truk_allocator_t *
+__truk_runtime_sxs_set_thread_allocator(__truk_allocator_t *allocator);
+
+static inline __truk_allocator_t *__truk_runtime_sxs_current_allocator(void) {
+  return __truk_runtime_sxs_thread_allocator
+             ? __truk_runtime_sxs_thread_allocator
+             : __truk_runtime_sxs_program_allocator;
+}
+
+/*
+ * Allocation tracking, compiled in when TRUK_TRACK_ALLOCS is defined
+ * (truk --track-allocs). Each make passes a static __truk_alloc_site_t naming
+ * its source line; the runtime keeps allocation and live-byte counters per
+ * site and prints them at exit and on SIGUSR1. Memory the runtime allocates
+ * for itself, such as vec storage, is counted under one "<runtime>" site.
+ * Allocators with a reset hook (arena, pool, slab) release memory in bulk, so
+ * their allocations are not tracked.
+ *
+ * With TRUK_TRACK_ALLOCS_SAMPLE set to a byte period, about one allocation
+ * per period bytes is recorded and its counts are scaled up to estimate the
+ * rest. Allocation then costs a thread-local subtraction and free a load
+ * from a counting filter of recorded pointers.
+ */
+#if defined(TRUK_TRACK_ALLOCS)
+typedef struct __truk_alloc_site_s {
+  const char *file;
+  __truk_u64 line;
+  __truk_u64 allocs;
+  __truk_u64 bytes;
+  __truk_u64 live_allocs;
+  __truk_u64 live_bytes;
+  __truk_u32 registered;
+  struct __truk_alloc_site_s *next;
+} __truk_alloc_site_t;
+
+#define __TRUK_ALLOC_SITE(f, l)                                                \
+  ({                                                                           \
+    static __truk_alloc_site_t __truk_site = {(f), (l), 0, 0, 0, 0, 0, NULL};  \
+    &__truk_site;                                                              \
+  })
+
+/* Allocates and records size bytes for site (NULL for the runtime site). */
+__truk_void *__truk_runtime_sxs_track_alloc(__truk_allocator_t *allocator,
+                                            __truk_u64 size,
+                                            __truk_alloc_site_t *site);
+__truk_void __truk_runtime_sxs_track_free(__truk_void *ptr);
+/* Writes live bytes per site, largest first, to fd; safe in a signal
+ * handler. */
+__truk_void __truk_runtime_sxs_track_report(int fd);
+/* Prints the report at exit and installs the SIGUSR1 handler unless the
+ * program has one. Called by __truk_runtime_sxs_start. */
+__truk_void __truk_runtime_sxs_track_start(void);
+
+#if defined(TRUK_TRACK_ALLOCS_SAMPLE)
+#define __TRUK_TRACK_FILTER_BITS 16
+
+extern __TRUK_THREAD_LOCAL __truk_i64 __truk_runtime_sxs_track_countdown;
+extern __truk_u16 __truk_runtime_sxs_track_filter[1 << __TRUK_TRACK_FILTER_BITS];
+
+static inline __truk_u64 __truk_runtime_sxs_track_slot(const __truk_void *ptr) {
+  return (((__truk_u64)(uintptr_t)ptr >> 4) * 0x9e3779b97f4a7c15ULL) >>
+         (64 - __TRUK_TRACK_FILTER_BITS);
+}
+#endif
+
+static inline __truk_void *
+__truk_runtime_sxs_alloc_at(__truk_allocator_t *allocator, __truk_u64 size,
+                            __truk_alloc_site_t *site) {
+#if defined(TRUK_TRACK_ALLOCS_SAMPLE)
+  if (__TRUK_LIKELY((__truk_runtime_sxs_track_countdown -= (__truk_i64)size) >
+                    0)) {
+    return allocator ? allocator->alloc(allocator, size) : malloc(size);
+  }
+#endif
+  return __truk_runtime_sxs_track_alloc(allocator, size, site);
+}
+
+static inline __truk_void __truk_runtime_sxs_track_forget(__truk_void *ptr) {
+#if defined(TRUK_TRACK_ALLOCS_SAMPLE)
+  if (__TRUK_LIKELY(!__truk_runtime_sxs_track_filter
+                        [__truk_runtime_sxs_track_slot(ptr)])) {
+    return;
+  }
+#endif
+  __truk_runtime_sxs_track_free(ptr);
+}
+#endif
+
+static inline __truk_void *
+__truk_runtime_sxs_alloc_with(__truk_allocator_t *allocator, __truk_u64 size) {
+#if defined(TRUK_TRACK_ALLOCS)
+  return __truk_runtime_sxs_alloc_at(allocator, size, NULL);
+#else
+  return allocator ? allocator->alloc(allocator, size) : malloc(size);
+#endif
+}
+
+static inline __truk_void
+__truk_runtime_sxs_free_with(__truk_allocator_t *allocator, __truk_void *ptr) {
+  if (!ptr) {
+    return;
+  }
+#if defined(TRUK_TRACK_ALLOCS)
+  __truk_runtime_sxs_track_forget(ptr);
+#endif
+  if (allocator) {
+    allocator->free(allocator, ptr);
+  } else {
+    free(ptr);
+  }
+}
+
+static inline __truk_void *
+__truk_runtime_sxs_alloc_array_with(__truk_allocator_t *allocator,
+                                    __truk_u64 elem_size, __truk_u64 count) {
+  return __truk_runtime_sxs_alloc_with(allocator, elem_size * count);
+}
+
+static inline __truk_void
+__truk_runtime_sxs_allocator_reset(__truk_allocator_t *allocator) {
+  if (allocator && allocator->reset) {
+    allocator->reset(allocator);
+  }
+}
+
+static inline __truk_void
+__truk_runtime_sxs_allocator_destroy(__truk_allocator_t *allocator) {
+  if (allocator && allocator->destroy) {
+    allocator->destroy(allocator);
   }
 }
 
 static inline __truk_void *__truk_runtime_sxs_alloc(__truk_u64 size) {
-  return malloc(size);
+  return __truk_runtime_sxs_alloc_with(__truk_runtime_sxs_current_allocator(),
+                                       size);
 }
 
 static inline __truk_void __truk_runtime_sxs_free(__truk_void *ptr) {
-  free(ptr);
+  __truk_runtime_sxs_free_with(__truk_runtime_sxs_current_allocator(), ptr);
 }
 
 static inline __truk_void *__truk_runtime_sxs_alloc_array(__truk_u64 elem_size,
                                                           __truk_u64 count) {
-  return malloc(elem_size * count);
+  return __truk_runtime_sxs_alloc_array_with(
+      __truk_runtime_sxs_current_allocator(), elem_size, count);
 }
 
 static inline __truk_void __truk_runtime_sxs_free_array(__truk_void *ptr) {
-  free(ptr);
+  __truk_runtime_sxs_free(ptr);
+}
+
+/*
+ * Single objects. make(@T) and delete of a *T go through a per-thread cache
+ * of freed objects when no allocator is set, so short-lived small objects are
+ * recycled without entering malloc. Sizes up to 256 bytes fall into sixteen
+ * 16-byte classes; every cached object is a malloc block of its full class
+ * size, so anything the cache hands out may still be released with free.
+ * delete passes the size of its pointee, and a class holds at most 32 KiB
+ * before half of it is returned to malloc. A thread's cache is emptied when
+ * the thread exits. TCC has no thread-local storage, so there the cache is
+ * found through a pthread key instead.
+ *
+ * delete also sees pointers make never returned, e.g. from a cimported
+ * malloc, so a block is only cached when malloc reports it can hold the full
+ * class; anything smaller goes straight back to free. Where the usable size
+ * cannot be asked for, the cache is compiled out.
+ */
+#if defined(__linux__)
+#  include <malloc.h>
+#define __TRUK_OBJECT_USABLE_SIZE(ptr) malloc_usable_size(ptr)
+#elif defined(__APPLE__)
+#  include <malloc/malloc.h>
+#define __TRUK_OBJECT_USABLE_SIZE(ptr) malloc_size(ptr)
+#endif
+
+#define __TRUK_OBJECT_CLASSES 16
+#define __TRUK_OBJECT_MAX_SIZE (__TRUK_OBJECT_CLASSES * 16)
+#define __TRUK_OBJECT_CACHE_UNITS 2048
+
+typedef struct {
+  __truk_void *head[__TRUK_OBJECT_CLASSES];
+  __truk_u32 count[__TRUK_OBJECT_CLASSES];
+  __truk_u32 registered;
+} __truk_object_cache_t;
+
+#if defined(__TINYC__)
+__truk_object_cache_t *__truk_runtime_sxs_object_cache_get(void);
+#define __TRUK_OBJECT_CACHE() __truk_runtime_sxs_object_cache_get()
+#else
+extern __thread __truk_object_cache_t __truk_runtime_sxs_object_cache;
+#define __TRUK_OBJECT_CACHE() (&__truk_runtime_sxs_object_cache)
+#endif
+
+/* Registers the cache for thread exit and spills a full class, then caches
+ * ptr. */
+__truk_void __truk_runtime_sxs_object_release(__truk_object_cache_t *cache,
+                                              __truk_void *ptr,
+                                              __truk_u64 cls);
+
+static inline __truk_u64 __truk_runtime_sxs_object_class(__truk_u64 size) {
+  return size ? (size - 1) >> 4 : 0;
+}
+
+static inline __truk_void *__truk_runtime_sxs_alloc_object(__truk_u64 size) {
+#if defined(TRUK_TRACK_ALLOCS) || !defined(__TRUK_OBJECT_USABLE_SIZE)
+  return __truk_runtime_sxs_alloc(size);
+#else
+  __truk_allocator_t *allocator = __truk_runtime_sxs_current_allocator();
+  __truk_object_cache_t *cache;
+  __truk_void *ptr;
+  __truk_u64 cls;
+  if (allocator || size > __TRUK_OBJECT_MAX_SIZE) {
+    return __truk_runtime_sxs_alloc_with(allocator, size);
+  }
+  cls = __truk_runtime_sxs_object_class(size);
+  cache = __TRUK_OBJECT_CACHE();
+  ptr = cache->head[cls];
+  if (__TRUK_UNLIKELY(!ptr)) {
+    return malloc((cls + 1) << 4);
+  }
+  cache->head[cls] = *(__truk_void **)ptr;
+  cache->count[cls]--;
+  return ptr;
+#endif
+}
+
+static inline __truk_void __truk_runtime_sxs_free_object(__truk_void *ptr,
+                                                         __truk_u64 size) {
+#if defined(TRUK_TRACK_ALLOCS) || !defined(__TRUK_OBJECT_USABLE_SIZE)
+  (void)size;
+  __truk_runtime_sxs_free(ptr);
+#else
+  __truk_allocator_t *allocator = __truk_runtime_sxs_current_allocator();
+  __truk_object_cache_t *cache;
+  __truk_u64 cls;
+  if (!ptr) {
+    return;
+  }
+  cls = __truk_runtime_sxs_object_class(size);
+  if (allocator || size > __TRUK_OBJECT_MAX_SIZE ||
+      __TRUK_OBJECT_USABLE_SIZE(ptr) < ((cls + 1) << 4)) {
+    __truk_runtime_sxs_free_with(allocator, ptr);
+    return;
+  }
+  cache = __TRUK_OBJECT_CACHE();
+  if (__TRUK_UNLIKELY(!cache->registered ||
+                      (cache->count[cls] + 1) * (cls + 1) >
+                          __TRUK_OBJECT_CACHE_UNITS)) {
+    __truk_runtime_sxs_object_release(cache, ptr, cls);
+    return;
+  }
+  *(__truk_void **)ptr = cache->head[cls];
+  cache->head[cls] = ptr;
+  cache->count[cls]++;
+#endif
 }
 
 static inline __truk_u64 __truk_runtime_sxs_sizeof_type(__truk_u64 size) {
   return size;
 }
 
+/*
+ * Growable arrays. A vec[T] is a struct { T *data; u64 len; u64 cap; }, so it
+ * reads like the slice of T. The macros take the vec as an lvalue and
+ * evaluate it once; storage comes from the current allocator and must be
+ * grown and deleted under the same one, like any slice. push doubles the
+ * capacity when it is full, so n pushes copy O(n) elements in total.
+ */
+#define __TRUK_VEC_MIN_CAP 8
+
+__truk_void *__truk_runtime_sxs_vec_resize(__truk_void *data, __truk_u64 len,
+                                           __truk_u64 elem_size,
+                                           __truk_u64 cap);
+
+#define __truk_vec_reserve(v, n)                                               \
+  ({                                                                           \
+    __typeof__(v) *__truk_v = &(v);                                            \
+    __truk_u64 __truk_n = (n);                                                 \
+    if (__truk_n > __truk_v->cap) {                                            \
+      __truk_v->data = __truk_runtime_sxs_vec_resize(                          \
+          __truk_v->data, __truk_v->len, sizeof(*__truk_v->data), __truk_n);   \
+      __truk_v->cap = __truk_n;                                                \
+    }                                                                          \
+  })
+
+#define __truk_vec_push(v, x)                                                  \
+  ({                                                                           \
+    __typeof__(v) *__truk_v = &(v);                                            \
+    __typeof__(*__truk_v->data) __truk_x = (x);                                \
+    if (__TRUK_UNLIKELY(__truk_v->len == __truk_v->cap)) {                     \
+      __truk_u64 __truk_cap =                                                  \
+          __truk_v->cap ? __truk_v->cap * 2 : __TRUK_VEC_MIN_CAP;              \
+      __truk_v->data = __truk_runtime_sxs_vec_resize(                          \
+          __truk_v->data, __truk_v->len, sizeof(*__truk_v->data), __truk_cap); \
+      __truk_v->cap = __truk_cap;                                              \
+    }                                                                          \
+    __truk_v->data[__truk_v->len++] = __truk_x;                                \
+  })
+
+#define __truk_vec_pop(v)                                                      \
+  ({                                                                           \
+    __typeof__(v) *__truk_v = &(v);                                            \
+    if (__TRUK_UNLIKELY(__truk_v->len == 0)) {                                 \
+      __truk_runtime_sxs_panic("pop from empty vec", 18);                      \
+    }                                                                          \
+    __truk_v->data[--__truk_v->len];                                           \
+  })
+
 typedef __truk_i32 (*__truk_runtime_sxs_entry_fn_no_args)(__truk_void);
 typedef __truk_i32 (*__truk_runtime_sxs_entry_fn_with_args)(__truk_i32 argc,
                                                             __truk_i8 **argv);
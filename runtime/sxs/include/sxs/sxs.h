@@ -1,5 +1,7 @@
 #pragma once
 
+#include "alloc.h"
+#include "bytes.h"
 #include "runtime.h"
 #include "test.h"
 #include "types.h"
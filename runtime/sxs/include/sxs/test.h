@@ -15,6 +15,11 @@ typedef struct {
   __truk_bool has_failed;
   __truk_i32 argc;
   char **argv;
+  /* Set by __truk_test_begin and __truk_test_end. */
+  __truk_u64 started_ns;
+  __truk_u64 started_cpu_ns;
+  __truk_u64 wall_ns;
+  __truk_u64 cpu_ns;
 } __truk_test_context_s;
 
 __truk_void __truk_test_fail(__truk_test_context_s *t, const char *msg);
@@ -67,6 +72,46 @@ __truk_void __truk_test_assert_bytes_eq(__truk_test_context_s *t,
 __truk_i32 __truk_test_get_argc(__truk_test_context_s *t);
 char **__truk_test_get_argv(__truk_test_context_s *t);
 
+/* Bracket a test, setup and teardown included, to measure its wall time and
+ * the CPU time of the whole process while it ran. */
+__truk_void __truk_test_begin(__truk_test_context_s *t);
+__truk_void __truk_test_end(__truk_test_context_s *t);
+
+/* Appends a line for a finished test to the file named by $TRUK_TEST_REPORT,
+ * if it is set, for `truk test` to build its reports from:
+ *
+ *   status \t name \t passed \t failed \t wall_ns \t cpu_ns
+ *
+ * status is passed, failed, crashed or timeout. */
+__truk_void __truk_test_record(const __truk_test_context_s *t,
+                               const char *status);
+
+typedef __truk_void (*__truk_test_fn_t)(__truk_test_context_s *t);
+
+typedef struct {
+  const char *name;
+  __truk_test_fn_t fn;
+} __truk_test_case_s;
+
+/* How __truk_test_run_isolated runs a file's tests. setup and teardown may be
+ * NULL; jobs of 0 means one per available core and timeout_ms of 0 means no
+ * limit. */
+typedef struct {
+  __truk_test_fn_t setup;
+  __truk_test_fn_t teardown;
+  __truk_i32 jobs;
+  __truk_u64 timeout_ms;
+} __truk_test_runner_s;
+
+/* Runs every test in its own forked process, at most runner->jobs at a time,
+ * killing any that runs past runner->timeout_ms. Each test's output is
+ * printed in order once it finishes, followed by its result and wall time.
+ * Returns the number of tests that failed, crashed or timed out. */
+__truk_i32 __truk_test_run_isolated(const __truk_test_case_s *tests,
+                                   __truk_i32 count,
+                                   const __truk_test_runner_s *runner,
+                                   __truk_i32 argc, char **argv);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,354 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sxs/alloc.h>
+#include <sxs/runtime.h>
+
+#define __TRUK_ALLOC_ALIGN 16
+#define __TRUK_ALLOC_ROUND(n)                                                  \
+  (((__truk_u64)(n) + (__TRUK_ALLOC_ALIGN - 1)) &                              \
+   ~(__truk_u64)(__TRUK_ALLOC_ALIGN - 1))
+
+/* Blocks are malloc'd with their header in front; the header is padded so
+ * the payload keeps malloc's 16-byte alignment. */
+typedef struct __truk_alloc_block_s {
+  struct __truk_alloc_block_s *next;
+  __truk_u64 size, used;
+} __truk_alloc_block_t;
+
+#define __TRUK_ALLOC_BLOCK_HEADER                                              \
+  __TRUK_ALLOC_ROUND(sizeof(__truk_alloc_block_t))
+
+static __truk_alloc_block_t *__truk_alloc_block_new(__truk_u64 size) {
+  __truk_alloc_block_t *block = malloc(__TRUK_ALLOC_BLOCK_HEADER + size);
+  if (!block) {
+    return NULL;
+  }
+  block->next = NULL;
+  block->size = size;
+  block->used = 0;
+  return block;
+}
+
+static unsigned char *__truk_alloc_block_data(__truk_alloc_block_t *block) {
+  return (unsigned char *)block + __TRUK_ALLOC_BLOCK_HEADER;
+}
+
+static void __truk_alloc_block_free_list(__truk_alloc_block_t *block) {
+  while (block) {
+    __truk_alloc_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
+}
+
+/* Arena */
+
+typedef struct {
+  __truk_allocator_t base;
+  __truk_alloc_block_t *head;
+  __truk_u64 block_size;
+} __truk_alloc_arena_t;
+
+static __truk_void *__truk_alloc_arena_alloc(__truk_allocator_t *self,
+                                             __truk_u64 size) {
+  __truk_alloc_arena_t *a = (__truk_alloc_arena_t *)self;
+  __truk_alloc_block_t *block = a->head;
+  unsigned char *ptr;
+  size = size ? __TRUK_ALLOC_ROUND(size) : __TRUK_ALLOC_ALIGN;
+  if (size > a->block_size) {
+    /* Oversized requests get their own block behind the current one so the
+     * space left in the current block is not abandoned. */
+    block = __truk_alloc_block_new(size);
+    if (!block) {
+      return NULL;
+    }
+    block->used = size;
+    if (a->head) {
+      block->next = a->head->next;
+      a->head->next = block;
+    } else {
+      a->head = block;
+    }
+    return __truk_alloc_block_data(block);
+  }
+  if (!block || block->size - block->used < size) {
+    block = __truk_alloc_block_new(a->block_size);
+    if (!block) {
+      return NULL;
+    }
+    block->next = a->head;
+    a->head = block;
+  }
+  ptr = __truk_alloc_block_data(block) + block->used;
+  block->used += size;
+  return ptr;
+}
+
+static __truk_void __truk_alloc_arena_free(__truk_allocator_t *self,
+                                           __truk_void *ptr) {
+  (void)self;
+  (void)ptr;
+}
+
+static __truk_void __truk_alloc_arena_reset(__truk_allocator_t *self) {
+  __truk_alloc_arena_t *a = (__truk_alloc_arena_t *)self;
+  if (!a->head) {
+    return;
+  }
+  /* Keep one regular block so a reset/refill cycle does not hit malloc. */
+  if (a->head->size == a->block_size) {
+    __truk_alloc_block_free_list(a->head->next);
+    a->head->next = NULL;
+    a->head->used = 0;
+  } else {
+    __truk_alloc_block_free_list(a->head);
+    a->head = NULL;
+  }
+}
+
+static __truk_void __truk_alloc_arena_destroy(__truk_allocator_t *self) {
+  __truk_alloc_arena_t *a = (__truk_alloc_arena_t *)self;
+  __truk_alloc_block_free_list(a->head);
+  free(a);
+}
+
+__truk_allocator_t *__truk_alloc_arena_new(__truk_u64 block_size) {
+  __truk_alloc_arena_t *a = malloc(sizeof(*a));
+  if (!a) {
+    return NULL;
+  }
+  a->base.alloc = __truk_alloc_arena_alloc;
+  a->base.free = __truk_alloc_arena_free;
+  a->base.reset = __truk_alloc_arena_reset;
+  a->base.destroy = __truk_alloc_arena_destroy;
+  a->head = NULL;
+  a->block_size = __TRUK_ALLOC_ROUND(block_size ? block_size : 4096);
+  return &a->base;
+}
+
+/* Pool */
+
+typedef struct {
+  __truk_allocator_t base;
+  __truk_alloc_block_t *chunks;
+  __truk_alloc_block_t *current;
+  void *free_list;
+  __truk_u64 elem_size, count;
+} __truk_alloc_pool_t;
+
+static __truk_void *__truk_alloc_pool_alloc(__truk_allocator_t *self,
+                                            __truk_u64 size) {
+  static const char msg[] = "pool allocation larger than its element size";
+  __truk_alloc_pool_t *p = (__truk_alloc_pool_t *)self;
+  __truk_alloc_block_t *chunk = p->current;
+  unsigned char *ptr;
+  if (size > p->elem_size) {
+    __truk_runtime_sxs_panic(msg, sizeof(msg) - 1);
+  }
+  if (p->free_list) {
+    ptr = p->free_list;
+    p->free_list = *(void **)ptr;
+    return ptr;
+  }
+  if (!chunk || chunk->used == chunk->size) {
+    /* After a reset the chunks are reused in order before growing. */
+    __truk_alloc_block_t *next = chunk ? chunk->next : p->chunks;
+    if (!next) {
+      next = __truk_alloc_block_new(p->elem_size * p->count);
+      if (!next) {
+        return NULL;
+      }
+      if (chunk) {
+        chunk->next = next;
+      } else {
+        p->chunks = next;
+      }
+    }
+    next->used = 0;
+    p->current = chunk = next;
+  }
+  ptr = __truk_alloc_block_data(chunk) + chunk->used;
+  chunk->used += p->elem_size;
+  return ptr;
+}
+
+static __truk_void __truk_alloc_pool_free(__truk_allocator_t *self,
+                                          __truk_void *ptr) {
+  __truk_alloc_pool_t *p = (__truk_alloc_pool_t *)self;
+  *(void **)ptr = p->free_list;
+  p->free_list = ptr;
+}
+
+static __truk_void __truk_alloc_pool_reset(__truk_allocator_t *self) {
+  __truk_alloc_pool_t *p = (__truk_alloc_pool_t *)self;
+  p->free_list = NULL;
+  p->current = NULL;
+}
+
+static __truk_void __truk_alloc_pool_destroy(__truk_allocator_t *self) {
+  __truk_alloc_pool_t *p = (__truk_alloc_pool_t *)self;
+  __truk_alloc_block_free_list(p->chunks);
+  free(p);
+}
+
+__truk_allocator_t *__truk_alloc_pool_new(__truk_u64 elem_size,
+                                          __truk_u64 count) {
+  __truk_alloc_pool_t *p = malloc(sizeof(*p));
+  if (!p) {
+    return NULL;
+  }
+  p->base.alloc = __truk_alloc_pool_alloc;
+  p->base.free = __truk_alloc_pool_free;
+  p->base.reset = __truk_alloc_pool_reset;
+  p->base.destroy = __truk_alloc_pool_destroy;
+  p->chunks = NULL;
+  p->current = NULL;
+  p->free_list = NULL;
+  p->elem_size = __TRUK_ALLOC_ROUND(elem_size ? elem_size : 1);
+  p->count = count ? count : 1;
+  return &p->base;
+}
+
+/* Slab */
+
+#define __TRUK_ALLOC_SLAB_BYTES (64 * 1024)
+#define __TRUK_ALLOC_SLAB_CLASSES 16
+#define __TRUK_ALLOC_SLAB_LARGE ((__truk_u64) - 1)
+
+static const __truk_u64
+    __truk_alloc_slab_class_size[__TRUK_ALLOC_SLAB_CLASSES] = {
+        16,  32,  48,  64,  80,   96,   112,  128,
+        192, 256, 384, 512, 768, 1024, 1536, 2048};
+
+/* Every object carries one aligned word in front of it naming its size
+ * class, so free needs no lookup. Large objects additionally sit on a
+ * doubly linked list so reset can find them. */
+typedef struct __truk_alloc_large_s {
+  struct __truk_alloc_large_s *next, *prev;
+} __truk_alloc_large_t;
+
+#define __TRUK_ALLOC_OBJ_HEADER __TRUK_ALLOC_ALIGN
+#define __TRUK_ALLOC_LARGE_HEADER                                              \
+  __TRUK_ALLOC_ROUND(sizeof(__truk_alloc_large_t))
+
+typedef struct {
+  void *free_list;
+  unsigned char *bump, *end;
+} __truk_alloc_slab_class_t;
+
+typedef struct {
+  __truk_allocator_t base;
+  __truk_alloc_block_t *slabs;
+  __truk_alloc_large_t *large;
+  __truk_alloc_slab_class_t classes[__TRUK_ALLOC_SLAB_CLASSES];
+} __truk_alloc_slab_t;
+
+static int __truk_alloc_slab_class(__truk_u64 size) {
+  int c;
+  for (c = 0; c < __TRUK_ALLOC_SLAB_CLASSES; c++) {
+    if (size <= __truk_alloc_slab_class_size[c]) {
+      return c;
+    }
+  }
+  return -1;
+}
+
+static __truk_void *__truk_alloc_slab_alloc(__truk_allocator_t *self,
+                                            __truk_u64 size) {
+  __truk_alloc_slab_t *s = (__truk_alloc_slab_t *)self;
+  int c = __truk_alloc_slab_class(size);
+  unsigned char *obj;
+  if (c < 0) {
+    __truk_alloc_large_t *large = malloc(
+        __TRUK_ALLOC_LARGE_HEADER + __TRUK_ALLOC_OBJ_HEADER + size);
+    if (!large) {
+      return NULL;
+    }
+    large->prev = NULL;
+    large->next = s->large;
+    if (s->large) {
+      s->large->prev = large;
+    }
+    s->large = large;
+    obj = (unsigned char *)large + __TRUK_ALLOC_LARGE_HEADER;
+    *(__truk_u64 *)obj = __TRUK_ALLOC_SLAB_LARGE;
+    return obj + __TRUK_ALLOC_OBJ_HEADER;
+  }
+  if (s->classes[c].free_list) {
+    obj = s->classes[c].free_list;
+    s->classes[c].free_list = *(void **)obj;
+  } else {
+    __truk_u64 slot = __TRUK_ALLOC_OBJ_HEADER + __truk_alloc_slab_class_size[c];
+    if (!s->classes[c].bump ||
+        (__truk_u64)(s->classes[c].end - s->classes[c].bump) < slot) {
+      __truk_alloc_block_t *slab =
+          __truk_alloc_block_new(__TRUK_ALLOC_SLAB_BYTES);
+      if (!slab) {
+        return NULL;
+      }
+      slab->next = s->slabs;
+      s->slabs = slab;
+      s->classes[c].bump = __truk_alloc_block_data(slab);
+      s->classes[c].end = s->classes[c].bump + __TRUK_ALLOC_SLAB_BYTES;
+    }
+    obj = s->classes[c].bump;
+    s->classes[c].bump += slot;
+  }
+  *(__truk_u64 *)obj = (__truk_u64)c;
+  return obj + __TRUK_ALLOC_OBJ_HEADER;
+}
+
+static __truk_void __truk_alloc_slab_free(__truk_allocator_t *self,
+                                          __truk_void *ptr) {
+  __truk_alloc_slab_t *s = (__truk_alloc_slab_t *)self;
+  unsigned char *obj = (unsigned char *)ptr - __TRUK_ALLOC_OBJ_HEADER;
+  __truk_u64 c = *(__truk_u64 *)obj;
+  if (c == __TRUK_ALLOC_SLAB_LARGE) {
+    __truk_alloc_large_t *large =
+        (__truk_alloc_large_t *)(obj - __TRUK_ALLOC_LARGE_HEADER);
+    if (large->prev) {
+      large->prev->next = large->next;
+    } else {
+      s->large = large->next;
+    }
+    if (large->next) {
+      large->next->prev = large->prev;
+    }
+    free(large);
+    return;
+  }
+  *(void **)obj = s->classes[c].free_list;
+  s->classes[c].free_list = obj;
+}
+
+static __truk_void __truk_alloc_slab_reset(__truk_allocator_t *self) {
+  __truk_alloc_slab_t *s = (__truk_alloc_slab_t *)self;
+  __truk_alloc_large_t *large = s->large;
+  while (large) {
+    __truk_alloc_large_t *next = large->next;
+    free(large);
+    large = next;
+  }
+  __truk_alloc_block_free_list(s->slabs);
+  s->slabs = NULL;
+  s->large = NULL;
+  memset(s->classes, 0, sizeof(s->classes));
+}
+
+static __truk_void __truk_alloc_slab_destroy(__truk_allocator_t *self) {
+  __truk_alloc_slab_reset(self);
+  free(self);
+}
+
+__truk_allocator_t *__truk_alloc_slab_new(void) {
+  __truk_alloc_slab_t *s = malloc(sizeof(*s));
+  if (!s) {
+    return NULL;
+  }
+  memset(s, 0, sizeof(*s));
+  s->base.alloc = __truk_alloc_slab_alloc;
+  s->base.free = __truk_alloc_slab_free;
+  s->base.reset = __truk_alloc_slab_reset;
+  s->base.destroy = __truk_alloc_slab_destroy;
+  return &s->base;
+}
@@ -0,0 +1,364 @@
+#include <string.h>
+#include <sxs/bytes.h>
+
+/*
+ * SSE2 is part of the x86-64 baseline, so it is used whenever the compiler
+ * targets it. The AVX2 kernels are compiled for that target with a function
+ * attribute and only entered when __builtin_cpu_supports says the CPU has it.
+ * They clear the upper register halves before handing the tail to the SSE2
+ * kernel; mixing the two encodings with dirty upper state costs far more
+ * than a short input takes to scan.
+ */
+#if defined(__SSE2__) && !defined(__TINYC__)
+#  include <emmintrin.h>
+#define __TRUK_BYTES_SSE2 1
+#endif
+
+#if defined(__TRUK_BYTES_SSE2) && defined(__x86_64__) && defined(__GNUC__)
+#  include <immintrin.h>
+#define __TRUK_BYTES_AVX2 1
+#define __TRUK_BYTES_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+/* find_any compares each block against every byte of the set, so the vector
+ * kernels only take sets up to this size; larger ones use a lookup table. */
+#define __TRUK_BYTES_MAX_SIMD_SET 16
+
+static __truk_u64 __truk_bytes_count_scalar(const __truk_u8 *data,
+                                            __truk_u64 len, __truk_u8 byte) {
+  __truk_u64 count = 0;
+  __truk_u64 i;
+  for (i = 0; i < len; i++) {
+    count += data[i] == byte;
+  }
+  return count;
+}
+
+static __truk_u64 __truk_bytes_find_any_scalar(const __truk_u8 *data,
+                                               __truk_u64 len,
+                                               const __truk_u8 *set,
+                                               __truk_u64 set_len) {
+  __truk_u8 member[256];
+  __truk_u64 i, k;
+  /* Vector tails are shorter than a block; compare them directly rather
+   * than building the table. */
+  if (len < 32) {
+    for (i = 0; i < len; i++) {
+      for (k = 0; k < set_len; k++) {
+        if (data[i] == set[k]) {
+          return i;
+        }
+      }
+    }
+    return len;
+  }
+  memset(member, 0, sizeof(member));
+  for (i = 0; i < set_len; i++) {
+    member[set[i]] = 1;
+  }
+  for (i = 0; i < len; i++) {
+    if (member[data[i]]) {
+      return i;
+    }
+  }
+  return len;
+}
+
+static __truk_u64 __truk_bytes_ascii_prefix_scalar(const __truk_u8 *data,
+                                                   __truk_u64 len) {
+  __truk_u64 i = 0;
+  for (; i + 8 <= len; i += 8) {
+    unsigned long long word;
+    memcpy(&word, data + i, sizeof(word));
+    if (word & 0x8080808080808080ULL) {
+      break;
+    }
+  }
+  while (i < len && data[i] < 0x80) {
+    i++;
+  }
+  return i;
+}
+
+#if defined(__TRUK_BYTES_SSE2)
+/* Byte compares are summed in 8-bit lanes, at most 255 blocks at a time so no
+ * lane overflows, then folded with sad_epu8. */
+static __truk_u64 __truk_bytes_count_sse2(const __truk_u8 *data,
+                                          __truk_u64 len, __truk_u8 byte) {
+  const __m128i needle = _mm_set1_epi8((char)byte);
+  __truk_u64 count = 0;
+  __truk_u64 i = 0;
+  while (len - i >= 16) {
+    __truk_u64 blocks = (len - i) / 16;
+    __m128i acc = _mm_setzero_si128();
+    __truk_u64 lanes[2];
+    if (blocks > 255) {
+      blocks = 255;
+    }
+    for (; blocks > 0; blocks--, i += 16) {
+      __m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+      acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(block, needle));
+    }
+    _mm_storeu_si128((__m128i *)lanes,
+                     _mm_sad_epu8(acc, _mm_setzero_si128()));
+    count += lanes[0] + lanes[1];
+  }
+  return count + __truk_bytes_count_scalar(data + i, len - i, byte);
+}
+
+static __truk_u64 __truk_bytes_find_any_sse2(const __truk_u8 *data,
+                                             __truk_u64 len,
+                                             const __truk_u8 *set,
+                                             __truk_u64 set_len) {
+  __m128i needles[__TRUK_BYTES_MAX_SIMD_SET];
+  __truk_u64 i, k;
+  for (k = 0; k < set_len; k++) {
+    needles[k] = _mm_set1_epi8((char)set[k]);
+  }
+  for (i = 0; i + 16 <= len; i += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+    __m128i hits = _mm_cmpeq_epi8(block, needles[0]);
+    int mask;
+    for (k = 1; k < set_len; k++) {
+      hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[k]));
+    }
+    mask = _mm_movemask_epi8(hits);
+    if (mask) {
+      return i + (__truk_u64)__builtin_ctz((unsigned)mask);
+    }
+  }
+  if (i < len && len >= 16) {
+    /* Finish with one block ending at len, ignoring the bytes before i that
+     * were already checked. */
+    __m128i block = _mm_loadu_si128((const __m128i *)(data + len - 16));
+    __m128i hits = _mm_cmpeq_epi8(block, needles[0]);
+    unsigned mask;
+    for (k = 1; k < set_len; k++) {
+      hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[k]));
+    }
+    mask = (unsigned)_mm_movemask_epi8(hits) >> (16 - (len - i));
+    return mask ? i + (__truk_u64)__builtin_ctz(mask) : len;
+  }
+  return i + __truk_bytes_find_any_scalar(data + i, len - i, set, set_len);
+}
+
+static __truk_u64 __truk_bytes_ascii_prefix_sse2(const __truk_u8 *data,
+                                                 __truk_u64 len) {
+  __truk_u64 i;
+  for (i = 0; i + 16 <= len; i += 16) {
+    int mask =
+        _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(data + i)));
+    if (mask) {
+      return i + (__truk_u64)__builtin_ctz((unsigned)mask);
+    }
+  }
+  return i + __truk_bytes_ascii_prefix_scalar(data + i, len - i);
+}
+#endif
+
+#if defined(__TRUK_BYTES_AVX2)
+__TRUK_BYTES_TARGET_AVX2
+static __truk_u64 __truk_bytes_count_avx2(const __truk_u8 *data,
+                                          __truk_u64 len, __truk_u8 byte) {
+  const __m256i needle = _mm256_set1_epi8((char)byte);
+  __truk_u64 count = 0;
+  __truk_u64 i = 0;
+  while (len - i >= 32) {
+    __truk_u64 blocks = (len - i) / 32;
+    __m256i acc = _mm256_setzero_si256();
+    __truk_u64 lanes[4];
+    if (blocks > 255) {
+      blocks = 255;
+    }
+    for (; blocks > 0; blocks--, i += 32) {
+      __m256i block = _mm256_loadu_si256((const __m256i *)(data + i));
+      acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(block, needle));
+    }
+    _mm256_storeu_si256((__m256i *)lanes,
+                        _mm256_sad_epu8(acc, _mm256_setzero_si256()));
+    count += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  }
+  _mm256_zeroupper();
+  return count + __truk_bytes_count_sse2(data + i, len - i, byte);
+}
+
+__TRUK_BYTES_TARGET_AVX2
+static __truk_u64 __truk_bytes_find_any_avx2(const __truk_u8 *data,
+                                             __truk_u64 len,
+                                             const __truk_u8 *set,
+                                             __truk_u64 set_len) {
+  __m256i needles[__TRUK_BYTES_MAX_SIMD_SET];
+  __truk_u64 i, k;
+  for (k = 0; k < set_len; k++) {
+    needles[k] = _mm256_set1_epi8((char)set[k]);
+  }
+  for (i = 0; i + 32 <= len; i += 32) {
+    __m256i block = _mm256_loadu_si256((const __m256i *)(data + i));
+    __m256i hits = _mm256_cmpeq_epi8(block, needles[0]);
+    unsigned mask;
+    for (k = 1; k < set_len; k++) {
+      hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, needles[k]));
+    }
+    mask = (unsigned)_mm256_movemask_epi8(hits);
+    if (mask) {
+      return i + (__truk_u64)__builtin_ctz(mask);
+    }
+  }
+  _mm256_zeroupper();
+  return i + __truk_bytes_find_any_sse2(data + i, len - i, set, set_len);
+}
+
+__TRUK_BYTES_TARGET_AVX2
+static __truk_u64 __truk_bytes_ascii_prefix_avx2(const __truk_u8 *data,
+                                                 __truk_u64 len) {
+  __truk_u64 i;
+  for (i = 0; i + 32 <= len; i += 32) {
+    unsigned mask = (unsigned)_mm256_movemask_epi8(
+        _mm256_loadu_si256((const __m256i *)(data + i)));
+    if (mask) {
+      return i + (__truk_u64)__builtin_ctz(mask);
+    }
+  }
+  _mm256_zeroupper();
+  return i + __truk_bytes_ascii_prefix_sse2(data + i, len - i);
+}
+#endif
+
+static __truk_u64 __truk_bytes_ascii_prefix(const __truk_u8 *data,
+                                            __truk_u64 len) {
+#if defined(__TRUK_BYTES_AVX2)
+  if (__builtin_cpu_supports("avx2")) {
+    return __truk_bytes_ascii_prefix_avx2(data, len);
+  }
+#endif
+#if defined(__TRUK_BYTES_SSE2)
+  return __truk_bytes_ascii_prefix_sse2(data, len);
+#else
+  return __truk_bytes_ascii_prefix_scalar(data, len);
+#endif
+}
+
+/* Length of the well-formed sequence starting at p, or 0 (Unicode table
+ * 3-7). */
+static __truk_u64 __truk_bytes_utf8_sequence(const __truk_u8 *p,
+                                             __truk_u64 n) {
+  __truk_u8 lo = 0x80, hi = 0xBF;
+  if (p[0] < 0x80) {
+    return 1;
+  }
+  if (p[0] < 0xC2) {
+    return 0;
+  }
+  if (p[0] < 0xE0) {
+    return n >= 2 && (p[1] & 0xC0) == 0x80 ? 2 : 0;
+  }
+  if (p[0] < 0xF0) {
+    if (p[0] == 0xE0) {
+      lo = 0xA0;
+    } else if (p[0] == 0xED) {
+      hi = 0x9F;
+    }
+    return n >= 3 && p[1] >= lo && p[1] <= hi && (p[2] & 0xC0) == 0x80 ? 3
+                                                                       : 0;
+  }
+  if (p[0] < 0xF5) {
+    if (p[0] == 0xF0) {
+      lo = 0x90;
+    } else if (p[0] == 0xF4) {
+      hi = 0x8F;
+    }
+    return n >= 4 && p[1] >= lo && p[1] <= hi && (p[2] & 0xC0) == 0x80 &&
+                   (p[3] & 0xC0) == 0x80
+               ? 4
+               : 0;
+  }
+  return 0;
+}
+
+__truk_u64 __truk_bytes_find(const __truk_u8 *data, __truk_u64 len,
+                             __truk_u8 byte) {
+  const __truk_u8 *hit;
+  if (len == 0) {
+    return 0;
+  }
+  hit = memchr(data, byte, len);
+  return hit ? (__truk_u64)(hit - data) : len;
+}
+
+__truk_u64 __truk_bytes_find_any(const __truk_u8 *data, __truk_u64 len,
+                                 const __truk_u8 *set, __truk_u64 set_len) {
+  if (set_len == 0) {
+    return len;
+  }
+  if (set_len == 1) {
+    return __truk_bytes_find(data, len, set[0]);
+  }
+#if defined(__TRUK_BYTES_SSE2)
+  if (set_len <= __TRUK_BYTES_MAX_SIMD_SET) {
+#if defined(__TRUK_BYTES_AVX2)
+    if (__builtin_cpu_supports("avx2")) {
+      return __truk_bytes_find_any_avx2(data, len, set, set_len);
+    }
+#endif
+    return __truk_bytes_find_any_sse2(data, len, set, set_len);
+  }
+#endif
+  return __truk_bytes_find_any_scalar(data, len, set, set_len);
+}
+
+__truk_u64 __truk_bytes_count(const __truk_u8 *data, __truk_u64 len,
+                              __truk_u8 byte) {
+#if defined(__TRUK_BYTES_AVX2)
+  if (__builtin_cpu_supports("avx2")) {
+    return __truk_bytes_count_avx2(data, len, byte);
+  }
+#endif
+#if defined(__TRUK_BYTES_SSE2)
+  return __truk_bytes_count_sse2(data, len, byte);
+#else
+  return __truk_bytes_count_scalar(data, len, byte);
+#endif
+}
+
+__truk_i32 __truk_bytes_compare(const __truk_u8 *a, __truk_u64 a_len,
+                                const __truk_u8 *b, __truk_u64 b_len) {
+  __truk_u64 n = a_len < b_len ? a_len : b_len;
+  int order = n ? memcmp(a, b, n) : 0;
+  if (order == 0) {
+    return a_len < b_len ? -1 : a_len > b_len ? 1 : 0;
+  }
+  return order < 0 ? -1 : 1;
+}
+
+__truk_void __truk_bytes_fill(__truk_u8 *data, __truk_u64 len,
+                              __truk_u8 byte) {
+  if (len) {
+    memset(data, byte, len);
+  }
+}
+
+__truk_u64 __truk_bytes_copy(__truk_u8 *dst, __truk_u64 dst_len,
+                             const __truk_u8 *src, __truk_u64 src_len) {
+  __truk_u64 n = dst_len < src_len ? dst_len : src_len;
+  if (n) {
+    memmove(dst, src, n);
+  }
+  return n;
+}
+
+__truk_bool __truk_bytes_utf8_valid(const __truk_u8 *data, __truk_u64 len) {
+  __truk_u64 i = 0;
+  while (i < len) {
+    __truk_u64 n;
+    i += __truk_bytes_ascii_prefix(data + i, len - i);
+    if (i == len) {
+      break;
+    }
+    n = __truk_bytes_utf8_sequence(data + i, len - i);
+    if (n == 0) {
+      return false;
+    }
+    i += n;
+  }
+  return true;
+}
@@ -0,0 +1,238 @@
+/**
+ * Copyright (c) 2014 rxi
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ * - Modified for TRUK by bosley 2025 - Generic key support
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sxs/ds/chained_map.h>
+#include <sxs/runtime.h>
+
+struct __truk_chained_map_node_t {
+  unsigned hash;
+  void *value;
+  __truk_chained_map_node_t *next;
+};
+
+/* Nodes are carved from chunks owned by the map. A chunk starts with a
+ * link to the previous chunk, padded to 16 bytes; chunk sizes double up to
+ * __TRUK_CHAINED_MAP_MAX_CHUNK nodes. */
+#define __TRUK_CHAINED_MAP_MIN_CHUNK 8
+#define __TRUK_CHAINED_MAP_MAX_CHUNK 4096
+#define __TRUK_CHAINED_MAP_CHUNK_HEADER 16
+
+static void *__truk_chained_map_slab_alloc(__truk_chained_map_base_t *m) {
+  __truk_chained_map_slab_t *slab = &m->slab;
+  void *node;
+  if (slab->free_nodes) {
+    node = slab->free_nodes;
+    slab->free_nodes = *(void **)node;
+    return node;
+  }
+  if (slab->bump == slab->end) {
+    unsigned count = slab->chunk_nodes ? slab->chunk_nodes * 2
+                                       : __TRUK_CHAINED_MAP_MIN_CHUNK;
+    unsigned char *chunk;
+    if (count > __TRUK_CHAINED_MAP_MAX_CHUNK) {
+      count = __TRUK_CHAINED_MAP_MAX_CHUNK;
+    }
+    chunk = __truk_runtime_sxs_alloc_with(
+        m->allocator, __TRUK_CHAINED_MAP_CHUNK_HEADER +
+                          (unsigned long long)count * slab->node_size);
+    if (!chunk) {
+      return NULL;
+    }
+    *(void **)chunk = slab->chunks;
+    slab->chunks = chunk;
+    slab->chunk_nodes = count;
+    slab->bump = chunk + __TRUK_CHAINED_MAP_CHUNK_HEADER;
+    slab->end = slab->bump + (unsigned long long)count * slab->node_size;
+  }
+  node = slab->bump;
+  slab->bump += slab->node_size;
+  return node;
+}
+
+static void __truk_chained_map_slab_free(__truk_chained_map_base_t *m,
+                                         void *node) {
+  *(void **)node = m->slab.free_nodes;
+  m->slab.free_nodes = node;
+}
+
+static void __truk_chained_map_slab_release(__truk_chained_map_base_t *m) {
+  void *chunk = m->slab.chunks;
+  while (chunk) {
+    void *prev = *(void **)chunk;
+    __truk_runtime_sxs_free_with(m->allocator, chunk);
+    chunk = prev;
+  }
+  memset(&m->slab, 0, sizeof(m->slab));
+}
+
+static __truk_chained_map_node_t *
+__truk_chained_map_newnode(__truk_chained_map_base_t *m, const void *key,
+                           void *value, int vsize) {
+  __truk_chained_map_node_t *node;
+  int ksize = m->ksize;
+  int voffset = ksize + ((sizeof(void *) - ksize) % sizeof(void *));
+  if (m->slab.node_size == 0) {
+    /* vsize is fixed per map. Nodes are packed at pointer alignment, which
+     * is all the node header and truk's value types need; malloc's 16-byte
+     * rounding is where the per-entry savings come from. */
+    m->slab.node_size = (unsigned)((sizeof(*node) + voffset + vsize +
+                                    sizeof(void *) - 1) &
+                                   ~(sizeof(void *) - 1));
+  }
+  node = __truk_chained_map_slab_alloc(m);
+  if (!node)
+    return NULL;
+  memcpy(node + 1, key, ksize);
+  node->hash = m->hash_fn(key, ksize);
+  node->value = ((char *)(node + 1)) + voffset;
+  memcpy(node->value, value, vsize);
+  return node;
+}
+
+static int __truk_chained_map_bucketidx(__truk_chained_map_base_t *m,
+                                        unsigned hash) {
+  return hash & (m->nbuckets - 1);
+}
+
+static void __truk_chained_map_addnode(__truk_chained_map_base_t *m,
+                                       __truk_chained_map_node_t *node) {
+  int n = __truk_chained_map_bucketidx(m, node->hash);
+  node->next = m->buckets[n];
+  m->buckets[n] = node;
+}
+
+static int __truk_chained_map_resize(__truk_chained_map_base_t *m,
+                                     int nbuckets) {
+  __truk_chained_map_node_t *nodes, *node, *next;
+  __truk_chained_map_node_t **buckets;
+  int i;
+  nodes = NULL;
+  i = m->nbuckets;
+  while (i--) {
+    node = (m->buckets)[i];
+    while (node) {
+      next = node->next;
+      node->next = nodes;
+      nodes = node;
+      node = next;
+    }
+  }
+  buckets = __truk_runtime_sxs_alloc_with(m->allocator,
+                                          sizeof(*m->buckets) * nbuckets);
+  if (buckets != NULL) {
+    __truk_runtime_sxs_free_with(m->allocator, m->buckets);
+    m->buckets = buckets;
+    m->nbuckets = nbuckets;
+  }
+  if (m->buckets) {
+    memset(m->buckets, 0, sizeof(*m->buckets) * m->nbuckets);
+    node = nodes;
+    while (node) {
+      next = node->next;
+      __truk_chained_map_addnode(m, node);
+      node = next;
+    }
+  }
+  return (buckets == NULL) ? -1 : 0;
+}
+
+static __truk_chained_map_node_t **
+__truk_chained_map_getref(__truk_chained_map_base_t *m, const void *key) {
+  unsigned hash = m->hash_fn(key, m->ksize);
+  __truk_chained_map_node_t **next;
+  if (m->nbuckets > 0) {
+    next = &m->buckets[__truk_chained_map_bucketidx(m, hash)];
+    while (*next) {
+      if ((*next)->hash == hash &&
+          m->cmp_fn((void *)(*next + 1), key, m->ksize) == 0) {
+        return next;
+      }
+      next = &(*next)->next;
+    }
+  }
+  return NULL;
+}
+
+void __truk_chained_map_deinit_(__truk_chained_map_base_t *m) {
+  __truk_chained_map_slab_release(m);
+  __truk_runtime_sxs_free_with(m->allocator, m->buckets);
+}
+
+void *__truk_chained_map_get_(__truk_chained_map_base_t *m, const void *key) {
+  __truk_chained_map_node_t **next = __truk_chained_map_getref(m, key);
+  return next ? (*next)->value : NULL;
+}
+
+int __truk_chained_map_set_(__truk_chained_map_base_t *m, const void *key,
+                            void *value, int vsize) {
+  int n, err;
+  __truk_chained_map_node_t **next, *node;
+  if (m->nbuckets == 0) {
+    __truk_map_seed_init();
+    m->allocator = __truk_runtime_sxs_current_allocator();
+  }
+  next = __truk_chained_map_getref(m, key);
+  if (next) {
+    memcpy((*next)->value, value, vsize);
+    return 0;
+  }
+  node = __truk_chained_map_newnode(m, key, value, vsize);
+  if (node == NULL)
+    goto fail;
+  if (m->nnodes >= m->nbuckets) {
+    n = (m->nbuckets > 0) ? (m->nbuckets << 1) : 1;
+    err = __truk_chained_map_resize(m, n);
+    if (err)
+      goto fail;
+  }
+  __truk_chained_map_addnode(m, node);
+  m->nnodes++;
+  return 0;
+fail:
+  if (node)
+    __truk_chained_map_slab_free(m, node);
+  return -1;
+}
+
+void __truk_chained_map_remove_(__truk_chained_map_base_t *m, const void *key) {
+  __truk_chained_map_node_t *node;
+  __truk_chained_map_node_t **next = __truk_chained_map_getref(m, key);
+  if (next) {
+    node = *next;
+    *next = (*next)->next;
+    __truk_chained_map_slab_free(m, node);
+    m->nnodes--;
+  }
+}
+
+__truk_chained_map_iter_t __truk_chained_map_iter_(void) {
+  __truk_chained_map_iter_t iter;
+  iter.bucketidx = -1;
+  iter.node = NULL;
+  return iter;
+}
+
+void *__truk_chained_map_next_(__truk_chained_map_base_t *m,
+                               __truk_chained_map_iter_t *iter) {
+  if (iter->node) {
+    iter->node = iter->node->next;
+    if (iter->node == NULL)
+      goto nextBucket;
+  } else {
+  nextBucket:
+    do {
+      if (++iter->bucketidx >= m->nbuckets) {
+        return NULL;
+      }
+      iter->node = m->buckets[iter->bucketidx];
+    } while (iter->node == NULL);
+  }
+  return (void *)(iter->node + 1);
+}
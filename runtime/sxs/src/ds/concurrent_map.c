@@ -0,0 +1,411 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sxs/ds/concurrent_map.h>
+#include <sxs/runtime.h>
+
+/* Each shard maps keys to node pointers. Shards are padded to a cache line
+ * so that taking one shard's lock never invalidates a neighbour's. */
+typedef struct {
+  pthread_mutex_t lock;
+  __truk_map_base_t map;
+  void *free_nodes;
+} __truk_concurrent_map_shard_t;
+
+#define __TRUK_CONCURRENT_MAP_LINE 64u
+#define __TRUK_CONCURRENT_MAP_STRIDE                                           \
+  ((sizeof(__truk_concurrent_map_shard_t) + __TRUK_CONCURRENT_MAP_LINE - 1) &  \
+   ~(size_t)(__TRUK_CONCURRENT_MAP_LINE - 1))
+
+static inline __truk_concurrent_map_shard_t *
+__truk_concurrent_map_shard_at(__truk_concurrent_map_base_t *m, unsigned i) {
+  return (__truk_concurrent_map_shard_t *)(m->shards +
+                                           (size_t)i *
+                                               __TRUK_CONCURRENT_MAP_STRIDE);
+}
+
+/* The shard comes from the top bits of a multiplicative spread, which the
+ * shard's own table folds into bits it only uses once it is very large, so
+ * the keys within a shard still fill its table evenly. */
+static inline __truk_concurrent_map_shard_t *
+__truk_concurrent_map_shard_for(__truk_concurrent_map_base_t *m,
+                                const void *key) {
+  unsigned long long h =
+      (unsigned long long)m->hash_fn(key, m->ksize) * 0x9e3779b97f4a7c15ULL;
+  return __truk_concurrent_map_shard_at(m, (unsigned)(h >> m->shard_shift));
+}
+
+static void *
+__truk_concurrent_map_node_alloc(__truk_concurrent_map_base_t *m,
+                                 __truk_concurrent_map_shard_t *s) {
+  void *node = s->free_nodes;
+  if (node) {
+    s->free_nodes = *(void **)node;
+    return node;
+  }
+  return __truk_runtime_sxs_alloc_with(m->allocator, m->nodesize);
+}
+
+static void __truk_concurrent_map_node_release(__truk_concurrent_map_shard_t *s,
+                                               void *node) {
+  *(void **)node = s->free_nodes;
+  s->free_nodes = node;
+}
+
+/* Looks key up in a locked shard and inserts a node for it if it is absent.
+ * A new node is zeroed, then filled from value if given, else by fn. */
+static void *__truk_concurrent_map_insert_locked(
+    __truk_concurrent_map_base_t *m, __truk_concurrent_map_shard_t *s,
+    const void *key, const void *value, __truk_concurrent_map_init_fn fn,
+    void *ctx) {
+  void **slot = (void **)__truk_map_get_(&s->map, key);
+  void *node;
+  if (slot) {
+    return *slot;
+  }
+  node = __truk_concurrent_map_node_alloc(m, s);
+  if (!node) {
+    return NULL;
+  }
+  memset(node, 0, m->nodesize);
+  if (value) {
+    memcpy(node, value, m->vsize);
+  } else if (fn && fn(key, node, ctx)) {
+    __truk_concurrent_map_node_release(s, node);
+    return NULL;
+  }
+  if (__truk_map_set_(&s->map, key, &node, sizeof(node))) {
+    __truk_concurrent_map_node_release(s, node);
+    return NULL;
+  }
+  return node;
+}
+
+int __truk_concurrent_map_init_(__truk_concurrent_map_base_t *m, int ksize,
+                                int vsize, __truk_map_hash_fn hash_fn,
+                                __truk_map_cmp_fn cmp_fn) {
+  size_t bytes;
+  unsigned i;
+  m->ksize = ksize;
+  m->vsize = vsize;
+  m->hash_fn = hash_fn;
+  m->cmp_fn = cmp_fn;
+  /* Nodes double as free list links, so they hold at least a pointer. */
+  m->nodesize = vsize < (int)sizeof(void *) ? (int)sizeof(void *) : vsize;
+  m->nodesize = (m->nodesize + 7) & ~7;
+  m->allocator = __truk_runtime_sxs_current_allocator();
+  m->nshards = 0;
+  m->shard_shift = 64;
+  bytes = (size_t)__TRUK_CONCURRENT_MAP_SHARDS * __TRUK_CONCURRENT_MAP_STRIDE;
+  m->shard_mem = __truk_runtime_sxs_alloc_with(
+      m->allocator, bytes + __TRUK_CONCURRENT_MAP_LINE - 1);
+  if (!m->shard_mem) {
+    return -1;
+  }
+  m->shards = (unsigned char *)(((size_t)m->shard_mem +
+                                 __TRUK_CONCURRENT_MAP_LINE - 1) &
+                                ~(size_t)(__TRUK_CONCURRENT_MAP_LINE - 1));
+  memset(m->shards, 0, bytes);
+  for (i = 1; i < __TRUK_CONCURRENT_MAP_SHARDS; i <<= 1) {
+    m->shard_shift--;
+  }
+  /* Preparing every shard now fixes the seed and the allocator before any
+   * other thread can touch the map. */
+  for (i = 0; i < __TRUK_CONCURRENT_MAP_SHARDS; i++) {
+    __truk_concurrent_map_shard_t *s = __truk_concurrent_map_shard_at(m, i);
+    pthread_mutex_init(&s->lock, NULL);
+    s->map.ksize = ksize;
+    s->map.vsize = (int)sizeof(void *);
+    s->map.hash_fn = hash_fn;
+    s->map.cmp_fn = cmp_fn;
+    m->nshards = i + 1;
+    if (__truk_map_reserve_(&s->map, 1)) {
+      __truk_concurrent_map_deinit_(m);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+void __truk_concurrent_map_deinit_(__truk_concurrent_map_base_t *m) {
+  unsigned i;
+  for (i = 0; i < m->nshards; i++) {
+    __truk_concurrent_map_shard_t *s = __truk_concurrent_map_shard_at(m, i);
+    __truk_map_iter_t iter = __truk_map_iter_();
+    void *slot;
+    while (__truk_map_next_kv_(&s->map, &iter, &slot)) {
+      __truk_runtime_sxs_free_with(m->allocator, *(void **)slot);
+    }
+    while (s->free_nodes) {
+      void *node = s->free_nodes;
+      s->free_nodes = *(void **)node;
+      __truk_runtime_sxs_free_with(m->allocator, node);
+    }
+    __truk_map_deinit_(&s->map);
+    pthread_mutex_destroy(&s->lock);
+  }
+  __truk_runtime_sxs_free_with(m->allocator, m->shard_mem);
+  m->shard_mem = NULL;
+  m->shards = NULL;
+  m->nshards = 0;
+}
+
+void *__truk_concurrent_map_get_(__truk_concurrent_map_base_t *m,
+                                 const void *key) {
+  __truk_concurrent_map_shard_t *s;
+  void **slot;
+  void *node = NULL;
+  if (m->nshards == 0) {
+    return NULL;
+  }
+  s = __truk_concurrent_map_shard_for(m, key);
+  pthread_mutex_lock(&s->lock);
+  slot = (void **)__truk_map_get_(&s->map, key);
+  if (slot) {
+    node = *slot;
+  }
+  pthread_mutex_unlock(&s->lock);
+  return node;
+}
+
+void *__truk_concurrent_map_get_copy_(__truk_concurrent_map_base_t *m,
+                                      const void *key, void *out) {
+  __truk_concurrent_map_shard_t *s;
+  void **slot;
+  if (m->nshards == 0) {
+    return NULL;
+  }
+  s = __truk_concurrent_map_shard_for(m, key);
+  pthread_mutex_lock(&s->lock);
+  slot = (void **)__truk_map_get_(&s->map, key);
+  if (slot) {
+    memcpy(out, *slot, m->vsize);
+  } else {
+    out = NULL;
+  }
+  pthread_mutex_unlock(&s->lock);
+  return out;
+}
+
+int __truk_concurrent_map_set_(__truk_concurrent_map_base_t *m,
+                               const void *key, void *value, int vsize) {
+  __truk_concurrent_map_shard_t *s;
+  void **slot;
+  int rc = 0;
+  if (m->nshards == 0 || vsize != m->vsize) {
+    return -1;
+  }
+  s = __truk_concurrent_map_shard_for(m, key);
+  pthread_mutex_lock(&s->lock);
+  slot = (void **)__truk_map_get_(&s->map, key);
+  if (slot) {
+    memcpy(*slot, value, vsize);
+  } else if (!__truk_concurrent_map_insert_locked(m, s, key, value, NULL,
+                                                  NULL)) {
+    rc = -1;
+  }
+  pthread_mutex_unlock(&s->lock);
+  return rc;
+}
+
+void __truk_concurrent_map_remove_(__truk_concurrent_map_base_t *m,
+                                   const void *key) {
+  __truk_concurrent_map_shard_t *s;
+  void **slot;
+  if (m->nshards == 0) {
+    return;
+  }
+  s = __truk_concurrent_map_shard_for(m, key);
+  pthread_mutex_lock(&s->lock);
+  slot = (void **)__truk_map_get_(&s->map, key);
+  if (slot) {
+    __truk_concurrent_map_node_release(s, *slot);
+    __truk_map_remove_(&s->map, key);
+  }
+  pthread_mutex_unlock(&s->lock);
+}
+
+void *__truk_concurrent_map_get_or_insert_(__truk_concurrent_map_base_t *m,
+                                           const void *key, const void *value) {
+  __truk_concurrent_map_shard_t *s;
+  void *node;
+  if (m->nshards == 0) {
+    return NULL;
+  }
+  s = __truk_concurrent_map_shard_for(m, key);
+  pthread_mutex_lock(&s->lock);
+  node = __truk_concurrent_map_insert_locked(m, s, key, value, NULL, NULL);
+  pthread_mutex_unlock(&s->lock);
+  return node;
+}
+
+void *__truk_concurrent_map_compute_if_absent_(
+    __truk_concurrent_map_base_t *m, const void *key,
+    __truk_concurrent_map_init_fn fn, void *ctx) {
+  __truk_concurrent_map_shard_t *s;
+  void *node;
+  if (m->nshards == 0) {
+    return NULL;
+  }
+  s = __truk_concurrent_map_shard_for(m, key);
+  pthread_mutex_lock(&s->lock);
+  node = __truk_concurrent_map_insert_locked(m, s, key, NULL, fn, ctx);
+  pthread_mutex_unlock(&s->lock);
+  return node;
+}
+
+void *__truk_concurrent_map_get_or_insert_copy_(
+    __truk_concurrent_map_base_t *m, const void *key, const void *value,
+    void *out) {
+  __truk_concurrent_map_shard_t *s;
+  void *node;
+  if (m->nshards == 0) {
+    return NULL;
+  }
+  s = __truk_concurrent_map_shard_for(m, key);
+  pthread_mutex_lock(&s->lock);
+  node = __truk_concurrent_map_insert_locked(m, s, key, value, NULL, NULL);
+  if (node) {
+    memcpy(out, node, m->vsize);
+  } else {
+    out = NULL;
+  }
+  pthread_mutex_unlock(&s->lock);
+  return out;
+}
+
+int __truk_concurrent_map_reserve_(__truk_concurrent_map_base_t *m,
+                                   unsigned long long count) {
+  unsigned long long per_shard;
+  unsigned i;
+  int rc = 0;
+  if (m->nshards == 0) {
+    return -1;
+  }
+  per_shard = (count + m->nshards - 1) / m->nshards;
+  per_shard += per_shard / 8;
+  for (i = 0; i < m->nshards && rc == 0; i++) {
+    __truk_concurrent_map_shard_t *s = __truk_concurrent_map_shard_at(m, i);
+    pthread_mutex_lock(&s->lock);
+    rc = __truk_map_reserve_(&s->map, per_shard);
+    pthread_mutex_unlock(&s->lock);
+  }
+  return rc;
+}
+
+int __truk_concurrent_map_shrink_(__truk_concurrent_map_base_t *m) {
+  unsigned i;
+  int rc = 0;
+  for (i = 0; i < m->nshards && rc == 0; i++) {
+    __truk_concurrent_map_shard_t *s = __truk_concurrent_map_shard_at(m, i);
+    pthread_mutex_lock(&s->lock);
+    /* Keep a table so the shard's allocator stays fixed. */
+    if (s->map.nnodes > 0) {
+      rc = __truk_map_shrink_(&s->map);
+    }
+    while (s->free_nodes) {
+      void *node = s->free_nodes;
+      s->free_nodes = *(void **)node;
+      __truk_runtime_sxs_free_with(m->allocator, node);
+    }
+    pthread_mutex_unlock(&s->lock);
+  }
+  return rc;
+}
+
+unsigned long long
+__truk_concurrent_map_count_(__truk_concurrent_map_base_t *m) {
+  unsigned long long count = 0;
+  unsigned i;
+  for (i = 0; i < m->nshards; i++) {
+    __truk_concurrent_map_shard_t *s = __truk_concurrent_map_shard_at(m, i);
+    pthread_mutex_lock(&s->lock);
+    count += s->map.nnodes;
+    pthread_mutex_unlock(&s->lock);
+  }
+  return count;
+}
+
+__truk_concurrent_map_iter_t __truk_concurrent_map_iter_(void) {
+  __truk_concurrent_map_iter_t iter;
+  memset(&iter, 0, sizeof(iter));
+  return iter;
+}
+
+/* Each copied entry is the key followed by the value, both padded to 8. */
+static inline unsigned long long
+__truk_concurrent_map_entry_size(__truk_concurrent_map_base_t *m) {
+  return (unsigned long long)(((m->ksize + 7) & ~7) + ((m->vsize + 7) & ~7));
+}
+
+/* Replaces the iterator's copy with the entries of shard i. Returns -1 if
+ * the copy could not be allocated. */
+static int __truk_concurrent_map_copy_shard(__truk_concurrent_map_base_t *m,
+                                            __truk_concurrent_map_iter_t *iter,
+                                            unsigned i) {
+  __truk_concurrent_map_shard_t *s = __truk_concurrent_map_shard_at(m, i);
+  unsigned long long esize = __truk_concurrent_map_entry_size(m);
+  unsigned long long kpad = (unsigned long long)((m->ksize + 7) & ~7);
+  __truk_map_iter_t inner = __truk_map_iter_();
+  unsigned char *entry;
+  void *key;
+  void *slot;
+  int rc = 0;
+
+  pthread_mutex_lock(&s->lock);
+  iter->count = s->map.nnodes;
+  iter->pos = 0;
+  if (iter->count > iter->cap) {
+    __truk_runtime_sxs_free_with(m->allocator, iter->buf);
+    iter->buf = (unsigned char *)__truk_runtime_sxs_alloc_with(
+        m->allocator, iter->count * esize);
+    iter->cap = iter->buf ? iter->count : 0;
+    if (!iter->buf) {
+      iter->count = 0;
+      rc = -1;
+    }
+  }
+  entry = iter->buf;
+  while (rc == 0 && (key = __truk_map_next_kv_(&s->map, &inner, &slot))) {
+    memcpy(entry, key, m->ksize);
+    memcpy(entry + kpad, *(void **)slot, m->vsize);
+    entry += esize;
+  }
+  pthread_mutex_unlock(&s->lock);
+  return rc;
+}
+
+void *__truk_concurrent_map_next_kv_(__truk_concurrent_map_base_t *m,
+                                     __truk_concurrent_map_iter_t *iter,
+                                     void **value) {
+  unsigned char *entry;
+  while (iter->pos == iter->count) {
+    if (iter->shard >= m->nshards ||
+        __truk_concurrent_map_copy_shard(m, iter, iter->shard)) {
+      __truk_concurrent_map_iter_end_(m, iter);
+      *value = NULL;
+      return NULL;
+    }
+    iter->shard++;
+  }
+  entry = iter->buf + iter->pos * __truk_concurrent_map_entry_size(m);
+  iter->pos++;
+  *value = entry + ((m->ksize + 7) & ~7);
+  return entry;
+}
+
+void *__truk_concurrent_map_next_(__truk_concurrent_map_base_t *m,
+                                  __truk_concurrent_map_iter_t *iter) {
+  void *value;
+  return __truk_concurrent_map_next_kv_(m, iter, &value);
+}
+
+void __truk_concurrent_map_iter_end_(__truk_concurrent_map_base_t *m,
+                                     __truk_concurrent_map_iter_t *iter) {
+  __truk_runtime_sxs_free_with(m->allocator, iter->buf);
+  iter->buf = NULL;
+  iter->cap = 0;
+  iter->count = 0;
+  iter->pos = 0;
+  iter->shard = m->nshards;
+}
@@ -4,19 +4,16 @@
  * This library is free software; you can redistribute it and/or modify it
  * under the terms of the MIT license. See LICENSE for details.
  * - Modified for TRUK by bosley 2025 - Generic key support
+ * - Rewritten as a flat open-addressing table
  */
 
+#include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sxs/ds/map.h>
 #include <sxs/runtime.h>
 
-struct __truk_map_node_t {
-  unsigned hash;
-  void *value;
-  __truk_map_node_t *next;
-};
-
 unsigned __truk_map_hash_str(const void *key, int ksize) {
   (void)ksize;
   const char *str = *(const char **)key;
@@ -105,159 +102,709 @@ int __truk_map_cmp_mem(const void *a, const void *b, int ksize) {
   return memcmp(a, b, ksize);
 }
 
-static __truk_map_node_t *__truk_map_newnode(__truk_map_base_t *m,
-                                             const void *key, void *value,
-                                             int vsize) {
-  __truk_map_node_t *node;
-  int ksize = m->ksize;
-  int voffset = ksize + ((sizeof(void *) - ksize) % sizeof(void *));
-  node = __truk_runtime_sxs_alloc(sizeof(*node) + voffset + vsize);
-  if (!node)
-    return NULL;
-  memcpy(node + 1, key, ksize);
-  node->hash = m->hash_fn(key, ksize);
-  node->value = ((char *)(node + 1)) + voffset;
-  memcpy(node->value, value, vsize);
-  return node;
-}
-
-static int __truk_map_bucketidx(__truk_map_base_t *m, unsigned hash) {
-  return hash & (m->nbuckets - 1);
-}
-
-static void __truk_map_addnode(__truk_map_base_t *m, __truk_map_node_t *node) {
-  int n = __truk_map_bucketidx(m, node->hash);
-  node->next = m->buckets[n];
-  m->buckets[n] = node;
-}
-
-static int __truk_map_resize(__truk_map_base_t *m, int nbuckets) {
-  __truk_map_node_t *nodes, *node, *next;
-  __truk_map_node_t **buckets;
-  int i;
-  nodes = NULL;
-  i = m->nbuckets;
-  while (i--) {
-    node = (m->buckets)[i];
-    while (node) {
-      next = node->next;
-      node->next = nodes;
-      nodes = node;
-      node = next;
-    }
+#define __TRUK_MAP_P0 0xa0761d6478bd642fULL
+#define __TRUK_MAP_P1 0xe7037ed1a0b428dbULL
+#define __TRUK_MAP_P2 0x8ebc6af09c88c6e3ULL
+#define __TRUK_MAP_P3 0x589965cc75374cc3ULL
+
+unsigned long long __truk_map_seed = __TRUK_MAP_P2;
+static pthread_once_t __truk_map_seed_once = PTHREAD_ONCE_INIT;
+
+/* 64x64 -> 128 bit multiply; *a receives the low half, *b the high half. */
+static inline void __truk_map_mum128(unsigned long long *a,
+                                     unsigned long long *b) {
+#if defined(__SIZEOF_INT128__) && !defined(__TINYC__)
+  __extension__ typedef unsigned __int128 u128_t;
+  u128_t r = (u128_t)*a * *b;
+  *a = (unsigned long long)r;
+  *b = (unsigned long long)(r >> 64);
+#else
+  unsigned long long ha = *a >> 32, hb = *b >> 32;
+  unsigned long long la = (unsigned)*a, lb = (unsigned)*b;
+  unsigned long long rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  unsigned long long t = rl + (rm0 << 32);
+  unsigned long long c = t < rl;
+  unsigned long long lo = t + (rm1 << 32);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline unsigned long long __truk_map_mum(unsigned long long a,
+                                                unsigned long long b) {
+  __truk_map_mum128(&a, &b);
+  return a ^ b;
+}
+
+static inline unsigned long long __truk_map_read8(const unsigned char *p) {
+  unsigned long long v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline unsigned long long __truk_map_read4(const unsigned char *p) {
+  unsigned v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline unsigned __truk_map_fold(unsigned long long h) {
+  return (unsigned)(h ^ (h >> 32));
+}
+
+/* Run through pthread_once, so the seed is written before any caller of
+ * __truk_map_seed_init can read it. */
+static void __truk_map_seed_pick(void) {
+  const char *env;
+  unsigned long long seed = 0;
+  FILE *f;
+  env = getenv("TRUK_MAP_SEED");
+  if (!env || !*env) {
+    return;
+  }
+  if (strcmp(env, "random") != 0) {
+    __truk_map_seed = strtoull(env, NULL, 0) ^ __TRUK_MAP_P2;
+    return;
+  }
+  f = fopen("/dev/urandom", "rb");
+  if (!f || fread(&seed, sizeof(seed), 1, f) != 1) {
+    /* No entropy source: fall back on address-space layout. */
+    seed = (unsigned long long)(size_t)&seed ^
+           ((unsigned long long)(size_t)env << 16) ^
+           (unsigned long long)(size_t)__truk_map_seed_init;
   }
-  buckets = realloc(m->buckets, sizeof(*m->buckets) * nbuckets);
-  if (buckets != NULL) {
-    m->buckets = buckets;
-    m->nbuckets = nbuckets;
-  }
-  if (m->buckets) {
-    memset(m->buckets, 0, sizeof(*m->buckets) * m->nbuckets);
-    node = nodes;
-    while (node) {
-      next = node->next;
-      __truk_map_addnode(m, node);
-      node = next;
+  if (f) {
+    fclose(f);
+  }
+  __truk_map_seed = __truk_map_mum(seed ^ __TRUK_MAP_P0, __TRUK_MAP_P1);
+}
+
+void __truk_map_seed_init(void) {
+  pthread_once(&__truk_map_seed_once, __truk_map_seed_pick);
+}
+
+/* wyhash final version 4, with the secret fixed to the P constants. */
+unsigned long long __truk_map_hash_bytes(const void *data, unsigned long len,
+                                         unsigned long long seed) {
+  const unsigned char *p = (const unsigned char *)data;
+  unsigned long long a, b;
+  seed ^= __truk_map_mum(seed ^ __TRUK_MAP_P0, __TRUK_MAP_P1);
+  if (len <= 16) {
+    if (len >= 4) {
+      unsigned long off = (len >> 3) << 2;
+      a = (__truk_map_read4(p) << 32) | __truk_map_read4(p + off);
+      b = (__truk_map_read4(p + len - 4) << 32) |
+          __truk_map_read4(p + len - 4 - off);
+    } else if (len > 0) {
+      a = ((unsigned long long)p[0] << 16) |
+          ((unsigned long long)p[len >> 1] << 8) | p[len - 1];
+      b = 0;
+    } else {
+      a = b = 0;
     }
+  } else {
+    unsigned long i = len;
+    if (i > 48) {
+      unsigned long long s1 = seed, s2 = seed;
+      do {
+        seed = __truk_map_mum(__truk_map_read8(p) ^ __TRUK_MAP_P1,
+                              __truk_map_read8(p + 8) ^ seed);
+        s1 = __truk_map_mum(__truk_map_read8(p + 16) ^ __TRUK_MAP_P2,
+                            __truk_map_read8(p + 24) ^ s1);
+        s2 = __truk_map_mum(__truk_map_read8(p + 32) ^ __TRUK_MAP_P3,
+                            __truk_map_read8(p + 40) ^ s2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= s1 ^ s2;
+    }
+    while (i > 16) {
+      seed = __truk_map_mum(__truk_map_read8(p) ^ __TRUK_MAP_P1,
+                            __truk_map_read8(p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+    a = __truk_map_read8(p + i - 16);
+    b = __truk_map_read8(p + i - 8);
+  }
+  a ^= __TRUK_MAP_P1;
+  b ^= seed;
+  __truk_map_mum128(&a, &b);
+  return __truk_map_mum(a ^ __TRUK_MAP_P0 ^ len, b ^ __TRUK_MAP_P1);
+}
+
+static inline unsigned __truk_map_mix(unsigned long long x) {
+  return __truk_map_fold(
+      __truk_map_mum(x ^ __truk_map_seed ^ __TRUK_MAP_P0, __TRUK_MAP_P1));
+}
+
+unsigned __truk_map_mixhash_8(const void *key, int ksize) {
+  (void)ksize;
+  return __truk_map_mix(*(const unsigned char *)key);
+}
+
+unsigned __truk_map_mixhash_16(const void *key, int ksize) {
+  unsigned short v;
+  (void)ksize;
+  memcpy(&v, key, sizeof(v));
+  return __truk_map_mix(v);
+}
+
+unsigned __truk_map_mixhash_32(const void *key, int ksize) {
+  unsigned v;
+  (void)ksize;
+  memcpy(&v, key, sizeof(v));
+  return __truk_map_mix(v);
+}
+
+unsigned __truk_map_mixhash_64(const void *key, int ksize) {
+  unsigned long long v;
+  (void)ksize;
+  memcpy(&v, key, sizeof(v));
+  return __truk_map_mix(v);
+}
+
+unsigned __truk_map_mixhash_str(const void *key, int ksize) {
+  const char *str = *(const char *const *)key;
+  (void)ksize;
+  return __truk_map_fold(
+      __truk_map_hash_bytes(str, strlen(str), __truk_map_seed));
+}
+
+unsigned __truk_map_hash_strkey(const void *key, int ksize) {
+  const __truk_map_strkey_t *k = (const __truk_map_strkey_t *)key;
+  (void)ksize;
+  return __truk_map_fold(
+      __truk_map_hash_bytes(k->data, (unsigned long)k->len, __truk_map_seed));
+}
+
+static inline int __truk_map_strkey_eq(const __truk_map_strkey_t *a,
+                                       const __truk_map_strkey_t *b) {
+  return a->len == b->len &&
+         (a->data == b->data || memcmp(a->data, b->data, a->len) == 0);
+}
+
+int __truk_map_cmp_strkey(const void *a, const void *b, int ksize) {
+  (void)ksize;
+  return !__truk_map_strkey_eq((const __truk_map_strkey_t *)a,
+                               (const __truk_map_strkey_t *)b);
+}
+
+#define __TRUK_MAP_CTRL_EMPTY ((signed char)-128)
+#define __TRUK_MAP_CTRL_DELETED ((signed char)-2)
+
+/*
+ * Group probing. With SSE2 a group is 16 control bytes tested with one
+ * compare and movemask; elsewhere (including TCC) a group is 8 bytes tested
+ * as a single 64-bit word. Either way a match mask has one bit set per
+ * matching slot, scaled by __TRUK_MAP_MASK_SHIFT.
+ */
+#if defined(__SSE2__) && !defined(__TINYC__)
+#  include <emmintrin.h>
+
+#define __TRUK_MAP_GROUP_WIDTH 16u
+#define __TRUK_MAP_MASK_SHIFT 0
+
+typedef unsigned __truk_map_mask_t;
+
+static inline __truk_map_mask_t
+__truk_map_group_match(const signed char *group, signed char h2) {
+  __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+  return (__truk_map_mask_t)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+}
+
+static inline __truk_map_mask_t
+__truk_map_group_match_empty(const signed char *group) {
+  return __truk_map_group_match(group, __TRUK_MAP_CTRL_EMPTY);
+}
+
+static inline __truk_map_mask_t
+__truk_map_group_match_free(const signed char *group) {
+  __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+  return (__truk_map_mask_t)_mm_movemask_epi8(
+      _mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl));
+}
+#else
+#define __TRUK_MAP_GROUP_WIDTH 8u
+#define __TRUK_MAP_MASK_SHIFT 3
+
+#define __TRUK_MAP_LSBS 0x0101010101010101ULL
+#define __TRUK_MAP_MSBS 0x8080808080808080ULL
+
+typedef unsigned long long __truk_map_mask_t;
+
+static inline unsigned long long
+__truk_map_group_load(const signed char *group) {
+  unsigned long long word;
+  memcpy(&word, group, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  return word;
+}
+
+/* May report a full slot whose byte differs from h2 in the lowest bit;
+ * callers compare keys anyway, so such false positives are harmless. */
+static inline __truk_map_mask_t
+__truk_map_group_match(const signed char *group, signed char h2) {
+  unsigned long long x =
+      __truk_map_group_load(group) ^ (__TRUK_MAP_LSBS * (unsigned char)h2);
+  return (x - __TRUK_MAP_LSBS) & ~x & __TRUK_MAP_MSBS;
+}
+
+/* EMPTY is the only control byte with the high bit set and bit 1 clear. */
+static inline __truk_map_mask_t
+__truk_map_group_match_empty(const signed char *group) {
+  unsigned long long word = __truk_map_group_load(group);
+  return word & ~(word << 6) & __TRUK_MAP_MSBS;
+}
+
+static inline __truk_map_mask_t
+__truk_map_group_match_free(const signed char *group) {
+  return __truk_map_group_load(group) & __TRUK_MAP_MSBS;
+}
+#endif
+
+static inline unsigned __truk_map_lowest(__truk_map_mask_t mask) {
+#if defined(__GNUC__) && !defined(__TINYC__)
+  return (unsigned)__builtin_ctzll(mask) >> __TRUK_MAP_MASK_SHIFT;
+#else
+  static const unsigned char debruijn[64] = {
+      0,  1,  48, 2,  57, 49, 28, 3,  61, 58, 50, 42, 38, 29, 17, 4,
+      62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+      63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+      46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9,  13, 8,  7,  6};
+  unsigned long long bit = (unsigned long long)mask & (0ULL - mask);
+  return (unsigned)debruijn[(bit * 0x03f79d71b4cb0a89ULL) >> 58] >>
+         __TRUK_MAP_MASK_SHIFT;
+#endif
+}
+
+/* Hash functions return 32 bits, and the identity-style ones have weak low
+ * bits. Spread them over 64 bits so both the group index (h1) and the
+ * 7-bit tag stored in the control byte (h2) depend on every input bit. */
+static inline unsigned long long __truk_map_spread(unsigned hash) {
+  unsigned long long h = (unsigned long long)hash * 0x9e3779b97f4a7c15ULL;
+  return h ^ (h >> 32);
+}
+
+static inline signed char __truk_map_h2(unsigned long long hash) {
+  return (signed char)(hash & 0x7f);
+}
+
+static inline unsigned __truk_map_growth_capacity(unsigned nbuckets) {
+  return nbuckets - nbuckets / 8;
+}
+
+/* The largest table an unsigned bucket count can describe. */
+#define __TRUK_MAP_MAX_BUCKETS 0x80000000u
+
+static inline unsigned char *__truk_map_slot(__truk_map_base_t *m,
+                                             unsigned i) {
+  return (unsigned char *)m->buckets + (size_t)i * (size_t)m->slotsize;
+}
+
+static inline int __truk_map_keyeq(__truk_map_base_t *m, const void *slot,
+                                   const void *key) {
+  if (m->cmp_fn == __truk_map_cmp_mem) {
+    return memcmp(slot, key, m->ksize) == 0;
+  }
+  if (m->cmp_fn == __truk_map_cmp_strkey) {
+    return __truk_map_strkey_eq((const __truk_map_strkey_t *)slot,
+                                (const __truk_map_strkey_t *)key);
+  }
+  return m->cmp_fn(slot, key, m->ksize) == 0;
+}
+
+static int __truk_map_align_of(int size) {
+  int align = size & -size;
+  if (align == 0) {
+    return 1;
   }
-  return (buckets == NULL) ? -1 : 0;
+  return align > 8 ? 8 : align;
+}
+
+static void __truk_map_layout(__truk_map_base_t *m) {
+  int kalign = __truk_map_align_of(m->ksize);
+  int valign = __truk_map_align_of(m->vsize);
+  int align = kalign > valign ? kalign : valign;
+  m->voffset = (m->ksize + valign - 1) & ~(valign - 1);
+  m->slotsize = (m->voffset + m->vsize + align - 1) & ~(align - 1);
 }
 
-static __truk_map_node_t **__truk_map_getref(__truk_map_base_t *m,
-                                             const void *key) {
-  unsigned hash = m->hash_fn(key, m->ksize);
-  __truk_map_node_t **next;
-  if (m->nbuckets > 0) {
-    next = &m->buckets[__truk_map_bucketidx(m, hash)];
-    while (*next) {
-      if ((*next)->hash == hash &&
-          m->cmp_fn((void *)(*next + 1), key, m->ksize) == 0) {
-        return next;
+static int __truk_map_find_in(__truk_map_base_t *m, unsigned char *slots,
+                              const signed char *ctrl, unsigned nbuckets,
+                              const void *key, unsigned long long hash,
+                              unsigned *index) {
+  unsigned gmask = nbuckets / __TRUK_MAP_GROUP_WIDTH - 1;
+  unsigned g = (unsigned)(hash >> 7) & gmask;
+  unsigned step = 0;
+  signed char h2 = __truk_map_h2(hash);
+  for (;;) {
+    const signed char *group = ctrl + g * __TRUK_MAP_GROUP_WIDTH;
+    __truk_map_mask_t mask = __truk_map_group_match(group, h2);
+    while (mask) {
+      unsigned i = g * __TRUK_MAP_GROUP_WIDTH + __truk_map_lowest(mask);
+      if (__truk_map_keyeq(m, slots + (size_t)i * (size_t)m->slotsize,
+                           key)) {
+        *index = i;
+        return 1;
       }
-      next = &(*next)->next;
+      mask &= mask - 1;
     }
+    if (__truk_map_group_match_empty(group)) {
+      return 0;
+    }
+    g = (g + ++step) & gmask;
   }
-  return NULL;
 }
 
-void __truk_map_deinit_(__truk_map_base_t *m) {
-  __truk_map_node_t *next, *node;
-  int i;
-  i = m->nbuckets;
-  while (i--) {
-    node = m->buckets[i];
-    while (node) {
-      next = node->next;
-      __truk_runtime_sxs_free(node);
-      node = next;
+static int __truk_map_find(__truk_map_base_t *m, const void *key,
+                           unsigned long long hash, unsigned *index) {
+  return __truk_map_find_in(m, (unsigned char *)m->buckets, m->ctrl,
+                            m->nbuckets, key, hash, index);
+}
+
+/* While an incremental resize is in flight, entries not yet migrated are
+ * still in the old table. */
+static int __truk_map_find_old(__truk_map_base_t *m, const void *key,
+                               unsigned long long hash, unsigned *index) {
+  return m->old_buckets &&
+         __truk_map_find_in(m, (unsigned char *)m->old_buckets, m->old_ctrl,
+                            m->old_nbuckets, key, hash, index);
+}
+
+static inline unsigned char *__truk_map_old_slot(__truk_map_base_t *m,
+                                                 unsigned i) {
+  return (unsigned char *)m->old_buckets + (size_t)i * (size_t)m->slotsize;
+}
+
+static unsigned __truk_map_find_free(__truk_map_base_t *m,
+                                     unsigned long long hash) {
+  unsigned gmask = m->nbuckets / __TRUK_MAP_GROUP_WIDTH - 1;
+  unsigned g = (unsigned)(hash >> 7) & gmask;
+  unsigned step = 0;
+  for (;;) {
+    __truk_map_mask_t mask =
+        __truk_map_group_match_free(m->ctrl + g * __TRUK_MAP_GROUP_WIDTH);
+    if (mask) {
+      return g * __TRUK_MAP_GROUP_WIDTH + __truk_map_lowest(mask);
+    }
+    g = (g + ++step) & gmask;
+  }
+}
+
+static void __truk_map_migrate(__truk_map_base_t *m, unsigned nslots);
+
+static int __truk_map_resize(__truk_map_base_t *m, unsigned nbuckets) {
+  unsigned char *old_slots;
+  signed char *old_ctrl;
+  unsigned old_nbuckets;
+  size_t slot_bytes = (size_t)nbuckets * (size_t)m->slotsize;
+  unsigned char *mem;
+  unsigned i;
+  if (m->old_buckets) {
+    __truk_map_migrate(m, m->old_nbuckets);
+  }
+  old_slots = (unsigned char *)m->buckets;
+  old_ctrl = m->ctrl;
+  old_nbuckets = m->nbuckets;
+  mem = __truk_runtime_sxs_alloc_with(m->allocator, slot_bytes + nbuckets);
+  if (!mem) {
+    return -1;
+  }
+  m->buckets = mem;
+  m->ctrl = (signed char *)(mem + slot_bytes);
+  m->nbuckets = nbuckets;
+  m->growth_left = __truk_map_growth_capacity(nbuckets) - m->nnodes;
+  memset(m->ctrl, __TRUK_MAP_CTRL_EMPTY, nbuckets);
+  for (i = 0; i < old_nbuckets; i++) {
+    if (old_ctrl[i] >= 0) {
+      unsigned char *src = old_slots + (size_t)i * (size_t)m->slotsize;
+      unsigned long long hash = __truk_map_spread(m->hash_fn(src, m->ksize));
+      unsigned j = __truk_map_find_free(m, hash);
+      m->ctrl[j] = __truk_map_h2(hash);
+      memcpy(__truk_map_slot(m, j), src, m->slotsize);
+    }
+  }
+  __truk_runtime_sxs_free_with(m->allocator, old_slots);
+  return 0;
+}
+
+/*
+ * Incremental resize. The new table is installed right away and the old one
+ * is kept until a cursor has walked all of its slots; each insert or remove
+ * moves the next __TRUK_MAP_MIGRATE_SLOTS of them. The new table's
+ * growth_left already accounts for every entry still in the old table, so
+ * migration never has to grow. Lookups probe both tables but do not
+ * migrate, so iterating while looking up keys stays well defined.
+ */
+#define __TRUK_MAP_MIGRATE_SLOTS __TRUK_MAP_GROUP_WIDTH
+
+static void __truk_map_migrate(__truk_map_base_t *m, unsigned nslots) {
+  unsigned end = m->migrate_pos + nslots;
+  if (end > m->old_nbuckets) {
+    end = m->old_nbuckets;
+  }
+  for (; m->migrate_pos < end; m->migrate_pos++) {
+    unsigned i = m->migrate_pos;
+    if (m->old_ctrl[i] >= 0) {
+      unsigned char *src = __truk_map_old_slot(m, i);
+      unsigned long long hash = __truk_map_spread(m->hash_fn(src, m->ksize));
+      unsigned j = __truk_map_find_free(m, hash);
+      /* The slot was reserved when the resize started; reusing a
+       * tombstone instead hands the reservation back. */
+      if (m->ctrl[j] != __TRUK_MAP_CTRL_EMPTY) {
+        m->growth_left++;
+      }
+      m->ctrl[j] = __truk_map_h2(hash);
+      memcpy(__truk_map_slot(m, j), src, m->slotsize);
+      m->old_ctrl[i] = __TRUK_MAP_CTRL_DELETED;
+      m->old_nnodes--;
     }
   }
-  __truk_runtime_sxs_free(m->buckets);
+  if (m->migrate_pos == m->old_nbuckets) {
+    __truk_runtime_sxs_free_with(m->allocator, m->old_buckets);
+    m->old_buckets = NULL;
+    m->old_ctrl = NULL;
+    m->old_nbuckets = 0;
+    m->old_nnodes = 0;
+    m->migrate_pos = 0;
+  }
+}
+
+static int __truk_map_begin_resize(__truk_map_base_t *m, unsigned nbuckets) {
+  size_t slot_bytes = (size_t)nbuckets * (size_t)m->slotsize;
+  unsigned char *mem =
+      __truk_runtime_sxs_alloc_with(m->allocator, slot_bytes + nbuckets);
+  if (!mem) {
+    return -1;
+  }
+  m->old_buckets = m->buckets;
+  m->old_ctrl = m->ctrl;
+  m->old_nbuckets = m->nbuckets;
+  m->old_nnodes = m->nnodes;
+  m->migrate_pos = 0;
+  m->buckets = mem;
+  m->ctrl = (signed char *)(mem + slot_bytes);
+  m->nbuckets = nbuckets;
+  m->growth_left = __truk_map_growth_capacity(nbuckets) - m->nnodes;
+  memset(m->ctrl, __TRUK_MAP_CTRL_EMPTY, nbuckets);
+  return 0;
+}
+
+void __truk_map_deinit_(__truk_map_base_t *m) {
+  __truk_runtime_sxs_free_with(m->allocator, m->old_buckets);
+  __truk_runtime_sxs_free_with(m->allocator, m->buckets);
 }
 
 void *__truk_map_get_(__truk_map_base_t *m, const void *key) {
-  __truk_map_node_t **next = __truk_map_getref(m, key);
-  return next ? (*next)->value : NULL;
+  unsigned long long hash;
+  unsigned i;
+  if (m->nnodes == 0) {
+    return NULL;
+  }
+  hash = __truk_map_spread(m->hash_fn(key, m->ksize));
+  if (__truk_map_find(m, key, hash, &i)) {
+    return __truk_map_slot(m, i) + m->voffset;
+  }
+  if (__truk_map_find_old(m, key, hash, &i)) {
+    return __truk_map_old_slot(m, i) + m->voffset;
+  }
+  return NULL;
+}
+
+/* Smallest table that holds n entries without growing, capped at the
+ * largest table; callers reject larger n first. */
+static unsigned __truk_map_buckets_for(unsigned n) {
+  unsigned nbuckets = __TRUK_MAP_GROUP_WIDTH;
+  while (__truk_map_growth_capacity(nbuckets) < n &&
+         nbuckets < __TRUK_MAP_MAX_BUCKETS) {
+    nbuckets <<= 1;
+  }
+  return nbuckets;
+}
+
+/* First allocation of the table: fixes the seed, the allocator and the
+ * slot layout. */
+static int __truk_map_prepare(__truk_map_base_t *m, unsigned nbuckets) {
+  __truk_map_seed_init();
+  m->allocator = __truk_runtime_sxs_current_allocator();
+  if (m->slotsize == 0) {
+    __truk_map_layout(m);
+  }
+  return __truk_map_resize(m, nbuckets);
+}
+
+int __truk_map_reserve_(__truk_map_base_t *m, unsigned long long count) {
+  unsigned nbuckets;
+  if (count > __truk_map_growth_capacity(__TRUK_MAP_MAX_BUCKETS)) {
+    return -1;
+  }
+  nbuckets = __truk_map_buckets_for((unsigned)count);
+  if (m->old_buckets) {
+    __truk_map_migrate(m, m->old_nbuckets);
+  }
+  if (m->nbuckets == 0) {
+    return __truk_map_prepare(m, nbuckets);
+  }
+  if (nbuckets <= m->nbuckets) {
+    return 0;
+  }
+  return __truk_map_resize(m, nbuckets);
+}
+
+int __truk_map_shrink_(__truk_map_base_t *m) {
+  unsigned nbuckets;
+  if (m->nbuckets == 0) {
+    return 0;
+  }
+  if (m->old_buckets) {
+    __truk_map_migrate(m, m->old_nbuckets);
+  }
+  if (m->nnodes == 0) {
+    __truk_runtime_sxs_free_with(m->allocator, m->buckets);
+    m->buckets = NULL;
+    m->ctrl = NULL;
+    m->nbuckets = 0;
+    m->growth_left = 0;
+    return 0;
+  }
+  /* Never larger than the current table, since that already holds nnodes.
+   * A same-size rehash is still worth it when it clears tombstones. */
+  nbuckets = __truk_map_buckets_for(m->nnodes);
+  if (nbuckets >= m->nbuckets &&
+      m->growth_left ==
+          __truk_map_growth_capacity(m->nbuckets) - m->nnodes) {
+    return 0;
+  }
+  return __truk_map_resize(m, nbuckets);
 }
 
 int __truk_map_set_(__truk_map_base_t *m, const void *key, void *value,
                     int vsize) {
-  int n, err;
-  __truk_map_node_t **next, *node;
-  next = __truk_map_getref(m, key);
-  if (next) {
-    memcpy((*next)->value, value, vsize);
+  unsigned long long hash;
+  unsigned i;
+  if (m->nbuckets == 0) {
+    if (m->slotsize == 0) {
+      m->vsize = vsize;
+    }
+    if (__truk_map_prepare(m, __TRUK_MAP_GROUP_WIDTH)) {
+      return -1;
+    }
+  }
+  hash = __truk_map_spread(m->hash_fn(key, m->ksize));
+  if (__truk_map_find(m, key, hash, &i)) {
+    memcpy(__truk_map_slot(m, i) + m->voffset, value, vsize);
     return 0;
   }
-  node = __truk_map_newnode(m, key, value, vsize);
-  if (node == NULL)
-    goto fail;
-  if (m->nnodes >= m->nbuckets) {
-    n = (m->nbuckets > 0) ? (m->nbuckets << 1) : 1;
-    err = __truk_map_resize(m, n);
-    if (err)
-      goto fail;
+  if (__truk_map_find_old(m, key, hash, &i)) {
+    memcpy(__truk_map_old_slot(m, i) + m->voffset, value, vsize);
+    return 0;
+  }
+  /* Only a new key moves entries, so updates keep pointers and iterators
+   * valid. */
+  if (m->old_buckets) {
+    __truk_map_migrate(m, __TRUK_MAP_MIGRATE_SLOTS);
   }
-  __truk_map_addnode(m, node);
+  i = __truk_map_find_free(m, hash);
+  if (m->growth_left == 0 && m->ctrl[i] == __TRUK_MAP_CTRL_EMPTY) {
+    /* Mostly tombstones: rehash in place instead of doubling. */
+    unsigned nbuckets = m->nbuckets;
+    if (m->nnodes >= __truk_map_growth_capacity(nbuckets) / 2) {
+      if (nbuckets == __TRUK_MAP_MAX_BUCKETS) {
+        return -1;
+      }
+      nbuckets <<= 1;
+    }
+    if (m->incremental) {
+      if (m->old_buckets) {
+        __truk_map_migrate(m, m->old_nbuckets);
+      }
+      if (__truk_map_begin_resize(m, nbuckets)) {
+        return -1;
+      }
+      __truk_map_migrate(m, __TRUK_MAP_MIGRATE_SLOTS);
+    } else if (__truk_map_resize(m, nbuckets)) {
+      return -1;
+    }
+    i = __truk_map_find_free(m, hash);
+  }
+  if (m->ctrl[i] == __TRUK_MAP_CTRL_EMPTY) {
+    m->growth_left--;
+  }
+  m->ctrl[i] = __truk_map_h2(hash);
+  memcpy(__truk_map_slot(m, i), key, m->ksize);
+  memcpy(__truk_map_slot(m, i) + m->voffset, value, vsize);
   m->nnodes++;
   return 0;
-fail:
-  if (node)
-    __truk_runtime_sxs_free(node);
-  return -1;
 }
 
 void __truk_map_remove_(__truk_map_base_t *m, const void *key) {
-  __truk_map_node_t *node;
-  __truk_map_node_t **next = __truk_map_getref(m, key);
-  if (next) {
-    node = *next;
-    *next = (*next)->next;
-    __truk_runtime_sxs_free(node);
-    m->nnodes--;
+  unsigned long long hash;
+  unsigned i;
+  if (m->nnodes == 0) {
+    return;
+  }
+  if (m->old_buckets) {
+    __truk_map_migrate(m, __TRUK_MAP_MIGRATE_SLOTS);
+  }
+  hash = __truk_map_spread(m->hash_fn(key, m->ksize));
+  if (!__truk_map_find(m, key, hash, &i)) {
+    if (__truk_map_find_old(m, key, hash, &i)) {
+      /* The old table is only ever probed, never inserted into, so a
+       * tombstone is always safe there. Its reservation is released. */
+      m->old_ctrl[i] = __TRUK_MAP_CTRL_DELETED;
+      m->old_nnodes--;
+      m->nnodes--;
+      m->growth_left++;
+    }
+    return;
+  }
+  /* A probe stops at a group with an empty slot, so the slot can only be
+   * emptied outright when its own group already has one. */
+  if (__truk_map_group_match_empty(m->ctrl + (i & ~(__TRUK_MAP_GROUP_WIDTH -
+                                                    1)))) {
+    m->ctrl[i] = __TRUK_MAP_CTRL_EMPTY;
+    m->growth_left++;
+  } else {
+    m->ctrl[i] = __TRUK_MAP_CTRL_DELETED;
   }
+  m->nnodes--;
 }
 
 __truk_map_iter_t __truk_map_iter_(void) {
   __truk_map_iter_t iter;
   iter.bucketidx = -1;
-  iter.node = NULL;
   return iter;
 }
 
 void *__truk_map_next_(__truk_map_base_t *m, __truk_map_iter_t *iter) {
-  if (iter->node) {
-    iter->node = iter->node->next;
-    if (iter->node == NULL)
-      goto nextBucket;
-  } else {
-  nextBucket:
-    do {
-      if (++iter->bucketidx >= m->nbuckets) {
-        return NULL;
-      }
-      iter->node = m->buckets[iter->bucketidx];
-    } while (iter->node == NULL);
+  /* Indices past the new table walk the old one during a migration. */
+  unsigned i = iter->bucketidx + 1;
+  while (i < m->nbuckets) {
+    if (m->ctrl[i] >= 0) {
+      iter->bucketidx = i;
+      return __truk_map_slot(m, i);
+    }
+    i++;
   }
-  return (void *)(iter->node + 1);
+  while (i - m->nbuckets < m->old_nbuckets) {
+    if (m->old_ctrl[i - m->nbuckets] >= 0) {
+      iter->bucketidx = i;
+      return __truk_map_old_slot(m, i - m->nbuckets);
+    }
+    i++;
+  }
+  iter->bucketidx = i - 1;
+  return NULL;
+}
+
+void *__truk_map_next_kv_(__truk_map_base_t *m, __truk_map_iter_t *iter,
+                          void **value) {
+  unsigned char *slot = (unsigned char *)__truk_map_next_(m, iter);
+  *value = slot ? slot + m->voffset : NULL;
+  return slot;
 }
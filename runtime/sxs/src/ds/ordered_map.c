@@ -0,0 +1,272 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sxs/ds/ordered_map.h>
+#include <sxs/runtime.h>
+
+/* Every entry starts with its full hash, so rebuilding the index never calls
+ * the hash function again, and a live flag that iteration checks. */
+typedef struct {
+  unsigned hash;
+  unsigned live;
+} __truk_ordered_map_header_t;
+
+/* Index slots hold an entry number plus two; 0 and 1 are free markers.
+ * Every slot in use or deleted corresponds to an entry in the dense array,
+ * so capping that array also caps the index load. */
+#define __TRUK_ORDERED_MAP_EMPTY 0u
+#define __TRUK_ORDERED_MAP_DELETED 1u
+#define __TRUK_ORDERED_MAP_MIN_SLOTS 8u
+
+static inline unsigned char *
+__truk_ordered_map_entry(__truk_ordered_map_base_t *m, unsigned i) {
+  return m->entries + (size_t)i * (size_t)m->entsize;
+}
+
+static inline unsigned char *__truk_ordered_map_key(unsigned char *entry) {
+  return entry + sizeof(__truk_ordered_map_header_t);
+}
+
+static inline unsigned __truk_ordered_map_start(unsigned hash, unsigned mask) {
+  return (hash ^ (hash >> 16)) & mask;
+}
+
+/* At most two thirds of the index is ever in use, which keeps linear
+ * probe sequences short. */
+static inline unsigned __truk_ordered_map_capacity_for(unsigned nslots) {
+  return nslots - nslots / 3;
+}
+
+static unsigned __truk_ordered_map_slots_for(unsigned n) {
+  unsigned nslots = __TRUK_ORDERED_MAP_MIN_SLOTS;
+  while (__truk_ordered_map_capacity_for(nslots) < n) {
+    nslots <<= 1;
+  }
+  return nslots;
+}
+
+static int __truk_ordered_map_align_of(int size) {
+  int align = size & -size;
+  if (align == 0) {
+    return 1;
+  }
+  return align > 8 ? 8 : align;
+}
+
+static void __truk_ordered_map_layout(__truk_ordered_map_base_t *m) {
+  int valign = __truk_ordered_map_align_of(m->vsize);
+  int kend = (int)sizeof(__truk_ordered_map_header_t) + m->ksize;
+  m->voffset = (kend + valign - 1) & ~(valign - 1);
+  m->entsize = (m->voffset + m->vsize + 7) & ~7;
+}
+
+static void __truk_ordered_map_link(__truk_ordered_map_base_t *m,
+                                    unsigned hash, unsigned entryidx) {
+  unsigned mask = m->nslots - 1;
+  unsigned s = __truk_ordered_map_start(hash, mask);
+  while (m->index[s] > __TRUK_ORDERED_MAP_DELETED) {
+    s = (s + 1) & mask;
+  }
+  m->index[s] = entryidx + 2;
+}
+
+/* Returns the index slot that refers to key, or -1. */
+static long __truk_ordered_map_find(__truk_ordered_map_base_t *m,
+                                    const void *key, unsigned hash) {
+  unsigned mask = m->nslots - 1;
+  unsigned s = __truk_ordered_map_start(hash, mask);
+  for (;;) {
+    unsigned v = m->index[s];
+    if (v == __TRUK_ORDERED_MAP_EMPTY) {
+      return -1;
+    }
+    if (v != __TRUK_ORDERED_MAP_DELETED) {
+      unsigned char *entry = __truk_ordered_map_entry(m, v - 2);
+      if (((__truk_ordered_map_header_t *)entry)->hash == hash &&
+          m->cmp_fn(__truk_ordered_map_key(entry), key, m->ksize) == 0) {
+        return (long)s;
+      }
+    }
+    s = (s + 1) & mask;
+  }
+}
+
+/* Moves the live entries, in order, into fresh arrays sized for nslots. The
+ * dense array and the index share one allocation. */
+static int __truk_ordered_map_rebuild(__truk_ordered_map_base_t *m,
+                                      unsigned nslots) {
+  unsigned capacity = __truk_ordered_map_capacity_for(nslots);
+  size_t entry_bytes = (size_t)capacity * (size_t)m->entsize;
+  unsigned char *mem = __truk_runtime_sxs_alloc_with(
+      m->allocator, entry_bytes + (size_t)nslots * sizeof(unsigned));
+  unsigned char *old_entries = m->entries;
+  unsigned old_nused = m->nused;
+  unsigned i;
+  if (!mem) {
+    return -1;
+  }
+  m->entries = mem;
+  m->index = (unsigned *)(mem + entry_bytes);
+  m->nslots = nslots;
+  m->capacity = capacity;
+  m->nused = 0;
+  memset(m->index, 0, (size_t)nslots * sizeof(unsigned));
+  for (i = 0; i < old_nused; i++) {
+    unsigned char *src = old_entries + (size_t)i * (size_t)m->entsize;
+    __truk_ordered_map_header_t *header = (__truk_ordered_map_header_t *)src;
+    if (header->live) {
+      memcpy(__truk_ordered_map_entry(m, m->nused), src, m->entsize);
+      __truk_ordered_map_link(m, header->hash, m->nused);
+      m->nused++;
+    }
+  }
+  __truk_runtime_sxs_free_with(m->allocator, old_entries);
+  return 0;
+}
+
+static int __truk_ordered_map_prepare(__truk_ordered_map_base_t *m,
+                                      unsigned nslots) {
+  __truk_map_seed_init();
+  m->allocator = __truk_runtime_sxs_current_allocator();
+  if (m->entsize == 0) {
+    __truk_ordered_map_layout(m);
+  }
+  return __truk_ordered_map_rebuild(m, nslots);
+}
+
+void __truk_ordered_map_deinit_(__truk_ordered_map_base_t *m) {
+  __truk_runtime_sxs_free_with(m->allocator, m->entries);
+}
+
+void *__truk_ordered_map_get_(__truk_ordered_map_base_t *m, const void *key) {
+  long s;
+  if (m->nnodes == 0) {
+    return NULL;
+  }
+  s = __truk_ordered_map_find(m, key, m->hash_fn(key, m->ksize));
+  if (s < 0) {
+    return NULL;
+  }
+  return __truk_ordered_map_entry(m, m->index[s] - 2) + m->voffset;
+}
+
+int __truk_ordered_map_set_(__truk_ordered_map_base_t *m, const void *key,
+                            void *value, int vsize) {
+  __truk_ordered_map_header_t *header;
+  unsigned char *entry;
+  unsigned hash;
+  long s;
+  if (m->nslots == 0) {
+    if (m->entsize == 0) {
+      m->vsize = vsize;
+    }
+    if (__truk_ordered_map_prepare(m, __TRUK_ORDERED_MAP_MIN_SLOTS)) {
+      return -1;
+    }
+  }
+  hash = m->hash_fn(key, m->ksize);
+  s = __truk_ordered_map_find(m, key, hash);
+  if (s >= 0) {
+    memcpy(__truk_ordered_map_entry(m, m->index[s] - 2) + m->voffset, value,
+           vsize);
+    return 0;
+  }
+  if (m->nused == m->capacity) {
+    /* Mostly holes: compact in place instead of doubling. */
+    unsigned nslots = m->nslots;
+    if (m->nnodes >= m->capacity / 2) {
+      nslots <<= 1;
+    }
+    if (__truk_ordered_map_rebuild(m, nslots)) {
+      return -1;
+    }
+  }
+  entry = __truk_ordered_map_entry(m, m->nused);
+  header = (__truk_ordered_map_header_t *)entry;
+  header->hash = hash;
+  header->live = 1;
+  memcpy(__truk_ordered_map_key(entry), key, m->ksize);
+  memcpy(entry + m->voffset, value, vsize);
+  __truk_ordered_map_link(m, hash, m->nused);
+  m->nused++;
+  m->nnodes++;
+  return 0;
+}
+
+void __truk_ordered_map_remove_(__truk_ordered_map_base_t *m,
+                                const void *key) {
+  long s;
+  if (m->nnodes == 0) {
+    return;
+  }
+  s = __truk_ordered_map_find(m, key, m->hash_fn(key, m->ksize));
+  if (s < 0) {
+    return;
+  }
+  ((__truk_ordered_map_header_t *)__truk_ordered_map_entry(m, m->index[s] - 2))
+      ->live = 0;
+  m->index[s] = __TRUK_ORDERED_MAP_DELETED;
+  m->nnodes--;
+}
+
+int __truk_ordered_map_reserve_(__truk_ordered_map_base_t *m,
+                                unsigned long long count) {
+  unsigned nslots;
+  if (count > 0x3fffffffULL) {
+    return -1;
+  }
+  nslots = __truk_ordered_map_slots_for((unsigned)count);
+  if (m->nslots == 0) {
+    return __truk_ordered_map_prepare(m, nslots);
+  }
+  if (nslots <= m->nslots) {
+    return 0;
+  }
+  return __truk_ordered_map_rebuild(m, nslots);
+}
+
+int __truk_ordered_map_shrink_(__truk_ordered_map_base_t *m) {
+  unsigned nslots;
+  if (m->nslots == 0) {
+    return 0;
+  }
+  if (m->nnodes == 0) {
+    __truk_runtime_sxs_free_with(m->allocator, m->entries);
+    m->entries = NULL;
+    m->index = NULL;
+    m->nslots = 0;
+    m->nused = 0;
+    m->capacity = 0;
+    return 0;
+  }
+  nslots = __truk_ordered_map_slots_for(m->nnodes);
+  if (nslots >= m->nslots && m->nused == m->nnodes) {
+    return 0;
+  }
+  return __truk_ordered_map_rebuild(m, nslots < m->nslots ? nslots
+                                                           : m->nslots);
+}
+
+__truk_ordered_map_iter_t __truk_ordered_map_iter_(void) {
+  __truk_ordered_map_iter_t iter;
+  iter.entryidx = 0;
+  return iter;
+}
+
+void *__truk_ordered_map_next_(__truk_ordered_map_base_t *m,
+                               __truk_ordered_map_iter_t *iter) {
+  while (iter->entryidx < m->nused) {
+    unsigned char *entry = __truk_ordered_map_entry(m, iter->entryidx++);
+    if (((__truk_ordered_map_header_t *)entry)->live) {
+      return __truk_ordered_map_key(entry);
+    }
+  }
+  return NULL;
+}
+
+void *__truk_ordered_map_next_kv_(__truk_ordered_map_base_t *m,
+                                  __truk_ordered_map_iter_t *iter,
+                                  void **value) {
+  unsigned char *key = (unsigned char *)__truk_ordered_map_next_(m, iter);
+  *value = key ? key - sizeof(__truk_ordered_map_header_t) + m->voffset : NULL;
+  return key;
+}
@@ -0,0 +1,631 @@
+#include <stddef.h>
+#include <sxs/bytes.h>
+#include <sxs/ds/scanner.h>
+
+/*
+ * The group scanner is dominated by runs of content between delimiters, so
+ * it classifies a whole block at a time: one compare per interesting byte
+ * (open, close, escape) gives a bit mask, and only the set bits are walked
+ * in scalar code. A block without escapes whose closers cannot bring the
+ * depth to zero is skipped with popcounts, so plain content and deep runs
+ * of nesting both cost a few instructions per 16 or 32 bytes. AVX2 is
+ * picked at run time as in bytes.c.
+ *
+ * Tokens are usually shorter than a block, so the static-type machine reads
+ * one whole from a single SSE2 block where it can (see
+ * __truk_scanner_static_block) and otherwise runs byte by byte, handing
+ * long symbols to __truk_bytes_find_any.
+ */
+#if defined(__SSE2__) && !defined(__TINYC__)
+#  include <emmintrin.h>
+#define __TRUK_SCANNER_SSE2 1
+#endif
+
+#if defined(__TRUK_SCANNER_SSE2) && defined(__x86_64__) && defined(__GNUC__)
+#  include <immintrin.h>
+#define __TRUK_SCANNER_AVX2 1
+#define __TRUK_SCANNER_TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#endif
+
+/* Symbols shorter than this are finished without calling into bytes.c. */
+#define __TRUK_SCANNER_SHORT_SYMBOL 32
+
+/* Space, tab, newline and carriage return are all below 64. */
+#define __TRUK_SCANNER_WS_BITS                                                 \
+  ((1ULL << ' ') | (1ULL << '\t') | (1ULL << '\n') | (1ULL << '\r'))
+
+enum {
+  __TRUK_SCANNER_ST_START,
+  __TRUK_SCANNER_ST_SIGN,
+  __TRUK_SCANNER_ST_INTEGER,
+  __TRUK_SCANNER_ST_DOT,
+  __TRUK_SCANNER_ST_REAL,
+  __TRUK_SCANNER_ST_SYMBOL
+};
+
+static inline __truk_bool __truk_scanner_is_ws(__truk_u8 c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline __truk_bool __truk_scanner_is_digit(__truk_u8 c) {
+  return (__truk_u8)(c - '0') < 10;
+}
+
+/* Handles an open, close or escape byte at chunk index i; returns true when
+ * it closes the group. *skip is one past an escaped byte, which is ignored
+ * whatever it is. */
+static inline __truk_bool
+__truk_scanner_group_visit(__truk_scanner_group_stream_t *stream, __truk_u8 c,
+                           __truk_u64 i, __truk_u64 *skip) {
+  if (i < *skip) {
+    return false;
+  }
+  if ((__truk_i32)c == stream->escape) {
+    *skip = i + 2;
+    return false;
+  }
+  if (c == stream->close) {
+    return --stream->depth == 0;
+  }
+  if (c == stream->open) {
+    stream->depth++;
+  }
+  return false;
+}
+
+static __truk_u64
+__truk_scanner_group_scan_scalar(__truk_scanner_group_stream_t *stream,
+                                 const __truk_u8 *data, __truk_u64 i,
+                                 __truk_u64 len, __truk_u64 *skip) {
+  for (; i < len; i++) {
+    __truk_u8 c = data[i];
+    if ((c == stream->open || c == stream->close ||
+         (__truk_i32)c == stream->escape) &&
+        __truk_scanner_group_visit(stream, c, i, skip)) {
+      return i;
+    }
+  }
+  return len;
+}
+
+#if defined(__TRUK_SCANNER_SSE2)
+static __truk_u64
+__truk_scanner_group_scan_sse2(__truk_scanner_group_stream_t *stream,
+                               const __truk_u8 *data, __truk_u64 i,
+                               __truk_u64 len, __truk_u64 *skip) {
+  const __m128i open = _mm_set1_epi8((char)stream->open);
+  const __m128i close = _mm_set1_epi8((char)stream->close);
+  const __m128i escape = _mm_set1_epi8((char)stream->escape);
+  for (; i + 16 <= len; i += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+    unsigned opens = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, open));
+    unsigned closes =
+        (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, close));
+    unsigned escapes =
+        stream->escape < 0
+            ? 0
+            : (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, escape));
+    unsigned mask = opens | closes | escapes;
+    if (!escapes && *skip <= i &&
+        stream->depth > (__truk_u64)__builtin_popcount(closes)) {
+      stream->depth = stream->depth + (__truk_u64)__builtin_popcount(opens) -
+                      (__truk_u64)__builtin_popcount(closes);
+      continue;
+    }
+    while (mask) {
+      __truk_u64 at = i + (__truk_u64)__builtin_ctz(mask);
+      if (__truk_scanner_group_visit(stream, data[at], at, skip)) {
+        return at;
+      }
+      mask &= mask - 1;
+    }
+  }
+  return __truk_scanner_group_scan_scalar(stream, data, i, len, skip);
+}
+#endif
+
+#if defined(__TRUK_SCANNER_AVX2)
+__TRUK_SCANNER_TARGET_AVX2
+static __truk_u64
+__truk_scanner_group_scan_avx2(__truk_scanner_group_stream_t *stream,
+                               const __truk_u8 *data, __truk_u64 i,
+                               __truk_u64 len, __truk_u64 *skip) {
+  const __m256i open = _mm256_set1_epi8((char)stream->open);
+  const __m256i close = _mm256_set1_epi8((char)stream->close);
+  const __m256i escape = _mm256_set1_epi8((char)stream->escape);
+  for (; i + 32 <= len; i += 32) {
+    __m256i block = _mm256_loadu_si256((const __m256i *)(data + i));
+    unsigned opens =
+        (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, open));
+    unsigned closes =
+        (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, close));
+    unsigned escapes =
+        stream->escape < 0
+            ? 0
+            : (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, escape));
+    unsigned mask = opens | closes | escapes;
+    if (!escapes && *skip <= i &&
+        stream->depth > (__truk_u64)__builtin_popcount(closes)) {
+      stream->depth = stream->depth + (__truk_u64)__builtin_popcount(opens) -
+                      (__truk_u64)__builtin_popcount(closes);
+      continue;
+    }
+    while (mask) {
+      __truk_u64 at = i + (__truk_u64)__builtin_ctz(mask);
+      if (__truk_scanner_group_visit(stream, data[at], at, skip)) {
+        return at;
+      }
+      mask &= mask - 1;
+    }
+  }
+  _mm256_zeroupper();
+  return __truk_scanner_group_scan_sse2(stream, data, i, len, skip);
+}
+#endif
+
+/* Index of the byte that closes the group, or len. */
+static __truk_u64
+__truk_scanner_group_scan(__truk_scanner_group_stream_t *stream,
+                          const __truk_u8 *data, __truk_u64 i, __truk_u64 len,
+                          __truk_u64 *skip) {
+#if defined(__TRUK_SCANNER_AVX2)
+  if (__builtin_cpu_supports("avx2")) {
+    return __truk_scanner_group_scan_avx2(stream, data, i, len, skip);
+  }
+#endif
+#if defined(__TRUK_SCANNER_SSE2)
+  return __truk_scanner_group_scan_sse2(stream, data, i, len, skip);
+#else
+  return __truk_scanner_group_scan_scalar(stream, data, i, len, skip);
+#endif
+}
+
+void __truk_scanner_group_begin(__truk_scanner_group_stream_t *stream,
+                                __truk_u8 open, __truk_u8 close,
+                                __truk_i32 escape,
+                                __truk_bool consume_leading_ws) {
+  stream->open = open;
+  stream->close = close;
+  stream->escape = escape;
+  stream->consume_leading_ws = consume_leading_ws;
+  stream->escaped = false;
+  stream->depth = 0;
+  stream->offset = 0;
+  stream->start = 0;
+  stream->end = 0;
+}
+
+__truk_scanner_status_e
+__truk_scanner_group_feed(__truk_scanner_group_stream_t *stream,
+                          const __truk_u8 *chunk, __truk_u64 len,
+                          __truk_u64 *used) {
+  __truk_u64 i = 0;
+  __truk_u64 skip;
+  __truk_u64 end;
+
+  if (stream->escape == (__truk_i32)stream->open ||
+      stream->escape == (__truk_i32)stream->close) {
+    *used = 0;
+    return __TRUK_SCANNER_FAIL;
+  }
+
+  if (stream->depth == 0) {
+    if (stream->consume_leading_ws) {
+      while (i < len && __truk_scanner_is_ws(chunk[i])) {
+        i++;
+      }
+    }
+    if (i == len) {
+      stream->offset += len;
+      *used = len;
+      return __TRUK_SCANNER_MORE;
+    }
+    if (chunk[i] != stream->open) {
+      stream->offset += i;
+      *used = i;
+      return __TRUK_SCANNER_FAIL;
+    }
+    stream->start = stream->offset + i;
+    stream->depth = 1;
+    stream->escaped = false;
+    i++;
+  }
+
+  skip = stream->escaped ? i + 1 : 0;
+  end = __truk_scanner_group_scan(stream, chunk, i, len, &skip);
+  if (end == len) {
+    stream->escaped = skip > len;
+    stream->offset += len;
+    *used = len;
+    return __TRUK_SCANNER_MORE;
+  }
+
+  stream->end = stream->offset + end;
+  stream->offset += end + 1;
+  *used = end + 1;
+  return __TRUK_SCANNER_DONE;
+}
+
+/* Whitespace and stop symbols, as a 256-bit set so each byte costs one
+ * lookup however many stop symbols there are. Built on first use: tokens
+ * the block path reads whole never need it. The whitespace bits make a
+ * built set nonzero. */
+static void
+__truk_scanner_static_prepare(__truk_scanner_static_stream_t *stream) {
+  __truk_u64 bits[4] = {__TRUK_SCANNER_WS_BITS, 0, 0, 0};
+  __truk_u64 k;
+  if (stream->terminator_bits[0]) {
+    return;
+  }
+  for (k = 0; k < stream->stop_count; k++) {
+    bits[stream->stops[k] >> 6] |= 1ULL << (stream->stops[k] & 63);
+  }
+  for (k = 0; k < 4; k++) {
+    stream->terminator_bits[k] = bits[k];
+  }
+}
+
+static inline __truk_bool
+__truk_scanner_is_terminator(const __truk_scanner_static_stream_t *stream,
+                             __truk_u8 c) {
+  return (stream->terminator_bits[c >> 6] >> (c & 63)) & 1;
+}
+
+/* Index of the first terminator at or after i, or len. */
+static __truk_u64
+__truk_scanner_symbol_end(const __truk_scanner_static_stream_t *stream,
+                          const __truk_u8 *chunk, __truk_u64 i,
+                          __truk_u64 len) {
+  __truk_u8 set[16];
+  __truk_u64 k;
+  __truk_u64 limit = len - i > __TRUK_SCANNER_SHORT_SYMBOL
+                         ? i + __TRUK_SCANNER_SHORT_SYMBOL
+                         : len;
+  for (; i < limit; i++) {
+    if (__truk_scanner_is_terminator(stream, chunk[i])) {
+      return i;
+    }
+  }
+  if (len - i >= __TRUK_SCANNER_SHORT_SYMBOL &&
+      stream->stop_count <= sizeof(set) - 4) {
+    set[0] = ' ';
+    set[1] = '\t';
+    set[2] = '\n';
+    set[3] = '\r';
+    for (k = 0; k < stream->stop_count; k++) {
+      set[4 + k] = stream->stops[k];
+    }
+    return i + __truk_bytes_find_any(chunk + i, len - i, set,
+                                     4 + stream->stop_count);
+  }
+  for (; i < len; i++) {
+    if (__truk_scanner_is_terminator(stream, chunk[i])) {
+      return i;
+    }
+  }
+  return len;
+}
+
+static __truk_scanner_status_e
+__truk_scanner_static_stop(__truk_scanner_static_stream_t *stream,
+                           __truk_u64 i, __truk_u64 *used,
+                           __truk_scanner_status_e status) {
+  stream->state = __TRUK_SCANNER_ST_START;
+  stream->offset += i;
+  *used = i;
+  return status;
+}
+
+static __truk_scanner_status_e
+__truk_scanner_static_error(__truk_scanner_static_stream_t *stream,
+                            __truk_u64 i, __truk_u64 *used) {
+  stream->type = stream->state == __TRUK_SCANNER_ST_REAL
+                     ? __TRUK_SCANNER_REAL
+                     : __TRUK_SCANNER_INTEGER;
+  stream->error = stream->offset + i;
+  return __truk_scanner_static_stop(stream, i, used, __TRUK_SCANNER_FAIL);
+}
+
+/* A stop symbol at chunk index i, where a token should have started. */
+static __truk_scanner_status_e
+__truk_scanner_static_no_token(__truk_scanner_static_stream_t *stream,
+                               __truk_u64 i, __truk_u64 *used) {
+  stream->type = __TRUK_SCANNER_NONE;
+  stream->start = stream->offset + i;
+  stream->error = stream->start;
+  return __truk_scanner_static_stop(stream, i, used, __TRUK_SCANNER_FAIL);
+}
+
+/* The token ends just before chunk index i. */
+static __truk_scanner_status_e
+__truk_scanner_static_complete(__truk_scanner_static_stream_t *stream,
+                               __truk_u64 i, __truk_u64 *used) {
+  switch (stream->state) {
+  case __TRUK_SCANNER_ST_DOT:
+    return __truk_scanner_static_error(stream, i, used);
+  case __TRUK_SCANNER_ST_INTEGER:
+    stream->type = __TRUK_SCANNER_INTEGER;
+    break;
+  case __TRUK_SCANNER_ST_REAL:
+    stream->type = __TRUK_SCANNER_REAL;
+    break;
+  default:
+    stream->type = __TRUK_SCANNER_SYMBOL;
+    break;
+  }
+  stream->length = stream->offset + i - stream->start;
+  return __truk_scanner_static_stop(stream, i, used, __TRUK_SCANNER_DONE);
+}
+
+#if defined(__TRUK_SCANNER_SSE2)
+/* Reads a token that starts at chunk[i] and ends within the next 16 bytes
+ * from one block: bit masks of terminators, digits and dots give its length
+ * and type, or the first byte that breaks a number, without walking it.
+ * Returns MORE when the token runs past the block; the byte loop takes it. */
+static __truk_scanner_status_e
+__truk_scanner_static_block(__truk_scanner_static_stream_t *stream,
+                            const __truk_u8 *chunk, __truk_u64 i,
+                            __truk_u64 *used) {
+  const __m128i block = _mm_loadu_si128((const __m128i *)(chunk + i));
+  const __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8('0'));
+  __m128i term = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')),
+                   _mm_cmpeq_epi8(block, _mm_set1_epi8('\t'))),
+      _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')),
+                   _mm_cmpeq_epi8(block, _mm_set1_epi8('\r'))));
+  unsigned tmask, digits, bad, sign, first, second;
+  __truk_u64 k;
+  for (k = 0; k < stream->stop_count; k++) {
+    term = _mm_or_si128(
+        term, _mm_cmpeq_epi8(block, _mm_set1_epi8((char)stream->stops[k])));
+  }
+  tmask = (unsigned)_mm_movemask_epi8(term);
+  if (!tmask) {
+    return __TRUK_SCANNER_MORE;
+  }
+  tmask = (unsigned)__builtin_ctz(tmask);
+  if (tmask == 0) {
+    return __truk_scanner_static_no_token(stream, i, used);
+  }
+
+  sign = chunk[i] == '+' || chunk[i] == '-';
+  if (sign == tmask || !__truk_scanner_is_digit(chunk[i + sign])) {
+    stream->state = __TRUK_SCANNER_ST_SYMBOL;
+    return __truk_scanner_static_complete(stream, i + tmask, used);
+  }
+
+  digits = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(
+      _mm_min_epu8(shifted, _mm_set1_epi8(9)), shifted));
+  bad = ((1u << tmask) - 1) & ~digits & ~sign;
+  if (!bad) {
+    stream->state = __TRUK_SCANNER_ST_INTEGER;
+    return __truk_scanner_static_complete(stream, i + tmask, used);
+  }
+  first = (unsigned)__builtin_ctz(bad);
+  stream->state = __TRUK_SCANNER_ST_INTEGER;
+  if (chunk[i + first] != '.') {
+    return __truk_scanner_static_error(stream, i + first, used);
+  }
+  bad &= bad - 1;
+  if (!bad) {
+    stream->state = first + 1 == tmask ? __TRUK_SCANNER_ST_DOT
+                                       : __TRUK_SCANNER_ST_REAL;
+    return __truk_scanner_static_complete(stream, i + tmask, used);
+  }
+  second = (unsigned)__builtin_ctz(bad);
+  stream->state = second == first + 1 ? __TRUK_SCANNER_ST_DOT
+                                      : __TRUK_SCANNER_ST_REAL;
+  return __truk_scanner_static_error(stream, i + second, used);
+}
+#endif
+
+void __truk_scanner_static_begin(__truk_scanner_static_stream_t *stream,
+                                 const __truk_u8 *stops,
+                                 __truk_u64 stop_count) {
+  stream->terminator_bits[0] = 0;
+  stream->stops = stops;
+  stream->stop_count = stops ? stop_count : 0;
+  stream->state = __TRUK_SCANNER_ST_START;
+  stream->type = __TRUK_SCANNER_NONE;
+  stream->offset = 0;
+  stream->start = 0;
+  stream->length = 0;
+  stream->error = 0;
+}
+
+__truk_scanner_status_e
+__truk_scanner_static_feed(__truk_scanner_static_stream_t *stream,
+                           const __truk_u8 *chunk, __truk_u64 len,
+                           __truk_u64 *used) {
+  __truk_u64 i = 0;
+
+  if (stream->state == __TRUK_SCANNER_ST_START) {
+    __truk_u8 c;
+    while (i < len && __truk_scanner_is_ws(chunk[i])) {
+      i++;
+    }
+    if (i == len) {
+      stream->offset += len;
+      *used = len;
+      return __TRUK_SCANNER_MORE;
+    }
+    stream->start = stream->offset + i;
+#if defined(__TRUK_SCANNER_SSE2)
+    if (len - i >= 16 && stream->stop_count <= 12) {
+      __truk_scanner_status_e status =
+          __truk_scanner_static_block(stream, chunk, i, used);
+      if (status != __TRUK_SCANNER_MORE) {
+        return status;
+      }
+    }
+#endif
+    __truk_scanner_static_prepare(stream);
+    c = chunk[i];
+    if (__truk_scanner_is_terminator(stream, c)) {
+      return __truk_scanner_static_no_token(stream, i, used);
+    }
+    stream->state = c == '+' || c == '-'     ? __TRUK_SCANNER_ST_SIGN
+                    : __truk_scanner_is_digit(c) ? __TRUK_SCANNER_ST_INTEGER
+                                               : __TRUK_SCANNER_ST_SYMBOL;
+    i++;
+  } else {
+    __truk_scanner_static_prepare(stream);
+  }
+
+  while (i < len) {
+    __truk_u8 c = chunk[i];
+    switch (stream->state) {
+    case __TRUK_SCANNER_ST_INTEGER:
+    case __TRUK_SCANNER_ST_REAL:
+      while (i < len && __truk_scanner_is_digit(chunk[i])) {
+        i++;
+      }
+      if (i == len) {
+        break;
+      }
+      c = chunk[i];
+      if (__truk_scanner_is_terminator(stream, c)) {
+        return __truk_scanner_static_complete(stream, i, used);
+      }
+      if (c != '.' || stream->state == __TRUK_SCANNER_ST_REAL) {
+        return __truk_scanner_static_error(stream, i, used);
+      }
+      stream->state = __TRUK_SCANNER_ST_DOT;
+      i++;
+      break;
+    case __TRUK_SCANNER_ST_DOT:
+      if (!__truk_scanner_is_digit(c)) {
+        return __truk_scanner_static_error(stream, i, used);
+      }
+      stream->state = __TRUK_SCANNER_ST_REAL;
+      i++;
+      break;
+    case __TRUK_SCANNER_ST_SIGN:
+      if (__truk_scanner_is_terminator(stream, c)) {
+        return __truk_scanner_static_complete(stream, i, used);
+      }
+      stream->state = __truk_scanner_is_digit(c) ? __TRUK_SCANNER_ST_INTEGER
+                                                 : __TRUK_SCANNER_ST_SYMBOL;
+      i++;
+      break;
+    default:
+      i = __truk_scanner_symbol_end(stream, chunk, i, len);
+      if (i < len) {
+        return __truk_scanner_static_complete(stream, i, used);
+      }
+      break;
+    }
+  }
+
+  stream->offset += len;
+  *used = len;
+  return __TRUK_SCANNER_MORE;
+}
+
+__truk_scanner_status_e
+__truk_scanner_static_finish(__truk_scanner_static_stream_t *stream) {
+  __truk_u64 used;
+  if (stream->state == __TRUK_SCANNER_ST_START) {
+    stream->type = __TRUK_SCANNER_NONE;
+    return __TRUK_SCANNER_END;
+  }
+  return __truk_scanner_static_complete(stream, 0, &used);
+}
+
+__truk_scanner_group_t
+__truk_scanner_find_group(__truk_scanner_t *scanner, __truk_u8 open,
+                          __truk_u8 close, __truk_i32 escape,
+                          __truk_bool consume_leading_ws) {
+  __truk_scanner_group_t result = {false, 0, 0};
+  __truk_scanner_group_stream_t stream;
+  __truk_u64 used;
+
+  if (!scanner || !scanner->buffer || scanner->position >= scanner->count) {
+    return result;
+  }
+  __truk_scanner_group_begin(&stream, open, close, escape,
+                             consume_leading_ws);
+  if (__truk_scanner_group_feed(&stream, scanner->buffer + scanner->position,
+                                scanner->count - scanner->position,
+                                &used) != __TRUK_SCANNER_DONE) {
+    return result;
+  }
+
+  result.success = true;
+  result.index_of_start_symbol = scanner->position + stream.start;
+  result.index_of_closing_symbol = scanner->position + stream.end;
+  scanner->position = result.index_of_closing_symbol;
+  return result;
+}
+
+__truk_scanner_static_t
+__truk_scanner_read_static(__truk_scanner_t *scanner,
+                           const __truk_u8 *stops, __truk_u64 stop_count) {
+  __truk_scanner_static_t result = {false, __TRUK_SCANNER_NONE, NULL, 0, 0, 0};
+  __truk_scanner_static_stream_t stream;
+  __truk_scanner_status_e status;
+  __truk_u64 base, used;
+
+  if (!scanner) {
+    return result;
+  }
+  if (!scanner->buffer || scanner->position >= scanner->count) {
+    result.start_position = scanner->count;
+    result.error_position = scanner->count;
+    return result;
+  }
+
+  base = scanner->position;
+  __truk_scanner_static_begin(&stream, stops, stop_count);
+  status = __truk_scanner_static_feed(&stream, scanner->buffer + base,
+                                      scanner->count - base, &used);
+  if (status == __TRUK_SCANNER_MORE) {
+    status = __truk_scanner_static_finish(&stream);
+  }
+
+  switch (status) {
+  case __TRUK_SCANNER_DONE:
+    result.success = true;
+    result.type = stream.type;
+    result.data = scanner->buffer + base + stream.start;
+    result.byte_length = stream.length;
+    result.start_position = base + stream.start;
+    scanner->position = result.start_position + stream.length;
+    break;
+  case __TRUK_SCANNER_FAIL:
+    result.type = stream.type;
+    result.start_position = base + stream.start;
+    result.error_position = base + stream.error;
+    break;
+  default:
+    result.start_position = scanner->count;
+    result.error_position = scanner->count;
+    break;
+  }
+  return result;
+}
+
+__truk_u64 __truk_scan_group(const __truk_u8 *data, __truk_u64 len,
+                             __truk_u64 at, __truk_u8 open, __truk_u8 close,
+                             __truk_i32 escape) {
+  __truk_scanner_t scanner = {data, len, at};
+  __truk_scanner_group_t group =
+      __truk_scanner_find_group(&scanner, open, close, escape, false);
+  return group.success ? group.index_of_closing_symbol : len;
+}
+
+__truk_i32 __truk_scan_token(const __truk_u8 *data, __truk_u64 len,
+                             __truk_u64 at, const __truk_u8 *stops,
+                             __truk_u64 stop_count, __truk_u64 *start,
+                             __truk_u64 *end) {
+  __truk_scanner_t scanner = {data, len, at};
+  __truk_scanner_static_t token =
+      __truk_scanner_read_static(&scanner, stops, stop_count);
+  *start = token.start_position;
+  if (token.success) {
+    *end = token.start_position + token.byte_length;
+    return (__truk_i32)token.type;
+  }
+  *end = token.error_position;
+  return token.type == __TRUK_SCANNER_NONE ? 0 : -1;
+}
@@ -1,13 +1,158 @@
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sxs/runtime.h>
 
+__truk_allocator_t *__truk_runtime_sxs_program_allocator = NULL;
+__TRUK_THREAD_LOCAL __truk_allocator_t *__truk_runtime_sxs_thread_allocator =
+    NULL;
+
+__truk_allocator_t *
+__truk_runtime_sxs_set_program_allocator(__truk_allocator_t *allocator) {
+  __truk_allocator_t *previous = __truk_runtime_sxs_program_allocator;
+  __truk_runtime_sxs_program_allocator = allocator;
+  return previous;
+}
+
+__truk_allocator_t *
+__truk_runtime_sxs_set_thread_allocator(__truk_allocator_t *allocator) {
+  __truk_allocator_t *previous = __truk_runtime_sxs_thread_allocator;
+  __truk_runtime_sxs_thread_allocator = allocator;
+  return previous;
+}
+
+#if !defined(__TINYC__)
+__thread __truk_object_cache_t __truk_runtime_sxs_object_cache;
+#endif
+
+static pthread_once_t __truk_object_cache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t __truk_object_cache_key;
+
+static __truk_void __truk_object_cache_flush(__truk_object_cache_t *cache) {
+  __truk_u64 cls;
+  for (cls = 0; cls < __TRUK_OBJECT_CLASSES; cls++) {
+    __truk_void *ptr = cache->head[cls];
+    while (ptr) {
+      __truk_void *next = *(__truk_void **)ptr;
+      free(ptr);
+      ptr = next;
+    }
+    cache->head[cls] = NULL;
+    cache->count[cls] = 0;
+  }
+  cache->registered = 0;
+}
+
+/* Thread exit. Under TCC the cache itself was heap allocated. */
+static void __truk_object_cache_exit(void *arg) {
+  __truk_object_cache_flush((__truk_object_cache_t *)arg);
+#if defined(__TINYC__)
+  free(arg);
+#endif
+}
+
+static void __truk_object_cache_init(void) {
+  pthread_key_create(&__truk_object_cache_key, __truk_object_cache_exit);
+}
+
+#if defined(__TINYC__)
+__truk_object_cache_t *__truk_runtime_sxs_object_cache_get(void) {
+  __truk_object_cache_t *cache;
+  pthread_once(&__truk_object_cache_once, __truk_object_cache_init);
+  cache = (__truk_object_cache_t *)pthread_getspecific(__truk_object_cache_key);
+  if (!cache) {
+    cache = (__truk_object_cache_t *)calloc(1, sizeof(*cache));
+    if (!cache) {
+      static const char msg[] = "out of memory creating object cache";
+      __truk_runtime_sxs_panic(msg, sizeof(msg) - 1);
+    }
+    cache->registered = 1;
+    pthread_setspecific(__truk_object_cache_key, cache);
+  }
+  return cache;
+}
+#endif
+
+__truk_void __truk_runtime_sxs_object_release(__truk_object_cache_t *cache,
+                                              __truk_void *ptr,
+                                              __truk_u64 cls) {
+  if (!cache->registered) {
+    pthread_once(&__truk_object_cache_once, __truk_object_cache_init);
+    pthread_setspecific(__truk_object_cache_key, cache);
+    cache->registered = 1;
+  }
+  if ((cache->count[cls] + 1) * (cls + 1) > __TRUK_OBJECT_CACHE_UNITS) {
+    /* Keep the most recently freed half, which is likeliest to be warm. */
+    __truk_u32 keep = cache->count[cls] / 2;
+    __truk_void *last = cache->head[cls];
+    __truk_void *rest;
+    __truk_u32 i;
+    for (i = 1; i < keep; i++) {
+      last = *(__truk_void **)last;
+    }
+    rest = *(__truk_void **)last;
+    *(__truk_void **)last = NULL;
+    cache->count[cls] = keep;
+    while (rest) {
+      __truk_void *next = *(__truk_void **)rest;
+      free(rest);
+      rest = next;
+    }
+  }
+  *(__truk_void **)ptr = cache->head[cls];
+  cache->head[cls] = ptr;
+  cache->count[cls]++;
+}
+
 __truk_void __truk_runtime_sxs_panic(const char *msg, __truk_u64 len) {
   fprintf(stderr, "panic: %.*s\n", (int)len, msg);
   exit(1);
 }
 
+__truk_void __truk_runtime_sxs_bounds_fail(__truk_u64 idx, __truk_u64 len) {
+  fprintf(stderr, "panic: index out of bounds: %llu >= %llu\n",
+          (unsigned long long)idx, (unsigned long long)len);
+  exit(1);
+}
+
+__truk_void __truk_runtime_sxs_range_fail(__truk_u64 lo, __truk_u64 hi,
+                                          __truk_u64 len) {
+  fprintf(stderr, "panic: slice range out of bounds: [%llu..%llu] of %llu\n",
+          (unsigned long long)lo, (unsigned long long)hi,
+          (unsigned long long)len);
+  exit(1);
+}
+
+__truk_void *__truk_runtime_sxs_vec_resize(__truk_void *data, __truk_u64 len,
+                                           __truk_u64 elem_size,
+                                           __truk_u64 cap) {
+  __truk_allocator_t *allocator = __truk_runtime_sxs_current_allocator();
+  __truk_void *resized;
+#if !defined(TRUK_TRACK_ALLOCS)
+  /* Tracked builds grow through alloc_with so the new block is recorded. */
+  if (!allocator) {
+    resized = realloc(data, elem_size * cap);
+  } else
+#endif
+  {
+    resized = __truk_runtime_sxs_alloc_with(allocator, elem_size * cap);
+    if (resized && len) {
+      memcpy(resized, data, elem_size * len);
+    }
+    __truk_runtime_sxs_free_with(allocator, data);
+  }
+  if (!resized && cap) {
+    static const char msg[] = "out of memory growing vec";
+    __truk_runtime_sxs_panic(msg, sizeof(msg) - 1);
+  }
+  return resized;
+}
+
 __truk_i32 __truk_runtime_sxs_start(__truk_runtime_sxs_target_app_s *app) {
+#if defined(TRUK_TRACK_ALLOCS)
+  __truk_runtime_sxs_track_start();
+#endif
   if (app->has_args) {
     __truk_runtime_sxs_entry_fn_with_args entry =
         (__truk_runtime_sxs_entry_fn_with_args)app->entry_fn;
@@ -1,5 +1,6 @@
 #include <string.h>
 #include <sxs/test.h>
+#include <time.h>
 
 __truk_void __truk_test_fail(__truk_test_context_s *t, const char *msg) {
   t->has_failed = 1;
@@ -283,3 +284,41 @@ __truk_void __truk_test_assert_bytes_eq(__truk_test_context_s *t,
 __truk_i32 __truk_test_get_argc(__truk_test_context_s *t) { return t->argc; }
 
 char **__truk_test_get_argv(__truk_test_context_s *t) { return t->argv; }
+
+static __truk_u64 __truk_test_clock_ns(clockid_t clock) {
+  struct timespec ts;
+  if (clock_gettime(clock, &ts) != 0) {
+    return 0;
+  }
+  return (__truk_u64)ts.tv_sec * 1000000000ULL + (__truk_u64)ts.tv_nsec;
+}
+
+__truk_void __truk_test_begin(__truk_test_context_s *t) {
+  t->wall_ns = 0;
+  t->cpu_ns = 0;
+  t->started_cpu_ns = __truk_test_clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+  t->started_ns = __truk_test_clock_ns(CLOCK_MONOTONIC);
+}
+
+__truk_void __truk_test_end(__truk_test_context_s *t) {
+  t->wall_ns = __truk_test_clock_ns(CLOCK_MONOTONIC) - t->started_ns;
+  t->cpu_ns =
+      __truk_test_clock_ns(CLOCK_PROCESS_CPUTIME_ID) - t->started_cpu_ns;
+}
+
+__truk_void __truk_test_record(const __truk_test_context_s *t,
+                               const char *status) {
+  const char *path = getenv("TRUK_TEST_REPORT");
+  FILE *out;
+  if (!path || !*path) {
+    return;
+  }
+  out = fopen(path, "a");
+  if (!out) {
+    return;
+  }
+  fprintf(out, "%s\t%s\t%d\t%d\t%llu\t%llu\n", status,
+          t->current_test_name, t->passed, t->failed,
+          (unsigned long long)t->wall_ns, (unsigned long long)t->cpu_ns);
+  fclose(out);
+}
@@ -0,0 +1,297 @@
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sxs/test.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* What a test process sends back before it exits. */
+typedef struct {
+  __truk_i32 passed;
+  __truk_i32 failed;
+  __truk_bool has_failed;
+} __truk_test_outcome_t;
+
+enum { __TRUK_TEST_PENDING, __TRUK_TEST_RUNNING, __TRUK_TEST_DONE };
+
+typedef struct {
+  pid_t pid;
+  int result_fd;
+  FILE *output;
+  __truk_u64 start_ns;
+  __truk_u64 elapsed_ns;
+  __truk_u64 cpu_ns;
+  int state;
+  int status;
+  int start_errno;
+  __truk_bool reported;
+  __truk_bool timed_out;
+  __truk_test_outcome_t outcome;
+} __truk_test_job_t;
+
+static __truk_u64 __truk_test_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (__truk_u64)ts.tv_sec * 1000000000ULL + (__truk_u64)ts.tv_nsec;
+}
+
+/* Child side: one test, with stdout and stderr both going to output_fd
+ * unbuffered so they interleave as they were written. Never returns. */
+static void __truk_test_child(const __truk_test_case_s *test,
+                              const __truk_test_runner_s *runner,
+                              __truk_i32 argc, char **argv, int output_fd,
+                              int result_fd) {
+  __truk_test_context_s ctx;
+  __truk_test_outcome_t outcome;
+  ssize_t written;
+
+  dup2(output_fd, STDOUT_FILENO);
+  dup2(output_fd, STDERR_FILENO);
+  setvbuf(stdout, NULL, _IONBF, 0);
+
+  memset(&ctx, 0, sizeof(ctx));
+  ctx.current_test_name = test->name;
+  ctx.argc = argc;
+  ctx.argv = argv;
+  if (runner->setup) {
+    runner->setup(&ctx);
+  }
+  test->fn(&ctx);
+  if (runner->teardown) {
+    runner->teardown(&ctx);
+  }
+  fflush(NULL);
+
+  outcome.passed = ctx.passed;
+  outcome.failed = ctx.failed;
+  outcome.has_failed = ctx.has_failed;
+  written = write(result_fd, &outcome, sizeof(outcome));
+  _exit(written == (ssize_t)sizeof(outcome) ? 0 : 1);
+}
+
+static void __truk_test_start(__truk_test_job_t *job,
+                              const __truk_test_case_s *test,
+                              const __truk_test_runner_s *runner,
+                              __truk_i32 argc, char **argv) {
+  int fds[2];
+
+  job->state = __TRUK_TEST_DONE;
+  job->output = tmpfile();
+  if (!job->output || pipe(fds) != 0) {
+    job->start_errno = errno;
+    return;
+  }
+
+  /* Anything still buffered would otherwise be written again by the child. */
+  fflush(stdout);
+  fflush(stderr);
+  job->start_ns = __truk_test_now_ns();
+  job->pid = fork();
+  if (job->pid < 0) {
+    job->start_errno = errno;
+    close(fds[0]);
+    close(fds[1]);
+    return;
+  }
+  if (job->pid == 0) {
+    close(fds[0]);
+    __truk_test_child(test, runner, argc, argv, fileno(job->output), fds[1]);
+  }
+
+  close(fds[1]);
+  job->result_fd = fds[0];
+  job->state = __TRUK_TEST_RUNNING;
+}
+
+/* Collects a child whose result pipe is readable or closed, or which timed
+ * out and has been killed. Its CPU time comes from the kernel, so it is known
+ * even for a test that never reported. */
+static void __truk_test_finish(__truk_test_job_t *job) {
+  struct rusage usage;
+  if (!job->timed_out && read(job->result_fd, &job->outcome,
+                              sizeof(job->outcome)) ==
+                             (ssize_t)sizeof(job->outcome)) {
+    job->reported = 1;
+  }
+  close(job->result_fd);
+  memset(&usage, 0, sizeof(usage));
+  while (wait4(job->pid, &job->status, 0, &usage) < 0 && errno == EINTR) {
+  }
+  job->elapsed_ns = __truk_test_now_ns() - job->start_ns;
+  job->cpu_ns =
+      ((__truk_u64)usage.ru_utime.tv_sec + (__truk_u64)usage.ru_stime.tv_sec) *
+          1000000000ULL +
+      ((__truk_u64)usage.ru_utime.tv_usec + (__truk_u64)usage.ru_stime.tv_usec) *
+          1000ULL;
+  job->state = __TRUK_TEST_DONE;
+}
+
+/* Prints a finished test the way the in-process runner would, plus its wall
+ * time, and records it. Returns 1 if it counts as a failure. */
+static int __truk_test_report(__truk_test_job_t *job,
+                              const __truk_test_case_s *test,
+                              const __truk_test_runner_s *runner) {
+  char buf[4096];
+  size_t n;
+  const char *status = "passed";
+  double ms = (double)job->elapsed_ns / 1e6;
+  __truk_test_context_s record;
+
+  printf("Running %s...\n", test->name);
+  if (job->output) {
+    rewind(job->output);
+    while ((n = fread(buf, 1, sizeof(buf), job->output)) > 0) {
+      fwrite(buf, 1, n, stdout);
+    }
+    fclose(job->output);
+    job->output = NULL;
+  }
+
+  if (job->start_errno) {
+    printf("  FAILED (could not start: %s)\n", strerror(job->start_errno));
+    status = "crashed";
+  } else if (job->timed_out) {
+    printf("  TIMED OUT (after %llu ms)\n",
+           (unsigned long long)runner->timeout_ms);
+    status = "timeout";
+  } else if (!job->reported) {
+    if (WIFSIGNALED(job->status)) {
+      printf("  CRASHED (signal %d, %.2f ms)\n", WTERMSIG(job->status), ms);
+    } else {
+      printf("  CRASHED (exit status %d, %.2f ms)\n", WEXITSTATUS(job->status),
+             ms);
+    }
+    status = "crashed";
+  } else if (job->outcome.has_failed) {
+    printf("  FAILED (%d/%d assertions, %.2f ms)\n", job->outcome.failed,
+           job->outcome.failed + job->outcome.passed, ms);
+    status = "failed";
+  } else {
+    printf("  PASSED (%d assertions, %.2f ms)\n", job->outcome.passed, ms);
+  }
+
+  memset(&record, 0, sizeof(record));
+  record.current_test_name = test->name;
+  record.passed = job->outcome.passed;
+  record.failed = job->outcome.failed;
+  record.wall_ns = job->elapsed_ns;
+  record.cpu_ns = job->cpu_ns;
+  __truk_test_record(&record, status);
+  return strcmp(status, "passed") != 0;
+}
+
+__truk_i32 __truk_test_run_isolated(const __truk_test_case_s *tests,
+                                   __truk_i32 count,
+                                   const __truk_test_runner_s *runner,
+                                   __truk_i32 argc, char **argv) {
+  __truk_test_job_t *jobs;
+  struct pollfd *fds;
+  __truk_i32 *polled;
+  __truk_i32 workers = runner->jobs;
+  __truk_i32 next_start = 0;
+  __truk_i32 next_print = 0;
+  __truk_i32 running = 0;
+  __truk_i32 total_failed = 0;
+  __truk_u64 timeout_ns = runner->timeout_ms * 1000000ULL;
+
+  if (workers <= 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    workers = cores > 0 ? (__truk_i32)cores : 1;
+  }
+
+  jobs = (__truk_test_job_t *)calloc((size_t)count, sizeof(*jobs));
+  fds = (struct pollfd *)calloc((size_t)workers, sizeof(*fds));
+  polled = (__truk_i32 *)calloc((size_t)workers, sizeof(*polled));
+  if ((count && !jobs) || !fds || !polled) {
+    fprintf(stderr, "test runner: out of memory\n");
+    free(jobs);
+    free(fds);
+    free(polled);
+    return count;
+  }
+
+  while (next_print < count) {
+    while (running < workers && next_start < count) {
+      __truk_test_start(&jobs[next_start], &tests[next_start], runner, argc,
+                        argv);
+      if (jobs[next_start].state == __TRUK_TEST_RUNNING) {
+        running++;
+      }
+      next_start++;
+    }
+
+    if (running > 0) {
+      nfds_t n = 0;
+      int wait_ms = -1;
+      __truk_u64 now = __truk_test_now_ns();
+      int ready;
+
+      /* Everything before next_print is done, so only this window can be
+       * running. */
+      for (__truk_i32 i = next_print; i < next_start; i++) {
+        if (jobs[i].state != __TRUK_TEST_RUNNING) {
+          continue;
+        }
+        fds[n].fd = jobs[i].result_fd;
+        fds[n].events = POLLIN;
+        fds[n].revents = 0;
+        polled[n++] = i;
+        if (timeout_ns) {
+          __truk_u64 deadline = jobs[i].start_ns + timeout_ns;
+          __truk_u64 left = deadline > now ? deadline - now : 0;
+          int left_ms = (int)((left + 999999ULL) / 1000000ULL);
+          if (wait_ms < 0 || left_ms < wait_ms) {
+            wait_ms = left_ms;
+          }
+        }
+      }
+
+      ready = poll(fds, n, wait_ms);
+      if (ready < 0 && errno != EINTR) {
+        fprintf(stderr, "test runner: poll failed: %s\n", strerror(errno));
+        for (nfds_t i = 0; i < n; i++) {
+          kill(jobs[polled[i]].pid, SIGKILL);
+          __truk_test_finish(&jobs[polled[i]]);
+        }
+        running = 0;
+      }
+      for (nfds_t i = 0; ready > 0 && i < n; i++) {
+        if (fds[i].revents) {
+          __truk_test_finish(&jobs[polled[i]]);
+          running--;
+        }
+      }
+
+      if (timeout_ns) {
+        now = __truk_test_now_ns();
+        for (nfds_t i = 0; i < n; i++) {
+          __truk_test_job_t *job = &jobs[polled[i]];
+          if (job->state == __TRUK_TEST_RUNNING &&
+              now - job->start_ns >= timeout_ns) {
+            kill(job->pid, SIGKILL);
+            job->timed_out = 1;
+            __truk_test_finish(job);
+            running--;
+          }
+        }
+      }
+    }
+
+    while (next_print < count && jobs[next_print].state == __TRUK_TEST_DONE) {
+      total_failed +=
+          __truk_test_report(&jobs[next_print], &tests[next_print], runner);
+      fflush(stdout);
+      next_print++;
+    }
+  }
+
+  free(jobs);
+  free(fds);
+  free(polled);
+
+  printf("\n%d/%d tests passed\n", count - total_failed, count);
+  return total_failed;
+}
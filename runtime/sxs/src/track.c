@@ -0,0 +1,387 @@
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sxs/runtime.h>
+#include <unistd.h>
+
+/*
+ * Allocation tracker behind truk --track-allocs; see runtime.h. Only built
+ * into programs (and tests) that define TRUK_TRACK_ALLOCS.
+ *
+ * Recorded pointers live in a sharded open-addressing table mapping each
+ * pointer to its site and the counts it was recorded with, so a free takes
+ * back exactly what its allocation added even when those counts are sampling
+ * estimates. Site counters are updated with relaxed atomics; the report reads
+ * them without locks, which is what lets it run from a signal handler.
+ */
+#if defined(TRUK_TRACK_ALLOCS)
+
+#if defined(__TINYC__)
+/* No atomics under TCC; counters are plain adds like the thread slot. */
+#define __TRUK_TRACK_ADD(p, v) (*(p) += (v))
+#define __TRUK_TRACK_LOAD(p) (*(p))
+#else
+#define __TRUK_TRACK_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define __TRUK_TRACK_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#endif
+
+#define __TRUK_TRACK_SHARD_BITS 6
+#define __TRUK_TRACK_SHARDS (1 << __TRUK_TRACK_SHARD_BITS)
+#define __TRUK_TRACK_MIN_CAP 64
+#define __TRUK_TRACK_TOP 64
+
+typedef struct {
+  __truk_void *ptr;
+  __truk_alloc_site_t *site;
+  __truk_u64 count;
+  __truk_u64 bytes;
+} __truk_track_entry_t;
+
+typedef struct {
+  pthread_mutex_t lock;
+  __truk_track_entry_t *entries;
+  __truk_u64 cap;
+  __truk_u64 size;
+} __truk_track_shard_t;
+
+static __truk_track_shard_t __truk_track_shards[__TRUK_TRACK_SHARDS];
+static pthread_once_t __truk_track_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t __truk_track_sites_lock = PTHREAD_MUTEX_INITIALIZER;
+static __truk_alloc_site_t *__truk_track_sites = NULL;
+static __truk_alloc_site_t __truk_track_runtime_site = {
+    "<runtime>", 0, 0, 0, 0, 0, 0, NULL};
+
+#if defined(TRUK_TRACK_ALLOCS_SAMPLE)
+__TRUK_THREAD_LOCAL __truk_i64 __truk_runtime_sxs_track_countdown = 0;
+__truk_u16 __truk_runtime_sxs_track_filter[1 << __TRUK_TRACK_FILTER_BITS];
+static __TRUK_THREAD_LOCAL __truk_u64 __truk_track_random = 0;
+#endif
+
+static void __truk_track_init(void) {
+  __truk_u64 i;
+  for (i = 0; i < __TRUK_TRACK_SHARDS; i++) {
+    pthread_mutex_init(&__truk_track_shards[i].lock, NULL);
+  }
+}
+
+static __truk_u64 __truk_track_hash(const __truk_void *ptr) {
+  __truk_u64 h = (__truk_u64)(uintptr_t)ptr >> 4;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return h;
+}
+
+static __truk_track_shard_t *__truk_track_shard_of(__truk_u64 hash) {
+  return &__truk_track_shards[hash >> (64 - __TRUK_TRACK_SHARD_BITS)];
+}
+
+static void __truk_track_register(__truk_alloc_site_t *site) {
+  pthread_mutex_lock(&__truk_track_sites_lock);
+  if (!site->registered) {
+    site->next = __truk_track_sites;
+#if defined(__TINYC__)
+    __truk_track_sites = site;
+#else
+    __atomic_store_n(&__truk_track_sites, site, __ATOMIC_RELEASE);
+#endif
+    site->registered = 1;
+  }
+  pthread_mutex_unlock(&__truk_track_sites_lock);
+}
+
+static void __truk_track_count(__truk_alloc_site_t *site, __truk_u64 count,
+                               __truk_u64 bytes, int sign) {
+  if (sign > 0) {
+    __TRUK_TRACK_ADD(&site->allocs, count);
+    __TRUK_TRACK_ADD(&site->bytes, bytes);
+    __TRUK_TRACK_ADD(&site->live_allocs, count);
+    __TRUK_TRACK_ADD(&site->live_bytes, bytes);
+  } else {
+    __TRUK_TRACK_ADD(&site->live_allocs, (__truk_u64)0 - count);
+    __TRUK_TRACK_ADD(&site->live_bytes, (__truk_u64)0 - bytes);
+  }
+}
+
+static void __truk_track_filter_add(const __truk_void *ptr, int delta) {
+#if defined(TRUK_TRACK_ALLOCS_SAMPLE)
+  __TRUK_TRACK_ADD(
+      &__truk_runtime_sxs_track_filter[__truk_runtime_sxs_track_slot(ptr)],
+      (__truk_u16)delta);
+#else
+  (void)ptr;
+  (void)delta;
+#endif
+}
+
+/* Linear probing over a power-of-two table, kept at most half full. */
+static __truk_track_entry_t *
+__truk_track_probe(__truk_track_shard_t *shard, const __truk_void *ptr,
+                   __truk_u64 hash) {
+  __truk_u64 mask = shard->cap - 1;
+  __truk_u64 i = hash & mask;
+  while (shard->entries[i].ptr && shard->entries[i].ptr != ptr) {
+    i = (i + 1) & mask;
+  }
+  return &shard->entries[i];
+}
+
+static int __truk_track_grow(__truk_track_shard_t *shard) {
+  __truk_u64 cap = shard->cap ? shard->cap * 2 : __TRUK_TRACK_MIN_CAP;
+  __truk_track_entry_t *old = shard->entries;
+  __truk_u64 old_cap = shard->cap, i;
+  __truk_track_entry_t *entries = calloc(cap, sizeof(__truk_track_entry_t));
+  if (!entries) {
+    return 0;
+  }
+  shard->entries = entries;
+  shard->cap = cap;
+  for (i = 0; i < old_cap; i++) {
+    if (old[i].ptr) {
+      *__truk_track_probe(shard, old[i].ptr, __truk_track_hash(old[i].ptr)) =
+          old[i];
+    }
+  }
+  free(old);
+  return 1;
+}
+
+static void __truk_track_record(__truk_void *ptr, __truk_alloc_site_t *site,
+                                __truk_u64 count, __truk_u64 bytes) {
+  __truk_u64 hash = __truk_track_hash(ptr);
+  __truk_track_shard_t *shard = __truk_track_shard_of(hash);
+  __truk_track_entry_t *entry;
+
+  if (!site->registered) {
+    __truk_track_register(site);
+  }
+  pthread_mutex_lock(&shard->lock);
+  if ((shard->size + 1) * 2 > shard->cap && !__truk_track_grow(shard)) {
+    pthread_mutex_unlock(&shard->lock);
+    return;
+  }
+  entry = __truk_track_probe(shard, ptr, hash);
+  if (entry->ptr) {
+    /* Released behind the runtime's back (e.g. by libc free) and reused. */
+    __truk_track_count(entry->site, entry->count, entry->bytes, -1);
+    __truk_track_filter_add(ptr, -1);
+  } else {
+    shard->size++;
+  }
+  entry->ptr = ptr;
+  entry->site = site;
+  entry->count = count;
+  entry->bytes = bytes;
+  __truk_track_count(site, count, bytes, 1);
+  __truk_track_filter_add(ptr, 1);
+  pthread_mutex_unlock(&shard->lock);
+}
+
+__truk_void *__truk_runtime_sxs_track_alloc(__truk_allocator_t *allocator,
+                                            __truk_u64 size,
+                                            __truk_alloc_site_t *site) {
+  __truk_void *ptr = allocator ? allocator->alloc(allocator, size)
+                               : malloc(size);
+  __truk_u64 count = 1, bytes = size;
+
+#if defined(TRUK_TRACK_ALLOCS_SAMPLE)
+  {
+    /* Next sample after a uniform draw from [1, 2 * period] bytes; a small
+     * allocation stands for the period / size others that went unrecorded. */
+    const __truk_u64 period = TRUK_TRACK_ALLOCS_SAMPLE;
+    __truk_u64 x = __truk_track_random;
+    const __truk_bool first = !x;
+    if (first) {
+      x = (__truk_u64)(uintptr_t)&__truk_track_random | 1;
+    }
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    __truk_track_random = x;
+    __truk_runtime_sxs_track_countdown = (__truk_i64)(1 + x % (2 * period));
+    /* A thread's countdown starts at zero; its first call only seeds it. */
+    if (first && (__truk_runtime_sxs_track_countdown -= (__truk_i64)size) > 0) {
+      return ptr;
+    }
+    if (size < period) {
+      count = size ? period / size : period;
+      bytes = count * size;
+    }
+  }
+#endif
+  if (!ptr || (allocator && allocator->reset)) {
+    return ptr;
+  }
+  pthread_once(&__truk_track_once, __truk_track_init);
+  __truk_track_record(ptr, site ? site : &__truk_track_runtime_site, count,
+                      bytes);
+  return ptr;
+}
+
+__truk_void __truk_runtime_sxs_track_free(__truk_void *ptr) {
+  __truk_u64 hash = __truk_track_hash(ptr);
+  __truk_track_shard_t *shard = __truk_track_shard_of(hash);
+  __truk_track_entry_t *entry;
+  __truk_u64 mask, i, j;
+
+  pthread_once(&__truk_track_once, __truk_track_init);
+  pthread_mutex_lock(&shard->lock);
+  if (!shard->cap) {
+    pthread_mutex_unlock(&shard->lock);
+    return;
+  }
+  entry = __truk_track_probe(shard, ptr, hash);
+  if (!entry->ptr) {
+    pthread_mutex_unlock(&shard->lock);
+    return;
+  }
+  __truk_track_count(entry->site, entry->count, entry->bytes, -1);
+  __truk_track_filter_add(ptr, -1);
+
+  /* Backward-shift deletion keeps probe chains intact without tombstones. */
+  mask = shard->cap - 1;
+  i = (__truk_u64)(entry - shard->entries);
+  j = i;
+  for (;;) {
+    __truk_u64 home;
+    j = (j + 1) & mask;
+    if (!shard->entries[j].ptr) {
+      break;
+    }
+    home = __truk_track_hash(shard->entries[j].ptr) & mask;
+    if (((j - home) & mask) >= ((j - i) & mask)) {
+      shard->entries[i] = shard->entries[j];
+      i = j;
+    }
+  }
+  shard->entries[i].ptr = NULL;
+  shard->size--;
+  pthread_mutex_unlock(&shard->lock);
+}
+
+/* The report is built with write(2) and no allocation so the SIGUSR1
+ * handler can produce it. */
+static void __truk_track_write(int fd, const char *text, __truk_u64 len) {
+  while (len) {
+    ssize_t n = write(fd, text, len);
+    if (n <= 0) {
+      return;
+    }
+    text += n;
+    len -= (__truk_u64)n;
+  }
+}
+
+static void __truk_track_puts(int fd, const char *text) {
+  __truk_track_write(fd, text, strlen(text));
+}
+
+static void __truk_track_putu(int fd, __truk_u64 value, int width) {
+  char buf[24];
+  int n = 0;
+  do {
+    buf[sizeof(buf) - 1 - n++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value);
+  while (n < width && n < (int)sizeof(buf)) {
+    buf[sizeof(buf) - 1 - n++] = ' ';
+  }
+  __truk_track_write(fd, buf + sizeof(buf) - n, (__truk_u64)n);
+}
+
+__truk_void __truk_runtime_sxs_track_report(int fd) {
+  __truk_alloc_site_t *top[__TRUK_TRACK_TOP];
+  __truk_u64 top_count = 0, sites = 0, live = 0, rest = 0, rest_bytes = 0;
+  __truk_u64 i;
+  __truk_alloc_site_t *site;
+
+  for (site = __TRUK_TRACK_LOAD(&__truk_track_sites); site;
+       site = site->next) {
+    __truk_u64 bytes = __TRUK_TRACK_LOAD(&site->live_bytes);
+    sites++;
+    live += bytes;
+    if (top_count == __TRUK_TRACK_TOP &&
+        bytes <= __TRUK_TRACK_LOAD(&top[top_count - 1]->live_bytes)) {
+      rest++;
+      rest_bytes += bytes;
+      continue;
+    }
+    if (top_count == __TRUK_TRACK_TOP) {
+      rest++;
+      rest_bytes += __TRUK_TRACK_LOAD(&top[top_count - 1]->live_bytes);
+      top_count--;
+    }
+    i = top_count++;
+    while (i > 0 && __TRUK_TRACK_LOAD(&top[i - 1]->live_bytes) < bytes) {
+      top[i] = top[i - 1];
+      i--;
+    }
+    top[i] = site;
+  }
+
+  __truk_track_puts(fd, "truk alloc report: ");
+  __truk_track_putu(fd, live, 0);
+  __truk_track_puts(fd, " bytes live across ");
+  __truk_track_putu(fd, sites, 0);
+  __truk_track_puts(fd, " sites");
+#if defined(TRUK_TRACK_ALLOCS_SAMPLE)
+  __truk_track_puts(fd, " (sampled every ~");
+  __truk_track_putu(fd, TRUK_TRACK_ALLOCS_SAMPLE, 0);
+  __truk_track_puts(fd, " bytes; counts are estimates)");
+#endif
+  __truk_track_puts(fd, "\n    live bytes   live allocs  total allocs   "
+                        "total bytes  site\n");
+  for (i = 0; i < top_count; i++) {
+    site = top[i];
+    __truk_track_putu(fd, __TRUK_TRACK_LOAD(&site->live_bytes), 14);
+    __truk_track_putu(fd, __TRUK_TRACK_LOAD(&site->live_allocs), 14);
+    __truk_track_putu(fd, __TRUK_TRACK_LOAD(&site->allocs), 14);
+    __truk_track_putu(fd, __TRUK_TRACK_LOAD(&site->bytes), 14);
+    __truk_track_puts(fd, "  ");
+    __truk_track_puts(fd, site->file);
+    if (site->line) {
+      __truk_track_puts(fd, ":");
+      __truk_track_putu(fd, site->line, 0);
+    }
+    __truk_track_puts(fd, "\n");
+  }
+  if (rest) {
+    __truk_track_putu(fd, rest_bytes, 14);
+    __truk_track_puts(fd, "  in ");
+    __truk_track_putu(fd, rest, 0);
+    __truk_track_puts(fd, " more sites\n");
+  }
+}
+
+static void __truk_track_report_at_exit(void) {
+  __truk_runtime_sxs_track_report(2);
+}
+
+static void __truk_track_report_on_signal(int sig) {
+  (void)sig;
+  __truk_runtime_sxs_track_report(2);
+}
+
+__truk_void __truk_runtime_sxs_track_start(void) {
+  static int started = 0;
+  struct sigaction action, previous;
+
+  if (started) {
+    return;
+  }
+  started = 1;
+  pthread_once(&__truk_track_once, __truk_track_init);
+  atexit(__truk_track_report_at_exit);
+
+  if (sigaction(SIGUSR1, NULL, &previous) == 0 &&
+      previous.sa_handler == SIG_DFL) {
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = __truk_track_report_on_signal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, NULL);
+  }
+}
+
+#endif
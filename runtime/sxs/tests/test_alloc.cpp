@@ -0,0 +1,165 @@
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+extern "C" {
+#include <stdint.h>
+#include <string.h>
+#include <sxs/alloc.h>
+#include <sxs/ds/map.h>
+#include <sxs/runtime.h>
+}
+
+static bool is_aligned(void *ptr) { return ((uintptr_t)ptr & 15) == 0; }
+
+TEST_GROUP(AllocArena){};
+
+TEST(AllocArena, BumpAllocatesAlignedDistinctBlocks) {
+  __truk_allocator_t *arena = __truk_alloc_arena_new(256);
+  char *a = (char *)__truk_runtime_sxs_alloc_with(arena, 3);
+  char *b = (char *)__truk_runtime_sxs_alloc_with(arena, 40);
+  CHECK(is_aligned(a));
+  CHECK(is_aligned(b));
+  CHECK_EQUAL(16, b - a);
+  memset(b, 0xab, 40);
+  __truk_runtime_sxs_free_with(arena, a);
+  __truk_runtime_sxs_allocator_destroy(arena);
+}
+
+TEST(AllocArena, OversizedRequestKeepsCurrentBlock) {
+  __truk_allocator_t *arena = __truk_alloc_arena_new(64);
+  char *a = (char *)__truk_runtime_sxs_alloc_with(arena, 16);
+  char *big = (char *)__truk_runtime_sxs_alloc_with(arena, 1000);
+  char *b = (char *)__truk_runtime_sxs_alloc_with(arena, 16);
+  CHECK(big != NULL);
+  memset(big, 0, 1000);
+  CHECK_EQUAL(16, b - a);
+  __truk_runtime_sxs_allocator_destroy(arena);
+}
+
+TEST(AllocArena, ResetKeepsOneBlock) {
+  __truk_allocator_t *arena = __truk_alloc_arena_new(128);
+  for (int i = 0; i < 100; i++) {
+    CHECK(__truk_runtime_sxs_alloc_with(arena, 48) != NULL);
+  }
+  __truk_runtime_sxs_allocator_reset(arena);
+  void *again = __truk_runtime_sxs_alloc_with(arena, 16);
+  CHECK(again != NULL);
+  CHECK(is_aligned(again));
+  CHECK_EQUAL(16, (char *)__truk_runtime_sxs_alloc_with(arena, 16) -
+                      (char *)again);
+  __truk_runtime_sxs_allocator_destroy(arena);
+}
+
+TEST_GROUP(AllocPool){};
+
+TEST(AllocPool, FreedElementsAreRecycled) {
+  __truk_allocator_t *pool = __truk_alloc_pool_new(24, 4);
+  void *a = __truk_runtime_sxs_alloc_with(pool, 24);
+  void *b = __truk_runtime_sxs_alloc_with(pool, 8);
+  CHECK(is_aligned(a));
+  CHECK(is_aligned(b));
+  CHECK(a != b);
+  __truk_runtime_sxs_free_with(pool, a);
+  POINTERS_EQUAL(a, __truk_runtime_sxs_alloc_with(pool, 24));
+  __truk_runtime_sxs_allocator_destroy(pool);
+}
+
+TEST(AllocPool, GrowsPastOneChunkAndResets) {
+  __truk_allocator_t *pool = __truk_alloc_pool_new(sizeof(int), 8);
+  int *elems[64];
+  for (int i = 0; i < 64; i++) {
+    elems[i] = (int *)__truk_runtime_sxs_alloc_with(pool, sizeof(int));
+    *elems[i] = i;
+  }
+  for (int i = 0; i < 64; i++) {
+    CHECK_EQUAL(i, *elems[i]);
+  }
+  __truk_runtime_sxs_allocator_reset(pool);
+  POINTERS_EQUAL(elems[0], __truk_runtime_sxs_alloc_with(pool, sizeof(int)));
+  __truk_runtime_sxs_allocator_destroy(pool);
+}
+
+TEST_GROUP(AllocSlab){};
+
+TEST(AllocSlab, SizeClassesAndLargeObjects) {
+  __truk_allocator_t *slab = __truk_alloc_slab_new();
+  unsigned sizes[] = {1, 16, 17, 100, 128, 129, 2048, 2049, 100000};
+  void *ptrs[sizeof(sizes) / sizeof(sizes[0])];
+  for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    ptrs[i] = __truk_runtime_sxs_alloc_with(slab, sizes[i]);
+    CHECK(ptrs[i] != NULL);
+    CHECK(is_aligned(ptrs[i]));
+    memset(ptrs[i], (int)i, sizes[i]);
+  }
+  for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    CHECK_EQUAL((unsigned char)i, ((unsigned char *)ptrs[i])[sizes[i] - 1]);
+    __truk_runtime_sxs_free_with(slab, ptrs[i]);
+  }
+  __truk_runtime_sxs_allocator_destroy(slab);
+}
+
+TEST(AllocSlab, FreeReturnsSlotToItsClass) {
+  __truk_allocator_t *slab = __truk_alloc_slab_new();
+  void *a = __truk_runtime_sxs_alloc_with(slab, 40);
+  void *b = __truk_runtime_sxs_alloc_with(slab, 300);
+  __truk_runtime_sxs_free_with(slab, a);
+  POINTERS_EQUAL(a, __truk_runtime_sxs_alloc_with(slab, 33));
+  __truk_runtime_sxs_free_with(slab, b);
+  __truk_runtime_sxs_allocator_reset(slab);
+  CHECK(__truk_runtime_sxs_alloc_with(slab, 40) != NULL);
+  __truk_runtime_sxs_allocator_destroy(slab);
+}
+
+TEST_GROUP(AllocCurrent) {
+  void teardown() override {
+    __truk_runtime_sxs_set_thread_allocator(NULL);
+    __truk_runtime_sxs_set_program_allocator(NULL);
+  }
+};
+
+TEST(AllocCurrent, ThreadAllocatorOverridesProgram) {
+  __truk_allocator_t *program = __truk_alloc_slab_new();
+  __truk_allocator_t *thread = __truk_alloc_arena_new(1024);
+
+  POINTERS_EQUAL(NULL, __truk_runtime_sxs_set_program_allocator(program));
+  POINTERS_EQUAL(program, __truk_runtime_sxs_current_allocator());
+  POINTERS_EQUAL(NULL, __truk_runtime_sxs_set_thread_allocator(thread));
+  POINTERS_EQUAL(thread, __truk_runtime_sxs_current_allocator());
+
+  void *ptr = __truk_runtime_sxs_alloc(32);
+  CHECK(ptr != NULL);
+  __truk_runtime_sxs_free(ptr);
+
+  POINTERS_EQUAL(thread, __truk_runtime_sxs_set_thread_allocator(NULL));
+  POINTERS_EQUAL(program, __truk_runtime_sxs_current_allocator());
+  POINTERS_EQUAL(program, __truk_runtime_sxs_set_program_allocator(NULL));
+
+  __truk_runtime_sxs_allocator_destroy(thread);
+  __truk_runtime_sxs_allocator_destroy(program);
+}
+
+TEST(AllocCurrent, MapKeepsAllocatorFromFirstInsert) {
+  __truk_allocator_t *arena = __truk_alloc_arena_new(4096);
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(int), __truk_map_mixhash_32,
+                          __truk_map_cmp_mem);
+
+  __truk_runtime_sxs_set_thread_allocator(arena);
+  int key = 0;
+  __truk_map_set_generic(&map, &key, 0);
+  __truk_runtime_sxs_set_thread_allocator(NULL);
+
+  POINTERS_EQUAL(arena, map.base.allocator);
+  for (key = 1; key < 200; key++) {
+    __truk_map_set_generic(&map, &key, key * 2);
+  }
+  key = 150;
+  CHECK_EQUAL(300, *(int *)__truk_map_get_(&map.base, &key));
+
+  __truk_map_deinit(&map);
+  __truk_runtime_sxs_allocator_destroy(arena);
+}
+
+int main(int argc, char **argv) {
+  return CommandLineTestRunner::RunAllTests(argc, argv);
+}
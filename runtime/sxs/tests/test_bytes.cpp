@@ -0,0 +1,120 @@
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+extern "C" {
+#include <string.h>
+#include <sxs/bytes.h>
+}
+
+static const __truk_u8 *bytes(const char *s) {
+  return (const __truk_u8 *)s;
+}
+
+TEST_GROUP(BytesSearch){};
+
+TEST(BytesSearch, FindReturnsLengthWhenAbsent) {
+  CHECK_EQUAL(3, __truk_bytes_find(bytes("abc\n"), 4, '\n'));
+  CHECK_EQUAL(4, __truk_bytes_find(bytes("abcd"), 4, 'z'));
+  CHECK_EQUAL(0, __truk_bytes_find(NULL, 0, 'a'));
+}
+
+// Lengths and match positions straddle the 16- and 32-byte block edges and
+// the scalar tail of every kernel.
+TEST(BytesSearch, FindAnyAtEveryPosition) {
+  __truk_u8 buf[100];
+  const __truk_u8 *set = bytes(",;\t");
+  for (__truk_u64 len = 1; len <= sizeof(buf); len++) {
+    for (__truk_u64 at = 0; at < len; at++) {
+      memset(buf, 'x', sizeof(buf));
+      buf[at] = ';';
+      if (at + 7 < len) {
+        buf[at + 7] = ',';
+      }
+      CHECK_EQUAL(at, __truk_bytes_find_any(buf, len, set, 3));
+    }
+    memset(buf, 'x', sizeof(buf));
+    CHECK_EQUAL(len, __truk_bytes_find_any(buf, len, set, 3));
+  }
+}
+
+TEST(BytesSearch, FindAnyLargeAndTrivialSets) {
+  __truk_u8 set[40];
+  __truk_u8 buf[64];
+  for (int i = 0; i < 40; i++) {
+    set[i] = (__truk_u8)('A' + i);
+  }
+  memset(buf, '0', sizeof(buf));
+  buf[50] = 'Z';
+  CHECK_EQUAL(50, __truk_bytes_find_any(buf, sizeof(buf), set, 40));
+  CHECK_EQUAL(50, __truk_bytes_find_any(buf, sizeof(buf), bytes("Z"), 1));
+  CHECK_EQUAL(64, __truk_bytes_find_any(buf, sizeof(buf), set, 0));
+}
+
+TEST(BytesSearch, CountAcrossBlockLimits) {
+  static __truk_u8 buf[20000];
+  memset(buf, '\n', sizeof(buf));
+  CHECK_EQUAL(20000, __truk_bytes_count(buf, sizeof(buf), '\n'));
+  for (__truk_u64 i = 0; i < sizeof(buf); i += 3) {
+    buf[i] = 'a';
+  }
+  CHECK_EQUAL(6667, __truk_bytes_count(buf, sizeof(buf), 'a'));
+  CHECK_EQUAL(13333, __truk_bytes_count(buf, sizeof(buf), '\n'));
+  CHECK_EQUAL(1, __truk_bytes_count(buf + 1, 5, 'a'));
+  CHECK_EQUAL(0, __truk_bytes_count(buf, 0, 'a'));
+}
+
+TEST_GROUP(BytesMemory){};
+
+TEST(BytesMemory, CompareOrdersPrefixesFirst) {
+  CHECK_EQUAL(0, __truk_bytes_compare(bytes("abc"), 3, bytes("abc"), 3));
+  CHECK_EQUAL(-1, __truk_bytes_compare(bytes("ab"), 2, bytes("abc"), 3));
+  CHECK_EQUAL(1, __truk_bytes_compare(bytes("abd"), 3, bytes("abc"), 3));
+  CHECK_EQUAL(1, __truk_bytes_compare(bytes("\xff"), 1, bytes("a"), 1));
+  CHECK_EQUAL(0, __truk_bytes_compare(NULL, 0, NULL, 0));
+}
+
+TEST(BytesMemory, CopyClampsAndAllowsOverlap) {
+  __truk_u8 buf[8] = {'0', '1', '2', '3', '4', '5', '6', '7'};
+  CHECK_EQUAL(6, __truk_bytes_copy(buf + 2, 6, buf, 8));
+  MEMCMP_EQUAL("01012345", buf, 8);
+  CHECK_EQUAL(2, __truk_bytes_copy(buf, 2, bytes("xyz"), 3));
+  MEMCMP_EQUAL("xy012345", buf, 8);
+}
+
+TEST(BytesMemory, Fill) {
+  __truk_u8 buf[5] = {0};
+  __truk_bytes_fill(buf, 4, '-');
+  MEMCMP_EQUAL("----\0", buf, 5);
+}
+
+TEST_GROUP(BytesUtf8){};
+
+TEST(BytesUtf8, AcceptsWellFormedText) {
+  const char *text = "plain ascii line long enough for a vector block, "
+                     "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 "
+                     "\xed\x9f\xbf \xf4\x8f\xbf\xbf end";
+  CHECK_TRUE(__truk_bytes_utf8_valid(bytes(text), strlen(text)));
+  CHECK_TRUE(__truk_bytes_utf8_valid(NULL, 0));
+}
+
+TEST(BytesUtf8, RejectsMalformedSequences) {
+  const char *cases[] = {
+      "\x80",             // lone continuation
+      "\xc0\xaf",         // overlong '/'
+      "\xe0\x80\xaf",     // overlong three-byte
+      "\xed\xa0\x80",     // surrogate
+      "\xf4\x90\x80\x80", // past U+10FFFF
+      "\xf5\x80\x80\x80", // invalid lead
+      "\xe2\x82",         // truncated
+  };
+  for (const char *bad : cases) {
+    char buf[64];
+    memset(buf, 'a', sizeof(buf));
+    memcpy(buf + 40, bad, strlen(bad));
+    CHECK_FALSE(__truk_bytes_utf8_valid(bytes(buf), 40 + strlen(bad)));
+  }
+}
+
+int main(int argc, char **argv) {
+  return CommandLineTestRunner::RunAllTests(argc, argv);
+}
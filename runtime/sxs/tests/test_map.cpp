@@ -4,7 +4,11 @@
 extern "C" {
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
+#include <sxs/ds/chained_map.h>
+#include <sxs/ds/concurrent_map.h>
 #include <sxs/ds/map.h>
+#include <sxs/ds/ordered_map.h>
 }
 
 #define __TRUK_MAP_GET_INT(m, k)                                               \
@@ -665,6 +669,966 @@ TEST(MapIntegerKeys, F32Keys) {
   __truk_map_deinit(&map);
 }
 
+TEST_GROUP(MapOpenAddressing){};
+
+TEST(MapOpenAddressing, CapacityIsPowerOfTwo) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(long long), __truk_map_hash_i64,
+                          __truk_map_cmp_mem);
+
+  for (long long i = 0; i < 1000; i++) {
+    __truk_map_set_generic(&map, &i, (int)i);
+    CHECK_EQUAL(0u, map.base.nbuckets & (map.base.nbuckets - 1));
+    CHECK(map.base.nnodes <= map.base.nbuckets - map.base.nbuckets / 8);
+  }
+
+  CHECK_EQUAL(1000, map.base.nnodes);
+  __truk_map_deinit(&map);
+}
+
+TEST(MapOpenAddressing, TombstoneChurnDoesNotGrow) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(long long), __truk_map_hash_i64,
+                          __truk_map_cmp_mem);
+
+  for (long long i = 0; i < 64; i++) {
+    __truk_map_set_generic(&map, &i, (int)i);
+  }
+  unsigned nbuckets = map.base.nbuckets;
+
+  for (long long i = 64; i < 100000; i++) {
+    long long old = i - 64;
+    __truk_map_remove_generic(&map, &old);
+    __truk_map_set_generic(&map, &i, (int)i);
+  }
+
+  CHECK_EQUAL(64, map.base.nnodes);
+  CHECK_EQUAL(nbuckets, map.base.nbuckets);
+  for (long long i = 100000 - 64; i < 100000; i++) {
+    int *val = __TRUK_MAP_GET_INT(&map, &i);
+    CHECK(val != NULL);
+    CHECK_EQUAL((int)i, *val);
+  }
+  long long gone = 100000 - 65;
+  POINTERS_EQUAL(NULL, __truk_map_get_(&map.base, &gone));
+
+  __truk_map_deinit(&map);
+}
+
+TEST(MapOpenAddressing, RemoveThenLookupPastTombstones) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(long long), __truk_map_hash_i64,
+                          __truk_map_cmp_mem);
+
+  for (long long i = 0; i < 5000; i++) {
+    __truk_map_set_generic(&map, &i, (int)i);
+  }
+  for (long long i = 0; i < 5000; i += 2) {
+    __truk_map_remove_generic(&map, &i);
+  }
+
+  CHECK_EQUAL(2500, map.base.nnodes);
+  for (long long i = 0; i < 5000; i++) {
+    int *val = __TRUK_MAP_GET_INT(&map, &i);
+    if (i % 2 == 0) {
+      POINTERS_EQUAL(NULL, val);
+    } else {
+      CHECK(val != NULL);
+      CHECK_EQUAL((int)i, *val);
+    }
+  }
+
+  __truk_map_deinit(&map);
+}
+
+TEST(MapOpenAddressing, MixedKeyAndValueSizes) {
+  typedef struct {
+    double x;
+    double y;
+    char tag;
+  } point_t;
+  __truk_map_t(point_t) map;
+  __truk_map_init_generic(&map, sizeof(char), __truk_map_hash_u8,
+                          __truk_map_cmp_mem);
+
+  for (int i = 0; i < 200; i++) {
+    unsigned char key = (unsigned char)i;
+    point_t p = {i * 1.5, i * 2.5, (char)(i & 0x7f)};
+    __truk_map_set_generic(&map, &key, p);
+  }
+
+  CHECK_EQUAL(200, map.base.nnodes);
+  CHECK_EQUAL(0, map.base.voffset % 8);
+  CHECK_EQUAL(0, map.base.slotsize % 8);
+  for (int i = 0; i < 200; i++) {
+    unsigned char key = (unsigned char)i;
+    point_t *p = (point_t *)__truk_map_get_(&map.base, &key);
+    CHECK(p != NULL);
+    DOUBLES_EQUAL(i * 1.5, p->x, 0.0);
+    DOUBLES_EQUAL(i * 2.5, p->y, 0.0);
+    CHECK_EQUAL((char)(i & 0x7f), p->tag);
+  }
+
+  __truk_map_deinit(&map);
+}
+
+TEST(MapOpenAddressing, IteratorVisitsEachKeyOnce) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(int), __truk_map_hash_i32,
+                          __truk_map_cmp_mem);
+
+  static int seen[3000];
+  memset(seen, 0, sizeof(seen));
+  for (int i = 0; i < 3000; i++) {
+    __truk_map_set_generic(&map, &i, i * 2);
+  }
+  for (int i = 0; i < 3000; i += 3) {
+    __truk_map_remove_generic(&map, &i);
+  }
+
+  __truk_map_iter_t iter = __truk_map_iter(&map);
+  const int *key;
+  int count = 0;
+  while ((key = (const int *)__truk_map_next_generic(&map, &iter))) {
+    CHECK(*key % 3 != 0);
+    CHECK_EQUAL(0, seen[*key]);
+    seen[*key] = 1;
+    count++;
+  }
+  POINTERS_EQUAL(NULL, __truk_map_next_generic(&map, &iter));
+
+  CHECK_EQUAL(2000, count);
+  __truk_map_deinit(&map);
+}
+
+TEST(MapOpenAddressing, IteratorReturnsValueWithKey) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(long long), __truk_map_mixhash_64,
+                          __truk_map_cmp_mem);
+
+  for (long long i = 0; i < 500; i++) {
+    __truk_map_set_generic(&map, &i, (int)i * 3);
+  }
+
+  __truk_map_iter_t iter = __truk_map_iter(&map);
+  const long long *key;
+  void *value;
+  int count = 0;
+  while ((key = (const long long *)__truk_map_next_kv_generic(&map, &iter,
+                                                              &value))) {
+    POINTERS_EQUAL(__truk_map_get_(&map.base, key), value);
+    CHECK_EQUAL((int)*key * 3, *(int *)value);
+    count++;
+  }
+  POINTERS_EQUAL(NULL, value);
+  CHECK_EQUAL(500, count);
+
+  __truk_map_deinit(&map);
+}
+
+TEST_GROUP(MapHashing){};
+
+TEST(MapHashing, WidthsHashKeyBits) {
+  int i = -7;
+  unsigned u = (unsigned)-7;
+  float f = 1.5f;
+  unsigned fbits;
+  memcpy(&fbits, &f, sizeof(fbits));
+
+  CHECK_EQUAL(__truk_map_mixhash_32(&i, 4), __truk_map_mixhash_32(&u, 4));
+  CHECK_EQUAL(__truk_map_mixhash_32(&f, 4), __truk_map_mixhash_32(&fbits, 4));
+
+  long long a = 1, b = 2;
+  CHECK(__truk_map_mixhash_64(&a, 8) != __truk_map_mixhash_64(&b, 8));
+}
+
+TEST(MapHashing, SequentialKeysFillLowBits) {
+  enum { NBUCKETS = 1024, NKEYS = NBUCKETS * 8 };
+  static int counts[NBUCKETS];
+  memset(counts, 0, sizeof(counts));
+  for (long long i = 0; i < NKEYS; i++) {
+    long long key = i * 4096;
+    counts[__truk_map_mixhash_64(&key, 8) & (NBUCKETS - 1)]++;
+  }
+
+  int max = 0;
+  for (int i = 0; i < NBUCKETS; i++) {
+    max = counts[i] > max ? counts[i] : max;
+  }
+  CHECK(max < 32);
+}
+
+TEST(MapHashing, BytesCoverEveryLength) {
+  unsigned char buf[200];
+  for (int i = 0; i < 200; i++) {
+    buf[i] = (unsigned char)(i * 7 + 1);
+  }
+
+  unsigned long long prev = 0;
+  for (unsigned long len = 0; len <= 200; len++) {
+    unsigned long long h = __truk_map_hash_bytes(buf, len, 0);
+    CHECK_EQUAL(h, __truk_map_hash_bytes(buf, len, 0));
+    CHECK(h != prev);
+    CHECK(h != __truk_map_hash_bytes(buf, len, 1));
+    prev = h;
+  }
+}
+
+TEST(MapHashing, StrHashUsesContents) {
+  char a[] = "hello world";
+  char b[] = "hello world";
+  char c[] = "hello worle";
+  const char *pa = a, *pb = b, *pc = c;
+
+  CHECK_EQUAL(__truk_map_mixhash_str(&pa, sizeof(pa)),
+              __truk_map_mixhash_str(&pb, sizeof(pb)));
+  CHECK(__truk_map_mixhash_str(&pa, sizeof(pa)) !=
+        __truk_map_mixhash_str(&pc, sizeof(pc)));
+}
+
+TEST(MapHashing, MapWithMixHash) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(long long), __truk_map_mixhash_64,
+                          __truk_map_cmp_mem);
+
+  for (long long i = 0; i < 10000; i++) {
+    long long key = i << 12;
+    __truk_map_set_generic(&map, &key, (int)i);
+  }
+  for (long long i = 0; i < 10000; i++) {
+    long long key = i << 12;
+    int *val = __TRUK_MAP_GET_INT(&map, &key);
+    CHECK(val != NULL);
+    CHECK_EQUAL((int)i, *val);
+  }
+
+  __truk_map_deinit(&map);
+}
+
+static void *seed_init_worker(void *arg) {
+  __truk_map_seed_init();
+  *(unsigned long long *)arg = __truk_map_seed;
+  return NULL;
+}
+
+TEST(MapHashing, SeedInitIsSafeFromManyThreads) {
+  enum { NTHREADS = 8 };
+  pthread_t threads[NTHREADS];
+  unsigned long long seen[NTHREADS];
+  for (int t = 0; t < NTHREADS; t++) {
+    pthread_create(&threads[t], NULL, seed_init_worker, &seen[t]);
+  }
+  for (int t = 0; t < NTHREADS; t++) {
+    pthread_join(threads[t], NULL);
+  }
+
+  __truk_map_seed_init();
+  for (int t = 0; t < NTHREADS; t++) {
+    CHECK_EQUAL(__truk_map_seed, seen[t]);
+  }
+}
+
+TEST_GROUP(MapStringKeys){};
+
+TEST(MapStringKeys, LengthDistinguishesPrefixes) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(__truk_map_strkey_t),
+                          __truk_map_hash_strkey, __truk_map_cmp_strkey);
+
+  const char buf[] = {'a', 'b', 'c'};
+  __truk_map_strkey_t ab = {buf, 2};
+  __truk_map_strkey_t abc = {buf, 3};
+  __truk_map_set_generic(&map, &ab, 1);
+  __truk_map_set_generic(&map, &abc, 2);
+
+  CHECK_EQUAL(2, map.base.nnodes);
+  __truk_map_strkey_t lookup = __truk_map_strkey_cstr("ab");
+  int *val = __TRUK_MAP_GET_INT(&map, &lookup);
+  CHECK(val != NULL);
+  CHECK_EQUAL(1, *val);
+
+  lookup = __truk_map_strkey_cstr("abc");
+  val = __TRUK_MAP_GET_INT(&map, &lookup);
+  CHECK(val != NULL);
+  CHECK_EQUAL(2, *val);
+
+  lookup = __truk_map_strkey_cstr("a");
+  POINTERS_EQUAL(NULL, __truk_map_get_(&map.base, &lookup));
+
+  __truk_map_deinit(&map);
+}
+
+TEST(MapStringKeys, ManyKeys) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(__truk_map_strkey_t),
+                          __truk_map_hash_strkey, __truk_map_cmp_strkey);
+
+  static char names[2000][32];
+  for (int i = 0; i < 2000; i++) {
+    snprintf(names[i], sizeof(names[i]), "some/longer/path/key_%d", i);
+    __truk_map_strkey_t key = __truk_map_strkey_cstr(names[i]);
+    __truk_map_set_generic(&map, &key, i);
+  }
+
+  for (int i = 0; i < 2000; i++) {
+    char copy[32];
+    snprintf(copy, sizeof(copy), "some/longer/path/key_%d", i);
+    __truk_map_strkey_t key = __truk_map_strkey_cstr(copy);
+    int *val = __TRUK_MAP_GET_INT(&map, &key);
+    CHECK(val != NULL);
+    CHECK_EQUAL(i, *val);
+  }
+
+  __truk_map_iter_t iter = __truk_map_iter(&map);
+  const __truk_map_strkey_t *key;
+  int count = 0;
+  while ((key = (const __truk_map_strkey_t *)__truk_map_next_generic(&map,
+                                                                    &iter))) {
+    CHECK_EQUAL(strlen((const char *)key->data), key->len);
+    count++;
+  }
+  CHECK_EQUAL(2000, count);
+
+  __truk_map_deinit(&map);
+}
+
+TEST_GROUP(MapCapacity){};
+
+TEST(MapCapacity, ReserveAvoidsResizeDuringLoad) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(long long), __truk_map_mixhash_64,
+                          __truk_map_cmp_mem);
+
+  CHECK_EQUAL(0, __truk_map_reserve(&map, 10000));
+  unsigned nbuckets = map.base.nbuckets;
+  void *table = map.base.buckets;
+  CHECK(nbuckets - nbuckets / 8 >= 10000u);
+
+  for (long long i = 0; i < 10000; i++) {
+    __truk_map_set_generic(&map, &i, (int)i);
+  }
+
+  CHECK_EQUAL(nbuckets, map.base.nbuckets);
+  POINTERS_EQUAL(table, map.base.buckets);
+  long long key = 9999;
+  CHECK_EQUAL(9999, *__TRUK_MAP_GET_INT(&map, &key));
+
+  CHECK_EQUAL(0, __truk_map_reserve(&map, 16));
+  CHECK_EQUAL(nbuckets, map.base.nbuckets);
+
+  __truk_map_deinit(&map);
+}
+
+TEST(MapCapacity, ReserveBeyondLargestTableFails) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(long long), __truk_map_mixhash_64,
+                          __truk_map_cmp_mem);
+  long long key = 1;
+  __truk_map_set_generic(&map, &key, 1);
+  unsigned nbuckets = map.base.nbuckets;
+
+  /* Counts past what a 2^31-bucket table holds used to double the bucket
+   * count until it wrapped to zero, and never returned. */
+  CHECK_EQUAL(-1, __truk_map_reserve(&map, 0x70000001ULL));
+  CHECK_EQUAL(-1, __truk_map_reserve(&map, 0x7fffffffULL));
+  CHECK_EQUAL(-1, __truk_map_reserve(&map, 1ULL << 40));
+  CHECK_EQUAL(nbuckets, map.base.nbuckets);
+  CHECK_EQUAL(1, *__TRUK_MAP_GET_INT(&map, &key));
+
+  __truk_map_deinit(&map);
+}
+
+TEST(MapCapacity, ShrinkKeepsEntries) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(long long), __truk_map_mixhash_64,
+                          __truk_map_cmp_mem);
+
+  for (long long i = 0; i < 4096; i++) {
+    __truk_map_set_generic(&map, &i, (int)i);
+  }
+  unsigned nbuckets = map.base.nbuckets;
+  for (long long i = 100; i < 4096; i++) {
+    __truk_map_remove_generic(&map, &i);
+  }
+
+  CHECK_EQUAL(0, __truk_map_shrink(&map));
+  CHECK(map.base.nbuckets < nbuckets);
+  CHECK_EQUAL(map.base.nbuckets - map.base.nbuckets / 8 - 100,
+              map.base.growth_left);
+  for (long long i = 0; i < 4096; i++) {
+    int *val = __TRUK_MAP_GET_INT(&map, &i);
+    if (i < 100) {
+      CHECK(val != NULL);
+      CHECK_EQUAL((int)i, *val);
+    } else {
+      POINTERS_EQUAL(NULL, val);
+    }
+  }
+
+  __truk_map_deinit(&map);
+}
+
+TEST(MapCapacity, ShrinkEmptyReleasesTable) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(long long), __truk_map_mixhash_64,
+                          __truk_map_cmp_mem);
+
+  CHECK_EQUAL(0, __truk_map_shrink(&map));
+  CHECK_EQUAL(0, __truk_map_reserve(&map, 100));
+  CHECK_EQUAL(0, __truk_map_shrink(&map));
+  POINTERS_EQUAL(NULL, map.base.buckets);
+  CHECK_EQUAL(0u, map.base.nbuckets);
+
+  long long key = 5;
+  __truk_map_set_generic(&map, &key, 50);
+  CHECK_EQUAL(50, *__TRUK_MAP_GET_INT(&map, &key));
+
+  __truk_map_deinit(&map);
+}
+
+TEST_GROUP(MapIncremental){};
+
+TEST(MapIncremental, GrowthKeepsOldTableUntilMigrated) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(long long), __truk_map_mixhash_64,
+                          __truk_map_cmp_mem);
+  __truk_map_set_incremental(&map, 1);
+
+  long long i = 0;
+  unsigned nbuckets = 0;
+  for (; i < 100000; i++) {
+    __truk_map_set_generic(&map, &i, (int)i);
+    if (map.base.old_buckets) {
+      nbuckets = map.base.nbuckets;
+      break;
+    }
+  }
+  CHECK(nbuckets != 0);
+  CHECK(map.base.old_nnodes > 0);
+
+  /* Lookups see entries in both tables and never move them. */
+  unsigned migrate_pos = map.base.migrate_pos;
+  for (long long k = 0; k <= i; k++) {
+    int *val = __TRUK_MAP_GET_INT(&map, &k);
+    CHECK(val != NULL);
+    CHECK_EQUAL((int)k, *val);
+  }
+  CHECK_EQUAL(migrate_pos, map.base.migrate_pos);
+
+  while (map.base.old_buckets) {
+    i++;
+    __truk_map_set_generic(&map, &i, (int)i);
+  }
+  CHECK_EQUAL(nbuckets, map.base.nbuckets);
+  CHECK_EQUAL((unsigned)(i + 1), map.base.nnodes);
+  for (long long k = 0; k <= i; k++) {
+    CHECK_EQUAL((int)k, *__TRUK_MAP_GET_INT(&map, &k));
+  }
+
+  __truk_map_deinit(&map);
+}
+
+TEST(MapIncremental, UpdateRemoveAndIterateDuringMigration) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(long long), __truk_map_mixhash_64,
+                          __truk_map_cmp_mem);
+  __truk_map_set_incremental(&map, 1);
+
+  const long long n = 20000;
+  int seen_migrating = 0;
+  for (long long i = 0; i < n; i++) {
+    __truk_map_set_generic(&map, &i, (int)i);
+    if (map.base.old_buckets && i % 3 == 0) {
+      long long old = i / 2;
+      __truk_map_set_generic(&map, &old, -(int)old);
+      long long gone = i / 2 + 1;
+      __truk_map_remove_generic(&map, &gone);
+      seen_migrating = 1;
+    }
+  }
+  CHECK(seen_migrating);
+
+  /* Force a migration to be in flight while iterating. */
+  long long extra = n;
+  while (!map.base.old_buckets) {
+    __truk_map_set_generic(&map, &extra, (int)extra);
+    extra++;
+  }
+
+  unsigned count = 0;
+  __truk_map_iter_t iter = __truk_map_iter(&map);
+  const long long *key;
+  while ((key = (const long long *)__truk_map_next_generic(&map, &iter))) {
+    int *val = __TRUK_MAP_GET_INT(&map, key);
+    CHECK(val != NULL);
+    CHECK(*val == (int)*key || *val == -(int)*key);
+    count++;
+  }
+  CHECK_EQUAL(map.base.nnodes, count);
+
+  CHECK_EQUAL(0, __truk_map_shrink(&map));
+  POINTERS_EQUAL(NULL, map.base.old_buckets);
+  unsigned after = 0;
+  iter = __truk_map_iter(&map);
+  while (__truk_map_next_generic(&map, &iter)) {
+    after++;
+  }
+  CHECK_EQUAL(count, after);
+
+  __truk_map_deinit(&map);
+}
+
+TEST(MapIncremental, UpdatesDuringMigrationMoveNothing) {
+  __truk_map_int_t map;
+  __truk_map_init_generic(&map, sizeof(long long), __truk_map_mixhash_64,
+                          __truk_map_cmp_mem);
+  __truk_map_set_incremental(&map, 1);
+
+  long long n = 0;
+  while (n < 1000 || !map.base.old_buckets) {
+    __truk_map_set_generic(&map, &n, (int)n);
+    n++;
+  }
+
+  /* Pointers taken before a run of updates still point at their entries. */
+  enum { HELD = 32 };
+  int *held[HELD];
+  for (long long k = 0; k < HELD; k++) {
+    held[k] = __TRUK_MAP_GET_INT(&map, &k);
+    CHECK(held[k] != NULL);
+  }
+  unsigned migrate_pos = map.base.migrate_pos;
+  long long updated = 0;
+  for (int r = 0; r < 1000; r++) {
+    __truk_map_set_generic(&map, &updated, r);
+  }
+  CHECK_EQUAL(migrate_pos, map.base.migrate_pos);
+  CHECK_EQUAL(999, *held[0]);
+  for (long long k = 1; k < HELD; k++) {
+    POINTERS_EQUAL(held[k], __TRUK_MAP_GET_INT(&map, &k));
+    CHECK_EQUAL((int)k, *held[k]);
+  }
+
+  /* Rewriting every value while iterating, as an each callback assigning
+   * m[k] does, visits every entry exactly once. */
+  unsigned count = 0;
+  __truk_map_iter_t iter = __truk_map_iter(&map);
+  const long long *key;
+  void *val;
+  while ((key = (const long long *)__truk_map_next_kv_(&map.base, &iter,
+                                                         &val))) {
+    CHECK(*(int *)val >= 0);
+    __truk_map_set_generic(&map, key, -1 - (int)*key);
+    count++;
+  }
+  CHECK(map.base.old_buckets != NULL);
+  CHECK_EQUAL((unsigned)n, count);
+  CHECK_EQUAL(map.base.nnodes, count);
+  for (long long k = 0; k < n; k++) {
+    CHECK_EQUAL(-1 - (int)k, *__TRUK_MAP_GET_INT(&map, &k));
+  }
+
+  __truk_map_deinit(&map);
+}
+
+TEST_GROUP(ChainedMap){};
+
+TEST(ChainedMap, SetGetRemove) {
+  __truk_chained_map_t(int) map;
+  __truk_chained_map_init_generic(&map, sizeof(long long), __truk_map_hash_i64,
+                                  __truk_map_cmp_mem);
+
+  for (long long i = 0; i < 1000; i++) {
+    __truk_chained_map_set_generic(&map, &i, (int)i * 3);
+  }
+  for (long long i = 0; i < 1000; i += 2) {
+    __truk_chained_map_remove_generic(&map, &i);
+  }
+
+  CHECK_EQUAL(500, map.base.nnodes);
+  for (long long i = 0; i < 1000; i++) {
+    int *val = (int *)__truk_chained_map_get_(&map.base, &i);
+    if (i % 2 == 0) {
+      POINTERS_EQUAL(NULL, val);
+    } else {
+      CHECK(val != NULL);
+      CHECK_EQUAL((int)i * 3, *val);
+    }
+  }
+
+  __truk_chained_map_deinit(&map);
+}
+
+TEST(ChainedMap, ValuePointersSurviveGrowth) {
+  __truk_chained_map_t(int) map;
+  __truk_chained_map_init_generic(&map, sizeof(int), __truk_map_hash_i32,
+                                  __truk_map_cmp_mem);
+
+  int first = 0;
+  __truk_chained_map_set_generic(&map, &first, 42);
+  int *ref = (int *)__truk_chained_map_get_(&map.base, &first);
+  for (int i = 1; i < 1000; i++) {
+    __truk_chained_map_set_generic(&map, &i, i);
+  }
+
+  POINTERS_EQUAL(ref, __truk_chained_map_get_(&map.base, &first));
+  CHECK_EQUAL(42, *ref);
+
+  int count = 0;
+  __truk_chained_map_iter_t iter = __truk_chained_map_iter(&map);
+  while (__truk_chained_map_next_generic(&map, &iter)) {
+    count++;
+  }
+  CHECK_EQUAL(1000, count);
+
+  __truk_chained_map_deinit(&map);
+}
+
+TEST(ChainedMap, RemovedNodesAreRecycled) {
+  __truk_chained_map_t(long long) map;
+  __truk_chained_map_init_generic(&map, sizeof(long long),
+                                  __truk_map_mixhash_64, __truk_map_cmp_mem);
+
+  for (long long i = 0; i < 100; i++) {
+    __truk_chained_map_set_generic(&map, &i, i);
+  }
+  void *chunks = map.base.slab.chunks;
+  unsigned char *bump = map.base.slab.bump;
+
+  long long key = 17;
+  void *old_value = __truk_chained_map_get_(&map.base, &key);
+  __truk_chained_map_remove_generic(&map, &key);
+  key = 1000;
+  __truk_chained_map_set_generic(&map, &key, 7LL);
+
+  POINTERS_EQUAL(old_value, __truk_chained_map_get_(&map.base, &key));
+  POINTERS_EQUAL(chunks, map.base.slab.chunks);
+  POINTERS_EQUAL(bump, map.base.slab.bump);
+  CHECK_EQUAL(7, *(long long *)__truk_chained_map_get_(&map.base, &key));
+
+  __truk_chained_map_deinit(&map);
+}
+
+TEST_GROUP(OrderedMap){};
+
+TEST(OrderedMap, SetGetRemove) {
+  __truk_ordered_map_t(int) map;
+  __truk_ordered_map_init_generic(&map, sizeof(long long),
+                                  __truk_map_mixhash_64, __truk_map_cmp_mem);
+
+  for (long long i = 0; i < 1000; i++) {
+    CHECK_EQUAL(0, __truk_ordered_map_set_generic(&map, &i, (int)i * 3));
+  }
+  for (long long i = 0; i < 1000; i += 2) {
+    __truk_ordered_map_remove_generic(&map, &i);
+  }
+  long long key = 7;
+  __truk_ordered_map_set_generic(&map, &key, -7);
+
+  CHECK_EQUAL(500u, map.base.nnodes);
+  for (long long i = 0; i < 1000; i++) {
+    int *val = (int *)__truk_ordered_map_get_(&map.base, &i);
+    if (i % 2 == 0) {
+      POINTERS_EQUAL(NULL, val);
+    } else {
+      CHECK(val != NULL);
+      CHECK_EQUAL(i == 7 ? -7 : (int)i * 3, *val);
+    }
+  }
+
+  __truk_ordered_map_deinit(&map);
+}
+
+TEST(OrderedMap, IteratesInInsertionOrder) {
+  __truk_ordered_map_t(int) map;
+  __truk_ordered_map_init_generic(&map, sizeof(__truk_map_strkey_t),
+                                  __truk_map_hash_strkey,
+                                  __truk_map_cmp_strkey);
+
+  static char names[300][16];
+  for (int i = 0; i < 300; i++) {
+    snprintf(names[i], sizeof(names[i]), "k%d", (i * 7919) % 300);
+    __truk_map_strkey_t key = __truk_map_strkey_cstr(names[i]);
+    __truk_ordered_map_set_generic(&map, &key, i);
+  }
+  /* Removing and re-adding a key moves it to the end; updating does not. */
+  __truk_map_strkey_t first = __truk_map_strkey_cstr(names[0]);
+  __truk_ordered_map_remove_generic(&map, &first);
+  __truk_ordered_map_set_generic(&map, &first, 0);
+  __truk_map_strkey_t second = __truk_map_strkey_cstr(names[1]);
+  __truk_ordered_map_set_generic(&map, &second, 1);
+
+  __truk_ordered_map_iter_t iter = __truk_ordered_map_iter(&map);
+  const __truk_map_strkey_t *key;
+  void *value;
+  int expected = 1;
+  while ((key = (const __truk_map_strkey_t *)
+              __truk_ordered_map_next_kv_generic(&map, &iter, &value))) {
+    CHECK_EQUAL(expected, *(int *)value);
+    STRCMP_EQUAL(names[expected], (const char *)key->data);
+    expected = expected == 299 ? 0 : expected == 0 ? -1 : expected + 1;
+  }
+  CHECK_EQUAL(-1, expected);
+  POINTERS_EQUAL(NULL, value);
+
+  __truk_ordered_map_deinit(&map);
+}
+
+TEST(OrderedMap, ChurnCompactsHoles) {
+  __truk_ordered_map_t(int) map;
+  __truk_ordered_map_init_generic(&map, sizeof(int), __truk_map_mixhash_32,
+                                  __truk_map_cmp_mem);
+
+  for (int i = 0; i < 64; i++) {
+    __truk_ordered_map_set_generic(&map, &i, i);
+  }
+  unsigned nslots = map.base.nslots;
+  for (int i = 64; i < 10000; i++) {
+    int gone = i - 64;
+    __truk_ordered_map_remove_generic(&map, &gone);
+    __truk_ordered_map_set_generic(&map, &i, i);
+  }
+
+  /* One doubling at most; after that holes are compacted away. */
+  CHECK(map.base.nslots <= nslots * 2);
+  CHECK_EQUAL(64u, map.base.nnodes);
+  __truk_ordered_map_iter_t iter = __truk_ordered_map_iter(&map);
+  const int *key;
+  int expected = 10000 - 64;
+  while ((key = (const int *)__truk_ordered_map_next_generic(&map, &iter))) {
+    CHECK_EQUAL(expected++, *key);
+  }
+  CHECK_EQUAL(10000, expected);
+
+  CHECK_EQUAL(0, __truk_ordered_map_shrink(&map));
+  CHECK_EQUAL(map.base.nnodes, map.base.nused);
+  CHECK_EQUAL(0, __truk_ordered_map_reserve(&map, 5000));
+  CHECK(map.base.capacity >= 5000u);
+  int probe = 9999;
+  CHECK_EQUAL(9999, *(int *)__truk_ordered_map_get_(&map.base, &probe));
+
+  __truk_ordered_map_deinit(&map);
+}
+
+TEST_GROUP(ConcurrentMap){};
+
+TEST(ConcurrentMap, SetGetRemoveReusesNodes) {
+  __truk_concurrent_map_t(int) map;
+  __truk_concurrent_map_init_generic(&map, sizeof(int), __truk_map_mixhash_32,
+                                     __truk_map_cmp_mem);
+
+  for (int i = 0; i < 2000; i++) {
+    CHECK_EQUAL(0, __truk_concurrent_map_set_generic(&map, &i, i * 3));
+  }
+  int key = 5;
+  int *five = __truk_concurrent_map_get_generic(&map, &key);
+  for (int i = 2000; i < 20000; i++) {
+    __truk_concurrent_map_set_generic(&map, &i, i);
+  }
+  /* Values live outside the shard tables, so growth never moves them. */
+  POINTERS_EQUAL(five, __truk_concurrent_map_get_generic(&map, &key));
+  CHECK_EQUAL(15, *five);
+
+  __truk_concurrent_map_remove_generic(&map, &key);
+  POINTERS_EQUAL(NULL, __truk_concurrent_map_get_generic(&map, &key));
+  __truk_concurrent_map_set_generic(&map, &key, 50);
+  POINTERS_EQUAL(five, __truk_concurrent_map_get_generic(&map, &key));
+  CHECK_EQUAL(50, *five);
+  CHECK_EQUAL(20000ull, __truk_concurrent_map_count(&map));
+
+  __truk_concurrent_map_deinit(&map);
+}
+
+static int concurrent_map_fill(const void *key, void *value, void *ctx) {
+  ++*(int *)ctx;
+  *(int *)value = *(const int *)key * 10;
+  return *(const int *)key < 0;
+}
+
+TEST(ConcurrentMap, ComputeIfAbsentRunsOnce) {
+  __truk_concurrent_map_t(int) map;
+  __truk_concurrent_map_init_generic(&map, sizeof(int), __truk_map_mixhash_32,
+                                     __truk_map_cmp_mem);
+
+  int calls = 0;
+  int key = 4;
+  int *first = __truk_concurrent_map_compute_if_absent(
+      &map, &key, concurrent_map_fill, &calls);
+  int *second = __truk_concurrent_map_compute_if_absent(
+      &map, &key, concurrent_map_fill, &calls);
+  POINTERS_EQUAL(first, second);
+  CHECK_EQUAL(40, *first);
+  CHECK_EQUAL(1, calls);
+
+  key = -1;
+  POINTERS_EQUAL(NULL, __truk_concurrent_map_compute_if_absent(
+                           &map, &key, concurrent_map_fill, &calls));
+  POINTERS_EQUAL(NULL, __truk_concurrent_map_get_generic(&map, &key));
+
+  key = 4;
+  CHECK_EQUAL(40, *__truk_concurrent_map_get_or_insert_generic(&map, &key, 9));
+  key = 9;
+  CHECK_EQUAL(9, *__truk_concurrent_map_get_or_insert_generic(&map, &key, 9));
+  CHECK_EQUAL(2ull, __truk_concurrent_map_count(&map));
+
+  __truk_concurrent_map_deinit(&map);
+}
+
+TEST(ConcurrentMap, IterationVisitsEveryShardAndUnlocksEarlyExit) {
+  __truk_concurrent_map_t(long long) map;
+  __truk_concurrent_map_init_generic(&map, sizeof(long long),
+                                     __truk_map_mixhash_64, __truk_map_cmp_mem);
+  CHECK_EQUAL(0, __truk_concurrent_map_reserve(&map, 5000));
+
+  long long sum = 0;
+  for (long long i = 0; i < 5000; i++) {
+    __truk_concurrent_map_set_generic(&map, &i, i * 2);
+    sum += i;
+  }
+
+  __truk_concurrent_map_iter_t iter = __truk_concurrent_map_iter(&map);
+  const long long *key;
+  void *value;
+  long long seen = 0;
+  int n = 0;
+  while ((key = (const long long *)__truk_concurrent_map_next_kv_generic(
+              &map, &iter, &value))) {
+    CHECK_EQUAL(*key * 2, *(long long *)value);
+    seen += *key;
+    n++;
+  }
+  CHECK_EQUAL(5000, n);
+  CHECK_EQUAL(sum, seen);
+
+  iter = __truk_concurrent_map_iter(&map);
+  CHECK(__truk_concurrent_map_next_generic(&map, &iter) != NULL);
+  __truk_concurrent_map_iter_end(&map, &iter);
+  long long probe = 10;
+  CHECK_EQUAL(20, *__truk_concurrent_map_get_generic(&map, &probe));
+
+  CHECK_EQUAL(0, __truk_concurrent_map_shrink(&map));
+  CHECK_EQUAL(5000ull, __truk_concurrent_map_count(&map));
+  __truk_concurrent_map_deinit(&map);
+}
+
+TEST(ConcurrentMap, CopyOutGetsTakeTheValueUnderTheLock) {
+  __truk_concurrent_map_t(long long) map;
+  __truk_concurrent_map_init_generic(&map, sizeof(int), __truk_map_mixhash_32,
+                                     __truk_map_cmp_mem);
+
+  int key = 3;
+  long long out = 0;
+  POINTERS_EQUAL(NULL, __truk_concurrent_map_get_copy_(&map.base, &key, &out));
+  __truk_concurrent_map_set_generic(&map, &key, 30ll);
+  POINTERS_EQUAL(&out, __truk_concurrent_map_get_copy_(&map.base, &key, &out));
+  CHECK_EQUAL(30, out);
+  out = 99;
+  CHECK_EQUAL(30, *__truk_concurrent_map_get_generic(&map, &key));
+
+  long long value = 7;
+  POINTERS_EQUAL(&out, __truk_concurrent_map_get_or_insert_copy_(
+                           &map.base, &key, &value, &out));
+  CHECK_EQUAL(30, out);
+  key = 4;
+  POINTERS_EQUAL(&out, __truk_concurrent_map_get_or_insert_copy_(
+                           &map.base, &key, &value, &out));
+  CHECK_EQUAL(7, out);
+  CHECK_EQUAL(7, *__truk_concurrent_map_get_generic(&map, &key));
+
+  __truk_concurrent_map_deinit(&map);
+}
+
+TEST(ConcurrentMap, IterationHoldsNoLockBetweenEntries) {
+  __truk_concurrent_map_t(int) map;
+  __truk_concurrent_map_init_generic(&map, sizeof(int), __truk_map_mixhash_32,
+                                     __truk_map_cmp_mem);
+  for (int i = 0; i < 500; i++) {
+    __truk_concurrent_map_set_generic(&map, &i, i);
+  }
+
+  /* Each step touches the key just returned, which lives in the shard being
+   * scanned; with that shard's lock held this would deadlock. */
+  __truk_concurrent_map_iter_t iter = __truk_concurrent_map_iter(&map);
+  const int *key;
+  void *value;
+  int n = 0;
+  while ((key = (const int *)__truk_concurrent_map_next_kv_generic(
+              &map, &iter, &value))) {
+    int k = *key;
+    *(int *)value = -1;
+    if (k % 2) {
+      __truk_concurrent_map_remove_generic(&map, &k);
+    } else {
+      __truk_concurrent_map_set_generic(&map, &k, k + 1);
+    }
+    n++;
+  }
+  CHECK_EQUAL(500, n);
+  CHECK_EQUAL(250ull, __truk_concurrent_map_count(&map));
+  int probe = 10;
+  CHECK_EQUAL(11, *__truk_concurrent_map_get_generic(&map, &probe));
+
+  __truk_concurrent_map_deinit(&map);
+}
+
+typedef __truk_concurrent_map_t(int) concurrent_int_map_t;
+
+struct concurrent_map_worker_s {
+  concurrent_int_map_t *map;
+  int first;
+};
+
+static void *concurrent_map_worker(void *arg) {
+  concurrent_map_worker_s *w = (concurrent_map_worker_s *)arg;
+  for (int i = 0; i < 4000; i++) {
+    int key = w->first + i;
+    __truk_concurrent_map_set_generic(w->map, &key, key);
+    /* Every thread also counts into a few shared keys. */
+    int shared = i % 8;
+    int zero = 0;
+    int *counter =
+        __truk_concurrent_map_get_or_insert_generic(w->map, &shared, zero);
+    (void)counter;
+    if (i % 3 == 0) {
+      __truk_concurrent_map_remove_generic(w->map, &key);
+    }
+  }
+  return NULL;
+}
+
+TEST(ConcurrentMap, ThreadsInsertAndRemoveDisjointKeys) {
+  concurrent_int_map_t map;
+  __truk_concurrent_map_init_generic(&map, sizeof(int), __truk_map_mixhash_32,
+                                     __truk_map_cmp_mem);
+
+  pthread_t threads[4];
+  concurrent_map_worker_s workers[4];
+  for (int t = 0; t < 4; t++) {
+    workers[t].map = &map;
+    workers[t].first = 100 + t * 10000;
+    pthread_create(&threads[t], NULL, concurrent_map_worker, &workers[t]);
+  }
+  for (int t = 0; t < 4; t++) {
+    pthread_join(threads[t], NULL);
+  }
+
+  CHECK_EQUAL(8ull + 4 * (4000 - 1334), __truk_concurrent_map_count(&map));
+  for (int t = 0; t < 4; t++) {
+    for (int i = 0; i < 4000; i++) {
+      int key = workers[t].first + i;
+      int *val = __truk_concurrent_map_get_generic(&map, &key);
+      if (i % 3 == 0) {
+        POINTERS_EQUAL(NULL, val);
+      } else {
+        CHECK(val != NULL);
+        CHECK_EQUAL(key, *val);
+      }
+    }
+  }
+
+  __truk_concurrent_map_deinit(&map);
+}
+
 int main(int argc, char **argv) {
   return CommandLineTestRunner::RunAllTests(argc, argv);
 }
@@ -1,5 +1,6 @@
 #include <CppUTest/CommandLineTestRunner.h>
 #include <CppUTest/TestHarness.h>
+#include <pthread.h>
 #include <sxs/runtime.h>
 #include <sxs/types.h>
 
@@ -56,6 +57,105 @@ TEST(SxsAllocation, AllocArrayZeroCount) {
   __truk_runtime_sxs_free_array(ptr);
 }
 
+static __truk_u32 cached(__truk_u64 size) {
+  return __TRUK_OBJECT_CACHE()
+      ->count[__truk_runtime_sxs_object_class(size)];
+}
+
+static int counting_allocs = 0;
+
+static __truk_void *counting_alloc(__truk_allocator_t *self, __truk_u64 size) {
+  (void)self;
+  counting_allocs++;
+  return malloc(size);
+}
+
+static __truk_void counting_free(__truk_allocator_t *self, __truk_void *ptr) {
+  (void)self;
+  counting_allocs--;
+  free(ptr);
+}
+
+TEST_GROUP(SxsObjectCache){};
+
+TEST(SxsObjectCache, ReusesFreedObjectOfSameClass) {
+  __truk_void *p = __truk_runtime_sxs_alloc_object(24);
+  __truk_runtime_sxs_free_object(p, 24);
+  POINTERS_EQUAL(p, __truk_runtime_sxs_alloc_object(32));
+  __truk_runtime_sxs_free_object(p, 32);
+}
+
+TEST(SxsObjectCache, ClassesAreKeptApart) {
+  __truk_void *p = __truk_runtime_sxs_alloc_object(24);
+  __truk_runtime_sxs_free_object(p, 24);
+  __truk_void *q = __truk_runtime_sxs_alloc_object(8);
+  CHECK(p != q);
+  __truk_runtime_sxs_free_object(q, 8);
+  POINTERS_EQUAL(p, __truk_runtime_sxs_alloc_object(17));
+  free(p);
+}
+
+TEST(SxsObjectCache, ForeignBlocksTooSmallForClassAreFreed) {
+  /* A 20-byte malloc block deleted as a 20-byte object falls in the 32-byte
+   * class; caching it would hand a short block to the next make of 32. */
+  __truk_u32 before = cached(20);
+  __truk_void *p = malloc(20);
+  __truk_runtime_sxs_free_object(p, 20);
+  CHECK_EQUAL(before, cached(20));
+}
+
+TEST(SxsObjectCache, LargeObjectsBypassCache) {
+  __truk_u32 before = cached(__TRUK_OBJECT_MAX_SIZE);
+  __truk_void *p = __truk_runtime_sxs_alloc_object(__TRUK_OBJECT_MAX_SIZE + 1);
+  __truk_runtime_sxs_free_object(p, __TRUK_OBJECT_MAX_SIZE + 1);
+  CHECK_EQUAL(before, cached(__TRUK_OBJECT_MAX_SIZE));
+}
+
+TEST(SxsObjectCache, CurrentAllocatorBypassesCache) {
+  __truk_allocator_t counting = {counting_alloc, counting_free, NULL, NULL};
+  __truk_u32 before = cached(16);
+  __truk_runtime_sxs_set_thread_allocator(&counting);
+  __truk_void *p = __truk_runtime_sxs_alloc_object(16);
+  CHECK_EQUAL(1, counting_allocs);
+  __truk_runtime_sxs_free_object(p, 16);
+  __truk_runtime_sxs_set_thread_allocator(NULL);
+  CHECK_EQUAL(0, counting_allocs);
+  CHECK_EQUAL(before, cached(16));
+}
+
+TEST(SxsObjectCache, FullClassSpillsHalf) {
+  enum { COUNT = 1000, SIZE = __TRUK_OBJECT_MAX_SIZE };
+  const __truk_u32 limit = __TRUK_OBJECT_CACHE_UNITS / (SIZE / 16);
+  __truk_void *ptrs[COUNT];
+  for (int i = 0; i < COUNT; i++) {
+    ptrs[i] = __truk_runtime_sxs_alloc_object(SIZE);
+  }
+  for (int i = 0; i < COUNT; i++) {
+    __truk_runtime_sxs_free_object(ptrs[i], SIZE);
+    CHECK(cached(SIZE) <= limit);
+  }
+  CHECK(cached(SIZE) >= limit / 2);
+}
+
+static void *free_on_worker(void *arg) {
+  __truk_void **ptrs = (__truk_void **)arg;
+  for (int i = 0; i < 64; i++) {
+    __truk_runtime_sxs_free_object(ptrs[i], 48);
+  }
+  CHECK_EQUAL(64, cached(48));
+  return NULL;
+}
+
+TEST(SxsObjectCache, ObjectsMayBeFreedOnAnotherThread) {
+  __truk_void *ptrs[64];
+  pthread_t worker;
+  for (int i = 0; i < 64; i++) {
+    ptrs[i] = __truk_runtime_sxs_alloc_object(48);
+  }
+  pthread_create(&worker, NULL, free_on_worker, ptrs);
+  pthread_join(worker, NULL);
+}
+
 TEST_GROUP(SxsSizeof){};
 
 TEST(SxsSizeof, BasicTypes) {
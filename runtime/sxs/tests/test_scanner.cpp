@@ -0,0 +1,397 @@
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+extern "C" {
+#include <stdlib.h>
+#include <string.h>
+#include <sxs/ds/scanner.h>
+}
+
+static const __truk_u8 *bytes(const char *s) {
+  return (const __truk_u8 *)s;
+}
+
+static __truk_scanner_t scanner_over(const char *s) {
+  __truk_scanner_t scanner = {bytes(s), strlen(s), 0};
+  return scanner;
+}
+
+TEST_GROUP(GroupScanner){};
+
+TEST(GroupScanner, MatchesNestedParentheses) {
+  __truk_scanner_t scanner = scanner_over("(outer(inner))");
+  __truk_scanner_group_t group = __truk_scanner_find_group(
+      &scanner, '(', ')', __TRUK_SCANNER_NO_ESCAPE, false);
+  CHECK_TRUE(group.success);
+  CHECK_EQUAL(0, group.index_of_start_symbol);
+  CHECK_EQUAL(13, group.index_of_closing_symbol);
+  CHECK_EQUAL(13, scanner.position);
+
+  scanner = scanner_over("(a(b(c(d(e)f)g)h)i)");
+  group = __truk_scanner_find_group(&scanner, '(', ')',
+                                    __TRUK_SCANNER_NO_ESCAPE, false);
+  CHECK_EQUAL(18, group.index_of_closing_symbol);
+}
+
+TEST(GroupScanner, SameDelimitersStopAtFirstClose) {
+  __truk_scanner_t scanner = scanner_over("|outer|inner||");
+  __truk_scanner_group_t group = __truk_scanner_find_group(
+      &scanner, '|', '|', __TRUK_SCANNER_NO_ESCAPE, false);
+  CHECK_TRUE(group.success);
+  CHECK_EQUAL(6, group.index_of_closing_symbol);
+}
+
+TEST(GroupScanner, EscapesSkipTheNextByte) {
+  __truk_scanner_t scanner = scanner_over("\"hello \\\"world\\\"\"");
+  __truk_scanner_group_t group =
+      __truk_scanner_find_group(&scanner, '"', '"', '\\', false);
+  CHECK_TRUE(group.success);
+  CHECK_EQUAL(16, group.index_of_closing_symbol);
+
+  // An escaped escape leaves the delimiter after it live.
+  scanner = scanner_over("(a\\\\)b)");
+  group = __truk_scanner_find_group(&scanner, '(', ')', '\\', false);
+  CHECK_EQUAL(4, group.index_of_closing_symbol);
+
+  scanner = scanner_over("(text with \\) inside)");
+  group = __truk_scanner_find_group(&scanner, '(', ')', '\\', false);
+  CHECK_EQUAL(20, group.index_of_closing_symbol);
+}
+
+TEST(GroupScanner, LeadingWhitespace) {
+  __truk_scanner_t scanner = scanner_over("   (hello)");
+  __truk_scanner_group_t group = __truk_scanner_find_group(
+      &scanner, '(', ')', __TRUK_SCANNER_NO_ESCAPE, false);
+  CHECK_FALSE(group.success);
+  group = __truk_scanner_find_group(&scanner, '(', ')',
+                                    __TRUK_SCANNER_NO_ESCAPE, true);
+  CHECK_TRUE(group.success);
+  CHECK_EQUAL(3, group.index_of_start_symbol);
+  CHECK_EQUAL(9, group.index_of_closing_symbol);
+}
+
+TEST(GroupScanner, FailuresLeavePositionUnchanged) {
+  const char *cases[] = {"(hello", "[hello)", "(a(b)", "(hello\\)", ""};
+  for (const char *input : cases) {
+    __truk_scanner_t scanner = scanner_over(input);
+    __truk_scanner_group_t group =
+        __truk_scanner_find_group(&scanner, '(', ')', '\\', false);
+    CHECK_FALSE(group.success);
+    CHECK_EQUAL(0, scanner.position);
+  }
+  __truk_scanner_t scanner = scanner_over("(x)");
+  CHECK_FALSE(__truk_scanner_find_group(&scanner, '(', ')', '(', false).success);
+  CHECK_FALSE(__truk_scanner_find_group(NULL, '(', ')', '\\', false).success);
+}
+
+TEST(GroupScanner, ScanGroupEntryPoint) {
+  const __truk_u8 *s = bytes("f(x, (y)) z");
+  CHECK_EQUAL(8, __truk_scan_group(s, 11, 1, '(', ')', -1));
+  CHECK_EQUAL(11, __truk_scan_group(s, 11, 0, '(', ')', -1));
+  CHECK_EQUAL(11, __truk_scan_group(s, 11, 40, '(', ')', -1));
+}
+
+TEST_GROUP(StaticScanner){};
+
+TEST(StaticScanner, ClassifiesTokens) {
+  __truk_scanner_t scanner = scanner_over("alpha 42 -3.14  +x +99 - foo-bar");
+  const __truk_scanner_type_e types[] = {
+      __TRUK_SCANNER_SYMBOL,  __TRUK_SCANNER_INTEGER, __TRUK_SCANNER_REAL,
+      __TRUK_SCANNER_SYMBOL,  __TRUK_SCANNER_INTEGER, __TRUK_SCANNER_SYMBOL,
+      __TRUK_SCANNER_SYMBOL};
+  const char *texts[] = {"alpha", "42", "-3.14", "+x", "+99", "-", "foo-bar"};
+  for (int i = 0; i < 7; i++) {
+    __truk_scanner_static_t token =
+        __truk_scanner_read_static(&scanner, NULL, 0);
+    CHECK_TRUE(token.success);
+    CHECK_EQUAL(types[i], token.type);
+    CHECK_EQUAL(strlen(texts[i]), token.byte_length);
+    MEMCMP_EQUAL(texts[i], token.data, token.byte_length);
+  }
+  __truk_scanner_static_t end = __truk_scanner_read_static(&scanner, NULL, 0);
+  CHECK_FALSE(end.success);
+  CHECK_EQUAL(__TRUK_SCANNER_NONE, end.type);
+}
+
+TEST(StaticScanner, MalformedNumbersReportErrorPosition) {
+  const char *cases[] = {"1.2.3", "123x", "1. ", "3.14x", "7."};
+  const __truk_u64 errors[] = {3, 3, 2, 4, 2};
+  for (int i = 0; i < 5; i++) {
+    __truk_scanner_t scanner = scanner_over(cases[i]);
+    __truk_scanner_static_t token =
+        __truk_scanner_read_static(&scanner, NULL, 0);
+    CHECK_FALSE(token.success);
+    CHECK_TRUE(token.type != __TRUK_SCANNER_NONE);
+    CHECK_EQUAL(0, token.start_position);
+    CHECK_EQUAL(errors[i], token.error_position);
+    CHECK_EQUAL(0, scanner.position);
+  }
+}
+
+TEST(StaticScanner, StopSymbolsAreNotConsumed) {
+  const __truk_u8 stops[] = {'(', ')'};
+  __truk_scanner_t scanner = scanner_over("(add 42 3.14)");
+  scanner.position = 1;
+  __truk_scanner_static_t token =
+      __truk_scanner_read_static(&scanner, stops, 2);
+  CHECK_EQUAL(__TRUK_SCANNER_SYMBOL, token.type);
+  token = __truk_scanner_read_static(&scanner, stops, 2);
+  CHECK_EQUAL(__TRUK_SCANNER_INTEGER, token.type);
+  token = __truk_scanner_read_static(&scanner, stops, 2);
+  CHECK_EQUAL(__TRUK_SCANNER_REAL, token.type);
+  CHECK_EQUAL(12, scanner.position);
+
+  // A stop symbol where a token would start is not a token.
+  token = __truk_scanner_read_static(&scanner, stops, 2);
+  CHECK_FALSE(token.success);
+  CHECK_EQUAL(__TRUK_SCANNER_NONE, token.type);
+  CHECK_EQUAL(12, token.error_position);
+}
+
+TEST(StaticScanner, ScanTokenEntryPoint) {
+  const __truk_u8 *s = bytes("  key=12 ");
+  __truk_u64 start = 0, end = 0;
+  CHECK_EQUAL(3, __truk_scan_token(s, 9, 0, bytes("="), 1, &start, &end));
+  CHECK_EQUAL(2, start);
+  CHECK_EQUAL(5, end);
+  CHECK_EQUAL(0, __truk_scan_token(s, 9, 5, bytes("="), 1, &start, &end));
+  CHECK_EQUAL(5, start);
+  CHECK_EQUAL(1, __truk_scan_token(s, 9, 6, bytes("="), 1, &start, &end));
+  CHECK_EQUAL(8, end);
+  CHECK_EQUAL(0, __truk_scan_token(s, 9, 8, NULL, 0, &start, &end));
+  CHECK_EQUAL(9, start);
+  CHECK_EQUAL(-1, __truk_scan_token(bytes("1x"), 2, 0, NULL, 0, &start, &end));
+  CHECK_EQUAL(1, end);
+}
+
+// Stress: random inputs checked against a plain reference scanner and
+// against every way of cutting the input into two or three chunks.
+
+static unsigned long long stress_state = 1;
+
+static unsigned stress_next(void) {
+  stress_state = stress_state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (unsigned)(stress_state >> 33);
+}
+
+static __truk_u64 reference_group(const __truk_u8 *data, __truk_u64 len,
+                                  __truk_u8 open, __truk_u8 close,
+                                  int escape) {
+  long depth = 1;
+  if (len == 0 || data[0] != open) {
+    return len;
+  }
+  for (__truk_u64 i = 1; i < len; i++) {
+    if (escape >= 0 && data[i] == escape) {
+      i++;
+    } else if (data[i] == close) {
+      if (--depth == 0) {
+        return i;
+      }
+    } else if (data[i] == open) {
+      depth++;
+    }
+  }
+  return len;
+}
+
+static __truk_u64 chunked_group(const __truk_u8 *data, __truk_u64 len,
+                                __truk_u64 cut1, __truk_u64 cut2,
+                                __truk_u8 open, __truk_u8 close, int escape) {
+  __truk_scanner_group_stream_t stream;
+  const __truk_u64 cuts[] = {0, cut1, cut2, len};
+  __truk_scanner_group_begin(&stream, open, close, escape, false);
+  for (int k = 0; k < 3; k++) {
+    __truk_u64 used;
+    __truk_scanner_status_e status = __truk_scanner_group_feed(
+        &stream, data + cuts[k], cuts[k + 1] - cuts[k], &used);
+    if (status == __TRUK_SCANNER_DONE) {
+      CHECK_EQUAL(stream.end + 1, cuts[k] + used);
+      return stream.end;
+    }
+    if (status == __TRUK_SCANNER_FAIL) {
+      return len;
+    }
+  }
+  return len;
+}
+
+TEST_GROUP(ScannerStress){};
+
+TEST(ScannerStress, GroupMatchesReference) {
+  const char alphabet[] = "(()) ab\\\\\"";
+  __truk_u8 buf[200];
+  for (int round = 0; round < 3000; round++) {
+    __truk_u64 len = 1 + stress_next() % sizeof(buf);
+    bool quoted = round % 3 == 0;
+    int escape = round % 2 ? '\\' : -1;
+    __truk_u8 open = quoted ? '"' : '(';
+    __truk_u8 close = quoted ? '"' : ')';
+    for (__truk_u64 i = 0; i < len; i++) {
+      buf[i] = (__truk_u8)alphabet[stress_next() % (sizeof(alphabet) - 1)];
+    }
+    buf[0] = open;
+    __truk_u64 expected = reference_group(buf, len, open, close, escape);
+    CHECK_EQUAL(expected, __truk_scan_group(buf, len, 0, open, close, escape));
+    for (int k = 0; k < 4; k++) {
+      __truk_u64 cut1 = stress_next() % (len + 1);
+      __truk_u64 cut2 = cut1 + stress_next() % (len - cut1 + 1);
+      CHECK_EQUAL(expected,
+                  chunked_group(buf, len, cut1, cut2, open, close, escape));
+    }
+  }
+}
+
+TEST(ScannerStress, DeepNestingAcrossEveryChunkSize) {
+  const __truk_u64 depth = 5000;
+  __truk_u8 *buf = (__truk_u8 *)malloc(depth * 2);
+  memset(buf, '(', depth);
+  memset(buf + depth, ')', depth);
+  CHECK_EQUAL(depth * 2 - 1, __truk_scan_group(buf, depth * 2, 0, '(', ')', -1));
+  CHECK_EQUAL(depth * 2 - 2, __truk_scan_group(buf, depth * 2, 1, '(', ')', -1));
+  for (__truk_u64 size = 1; size <= 70; size++) {
+    __truk_scanner_group_stream_t stream;
+    __truk_scanner_status_e status = __TRUK_SCANNER_MORE;
+    __truk_u64 at = 0, used = 0;
+    __truk_scanner_group_begin(&stream, '(', ')', '\\', false);
+    while (status == __TRUK_SCANNER_MORE && at < depth * 2) {
+      __truk_u64 n = depth * 2 - at < size ? depth * 2 - at : size;
+      status = __truk_scanner_group_feed(&stream, buf + at, n, &used);
+      at += used;
+    }
+    CHECK_EQUAL(__TRUK_SCANNER_DONE, status);
+    CHECK_EQUAL(depth * 2 - 1, stream.end);
+  }
+  free(buf);
+}
+
+struct token_s {
+  int status;
+  __truk_scanner_type_e type;
+  __truk_u64 start, length, error;
+};
+
+// Tokenizes the input fed in chunks of the given size.
+static int stream_tokens(const __truk_u8 *data, __truk_u64 len,
+                         __truk_u64 size, const __truk_u8 *stops,
+                         __truk_u64 stop_count, token_s *out, int max) {
+  __truk_scanner_static_stream_t stream;
+  __truk_u64 at = 0;
+  int n = 0;
+  __truk_scanner_static_begin(&stream, stops, stop_count);
+  for (;;) {
+    __truk_u64 chunk_end = at + size < len ? at + size : len;
+    while (at < chunk_end) {
+      __truk_u64 used;
+      __truk_scanner_status_e status = __truk_scanner_static_feed(
+          &stream, data + at, chunk_end - at, &used);
+      at += used;
+      if (status == __TRUK_SCANNER_MORE) {
+        continue;
+      }
+      out[n++] = {status, stream.type, stream.start, stream.length,
+                  stream.error};
+      if (n == max || status == __TRUK_SCANNER_FAIL) {
+        return n;
+      }
+    }
+    if (at == len) {
+      __truk_scanner_status_e status = __truk_scanner_static_finish(&stream);
+      if (status != __TRUK_SCANNER_END) {
+        out[n++] = {status, stream.type, stream.start, stream.length,
+                    stream.error};
+      }
+      return n;
+    }
+  }
+}
+
+TEST(ScannerStress, StreamingTokensMatchBufferScan) {
+  const char alphabet[] = "0123456789.+-ab ()\n";
+  const __truk_u8 stops[] = {'(', ')'};
+  __truk_u8 buf[96];
+  token_s whole[96], chunked[96];
+  for (int round = 0; round < 3000; round++) {
+    __truk_u64 len = stress_next() % sizeof(buf);
+    for (__truk_u64 i = 0; i < len; i++) {
+      buf[i] = (__truk_u8)alphabet[stress_next() % (sizeof(alphabet) - 1)];
+    }
+
+    // Reference: repeated buffer reads, stepping over stop symbols.
+    __truk_scanner_t scanner = {buf, len, 0};
+    int expected = 0;
+    for (;;) {
+      __truk_scanner_static_t token =
+          __truk_scanner_read_static(&scanner, stops, 2);
+      if (token.success) {
+        whole[expected++] = {__TRUK_SCANNER_DONE, token.type,
+                             token.start_position, token.byte_length, 0};
+        continue;
+      }
+      if (token.type == __TRUK_SCANNER_NONE &&
+          token.error_position < len) {
+        whole[expected++] = {__TRUK_SCANNER_FAIL, token.type,
+                             token.start_position, 0, token.error_position};
+        scanner.position = token.error_position + 1;
+        continue;
+      }
+      if (token.type != __TRUK_SCANNER_NONE) {
+        whole[expected++] = {__TRUK_SCANNER_FAIL, token.type,
+                             token.start_position, 0, token.error_position};
+      }
+      break;
+    }
+
+    for (__truk_u64 size = 1; size <= len; size += 1 + size / 4) {
+      // The streaming tokenizer stops at a stop symbol; resume past it the
+      // same way the reference does.
+      int got = 0;
+      __truk_u64 base = 0;
+      while (base <= len) {
+        token_s part[96];
+        int n = stream_tokens(buf + base, len - base, size, stops, 2, part,
+                              96);
+        for (int k = 0; k < n; k++) {
+          part[k].start += base;
+          part[k].error += base;
+          chunked[got++] = part[k];
+        }
+        if (n == 0 || part[n - 1].status != __TRUK_SCANNER_FAIL ||
+            part[n - 1].type != __TRUK_SCANNER_NONE) {
+          break;
+        }
+        base = part[n - 1].error + 1;
+      }
+      CHECK_EQUAL(expected, got);
+      for (int k = 0; k < expected; k++) {
+        CHECK_EQUAL(whole[k].status, chunked[k].status);
+        CHECK_EQUAL(whole[k].type, chunked[k].type);
+        CHECK_EQUAL(whole[k].start, chunked[k].start);
+        if (whole[k].status == __TRUK_SCANNER_DONE) {
+          CHECK_EQUAL(whole[k].length, chunked[k].length);
+        } else {
+          CHECK_EQUAL(whole[k].error, chunked[k].error);
+        }
+      }
+    }
+  }
+}
+
+TEST(ScannerStress, LongSymbolsUseTheVectorPath) {
+  __truk_u8 buf[300];
+  const __truk_u8 stops[] = {';'};
+  for (__truk_u64 len = 1; len < 280; len++) {
+    memset(buf, 'x', sizeof(buf));
+    buf[len] = len % 2 ? ';' : '\t';
+    __truk_scanner_t scanner = {buf, sizeof(buf), 0};
+    __truk_scanner_static_t token =
+        __truk_scanner_read_static(&scanner, stops, 1);
+    CHECK_TRUE(token.success);
+    CHECK_EQUAL(__TRUK_SCANNER_SYMBOL, token.type);
+    CHECK_EQUAL(len, token.byte_length);
+  }
+}
+
+int main(int argc, char **argv) {
+  return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,186 @@
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+#include <string>
+#include <unistd.h>
+
+extern "C" {
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sxs/test.h>
+}
+
+static void passes(__truk_test_context_s *t) {
+  __truk_test_assert_i32(t, 1, 1, "one");
+  __truk_test_assert_i32(t, 2, 2, "two");
+}
+
+static void fails(__truk_test_context_s *t) {
+  __truk_test_log(t, "before");
+  __truk_test_assert_i32(t, 1, 2, "mismatch");
+}
+
+static void crashes(__truk_test_context_s *t) {
+  (void)t;
+  abort();
+}
+
+static void hangs(__truk_test_context_s *t) {
+  (void)t;
+  for (;;) {
+    pause();
+  }
+}
+
+static void slow_pass(__truk_test_context_s *t) {
+  usleep(50 * 1000);
+  __truk_test_assert_true(t, true, "slow");
+}
+
+static void mark_setup(__truk_test_context_s *t) {
+  __truk_test_log(t, "setup");
+}
+
+struct run_s {
+  int failed;
+  std::string output;
+};
+
+/* Runs the isolated runner with stdout captured. */
+static run_s run(const __truk_test_case_s *tests, int count,
+                 __truk_test_runner_s runner) {
+  run_s result;
+  char buf[4096];
+  size_t n;
+  FILE *capture = tmpfile();
+  CHECK_TRUE(capture != NULL);
+
+  fflush(stdout);
+  int saved = dup(STDOUT_FILENO);
+  dup2(fileno(capture), STDOUT_FILENO);
+  result.failed = __truk_test_run_isolated(tests, count, &runner, 0, NULL);
+  fflush(stdout);
+  dup2(saved, STDOUT_FILENO);
+  close(saved);
+
+  rewind(capture);
+  while ((n = fread(buf, 1, sizeof(buf), capture)) > 0) {
+    result.output.append(buf, n);
+  }
+  fclose(capture);
+  return result;
+}
+
+static bool contains(const std::string &text, const char *needle) {
+  return text.find(needle) != std::string::npos;
+}
+
+TEST_GROUP(IsolatedTestRunner){};
+
+TEST(IsolatedTestRunner, CountsFailuresAndReportsTimes) {
+  const __truk_test_case_s tests[] = {{"passes", passes}, {"fails", fails}};
+  __truk_test_runner_s runner = {NULL, NULL, 2, 0};
+  run_s result = run(tests, 2, runner);
+
+  CHECK_EQUAL(1, result.failed);
+  CHECK_TRUE(contains(result.output, "Running passes...\n  PASSED (2 "
+                                     "assertions, "));
+  CHECK_TRUE(contains(result.output, "    LOG: before\n    FAIL: Expected 1, "
+                                     "got 2 - mismatch\n  FAILED (1/1 "
+                                     "assertions, "));
+  CHECK_TRUE(contains(result.output, " ms)\n"));
+  CHECK_TRUE(contains(result.output, "\n1/2 tests passed\n"));
+}
+
+TEST(IsolatedTestRunner, CrashOnlyFailsItsOwnTest) {
+  const __truk_test_case_s tests[] = {
+      {"crashes", crashes}, {"passes", passes}, {"after", passes}};
+  __truk_test_runner_s runner = {NULL, NULL, 1, 0};
+  run_s result = run(tests, 3, runner);
+
+  CHECK_EQUAL(1, result.failed);
+  CHECK_TRUE(contains(result.output, "Running crashes...\n  CRASHED (signal "));
+  CHECK_TRUE(contains(result.output, "\n2/3 tests passed\n"));
+}
+
+TEST(IsolatedTestRunner, TimeoutKillsHangingTest) {
+  const __truk_test_case_s tests[] = {{"hangs", hangs}, {"passes", passes}};
+  __truk_test_runner_s runner = {NULL, NULL, 2, 100};
+  run_s result = run(tests, 2, runner);
+
+  CHECK_EQUAL(1, result.failed);
+  CHECK_TRUE(contains(result.output, "Running hangs...\n  TIMED OUT (after "
+                                     "100 ms)\n"));
+  CHECK_TRUE(contains(result.output, "Running passes...\n  PASSED"));
+}
+
+TEST(IsolatedTestRunner, OutputKeepsTestOrder) {
+  const __truk_test_case_s tests[] = {
+      {"first", slow_pass}, {"second", passes}, {"third", passes}};
+  __truk_test_runner_s runner = {mark_setup, NULL, 3, 0};
+  run_s result = run(tests, 3, runner);
+
+  CHECK_EQUAL(0, result.failed);
+  size_t first = result.output.find("Running first...\n    LOG: setup\n");
+  size_t second = result.output.find("Running second...\n    LOG: setup\n");
+  size_t third = result.output.find("Running third...\n    LOG: setup\n");
+  CHECK_TRUE(first != std::string::npos);
+  CHECK_TRUE(first < second);
+  CHECK_TRUE(second < third);
+  CHECK_TRUE(third != std::string::npos);
+}
+
+TEST(IsolatedTestRunner, RecordsEveryTest) {
+  char path[] = "/tmp/sxs-test-records-XXXXXX";
+  int fd = mkstemp(path);
+  CHECK_TRUE(fd >= 0);
+  close(fd);
+  setenv("TRUK_TEST_REPORT", path, 1);
+
+  const __truk_test_case_s tests[] = {{"slow", slow_pass}, {"fails", fails}};
+  __truk_test_runner_s runner = {NULL, NULL, 2, 0};
+  run(tests, 2, runner);
+  unsetenv("TRUK_TEST_REPORT");
+
+  char status[16], name[16];
+  int passed, failed;
+  unsigned long long wall, cpu;
+  FILE *records = fopen(path, "r");
+  CHECK_TRUE(records != NULL);
+  CHECK_EQUAL(6, fscanf(records, "%15s %15s %d %d %llu %llu", status, name,
+                        &passed, &failed, &wall, &cpu));
+  STRCMP_EQUAL("passed", status);
+  STRCMP_EQUAL("slow", name);
+  CHECK_EQUAL(1, passed);
+  CHECK_TRUE(wall >= 50ULL * 1000 * 1000);
+  CHECK_EQUAL(6, fscanf(records, "%15s %15s %d %d %llu %llu", status, name,
+                        &passed, &failed, &wall, &cpu));
+  STRCMP_EQUAL("failed", status);
+  STRCMP_EQUAL("fails", name);
+  CHECK_EQUAL(1, failed);
+  fclose(records);
+  unlink(path);
+}
+
+TEST_GROUP(TestTiming){};
+
+TEST(TestTiming, MeasuresWallAndCpuTime) {
+  __truk_test_context_s ctx;
+  memset(&ctx, 0, sizeof(ctx));
+  __truk_test_begin(&ctx);
+  volatile unsigned long long spin = 0;
+  for (unsigned long long i = 0; i < 20000000ULL; i++) {
+    spin = spin + i;
+  }
+  usleep(20 * 1000);
+  __truk_test_end(&ctx);
+
+  CHECK_TRUE(ctx.wall_ns >= 20ULL * 1000 * 1000);
+  CHECK_TRUE(ctx.cpu_ns > 0);
+  CHECK_TRUE(ctx.cpu_ns < ctx.wall_ns);
+}
+
+int main(int argc, char **argv) {
+  return CommandLineTestRunner::RunAllTests(argc, argv);
+}
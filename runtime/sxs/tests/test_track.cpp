@@ -0,0 +1,248 @@
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+#include <pthread.h>
+#include <string>
+#include <unistd.h>
+
+extern "C" {
+#include <stdlib.h>
+#include <string.h>
+#include <sxs/runtime.h>
+}
+
+/* Built twice: with TRUK_TRACK_ALLOCS (test_sxs_track) and additionally with
+ * TRUK_TRACK_ALLOCS_SAMPLE (test_sxs_track_sampled). */
+
+static __truk_alloc_site_t make_site(const char *file, __truk_u64 line) {
+  __truk_alloc_site_t site = {file, line, 0, 0, 0, 0, 0, NULL};
+  return site;
+}
+
+static std::string report() {
+  int fds[2];
+  char buf[8192];
+  std::string text;
+  ssize_t n;
+  CHECK_EQUAL(0, pipe(fds));
+  __truk_runtime_sxs_track_report(fds[1]);
+  close(fds[1]);
+  while ((n = read(fds[0], buf, sizeof(buf))) > 0) {
+    text.append(buf, (size_t)n);
+  }
+  close(fds[0]);
+  return text;
+}
+
+#if !defined(TRUK_TRACK_ALLOCS_SAMPLE)
+
+/* First column (live bytes) of the report line for a site, or -1. */
+static long long live_bytes_of(const std::string &text, const char *site) {
+  size_t at = text.find(std::string("  ") + site + "\n");
+  if (at == std::string::npos) {
+    return -1;
+  }
+  size_t start = text.rfind('\n', at);
+  return std::stoll(text.substr(start == std::string::npos ? 0 : start + 1));
+}
+
+static __truk_void *bump_alloc(__truk_allocator_t *self, __truk_u64 size) {
+  (void)self;
+  return malloc(size);
+}
+
+static __truk_void bump_free(__truk_allocator_t *self, __truk_void *ptr) {
+  (void)self;
+  free(ptr);
+}
+
+static __truk_void bump_reset(__truk_allocator_t *self) { (void)self; }
+
+TEST_GROUP(TrackFull){};
+
+TEST(TrackFull, CountsLiveBytesPerSite) {
+  static __truk_alloc_site_t a = make_site("server.truk", 12);
+  static __truk_alloc_site_t b = make_site("server.truk", 40);
+  void *x = __truk_runtime_sxs_alloc_at(NULL, 100, &a);
+  void *y = __truk_runtime_sxs_alloc_at(NULL, 100, &a);
+  void *z = __truk_runtime_sxs_alloc_at(NULL, 50, &b);
+
+  CHECK_EQUAL(2, a.allocs);
+  CHECK_EQUAL(200, a.live_bytes);
+  CHECK_EQUAL(1, b.live_allocs);
+
+  __truk_runtime_sxs_free_with(NULL, x);
+  CHECK_EQUAL(100, a.live_bytes);
+  CHECK_EQUAL(1, a.live_allocs);
+  CHECK_EQUAL(200, a.bytes);
+
+  __truk_runtime_sxs_free_with(NULL, y);
+  __truk_runtime_sxs_free_with(NULL, z);
+  CHECK_EQUAL(0, a.live_bytes);
+  CHECK_EQUAL(0, b.live_bytes);
+}
+
+TEST(TrackFull, UntaggedAllocationsCountUnderRuntimeSite) {
+  long long before = live_bytes_of(report(), "<runtime>");
+  void *p = __truk_runtime_sxs_alloc(12345);
+  CHECK_EQUAL((before < 0 ? 0 : before) + 12345,
+              live_bytes_of(report(), "<runtime>"));
+  __truk_runtime_sxs_free(p);
+  CHECK_EQUAL(before < 0 ? 0 : before, live_bytes_of(report(), "<runtime>"));
+}
+
+TEST(TrackFull, VecGrowthIsTracked) {
+  static __truk_alloc_site_t site = make_site("vec.truk", 3);
+  __truk_i64 *data =
+      (__truk_i64 *)__truk_runtime_sxs_alloc_at(NULL, 8 * 8, &site);
+  for (int i = 0; i < 8; i++) {
+    data[i] = i;
+  }
+  long long before = live_bytes_of(report(), "<runtime>");
+  data = (__truk_i64 *)__truk_runtime_sxs_vec_resize(data, 8, 8, 1024);
+  CHECK_EQUAL(7, data[7]);
+  CHECK_EQUAL(0, site.live_bytes);
+  CHECK_EQUAL((before < 0 ? 0 : before) + 1024 * 8,
+              live_bytes_of(report(), "<runtime>"));
+  __truk_runtime_sxs_free(data);
+  CHECK_EQUAL(before < 0 ? 0 : before, live_bytes_of(report(), "<runtime>"));
+}
+
+TEST(TrackFull, ResettableAllocatorsAreNotTracked) {
+  static __truk_alloc_site_t site = make_site("arena.truk", 7);
+  __truk_allocator_t region = {bump_alloc, bump_free, bump_reset, NULL};
+  __truk_allocator_t plain = {bump_alloc, bump_free, NULL, NULL};
+
+  void *p = __truk_runtime_sxs_alloc_at(&region, 64, &site);
+  CHECK_EQUAL(0, site.allocs);
+  __truk_runtime_sxs_free_with(&region, p);
+
+  p = __truk_runtime_sxs_alloc_at(&plain, 64, &site);
+  CHECK_EQUAL(64, site.live_bytes);
+  __truk_runtime_sxs_free_with(&plain, p);
+  CHECK_EQUAL(0, site.live_bytes);
+}
+
+TEST(TrackFull, UnknownPointersAreIgnored) {
+  static __truk_alloc_site_t site = make_site("libc.truk", 1);
+  void *p = __truk_runtime_sxs_alloc_at(NULL, 32, &site);
+  void *q = malloc(32);
+  __truk_runtime_sxs_free_with(NULL, q);
+  CHECK_EQUAL(32, site.live_bytes);
+  __truk_runtime_sxs_free_with(NULL, p);
+}
+
+TEST(TrackFull, ManyPointersSurviveGrowthAndDeletion) {
+  static __truk_alloc_site_t site = make_site("many.truk", 9);
+  enum { COUNT = 20000 };
+  void **ptrs = (void **)malloc(COUNT * sizeof(void *));
+  for (int i = 0; i < COUNT; i++) {
+    ptrs[i] = __truk_runtime_sxs_alloc_at(NULL, 16, &site);
+  }
+  for (int i = 0; i < COUNT; i += 2) {
+    __truk_runtime_sxs_free(ptrs[i]);
+  }
+  CHECK_EQUAL(COUNT / 2 * 16, site.live_bytes);
+  for (int i = 1; i < COUNT; i += 2) {
+    __truk_runtime_sxs_free(ptrs[i]);
+  }
+  CHECK_EQUAL(0, site.live_allocs);
+  CHECK_EQUAL(COUNT, site.allocs);
+  free(ptrs);
+}
+
+static __truk_alloc_site_t thread_site = make_site("worker.truk", 21);
+
+static void *churn(void *arg) {
+  (void)arg;
+  void *held[16];
+  for (int round = 0; round < 2000; round++) {
+    for (int i = 0; i < 16; i++) {
+      held[i] = __truk_runtime_sxs_alloc_at(NULL, 24, &thread_site);
+    }
+    for (int i = 0; i < 16; i++) {
+      __truk_runtime_sxs_free(held[i]);
+    }
+  }
+  return NULL;
+}
+
+TEST(TrackFull, ThreadsKeepCountsConsistent) {
+  pthread_t threads[4];
+  for (int i = 0; i < 4; i++) {
+    pthread_create(&threads[i], NULL, churn, NULL);
+  }
+  for (int i = 0; i < 4; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  CHECK_EQUAL(4 * 2000 * 16, thread_site.allocs);
+  CHECK_EQUAL(0, thread_site.live_allocs);
+  CHECK_EQUAL(0, thread_site.live_bytes);
+}
+
+TEST(TrackFull, ReportListsLargestSiteFirst) {
+  static __truk_alloc_site_t small = make_site("order.truk", 1);
+  static __truk_alloc_site_t large = make_site("order.truk", 2);
+  void *p = __truk_runtime_sxs_alloc_at(NULL, 1000, &small);
+  void *q = __truk_runtime_sxs_alloc_at(NULL, 900000, &large);
+  std::string text = report();
+  size_t at_small = text.find("order.truk:1\n");
+  size_t at_large = text.find("order.truk:2\n");
+  CHECK(at_small != std::string::npos);
+  CHECK(at_large != std::string::npos);
+  CHECK(at_large < at_small);
+  __truk_runtime_sxs_free(p);
+  __truk_runtime_sxs_free(q);
+}
+
+#else
+
+TEST_GROUP(TrackSampled){};
+
+TEST(TrackSampled, EstimatesLiveBytes) {
+  static __truk_alloc_site_t site = make_site("sampled.truk", 5);
+  constexpr int COUNT = 100000, SIZE = 64;
+  void **ptrs = (void **)malloc(COUNT * sizeof(void *));
+  for (int i = 0; i < COUNT; i++) {
+    ptrs[i] = __truk_runtime_sxs_alloc_at(NULL, SIZE, &site);
+  }
+  const double actual = (double)COUNT * SIZE;
+  CHECK(site.allocs > COUNT * 8 / 10);
+  CHECK(site.allocs < COUNT * 12 / 10);
+  CHECK((double)site.live_bytes > actual * 0.8);
+  CHECK((double)site.live_bytes < actual * 1.2);
+
+  for (int i = 0; i < COUNT; i++) {
+    __truk_runtime_sxs_free(ptrs[i]);
+  }
+  CHECK_EQUAL(0, site.live_bytes);
+  CHECK_EQUAL(0, site.live_allocs);
+  free(ptrs);
+}
+
+TEST(TrackSampled, LargeAllocationsAreAlwaysRecorded) {
+  static __truk_alloc_site_t site = make_site("large.truk", 8);
+  for (int i = 0; i < 10; i++) {
+    void *p = __truk_runtime_sxs_alloc_at(NULL, 2 * TRUK_TRACK_ALLOCS_SAMPLE,
+                                          &site);
+    __truk_runtime_sxs_free(p);
+  }
+  CHECK_EQUAL(10, site.allocs);
+  CHECK_EQUAL(0, site.live_bytes);
+}
+
+TEST(TrackSampled, ReportSaysCountsAreEstimates) {
+  static __truk_alloc_site_t site = make_site("estimate.truk", 2);
+  void *p =
+      __truk_runtime_sxs_alloc_at(NULL, 4 * TRUK_TRACK_ALLOCS_SAMPLE, &site);
+  std::string text = report();
+  CHECK(text.find("estimate.truk:2") != std::string::npos);
+  CHECK(text.find("estimates") != std::string::npos);
+  __truk_runtime_sxs_free(p);
+}
+
+#endif
+
+int main(int argc, char **argv) {
+  return CommandLineTestRunner::RunAllTests(argc, argv);
+}